@@ -6,21 +6,89 @@
 #include "hash.h"
 #include "parser.h"
 #include "table.h"
+#include "epoch.h"
+
+/* ---- 读端快照 ---- */
+
+typedef struct
+{
+    u32 hash;
+    const char* name;    // 指向 data 里节点的 key，随 CatalogSet 存续
+    CatalogEntry* head;  // 发布时的版本链头
+} CatalogSlot;
+
+// 不可变的线性探测表，容量为 2 的幂且至少是条目数的两倍
+struct CatalogSnapshot
+{
+    usize mask;
+    usize count;
+    CatalogSlot slots[];
+};
+
+static CatalogSnapshot* catalogSnapshot_build(hmap* data)
+{
+    usize cap = 8;
+    while (cap < data->len * 2) cap <<= 1;
+    CatalogSnapshot* snap = calloc(1, sizeof(CatalogSnapshot) + cap * sizeof(CatalogSlot));
+    if (!snap) return NULL;
+    snap->mask = cap - 1;
+    snap->count = data->len;
+    HMAP_FOREACH(data, value)
+    {
+        const char* name = hmap_iter_key(&_iter_value);
+        u32 hash = hmap_str_hash(name);
+        usize i = hash & snap->mask;
+        while (snap->slots[i].name) i = (i + 1) & snap->mask;
+        snap->slots[i] = (CatalogSlot){hash, name, *(CatalogEntry**)value};
+    }
+    return snap;
+}
+
+static CatalogEntry* catalogSnapshot_lookup(const CatalogSnapshot* snap, const char* name)
+{
+    u32 hash = hmap_str_hash(name);
+    for (usize i = hash & snap->mask; snap->slots[i].name; i = (i + 1) & snap->mask)
+    {
+        const CatalogSlot* slot = &snap->slots[i];
+        if (slot->hash == hash && strcmp(slot->name, name) == 0) return slot->head;
+    }
+    return NULL;
+}
+
+static void catalogSnapshot_free(void* snap)
+{
+    free(snap);
+}
+
+// 在 write_lock 下调用：按 data 的当前状态发布新快照
+static void catalogSet_publish(CatalogSet* set)
+{
+    CatalogSnapshot* snap = catalogSnapshot_build(&set->data);
+    if (!snap) return; // 内存不足时读者继续看旧快照
+    CatalogSnapshot* old = atomic_exchange_explicit(&set->snapshot, snap, memory_order_acq_rel);
+    if (old) epoch_retire(old, catalogSnapshot_free);
+}
 
 void catalogSet_init(CatalogSet* set)
 {
     hmap_init_str(&set->data, sizeof(CatalogEntry*));
+    LWLockInit(&set->write_lock, "catalog_set");
+    atomic_init(&set->snapshot, catalogSnapshot_build(&set->data));
 }
 
 void catalogSet_deinit(CatalogSet* set)
 {
     hmap_deinit(&set->data);
+    // 调用方保证已无读者；更早的快照仍在 epoch 的待回收链上，各自释放
+    free(atomic_exchange(&set->snapshot, NULL));
+    LWLockDestroy(&set->write_lock);
 }
 
 static void catalogEntry_init(CatalogEntry* entry, CatalogType type, char* name)
 {
     entry->type = type;
     entry->name = name;
+    entry->oid = INVALID_OID;
     entry->deleted = false;
     entry->parent = NULL;
     entry->child = NULL;
@@ -44,6 +112,21 @@ static SchemaCatalogEntry* make_schema_entry(char* name)
     return entry;
 }
 
+#define TABLE_ENTRY_CXT_BLOCK_SIZE 1024 // 列定义加列名，一般一块就够
+
+static void tablecatalogEntry_destroy(TableCatalogEntry* entry)
+{
+    if (entry->cxt)
+    {
+        LWLockAcquire(&entry->catalog->ddl_lock, LW_EXCLUSIVE);
+        memoryContext_delete(entry->cxt);
+        LWLockRelease(&entry->catalog->ddl_lock);
+    }
+    LWLockDestroy(&entry->data_lock);
+    free(entry->base.name);
+    free(entry);
+}
+
 static TableCatalogEntry* make_table_entry(Catalog* catalog, SchemaCatalogEntry* schema, char* name,
                                            CreateTableInfo* info)
 {
@@ -61,23 +144,35 @@ static TableCatalogEntry* make_table_entry(Catalog* catalog, SchemaCatalogEntry*
     entry->datatable =
         Datatable_create(catalog->storage, info->schema_name, name, info->col_count, types.data);
     entry->storage_table = NULL;   /* new path not used on legacy create */
-    entry->columns = malloc(info->col_count * sizeof(ColumnDefinition));
+    atomic_init(&entry->data_state, TABLE_DATA_LOADED);
+    LWLockInit(&entry->data_lock, "TableCatalogEntry.data_lock");
+    entry->load_fn = NULL;
+    entry->load_arg = NULL;
+    entry->td_block_id = (block_id_t)-1;
+    entry->td_offset = 0;
+    // 列定义和列名拷进表自己的上下文（catalog->cxt 的子上下文），调用方的 info 可以随即释放，
+    // 表项销毁时整块归还。挂到父上下文要改它的子链表，与 catalog 上的其他 DDL 一样在 ddl_lock 下做
+    entry->catalog = catalog;
+    LWLockAcquire(&catalog->ddl_lock, LW_EXCLUSIVE);
+    entry->cxt = MemoryContext_create(&catalog->cxt, "table_entry", TABLE_ENTRY_CXT_BLOCK_SIZE);
+    LWLockRelease(&catalog->ddl_lock);
+    entry->columns = entry->cxt ? memoryContext_alloc(entry->cxt,
+                                                      info->col_count * sizeof(ColumnDefinition))
+                                : NULL;
     if (!entry->columns)
     {
-        free(entry);
+        tablecatalogEntry_destroy(entry);
         return NULL;
     }
     memcpy(entry->columns, info->columns, info->col_count * sizeof(ColumnDefinition));
+    for (usize i = 0; i < info->col_count; i++)
+    {
+        if (info->columns[i].name)
+            entry->columns[i].name = memoryContext_strdup(entry->cxt, info->columns[i].name);
+    }
     return entry;
 }
 
-static void tablecatalogEntry_destroy(TableCatalogEntry* entry)
-{
-    free(entry->base.name);
-    free(entry->columns);
-    free(entry);
-}
-
 static void schemacatalogEntry_destroy(SchemaCatalogEntry* entry)
 {
     catalogSet_deinit(&entry->tables);
@@ -96,7 +191,7 @@ static void schemacatalogEntry_destroy(SchemaCatalogEntry* entry)
   └─────────────────┴────────────────────────────────────────────────────────────────────┘
 
 */
-bool catalogSet_create_entry(CatalogSet* set, const char* name, CatalogEntry* value)
+static bool catalogSet_create_entry_locked(CatalogSet* set, const char* name, CatalogEntry* value)
 {
     /* hmap_get 返回 hmap_node* (即存储的 CatalogEntry*), 不存在则返回 NULL */
     hmap_node* node = hmap_get(&set->data, name);
@@ -140,21 +235,41 @@ bool catalogSet_create_entry(CatalogSet* set, const char* name, CatalogEntry* va
     return true;
 }
 
+bool catalogSet_create_entry(CatalogSet* set, const char* name, CatalogEntry* value)
+{
+    LWLockAcquire(&set->write_lock, LW_EXCLUSIVE);
+    bool created = catalogSet_create_entry_locked(set, name, value);
+    if (created) catalogSet_publish(set);
+    LWLockRelease(&set->write_lock);
+    return created;
+}
+
 CatalogEntry* catalogSet_get_entry(CatalogSet* set, const char* name)
 {
-    hmap_node* node = hmap_get(&set->data, name);
-    if (!node) return NULL;
-    CatalogEntry* entry = HMAP_VALUE(node, CatalogEntry*);
-    if (entry->deleted) return NULL;
+    epoch_enter();
+    CatalogSnapshot* snap = atomic_load_explicit(&set->snapshot, memory_order_acquire);
+    CatalogEntry* entry = snap ? catalogSnapshot_lookup(snap, name) : NULL;
+    epoch_exit();
+    if (!entry || entry->deleted) return NULL;
     return entry;
 }
 
 void catalogSet_scan(CatalogSet* set, CatalogScanFn scan_fn, void* ctx)
 {
-    HMAP_FOREACH(&set->data, entry)
+    // 先在临界区内拷出链头，回调可能做 I/O，不能压着 epoch
+    epoch_enter();
+    CatalogSnapshot* snap = atomic_load_explicit(&set->snapshot, memory_order_acquire);
+    usize count = 0;
+    CatalogEntry** heads = NULL;
+    if (snap && snap->count > 0) heads = malloc(snap->count * sizeof(CatalogEntry*));
+    if (heads)
     {
-        scan_fn(*(CatalogEntry**)entry, ctx);
+        for (usize i = 0; i <= snap->mask; i++)
+            if (snap->slots[i].name) heads[count++] = snap->slots[i].head;
     }
+    epoch_exit();
+    for (usize i = 0; i < count; i++) scan_fn(heads[i], ctx);
+    free(heads);
 }
 
 static void catalogSet_drop_entry_impl(CatalogSet* set, hmap_node* node)
@@ -172,10 +287,15 @@ static void catalogSet_drop_entry_impl(CatalogSet* set, hmap_node* node)
 
 bool catalogSet_drop_entry(CatalogSet* set, const char* name)
 {
+    LWLockAcquire(&set->write_lock, LW_EXCLUSIVE);
     hmap_node* node = hmap_get(&set->data, name);
-    if (!node) return false;
-    catalogSet_drop_entry_impl(set, node);
-    return true;
+    if (node)
+    {
+        catalogSet_drop_entry_impl(set, node);
+        catalogSet_publish(set);
+    }
+    LWLockRelease(&set->write_lock);
+    return node != NULL;
 }
 
 static void count_entry_callback(CatalogEntry* entry, void* ctx)
@@ -190,6 +310,82 @@ u32 catalogSet_get_entry_count(CatalogSet* set)
     return count;
 }
 
+/* ---- OID 表：OID 连续分配，直接按下标寻址 ---- */
+
+#define CATALOG_OID_MAP_INIT 64
+
+struct CatalogOidMap
+{
+    usize cap;
+    _Atomic(CatalogEntry*) slots[];
+};
+
+static CatalogOidMap* catalogOidMap_create(usize cap)
+{
+    CatalogOidMap* map = calloc(1, sizeof(CatalogOidMap) + cap * sizeof(CatalogEntry*));
+    if (map) map->cap = cap;
+    return map;
+}
+
+static void catalogOidMap_free(void* map)
+{
+    free(map);
+}
+
+static u64 catalog_next_oid(Catalog* catalog)
+{
+    return atomic_fetch_add_explicit(&catalog->next_oid, 1, memory_order_relaxed);
+}
+
+// 设置 oid 对应的目录项（NULL 表示注销）；容量不够时复制扩容并发布新表
+static void catalog_set_oid(Catalog* catalog, u64 oid, CatalogEntry* entry)
+{
+    if (oid == INVALID_OID) return;
+    LWLockAcquire(&catalog->ddl_lock, LW_EXCLUSIVE);
+    CatalogOidMap* map = atomic_load_explicit(&catalog->oids, memory_order_relaxed);
+    if (oid >= map->cap)
+    {
+        usize cap = map->cap * 2;
+        while (cap <= oid) cap *= 2;
+        CatalogOidMap* grown = catalogOidMap_create(cap);
+        if (!grown)
+        {
+            LWLockRelease(&catalog->ddl_lock);
+            return;
+        }
+        for (usize i = 0; i < map->cap; i++)
+            atomic_init(&grown->slots[i], atomic_load_explicit(&map->slots[i], memory_order_relaxed));
+        atomic_store_explicit(&catalog->oids, grown, memory_order_release);
+        epoch_retire(map, catalogOidMap_free);
+        map = grown;
+    }
+    atomic_store_explicit(&map->slots[oid], entry, memory_order_release);
+    LWLockRelease(&catalog->ddl_lock);
+}
+
+static void catalog_unregister_fn(CatalogEntry* entry, void* ctx)
+{
+    if (!entry->deleted) catalog_set_oid((Catalog*)ctx, entry->oid, NULL);
+}
+
+CatalogEntry* catalog_get_entry_by_oid(Catalog* catalog, u64 oid)
+{
+    epoch_enter();
+    CatalogOidMap* map = atomic_load_explicit(&catalog->oids, memory_order_acquire);
+    CatalogEntry* entry =
+        oid < map->cap ? atomic_load_explicit(&map->slots[oid], memory_order_acquire) : NULL;
+    epoch_exit();
+    return entry;
+}
+
+TableCatalogEntry* catalog_get_table_by_oid(Catalog* catalog, u64 oid)
+{
+    CatalogEntry* entry = catalog_get_entry_by_oid(catalog, oid);
+    if (!entry || entry->type != TABLE) return NULL;
+    tableCatalogEntry_ensure_loaded((TableCatalogEntry*)entry);
+    return (TableCatalogEntry*)entry;
+}
+
 int catalog_create_schema(Catalog* catalog, CreateSchemaInfo* info)
 {
     char* name_copy = strdup(info->schema_name);
@@ -200,11 +396,15 @@ int catalog_create_schema(Catalog* catalog, CreateSchemaInfo* info)
         free(name_copy);
         return -1;
     }
+    // OID 在发布前写好，读者看到目录项时 oid 已就绪
+    entry->base.oid = catalog_next_oid(catalog);
     if (!catalogSet_create_entry(&catalog->schemas, info->schema_name, (CatalogEntry*)entry))
     {
         schemacatalogEntry_destroy(entry);
         if (!info->if_not_exists) return -2; // 已存在
+        return 0;
     }
+    catalog_set_oid(catalog, entry->base.oid, (CatalogEntry*)entry);
     return 0;
 }
 
@@ -216,7 +416,15 @@ SchemaCatalogEntry* catalog_get_schema(Catalog* catalog, const char* schema_name
 int catalog_drop_schema(Catalog* catalog, const char* schema_name)
 {   // 不能删除默认 schema
     if (!strcmp(schema_name, DEFAULT_SCHEMA)) return -1;
+    SchemaCatalogEntry* schema = catalog_get_schema(catalog, schema_name);
     catalogSet_drop_entry(&catalog->schemas, schema_name);
+    if (schema)
+    {
+        // schema 下的表和索引随之不可按 OID 访问
+        catalog_set_oid(catalog, schema->base.oid, NULL);
+        catalogSet_scan(&schema->tables, catalog_unregister_fn, catalog);
+        catalogSet_scan(&schema->indexes, catalog_unregister_fn, catalog);
+    }
     return 0;
 }
 
@@ -232,20 +440,53 @@ int catalog_create_table(Catalog* catalog, CreateTableInfo* info)
         free(name_copy);
         return -1;
     }
+    entry->base.oid = catalog_next_oid(catalog);
     if (!catalogSet_create_entry(&schema_entry->tables, info->table_name, (CatalogEntry*)entry))
     {
         tablecatalogEntry_destroy(entry);
         if (!info->if_not_exists) return -2; // 已存在
+        return 0;
     }
+    catalog_set_oid(catalog, entry->base.oid, (CatalogEntry*)entry);
     return 0;
 }
 
 TableCatalogEntry* catalog_get_table(Catalog* catalog, const char* schema_name,
                                      const char* table_name)
 {
+    // 两次快照查找放在同一个 epoch 临界区里，只付一次进出开销
+    epoch_enter();
     SchemaCatalogEntry* schema = catalog_get_schema(catalog, schema_name);
-    if (!schema) return NULL;
-    return (TableCatalogEntry*)catalogSet_get_entry(&schema->tables, table_name);
+    TableCatalogEntry* entry =
+        schema ? (TableCatalogEntry*)catalogSet_get_entry(&schema->tables, table_name) : NULL;
+    epoch_exit();
+    if (entry) tableCatalogEntry_ensure_loaded(entry);
+    return entry;
+}
+
+void tableCatalogEntry_set_pending(TableCatalogEntry* entry, TableDataLoadFn load_fn, void* arg)
+{
+    LWLockAcquire(&entry->data_lock, LW_EXCLUSIVE);
+    entry->load_fn = load_fn;
+    entry->load_arg = arg;
+    atomic_store_explicit(&entry->data_state, TABLE_DATA_PENDING, memory_order_release);
+    LWLockRelease(&entry->data_lock);
+}
+
+void tableCatalogEntry_ensure_loaded(TableCatalogEntry* entry)
+{
+    if (atomic_load_explicit(&entry->data_state, memory_order_acquire) == TABLE_DATA_LOADED)
+        return;
+    LWLockAcquire(&entry->data_lock, LW_EXCLUSIVE);
+    // 双重检查：等锁期间可能已被另一个线程（前台查询或预取线程）加载完
+    if (atomic_load_explicit(&entry->data_state, memory_order_relaxed) == TABLE_DATA_PENDING)
+    {
+        entry->load_fn(entry, entry->load_arg);
+        entry->load_fn = NULL;
+        entry->load_arg = NULL;
+        atomic_store_explicit(&entry->data_state, TABLE_DATA_LOADED, memory_order_release);
+    }
+    LWLockRelease(&entry->data_lock);
 }
 
 Vector tableCatalogEntry_get_types(TableCatalogEntry* entry)
@@ -264,6 +505,10 @@ Catalog* catalog_create()
     if (!catalog) return NULL;
     catalogSet_init(&catalog->schemas);
     catalog->storage = NULL;
+    MemoryContext_init(&catalog->cxt, NULL, "catalog", 0);
+    atomic_init(&catalog->next_oid, INVALID_OID + 1);
+    LWLockInit(&catalog->ddl_lock, "catalog_ddl");
+    atomic_init(&catalog->oids, catalogOidMap_create(CATALOG_OID_MAP_INIT));
     return catalog;
 }
 
@@ -271,6 +516,9 @@ void catalog_destroy(Catalog* catalog)
 {
     if (!catalog) return;
     catalogSet_deinit(&catalog->schemas);
+    free(atomic_load(&catalog->oids));
+    LWLockDestroy(&catalog->ddl_lock);
+    memoryContext_delete(&catalog->cxt);
     free(catalog);
 }
 
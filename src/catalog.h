@@ -5,6 +5,9 @@
 #include "hash.h"
 #include "parser.h"
 #include "vector.h"
+#include "lock.h"
+#include "memctx.h"
+#include <stdatomic.h>
 typedef struct DataTable DataTable;
 typedef struct StorageManager StorageManager;
 typedef struct StorageTable StorageTable;
@@ -19,12 +22,15 @@ typedef enum
     INDEX = 3,
 } CatalogType;
 
+#define INVALID_OID 0
+
 typedef struct CatalogEntry CatalogEntry;
 
 struct CatalogEntry
 {
     CatalogType type; // 目录项类型
     char* name;       // 目录项名称
+    u64 oid;          // Catalog 内唯一的数字 ID，热路径可按 OID 直接查（INVALID_OID 表示未分配）
     bool deleted; // 是否已删除（逻辑删除）
     CatalogEntry* parent; // 父目录项
     CatalogEntry* child;  // 子目录项
@@ -32,10 +38,21 @@ struct CatalogEntry
 
 typedef void (*CatalogScanFn)(CatalogEntry* entry, void* ctx);
 
+/*
+ * CatalogSet 的并发模型（RCU / copy-on-write）：
+ *   写者（DDL）在 write_lock 下修改 data 里的版本链，然后整体重建一份不可变的
+ *   CatalogSnapshot，release 发布并 epoch_retire 旧快照；
+ *   读者只在 epoch 临界区内读快照，不加锁，不与 DDL 互斥。
+ * CatalogEntry 在 CatalogSet 存续期间不会释放，读者拿到的指针可以在临界区外继续使用。
+ */
+typedef struct CatalogSnapshot CatalogSnapshot;
+
 // MVCC 版本化容器，存放 CatalogEntry
 typedef struct
 {
-    hmap data;
+    hmap data;                          // 名字 → 版本链头，仅写者在 write_lock 下访问
+    LWLock write_lock;                  // 串行化 DDL
+    _Atomic(CatalogSnapshot*) snapshot; // 读端快照
 } CatalogSet;
 
 void catalogSet_init(CatalogSet* set);
@@ -61,24 +78,56 @@ typedef struct
 
 usize schemaCatalogEntry_get_table_count(SchemaCatalogEntry* entry);
 
-typedef struct
+// 表数据的加载状态（懒加载启动模式下 catalog 先于表数据加载）
+typedef enum
+{
+    TABLE_DATA_LOADED = 0,  // 表数据已在内存（新建表或已加载）
+    TABLE_DATA_PENDING = 1, // 只加载了 catalog 定义，表数据仍在磁盘
+} TableDataState;
+
+typedef struct TableCatalogEntry TableCatalogEntry;
+typedef struct Catalog Catalog;
+
+typedef void (*TableDataLoadFn)(TableCatalogEntry* entry, void* arg);
+
+struct TableCatalogEntry
 {
     EXTENDS(CatalogEntry);
     SchemaCatalogEntry* schema;
     DataTable* datatable;      /* legacy path (src/), may be NULL */
     StorageTable* storage_table;  /* new path (tmp/src/), may be NULL */
-    ColumnDefinition* columns;
+    ColumnDefinition* columns; /* 与列名一起分配在 cxt */
+    MemoryContext* cxt;        /* 表项自己的内存（Catalog.cxt 的子上下文），随表项销毁 */
+    Catalog* catalog;
     usize column_count;
-} TableCatalogEntry;
+    _Atomic u32 data_state;    /* TableDataState */
+    LWLock data_lock;          /* 串行化首次访问与后台预取的加载（持有期间读整张表，可睡眠） */
+    TableDataLoadFn load_fn;   /* PENDING 时负责把表数据读入内存 */
+    void* load_arg;
+    block_id_t td_block_id;    /* 表数据 DataPointer 在 tabledata 链中的位置 */
+    u64 td_offset;
+};
 
 Vector tableCatalogEntry_get_types(TableCatalogEntry* entry);
 
+// 标记表数据为待加载：首次 catalog_get_table 或后台预取时调用 load_fn
+void tableCatalogEntry_set_pending(TableCatalogEntry* entry, TableDataLoadFn load_fn, void* arg);
+
+// 确保表数据已加载（已加载时只有一次 acquire load）
+void tableCatalogEntry_ensure_loaded(TableCatalogEntry* entry);
+
+typedef struct CatalogOidMap CatalogOidMap;
+
 // 目录项 相当于pg catalog
-typedef struct
+struct Catalog
 {
     CatalogSet schemas;
     StorageManager* storage;
-} Catalog;
+    MemoryContext cxt;             // 目录存续期的内存；每个表项在下面挂一个子上下文放列定义和列名
+    _Atomic u64 next_oid;
+    LWLock ddl_lock;               // 串行化 OID 表的写入与扩容，以及 cxt 子上下文的挂接与摘除
+    _Atomic(CatalogOidMap*) oids;  // OID → 目录项，读者无锁
+};
 
 // 创建目录项
 Catalog* catalog_create();
@@ -96,6 +145,12 @@ int catalog_create_table(Catalog* catalog, CreateTableInfo* info);
 TableCatalogEntry* catalog_get_table(Catalog* catalog, const char* schema_name,
                                      const char* table_name);
 
+// 按 OID 查目录项；不存在或已删除时返回 NULL。无锁
+CatalogEntry* catalog_get_entry_by_oid(Catalog* catalog, u64 oid);
+
+// 按 OID 查表（并确保表数据已加载）。高 QPS 路径可先用名字解析出 OID 再反复调用
+TableCatalogEntry* catalog_get_table_by_oid(Catalog* catalog, u64 oid);
+
 StorageTable* catalog_get_storage_table(Catalog* catalog, const char* schema_name,
                                         const char* table_name);
 
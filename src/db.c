@@ -0,0 +1,29 @@
+#include "db.h"
+
+int db_open(DB* db, StorageManager* storage_manager, const DBConfig* config)
+{
+    DBConfig cfg = config ? *config : DB_CONFIG_DEFAULT;
+    db->storage_manager = storage_manager;
+    db->catalog = catalog_create();
+    db->checkpoint_manager = NULL;
+    if (!db->catalog) return -1;
+    db->checkpoint_manager = CheckpointManager_create(storage_manager->block_manager, db->catalog);
+    if (!db->checkpoint_manager)
+    {
+        catalog_destroy(db->catalog);
+        db->catalog = NULL;
+        return -1;
+    }
+    checkpointManager_set_load_mode(db->checkpoint_manager, cfg.load_mode, cfg.prefetch_workers);
+    checkpointManager_loadfromstorage(db->checkpoint_manager);
+    return 0;
+}
+
+void db_close(DB* db)
+{
+    if (!db) return;
+    CheckpointManager_destroy(db->checkpoint_manager);
+    db->checkpoint_manager = NULL;
+    catalog_destroy(db->catalog);
+    db->catalog = NULL;
+}
@@ -7,6 +7,31 @@ typedef struct
 {
     StorageManager *storage_manager;
     Catalog *catalog;
+    CheckpointManager *checkpoint_manager; // 启动加载用的 CheckpointManager，LAZY 模式下预取任务引用它
 } DB;
 
-#endif // VECTORBASE_H
\ No newline at end of file
+// 打开数据库的配置；db_open 传 NULL 时使用 DB_CONFIG_DEFAULT
+typedef struct
+{
+    CheckpointLoadMode load_mode; // 启动加载模式
+    u32 prefetch_workers;         // LAZY 模式下后台预取表数据的并发任务数（0 = 只在首次访问时加载）
+} DBConfig;
+
+// 默认懒加载：catalog 读完即可服务，表数据由后台预取或首次访问时加载
+#define DB_DEFAULT_PREFETCH_WORKERS 2
+#define DB_CONFIG_DEFAULT \
+    ((DBConfig){.load_mode = CHECKPOINT_LOAD_LAZY, .prefetch_workers = DB_DEFAULT_PREFETCH_WORKERS})
+
+/*
+ * 打开数据库：新建 catalog，按 config 的加载模式从 storage_manager 的块管理器读取最近的
+ * checkpoint。成功返回 0，分配失败返回 -1。storage_manager 仍归调用方所有。
+ */
+int db_open(DB *db, StorageManager *storage_manager, const DBConfig *config);
+
+/*
+ * 关闭数据库：先等后台预取结束并释放 CheckpointManager（预取任务会写 catalog 里的表），
+ * 再释放 catalog。storage_manager 由打开它的调用方负责。
+ */
+void db_close(DB *db);
+
+#endif // VECTORBASE_H
@@ -0,0 +1,169 @@
+/**
+ * epoch.c — 延迟回收实现
+ *
+ * 每个线程第一次进入临界区时领取一个 EpochRecord（挂在全局无锁单链表上，
+ * 只增不删；线程退出时归还，供后来的线程复用）。record.epoch 为 0 表示不在临界区，
+ * 否则是进入时看到的全局 epoch。退休对象挂在自旋锁保护的 limbo 链表上——
+ * 退休只发生在目录扩容这类低频路径，锁不会成为瓶颈。
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "epoch.h"
+#include "lock.h"
+
+typedef struct EpochRecord
+{
+    _Atomic uint64_t epoch; /* 0：静止；否则为进入临界区时的全局 epoch */
+    atomic_bool in_use;
+    struct EpochRecord* next;
+} EpochRecord;
+
+typedef struct EpochRetired
+{
+    void* ptr;
+    void (*free_fn)(void*);
+    uint64_t epoch; /* 退休时的全局 epoch */
+    struct EpochRetired* next;
+} EpochRetired;
+
+static _Atomic uint64_t epoch_global = 1; /* 从 1 开始，0 留给"静止" */
+static _Atomic(EpochRecord*) epoch_records = NULL;
+static slock_t epoch_limbo_lock = 0;
+static EpochRetired* epoch_limbo = NULL;
+
+static __thread EpochRecord* epoch_self = NULL;
+static __thread uint32_t epoch_depth = 0;
+
+static pthread_key_t epoch_key;
+static pthread_once_t epoch_key_once = PTHREAD_ONCE_INIT;
+
+/* 线程退出：归还槽位 */
+static void epoch_thread_exit(void* arg)
+{
+    EpochRecord* r = arg;
+    atomic_store_explicit(&r->epoch, 0, memory_order_release);
+    atomic_store_explicit(&r->in_use, false, memory_order_release);
+}
+
+static void epoch_key_init(void)
+{
+    pthread_key_create(&epoch_key, epoch_thread_exit);
+}
+
+static EpochRecord* epoch_register(void)
+{
+    pthread_once(&epoch_key_once, epoch_key_init);
+    EpochRecord* r;
+    for (r = atomic_load(&epoch_records); r; r = r->next)
+    {
+        bool expected = false;
+        if (!atomic_load_explicit(&r->in_use, memory_order_relaxed) &&
+            atomic_compare_exchange_strong(&r->in_use, &expected, true))
+            break;
+    }
+    if (!r)
+    {
+        r = malloc(sizeof(EpochRecord));
+        atomic_init(&r->epoch, 0);
+        atomic_init(&r->in_use, true);
+        r->next = atomic_load(&epoch_records);
+        while (!atomic_compare_exchange_weak(&epoch_records, &r->next, r))
+            ;
+    }
+    pthread_setspecific(epoch_key, r);
+    epoch_self = r;
+    return r;
+}
+
+void epoch_enter(void)
+{
+    if (epoch_depth++ > 0) return;
+    EpochRecord* r = epoch_self ? epoch_self : epoch_register();
+    /* 发布 epoch 后的全屏障保证：之后对共享指针的读取排在推进者扫描本槽位之后，
+     * 推进者若把本线程当作静止，本线程必然读到已发布的新指针 */
+    atomic_store_explicit(&r->epoch, atomic_load(&epoch_global), memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+void epoch_exit(void)
+{
+    if (--epoch_depth > 0) return;
+    atomic_store_explicit(&epoch_self->epoch, 0, memory_order_release);
+}
+
+/* 所有活跃读者都已看到当前 epoch 时前进一步；有落后者返回 false */
+static bool epoch_try_advance(void)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    uint64_t g = atomic_load(&epoch_global);
+    for (EpochRecord* r = atomic_load(&epoch_records); r; r = r->next)
+    {
+        uint64_t e = atomic_load_explicit(&r->epoch, memory_order_acquire);
+        if (e != 0 && e != g) return false;
+    }
+    /* CAS 失败说明别人已推进，同样算成功 */
+    atomic_compare_exchange_strong(&epoch_global, &g, g + 1);
+    return true;
+}
+
+void epoch_reclaim(void)
+{
+    epoch_try_advance();
+    uint64_t g = atomic_load(&epoch_global);
+
+    EpochRetired* ready = NULL;
+    SpinLockAcquire(&epoch_limbo_lock);
+    EpochRetired** link = &epoch_limbo;
+    while (*link)
+    {
+        EpochRetired* cur = *link;
+        if (cur->epoch + 2 <= g)
+        {
+            *link = cur->next;
+            cur->next = ready;
+            ready = cur;
+        }
+        else
+            link = &cur->next;
+    }
+    SpinLockRelease(&epoch_limbo_lock);
+
+    while (ready)
+    {
+        EpochRetired* next = ready->next;
+        ready->free_fn(ready->ptr);
+        free(ready);
+        ready = next;
+    }
+}
+
+void epoch_retire(void* ptr, void (*free_fn)(void*))
+{
+    EpochRetired* node = malloc(sizeof(EpochRetired));
+    node->ptr = ptr;
+    node->free_fn = free_fn;
+    /* 摘除（release 发布新指针）先于这次读取，读到的 epoch 不会偏小 */
+    atomic_thread_fence(memory_order_seq_cst);
+    node->epoch = atomic_load(&epoch_global);
+    SpinLockAcquire(&epoch_limbo_lock);
+    node->next = epoch_limbo;
+    epoch_limbo = node;
+    SpinLockRelease(&epoch_limbo_lock);
+    epoch_reclaim();
+}
+
+void epoch_synchronize(void)
+{
+    uint64_t target = atomic_load(&epoch_global) + 2;
+    while (atomic_load(&epoch_global) < target)
+        if (!epoch_try_advance()) sched_yield();
+    epoch_reclaim();
+}
+
+uint64_t epoch_current(void)
+{
+    return atomic_load(&epoch_global);
+}
@@ -0,0 +1,38 @@
+/**
+ * epoch.h — 基于 epoch 的延迟回收（EBR）
+ *
+ * 无锁读者访问可能被写者替换掉的共享结构（如 SegmentTree 的段目录）时，
+ * 写者不能立刻释放旧结构：读者可能还拿着指向它的指针。做法：
+ *
+ *   读者   epoch_enter();  p = 原子 acquire 读共享指针;  ... 使用 p ...;  epoch_exit();
+ *   写者   原子 release 发布新结构;  epoch_retire(旧结构, 释放函数);
+ *
+ * 全局 epoch 只在所有处于临界区的线程都已观察到当前值时才能前进一步；
+ * 在 epoch e 退休的对象，等全局 epoch 到达 e + 2 时，退休前进入的读者必然都已离开，
+ * 此时才真正释放。读者从不阻塞：进入 / 退出各是一次线程私有槽位上的原子写。
+ *
+ * 临界区必须短小且不能阻塞（不要在其中等锁）：长临界区只会推迟回收，不影响正确性。
+ * 临界区可嵌套。与 lock.h 一样是自包含模块，不依赖 vb_type.h。
+ */
+#ifndef EPOCH_H
+#define EPOCH_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 进入 / 退出读临界区（可嵌套，仅最外层生效） */
+void epoch_enter(void);
+void epoch_exit(void);
+
+/* 延迟释放：ptr 已从共享结构摘除，等所有可能看到它的读者离开后调用 free_fn(ptr) */
+void epoch_retire(void* ptr, void (*free_fn)(void*));
+
+/* 尝试推进全局 epoch 并释放已安全的退休对象；不等待，可随时调用 */
+void epoch_reclaim(void);
+
+/* 等待当前所有读者离开并释放此前退休的全部对象。调用方自身不得处于临界区 */
+void epoch_synchronize(void);
+
+/* 当前全局 epoch（测试与诊断用） */
+uint64_t epoch_current(void);
+
+#endif
@@ -0,0 +1,816 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "executor.h"
+#include "lock.h"
+#include "operator.h"
+#include "transaction.h"
+
+/* ================= ExecChunk ================= */
+
+ExecChunk* ExecChunk_create(MemoryContext* cxt, usize ncols)
+{
+    ExecChunk* chunk = memoryContext_alloc_zero(cxt, sizeof(ExecChunk));
+    if (!chunk) return NULL;
+    chunk->data.mode = CHUNK_COLUMN;
+    chunk->data.count = ncols;
+    if (ncols > 0)
+    {
+        chunk->data.arrays = memoryContext_alloc_zero(cxt, ncols * sizeof(VectorBase));
+        chunk->data.size = ncols * STANDARD_VECTOR_SIZE * sizeof(Datum);
+        chunk->data.data = memoryContext_alloc_zero(cxt, chunk->data.size);
+        if (!chunk->data.arrays || !chunk->data.data) return NULL;
+        for (usize i = 0; i < ncols; i++) chunk->data.arrays[i].type = TYPE_INT64;
+    }
+    execChunk_reset(chunk);
+    return chunk;
+}
+
+void execChunk_reset(ExecChunk* chunk)
+{
+    dataChunk_reset(&chunk->data);
+    chunk->count = 0;
+    chunk->has_sel = false;
+    chunk->sel_count = 0;
+}
+
+// 同步 DataChunk 各列的元素个数
+static void execChunk_set_count(ExecChunk* chunk, usize count)
+{
+    chunk->count = count;
+    for (usize i = 0; i < execChunk_ncols(chunk); i++) chunk->data.arrays[i].count = count;
+}
+
+// 把恒等映射显式化，之后可以原地收缩选择向量
+static void execChunk_materialize_sel(ExecChunk* chunk)
+{
+    if (chunk->has_sel) return;
+    for (usize i = 0; i < chunk->count; i++) chunk->sel[i] = i;
+    chunk->sel_count = chunk->count;
+    chunk->has_sel = true;
+}
+
+// 不缓存数据的算子：finalize 直接转给下游
+static ExecStatus physicalOperator_finalize_next(PhysicalOperator* op)
+{
+    return op->next ? VCALL(op->next, finalize) : EXEC_CONTINUE;
+}
+
+/* ================= 过滤 ================= */
+
+/*
+ * 按谓词收缩选择向量：每行无分支地写回 sel[m]，满足条件时 m 前进。
+ * 写位置 m 不超过读位置 k，原地收缩是安全的。
+ */
+#define EXEC_FILTER_LOOP(cond)                                         \
+    for (usize k = 0; k < n; k++)                                      \
+    {                                                                  \
+        usize r = sel[k];                                              \
+        sel[m] = r;                                                    \
+        m += (usize)(!((nulls[r] >> bit) & 1) && (cond));             \
+    }
+
+#define EXEC_FILTER_CMP(T, GET)                                        \
+    do                                                                 \
+    {                                                                  \
+        T v = GET(pred->value);                                        \
+        switch (pred->op)                                              \
+        {                                                              \
+            case EXEC_CMP_EQ:                                          \
+                EXEC_FILTER_LOOP(GET(col[r]) == v);                    \
+                break;                                                 \
+            case EXEC_CMP_NE:                                          \
+                EXEC_FILTER_LOOP(GET(col[r]) != v);                    \
+                break;                                                 \
+            case EXEC_CMP_LT:                                          \
+                EXEC_FILTER_LOOP(GET(col[r]) < v);                     \
+                break;                                                 \
+            case EXEC_CMP_LE:                                          \
+                EXEC_FILTER_LOOP(GET(col[r]) <= v);                    \
+                break;                                                 \
+            case EXEC_CMP_GT:                                          \
+                EXEC_FILTER_LOOP(GET(col[r]) > v);                     \
+                break;                                                 \
+            case EXEC_CMP_GE:                                          \
+                EXEC_FILTER_LOOP(GET(col[r]) >= v);                    \
+                break;                                                 \
+            default:                                                   \
+                break;                                                 \
+        }                                                              \
+    } while (0)
+
+static usize exec_filter_apply(const ExecPredicate* pred, ExecChunk* chunk, usize n)
+{
+    usize* sel = chunk->sel;
+    const u64* nulls = chunk->null_bits;
+    const Datum* col = execChunk_col(chunk, pred->col);
+    u16 bit = pred->col;
+    usize m = 0;
+
+    if (pred->op == EXEC_CMP_IS_NULL || pred->op == EXEC_CMP_NOT_NULL)
+    {
+        bool want_null = pred->op == EXEC_CMP_IS_NULL;
+        for (usize k = 0; k < n; k++)
+        {
+            usize r = sel[k];
+            sel[m] = r;
+            m += (usize)((bool)((nulls[r] >> bit) & 1) == want_null);
+        }
+        return m;
+    }
+    switch (pred->type)
+    {
+        case TUPLE_COL_BOOL:
+            EXEC_FILTER_CMP(bool, DatumGetBool);
+            break;
+        case TUPLE_COL_I32:
+            EXEC_FILTER_CMP(i32, DatumGetInt32);
+            break;
+        case TUPLE_COL_I64:
+            EXEC_FILTER_CMP(i64, DatumGetInt64);
+            break;
+        case TUPLE_COL_F32:
+            EXEC_FILTER_CMP(f32, DatumGetFloat32);
+            break;
+        case TUPLE_COL_F64:
+            EXEC_FILTER_CMP(f64, DatumGetFloat64);
+            break;
+        default:
+            break;
+    }
+    return m;
+}
+
+// 依次应用合取谓词收缩选择向量，返回存活行数
+static usize exec_filter_rows(const ExecPredicate* preds, usize npreds, ExecChunk* chunk)
+{
+    execChunk_materialize_sel(chunk);
+    usize n = chunk->sel_count;
+    for (usize p = 0; p < npreds && n > 0; p++) n = exec_filter_apply(&preds[p], chunk, n);
+    chunk->sel_count = n;
+    return n;
+}
+
+static ExecStatus physicalFilter_push(PhysicalOperator* op, ExecChunk* chunk)
+{
+    PhysicalFilter* filter = (PhysicalFilter*)op;
+    if (exec_filter_rows(filter->preds, filter->npreds, chunk) == 0) return EXEC_CONTINUE;
+    return VCALL(op->next, push, chunk);
+}
+
+static const PhysicalOperatorVTable physical_filter_vtable = {
+    .push = physicalFilter_push,
+    .finalize = physicalOperator_finalize_next,
+};
+
+// 比较谓词只支持定宽类型
+static bool exec_predicates_supported(const ExecPredicate* preds, usize npreds)
+{
+    for (usize p = 0; p < npreds; p++)
+    {
+        if (preds[p].op == EXEC_CMP_IS_NULL || preds[p].op == EXEC_CMP_NOT_NULL) continue;
+        switch (preds[p].type)
+        {
+            case TUPLE_COL_BOOL:
+            case TUPLE_COL_I32:
+            case TUPLE_COL_I64:
+            case TUPLE_COL_F32:
+            case TUPLE_COL_F64:
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
+
+PhysicalFilter* PhysicalFilter_create(ExecContext* ctx, const ExecPredicate* preds, usize npreds,
+                                      PhysicalOperator* next)
+{
+    if (!exec_predicates_supported(preds, npreds)) return NULL;
+    PhysicalFilter* filter = memoryContext_alloc_zero(ctx->cxt, sizeof(PhysicalFilter));
+    if (!filter) return NULL;
+    filter->base.vtable = (PhysicalOperatorVTable*)&physical_filter_vtable;
+    filter->base.type = PHYSICAL_FILTER;
+    filter->base.next = next;
+    if (npreds > 0)
+    {
+        filter->preds = memoryContext_alloc(ctx->cxt, npreds * sizeof(ExecPredicate));
+        if (!filter->preds) return NULL;
+        memcpy(filter->preds, preds, npreds * sizeof(ExecPredicate));
+    }
+    filter->npreds = npreds;
+    return filter;
+}
+
+/* ================= 向量 top-k ================= */
+
+static void topk_sift_up(PhysicalTopK* t, usize i)
+{
+    while (i > 0)
+    {
+        usize p = (i - 1) / 2;
+        if (t->dist[t->heap[p]] >= t->dist[t->heap[i]]) break;
+        usize tmp = t->heap[p];
+        t->heap[p] = t->heap[i];
+        t->heap[i] = tmp;
+        i = p;
+    }
+}
+
+static void topk_sift_down(PhysicalTopK* t, usize i, usize n)
+{
+    for (;;)
+    {
+        usize l = 2 * i + 1, r = 2 * i + 2, m = i;
+        if (l < n && t->dist[t->heap[l]] > t->dist[t->heap[m]]) m = l;
+        if (r < n && t->dist[t->heap[r]] > t->dist[t->heap[m]]) m = r;
+        if (m == i) break;
+        usize tmp = t->heap[i];
+        t->heap[i] = t->heap[m];
+        t->heap[m] = tmp;
+        i = m;
+    }
+}
+
+// 把批内第 r 行写进候选槽 slot（被淘汰候选的 varlena 留在查询上下文里，随上下文回收）
+static void topk_store(PhysicalTopK* t, usize slot, ExecChunk* chunk, usize r)
+{
+    t->dist[slot] = chunk->dist[r];
+    t->heap_ctid[slot] = chunk->heap_ctid[r];
+    t->emb_ctid[slot] = chunk->emb_ctid[r];
+    t->vec[slot] = chunk->vec[r];
+    t->null_bits[slot] = chunk->null_bits[r];
+    for (usize c = 0; c < t->ncols; c++) t->vals[c * t->k + slot] = execChunk_col(chunk, c)[r];
+}
+
+static ExecStatus physicalTopK_push(PhysicalOperator* op, ExecChunk* chunk)
+{
+    PhysicalTopK* t = (PhysicalTopK*)op;
+    if (t->k == 0) return EXEC_FINISHED;
+    if (chunk->dim != t->cond.query.count || execChunk_ncols(chunk) != t->ncols) return EXEC_ERROR;
+
+    /* 先整批算距离，再逐行和堆顶比较 */
+    usize rows = execChunk_rows(chunk);
+    VectorBase stored = {TYPE_FLOAT32, chunk->dim, NULL};
+    for (usize i = 0; i < rows; i++)
+    {
+        usize r = execChunk_row(chunk, i);
+        stored.data = (data_ptr_t)chunk->vec[r];
+        chunk->dist[r] = chunk->vec[r] ? vec_compute_distance(&stored, &t->cond.query, t->cond.metric)
+                                       : NAN;
+    }
+    for (usize i = 0; i < rows; i++)
+    {
+        usize r = execChunk_row(chunk, i);
+        f32 d = chunk->dist[r];
+        if (isnan(d)) continue;
+        if (t->size < t->k)
+        {
+            topk_store(t, t->size, chunk, r);
+            t->heap[t->size] = t->size;
+            topk_sift_up(t, t->size++);
+        }
+        else if (d < t->dist[t->heap[0]])
+        {
+            topk_store(t, t->heap[0], chunk, r);
+            topk_sift_down(t, 0, t->size);
+        }
+    }
+    return EXEC_CONTINUE;
+}
+
+static ExecStatus physicalTopK_finalize(PhysicalOperator* op)
+{
+    PhysicalTopK* t = (PhysicalTopK*)op;
+    /* 原地堆排序：heap[] 变成按距离升序的槽号序列，直接当作 copy_fn 的选择向量 */
+    for (usize end = t->size; end > 1; end--)
+    {
+        usize tmp = t->heap[0];
+        t->heap[0] = t->heap[end - 1];
+        t->heap[end - 1] = tmp;
+        topk_sift_down(t, 0, end - 1);
+    }
+
+    ExecChunk* out = t->out;
+    ExecStatus st = EXEC_CONTINUE;
+    for (usize off = 0; off < t->size && st == EXEC_CONTINUE; off += STANDARD_VECTOR_SIZE)
+    {
+        usize n = t->size - off < STANDARD_VECTOR_SIZE ? t->size - off : STANDARD_VECTOR_SIZE;
+        execChunk_reset(out);
+        for (usize c = 0; c < t->ncols; c++)
+            copy_fn((data_ptr_t)(t->vals + c * t->k), (data_ptr_t)execChunk_col(out, c), off, n,
+                    sizeof(Datum), t->heap);
+        copy_fn((data_ptr_t)t->dist, (data_ptr_t)out->dist, off, n, sizeof(f32), t->heap);
+        copy_fn((data_ptr_t)t->heap_ctid, (data_ptr_t)out->heap_ctid, off, n, sizeof(ItemPtr),
+                t->heap);
+        copy_fn((data_ptr_t)t->emb_ctid, (data_ptr_t)out->emb_ctid, off, n, sizeof(ItemPtr),
+                t->heap);
+        copy_fn((data_ptr_t)t->vec, (data_ptr_t)out->vec, off, n, sizeof(const f32*), t->heap);
+        copy_fn((data_ptr_t)t->null_bits, (data_ptr_t)out->null_bits, off, n, sizeof(u64),
+                t->heap);
+        execChunk_set_count(out, n);
+        out->dim = t->cond.query.count;
+        st = VCALL(op->next, push, out);
+    }
+    if (st == EXEC_ERROR) return st;
+    return physicalOperator_finalize_next(op);
+}
+
+static const PhysicalOperatorVTable physical_topk_vtable = {
+    .push = physicalTopK_push,
+    .finalize = physicalTopK_finalize,
+};
+
+PhysicalTopK* PhysicalTopK_create(ExecContext* ctx, const VectorCondition* cond, usize k,
+                                  usize ncols, PhysicalOperator* next)
+{
+    MemoryContext* cxt = ctx->cxt;
+    PhysicalTopK* t = memoryContext_alloc_zero(cxt, sizeof(PhysicalTopK));
+    if (!t) return NULL;
+    t->base.vtable = (PhysicalOperatorVTable*)&physical_topk_vtable;
+    t->base.type = PHYSICAL_TOPK;
+    t->base.next = next;
+    t->cond = *cond;
+    t->k = k;
+    t->ncols = ncols;
+    usize cap = k > 0 ? k : 1;
+    t->heap = memoryContext_alloc(cxt, cap * sizeof(usize));
+    t->dist = memoryContext_alloc(cxt, cap * sizeof(f32));
+    t->heap_ctid = memoryContext_alloc(cxt, cap * sizeof(ItemPtr));
+    t->emb_ctid = memoryContext_alloc(cxt, cap * sizeof(ItemPtr));
+    t->vec = memoryContext_alloc(cxt, cap * sizeof(const f32*));
+    t->null_bits = memoryContext_alloc(cxt, cap * sizeof(u64));
+    t->vals = ncols > 0 ? memoryContext_alloc(cxt, ncols * cap * sizeof(Datum)) : NULL;
+    t->out = ExecChunk_create(cxt, ncols);
+    if (!t->heap || !t->dist || !t->heap_ctid || !t->emb_ctid || !t->vec || !t->null_bits ||
+        (ncols > 0 && !t->vals) || !t->out)
+        return NULL;
+    return t;
+}
+
+/* ================= 投影 ================= */
+
+// 按选择向量把选中的列压实到输出批
+static ExecStatus physicalProjection_push(PhysicalOperator* op, ExecChunk* chunk)
+{
+    PhysicalProjection* proj = (PhysicalProjection*)op;
+    ExecChunk* out = proj->out;
+    usize rows = execChunk_rows(chunk);
+    usize* sel = chunk->has_sel ? chunk->sel : NULL;
+    for (usize i = 0; i < proj->ncols; i++)
+    {
+        if (proj->cols[i] >= execChunk_ncols(chunk)) return EXEC_ERROR;
+    }
+
+    execChunk_reset(out);
+    for (usize i = 0; i < proj->ncols; i++)
+        copy_fn((data_ptr_t)execChunk_col(chunk, proj->cols[i]), (data_ptr_t)execChunk_col(out, i),
+                0, rows, sizeof(Datum), sel);
+    copy_fn((data_ptr_t)chunk->heap_ctid, (data_ptr_t)out->heap_ctid, 0, rows, sizeof(ItemPtr), sel);
+    copy_fn((data_ptr_t)chunk->emb_ctid, (data_ptr_t)out->emb_ctid, 0, rows, sizeof(ItemPtr), sel);
+    copy_fn((data_ptr_t)chunk->vec, (data_ptr_t)out->vec, 0, rows, sizeof(const f32*), sel);
+    copy_fn((data_ptr_t)chunk->dist, (data_ptr_t)out->dist, 0, rows, sizeof(f32), sel);
+    for (usize j = 0; j < rows; j++)
+    {
+        u64 in = chunk->null_bits[execChunk_row(chunk, j)];
+        u64 bits = 0;
+        for (usize i = 0; i < proj->ncols; i++) bits |= ((in >> proj->cols[i]) & 1) << i;
+        out->null_bits[j] = bits;
+    }
+    execChunk_set_count(out, rows);
+    out->dim = chunk->dim;
+    return VCALL(op->next, push, out);
+}
+
+static const PhysicalOperatorVTable physical_projection_vtable = {
+    .push = physicalProjection_push,
+    .finalize = physicalOperator_finalize_next,
+};
+
+PhysicalProjection* PhysicalProjection_create(ExecContext* ctx, const u16* cols, usize ncols,
+                                              PhysicalOperator* next)
+{
+    if (ncols > HEAP_MAX_COLS) return NULL;
+    PhysicalProjection* proj = memoryContext_alloc_zero(ctx->cxt, sizeof(PhysicalProjection));
+    if (!proj) return NULL;
+    proj->base.vtable = (PhysicalOperatorVTable*)&physical_projection_vtable;
+    proj->base.type = PHYSICAL_PROJECTION;
+    proj->base.next = next;
+    if (ncols > 0)
+    {
+        proj->cols = memoryContext_alloc(ctx->cxt, ncols * sizeof(u16));
+        if (!proj->cols) return NULL;
+        memcpy(proj->cols, cols, ncols * sizeof(u16));
+    }
+    proj->ncols = ncols;
+    proj->out = ExecChunk_create(ctx->cxt, ncols);
+    return proj->out ? proj : NULL;
+}
+
+/* ================= limit ================= */
+
+static ExecStatus physicalLimit_push(PhysicalOperator* op, ExecChunk* chunk)
+{
+    PhysicalLimit* lim = (PhysicalLimit*)op;
+    usize end = lim->offset + lim->limit;
+    if (lim->seen >= end) return EXEC_FINISHED;
+
+    usize rows = execChunk_rows(chunk);
+    usize skip = lim->seen < lim->offset ? lim->offset - lim->seen : 0;
+    if (skip > rows) skip = rows;
+    usize emitted = lim->seen > lim->offset ? lim->seen - lim->offset : 0;
+    usize take = rows - skip;
+    if (take > lim->limit - emitted) take = lim->limit - emitted;
+    lim->seen += skip + take;
+
+    ExecStatus st = EXEC_CONTINUE;
+    if (take > 0)
+    {
+        execChunk_materialize_sel(chunk);
+        if (skip > 0) memmove(chunk->sel, chunk->sel + skip, take * sizeof(usize));
+        chunk->sel_count = take;
+        st = VCALL(op->next, push, chunk);
+    }
+    if (st == EXEC_CONTINUE && lim->seen >= end) st = EXEC_FINISHED;
+    return st;
+}
+
+static const PhysicalOperatorVTable physical_limit_vtable = {
+    .push = physicalLimit_push,
+    .finalize = physicalOperator_finalize_next,
+};
+
+PhysicalLimit* PhysicalLimit_create(ExecContext* ctx, usize limit, usize offset,
+                                    PhysicalOperator* next)
+{
+    PhysicalLimit* lim = memoryContext_alloc_zero(ctx->cxt, sizeof(PhysicalLimit));
+    if (!lim) return NULL;
+    lim->base.vtable = (PhysicalOperatorVTable*)&physical_limit_vtable;
+    lim->base.type = PHYSICAL_LIMIT;
+    lim->base.next = next;
+    lim->limit = limit;
+    lim->offset = offset;
+    return lim;
+}
+
+/* ================= 汇点 ================= */
+
+static ExecStatus physicalCollect_push(PhysicalOperator* op, ExecChunk* chunk)
+{
+    PhysicalCollect* col = (PhysicalCollect*)op;
+    usize rows = execChunk_rows(chunk);
+    usize ncols = execChunk_ncols(chunk);
+    for (usize i = 0; i < rows && col->count < col->cap; i++)
+    {
+        usize r = execChunk_row(chunk, i);
+        TableQueryResult* res = &col->results[col->count];
+        Datum* vals = NULL;
+        if (ncols > 0)
+        {
+            vals = memoryContext_alloc(col->ctx->cxt, ncols * sizeof(Datum));
+            if (!vals) return EXEC_ERROR;
+            for (usize c = 0; c < ncols; c++) vals[c] = execChunk_col(chunk, c)[r];
+        }
+        res->heap_ctid = chunk->heap_ctid[r];
+        res->emb_ctid = chunk->emb_ctid[r];
+        res->payloads = vals;
+        res->distance = chunk->dist[r];
+        res->vector.type = TYPE_FLOAT32;
+        res->vector.count = chunk->vec[r] ? chunk->dim : 0;
+        res->vector.data = (data_ptr_t)chunk->vec[r];
+        col->count++;
+    }
+    return col->count == col->cap ? EXEC_FINISHED : EXEC_CONTINUE;
+}
+
+static ExecStatus physicalCollect_finalize(PhysicalOperator* op)
+{
+    (void)op;
+    return EXEC_CONTINUE;
+}
+
+static const PhysicalOperatorVTable physical_collect_vtable = {
+    .push = physicalCollect_push,
+    .finalize = physicalCollect_finalize,
+};
+
+PhysicalCollect* PhysicalCollect_create(ExecContext* ctx, TableQueryResult* results, usize cap)
+{
+    PhysicalCollect* col = memoryContext_alloc_zero(ctx->cxt, sizeof(PhysicalCollect));
+    if (!col) return NULL;
+    col->base.vtable = (PhysicalOperatorVTable*)&physical_collect_vtable;
+    col->base.type = PHYSICAL_COLLECT;
+    col->base.next = NULL;
+    col->ctx = ctx;
+    col->results = results;
+    col->cap = cap;
+    return col;
+}
+
+/* ================= 扫描 ================= */
+
+PhysicalTableScan* PhysicalTableScan_create(ExecContext* ctx, DataTable* table, const u16* col_ids,
+                                            usize ncols)
+{
+    HeapStore* heap;
+    EmbeddingStore* emb = NULL;
+    switch (table->table->type)
+    {
+        case TABLE_AM_ROUTINE_EMBEDDING:
+        {
+            EmbeddingHeapTable* et = (EmbeddingHeapTable*)table->table;
+            heap = &et->heap_table.store;
+            emb = &et->embed_store;
+            break;
+        }
+        case TABLE_AM_ROUTINE_ROW:
+            heap = &((HeapTable*)table->table)->store;
+            break;
+        default:
+            return NULL;
+    }
+    u64 want = 0;
+    for (usize i = 0; i < ncols; i++)
+    {
+        if (col_ids[i] >= heap->desc.natts) return NULL;
+        want |= (u64)1 << col_ids[i];
+    }
+
+    PhysicalTableScan* scan = memoryContext_alloc_zero(ctx->cxt, sizeof(PhysicalTableScan));
+    if (!scan) return NULL;
+    scan->ctx = ctx;
+    scan->table = table;
+    scan->heap = heap;
+    scan->emb = emb;
+    if (ncols > 0)
+    {
+        scan->col_ids = memoryContext_alloc(ctx->cxt, ncols * sizeof(u16));
+        if (!scan->col_ids) return NULL;
+        memcpy(scan->col_ids, col_ids, ncols * sizeof(u16));
+    }
+    scan->ncols = ncols;
+    scan->want = want;
+    scan->out = ExecChunk_create(ctx->cxt, ncols);
+    return scan->out ? scan : NULL;
+}
+
+static ExecStatus physicalTableScan_flush(PhysicalTableScan* scan, PhysicalOperator* head)
+{
+    ExecChunk* out = scan->out;
+    execChunk_set_count(out, out->count);
+    ExecStatus st = VCALL(head, push, out);
+    execChunk_reset(out);
+    return st;
+}
+
+int physicalTableScan_run(PhysicalTableScan* scan, PhysicalOperator* head)
+{
+    ExecContext* ctx = scan->ctx;
+    HeapStore* hs = scan->heap;
+    if (LockRelation(scan->table->relid, AccessShareLock) == LOCKACQUIRE_DEADLOCK) return -1;
+
+    Snapshot* snap = ctx->snapshot;
+    Snapshot* own_snap = NULL;
+    if (!snap && hs->txn_mgr)
+    {
+        snap = own_snap = transactionManager_get_snapshot(hs->txn_mgr, 0);
+        if (!snap)
+        {
+            UnlockRelation(scan->table->relid, AccessShareLock);
+            return -1;
+        }
+    }
+
+    ExecChunk* out = scan->out;
+    execChunk_reset(out);
+    out->dim = scan->emb ? (usize)scan->emb->dimension : 0;
+    ExecStatus st = EXEC_CONTINUE;
+    Datum row[HEAP_MAX_COLS];
+
+    /* 批内值都拷贝出页面（varlena 进查询上下文），迭代器仍然只持有当前页的共享闩锁 */
+    HeapStoreIter iter;
+    heapStoreIter_begin_snapshot(&iter, hs, snap);
+    const TupleHdr* hdr;
+    while (st == EXEC_CONTINUE && (hdr = heapStoreIter_next(&iter)) != NULL)
+    {
+        /* 快照迭代器已过滤不可见元组；all-visible 页上的元组必然存活 */
+        if (!snap && !iter.page_all_visible && hdr->t_xmax != INVALID_TXN_ID) continue;
+        const f32* vec = NULL;
+        if (scan->emb)
+        {
+            if (!item_ptr_is_valid(hdr->t_emb_ctid)) continue;
+            vec = embedding_store_get_ptr_ctid(scan->emb, hdr->t_emb_ctid);
+            if (!vec) continue;
+        }
+        if (scan->want && tupleDesc_deform_ex(&hs->desc, iter.curr_col_data, hdr->null_bits,
+                                              scan->want, row, VARLENA_COPY_ARENA, ctx->cxt) != 0)
+        {
+            st = EXEC_ERROR;
+            break;
+        }
+
+        usize r = out->count;
+        u64 nulls = 0;
+        for (usize i = 0; i < scan->ncols; i++)
+        {
+            execChunk_col(out, i)[r] = row[scan->col_ids[i]];
+            nulls |= ((hdr->null_bits >> scan->col_ids[i]) & 1) << i;
+        }
+        out->heap_ctid[r] = heapStoreIter_ctid(&iter);
+        out->emb_ctid[r] = scan->emb ? hdr->t_emb_ctid : INVALID_ITEM_PTR;
+        out->vec[r] = vec;
+        out->dist[r] = 0;
+        out->null_bits[r] = nulls;
+        out->count++;
+        scan->rows_scanned++;
+        if (out->count == STANDARD_VECTOR_SIZE) st = physicalTableScan_flush(scan, head);
+    }
+    heapStoreIter_end(&iter);
+
+    if (st == EXEC_CONTINUE && out->count > 0) st = physicalTableScan_flush(scan, head);
+    if (st != EXEC_ERROR) st = VCALL(head, finalize);
+
+    if (own_snap) transactionManager_release_snapshot(hs->txn_mgr, own_snap);
+    UnlockRelation(scan->table->relid, AccessShareLock);
+    return st == EXEC_ERROR ? -1 : 0;
+}
+
+/* ================= 索引扫描 ================= */
+
+PhysicalIndexScan* PhysicalIndexScan_create(ExecContext* ctx, DataTable* table, VectorIndex* index,
+                                            const f32* query, usize probe_k, const u16* col_ids,
+                                            usize ncols, const ExecPredicate* preds, usize npreds)
+{
+    if (table->table->type != TABLE_AM_ROUTINE_EMBEDDING || !index || !query) return NULL;
+    if (npreds > 0 && !index->vtable->search_filtered) return NULL;
+    if (!exec_predicates_supported(preds, npreds)) return NULL;
+    EmbeddingHeapTable* et = (EmbeddingHeapTable*)table->table;
+    HeapStore* hs = &et->heap_table.store;
+    u64 want = 0;
+    for (usize i = 0; i < ncols; i++)
+    {
+        if (col_ids[i] >= hs->desc.natts) return NULL;
+        want |= (u64)1 << col_ids[i];
+    }
+    for (usize p = 0; p < npreds; p++)
+    {
+        if (preds[p].col >= ncols) return NULL;
+    }
+
+    PhysicalIndexScan* scan = memoryContext_alloc_zero(ctx->cxt, sizeof(PhysicalIndexScan));
+    if (!scan) return NULL;
+    scan->ctx = ctx;
+    scan->table = table;
+    scan->et = et;
+    scan->index = index;
+    scan->query = query;
+    scan->probe_k = probe_k;
+    if (ncols > 0)
+    {
+        scan->col_ids = memoryContext_alloc(ctx->cxt, ncols * sizeof(u16));
+        if (!scan->col_ids) return NULL;
+        memcpy(scan->col_ids, col_ids, ncols * sizeof(u16));
+    }
+    scan->ncols = ncols;
+    scan->want = want;
+    if (npreds > 0)
+    {
+        scan->preds = memoryContext_alloc(ctx->cxt, npreds * sizeof(ExecPredicate));
+        scan->probe = ExecChunk_create(ctx->cxt, ncols);
+        if (!scan->preds || !scan->probe) return NULL;
+        memcpy(scan->preds, preds, npreds * sizeof(ExecPredicate));
+    }
+    scan->npreds = npreds;
+    scan->out = ExecChunk_create(ctx->cxt, ncols);
+    return scan->out ? scan : NULL;
+}
+
+/*
+ * search_filtered 的回调：沿 HOT 链回表取快照可见的版本，解码谓词列（都是定宽列，
+ * 按引用解码不拷贝），装进单行批后复用批过滤求值。调用时持有索引共享锁，这里只加页共享闩锁。
+ */
+static bool physicalIndexScan_accept(u64 heap_ctid_packed, void* arg)
+{
+    PhysicalIndexScan* scan = arg;
+    HeapTupleRef ref;
+    HeapStore* hs = &scan->et->heap_table.store;
+    scan->rows_fetched++;
+    if (heapStore_fetch_visible(hs, item_ptr_unpack(heap_ctid_packed), scan->snap, &ref, NULL) != 0)
+        return false;
+    u64 pred_want = 0;
+    for (usize p = 0; p < scan->npreds; p++)
+        pred_want |= (u64)1 << scan->col_ids[scan->preds[p].col];
+    Datum row[HEAP_MAX_COLS];
+    ExecChunk* probe = scan->probe;
+    execChunk_reset(probe);
+    bool ok = heapStore_deform_cols_byref(&ref, pred_want, row) == 0;
+    if (ok)
+    {
+        u64 nulls = 0;
+        for (usize p = 0; p < scan->npreds; p++)
+        {
+            u16 c = scan->preds[p].col;
+            execChunk_col(probe, c)[0] = row[scan->col_ids[c]];
+            nulls |= ((ref.hdr->null_bits >> scan->col_ids[c]) & 1) << c;
+        }
+        probe->null_bits[0] = nulls;
+        execChunk_set_count(probe, 1);
+        ok = exec_filter_rows(scan->preds, scan->npreds, probe) == 1;
+    }
+    heapStore_release_ref(&ref);
+    return ok;
+}
+
+int physicalIndexScan_run(PhysicalIndexScan* scan, PhysicalOperator* head)
+{
+    ExecContext* ctx = scan->ctx;
+    EmbeddingHeapTable* et = scan->et;
+    HeapStore* hs = &et->heap_table.store;
+    EmbeddingStore* es = &et->embed_store;
+    if (LockRelation(scan->table->relid, AccessShareLock) == LOCKACQUIRE_DEADLOCK) return -1;
+
+    Snapshot* own_snap = NULL;
+    scan->snap = ctx->snapshot;
+    if (!scan->snap && hs->txn_mgr)
+    {
+        scan->snap = own_snap = transactionManager_get_snapshot(hs->txn_mgr, 0);
+        if (!scan->snap)
+        {
+            UnlockRelation(scan->table->relid, AccessShareLock);
+            return -1;
+        }
+    }
+
+    usize cap = scan->probe_k > 0 ? scan->probe_k : 1;
+    SearchResult* hits = memoryContext_alloc(ctx->cxt, cap * sizeof(SearchResult));
+    ExecStatus st = hits ? EXEC_CONTINUE : EXEC_ERROR;
+    usize nhits = 0;
+    if (hits && scan->probe_k > 0)
+    {
+        LWLockAcquire(&et->index_lock, LW_SHARED);
+        nhits = scan->npreds > 0
+                    ? VCALL(scan->index, search_filtered, scan->query, scan->probe_k,
+                            physicalIndexScan_accept, scan, hits)
+                    : VCALL(scan->index, search, scan->query, scan->probe_k, hits);
+        LWLockRelease(&et->index_lock);
+    }
+
+    /* 按索引返回的顺序回表；批内值拷贝出页面后立即释放页闩锁 */
+    ExecChunk* out = scan->out;
+    execChunk_reset(out);
+    out->dim = (usize)es->dimension;
+    Datum row[HEAP_MAX_COLS];
+    for (usize i = 0; i < nhits && st == EXEC_CONTINUE; i++)
+    {
+        ItemPtr heap_ctid = item_ptr_unpack(hits[i].heap_ctid_packed);
+        HeapTupleRef ref;
+        scan->rows_fetched++;
+        /* 索引项指向 HOT 链根，输出链上可见成员的 ctid */
+        if (heapStore_fetch_visible(hs, heap_ctid, scan->snap, &ref, &heap_ctid) != 0) continue;
+        const TupleHdr* hdr = ref.hdr;
+        ItemPtr emb_ctid = hdr->t_emb_ctid;
+        u64 null_bits = hdr->null_bits;
+        const f32* vec = NULL;
+        bool ok = item_ptr_is_valid(emb_ctid) &&
+                  (vec = embedding_store_get_ptr_ctid(es, emb_ctid)) != NULL;
+        if (ok && scan->want &&
+            tupleDesc_deform_ex(&hs->desc, ref.col_data, null_bits, scan->want, row,
+                                VARLENA_COPY_ARENA, ctx->cxt) != 0)
+            st = EXEC_ERROR;
+        heapStore_release_ref(&ref);
+        if (!ok || st == EXEC_ERROR) continue;
+
+        usize r = out->count;
+        u64 nulls = 0;
+        for (usize c = 0; c < scan->ncols; c++)
+        {
+            execChunk_col(out, c)[r] = row[scan->col_ids[c]];
+            nulls |= ((null_bits >> scan->col_ids[c]) & 1) << c;
+        }
+        out->heap_ctid[r] = heap_ctid;
+        out->emb_ctid[r] = emb_ctid;
+        out->vec[r] = vec;
+        out->dist[r] = hits[i].distance;
+        out->null_bits[r] = nulls;
+        out->count++;
+        scan->rows_returned++;
+        if (out->count == STANDARD_VECTOR_SIZE)
+        {
+            execChunk_set_count(out, out->count);
+            st = VCALL(head, push, out);
+            execChunk_reset(out);
+        }
+    }
+    if (st == EXEC_CONTINUE && out->count > 0)
+    {
+        execChunk_set_count(out, out->count);
+        st = VCALL(head, push, out);
+    }
+    if (st != EXEC_ERROR) st = VCALL(head, finalize);
+
+    if (own_snap) transactionManager_release_snapshot(hs->txn_mgr, own_snap);
+    scan->snap = NULL;
+    UnlockRelation(scan->table->relid, AccessShareLock);
+    return st == EXEC_ERROR ? -1 : 0;
+}
@@ -1,4 +1,270 @@
 #ifndef EXECUTOR_H
 #define EXECUTOR_H
 
-#endif
\ No newline at end of file
+#include "vb_type.h"
+#include "interface.h"
+#include "memctx.h"
+#include "table.h"
+
+/**
+ * executor.h — 推式（push-based）向量化执行器
+ *
+ * 一条查询编成一条流水线：源头 PhysicalTableScan 每次从表里解码至多
+ * STANDARD_VECTOR_SIZE 行装进 ExecChunk，推给第一个算子；每个算子整批处理后
+ * 继续往下推，直到汇点 PhysicalCollect 把行写进调用方的 TableQueryResult 数组。
+ *
+ *   scan ──► filter ──► topk ──► project ──► limit ──► collect
+ *
+ * 源头也可以是 PhysicalIndexScan：先向挂载的向量索引要候选，再按 heap ctid 回表
+ * 解码成批，下游算子不区分两种来源。
+ *
+ * 过滤不搬数据，只收缩批上的选择向量（sel）；压实推迟到 top-k / 投影物化时，
+ * 用 copy_fn 按选择向量一次完成。top-k 是阻塞算子：push 只维护候选堆，
+ * finalize 时按距离排好序再分批推出。下游返回 EXEC_FINISHED（例如 limit 已满）
+ * 时扫描提前结束。
+ *
+ * 算子、批缓冲、top-k 候选、varlena 拷贝和结果 payload 都从 ExecContext.cxt
+ * 分配，查询结束删除 / 重置这个上下文即整体释放，算子没有单独的 destroy。
+ * 一条流水线只在一个线程里运行。
+ */
+
+typedef enum
+{
+    EXEC_ERROR = -1,
+    EXEC_CONTINUE = 0,  // 继续推送
+    EXEC_FINISHED = 1,  // 下游不再需要数据
+} ExecStatus;
+
+typedef struct
+{
+    MemoryContext* cxt;  // 查询级上下文
+    Snapshot* snapshot;  // 可选；为 NULL 且表挂了事务管理器时，扫描自取一个快照
+} ExecContext;
+
+/*
+ * 算子间传递的批。data 是 COLUMN 模式的 DataChunk：arrays[i] 是第 i 个输出列，
+ * 每行一个 Datum（以 TYPE_INT64 承载）。其余逐行数组与物理行号对齐。
+ * has_sel 为 false 时选择向量是恒等映射 [0, count)。
+ */
+typedef struct
+{
+    DataChunk data;
+    usize count;                             // 物理行数
+    usize dim;                               // 向量维数（纯 heap 表为 0）
+    bool has_sel;
+    usize sel_count;
+    usize sel[STANDARD_VECTOR_SIZE];         // 存活行的物理行号，升序
+    ItemPtr heap_ctid[STANDARD_VECTOR_SIZE];
+    ItemPtr emb_ctid[STANDARD_VECTOR_SIZE];
+    const f32* vec[STANDARD_VECTOR_SIZE];    // 指向 embedding 存储；纯 heap 表为 NULL
+    f32 dist[STANDARD_VECTOR_SIZE];          // 经过 top-k 后有效
+    u64 null_bits[STANDARD_VECTOR_SIZE];     // bit i：第 i 个输出列为 NULL
+} ExecChunk;
+
+// 在 cxt 中分配一个 ncols 列的空批
+ExecChunk* ExecChunk_create(MemoryContext* cxt, usize ncols);
+
+void execChunk_reset(ExecChunk* chunk);
+
+static inline usize execChunk_ncols(const ExecChunk* chunk)
+{
+    return chunk->data.count;
+}
+
+static inline Datum* execChunk_col(ExecChunk* chunk, usize col)
+{
+    return (Datum*)chunk->data.arrays[col].data;
+}
+
+// 选择后的行数
+static inline usize execChunk_rows(const ExecChunk* chunk)
+{
+    return chunk->has_sel ? chunk->sel_count : chunk->count;
+}
+
+// 第 i 个被选中行的物理行号
+static inline usize execChunk_row(const ExecChunk* chunk, usize i)
+{
+    return chunk->has_sel ? chunk->sel[i] : i;
+}
+
+typedef enum
+{
+    PHYSICAL_FILTER = 0,
+    PHYSICAL_TOPK,
+    PHYSICAL_PROJECTION,
+    PHYSICAL_LIMIT,
+    PHYSICAL_COLLECT,
+    PHYSICAL_ANALYZE,  // optimizer.c 的统计采样汇点
+} PhysicalOperatorType;
+
+// clang-format off
+DEFINE_CLASS(PhysicalOperator,
+    VMETHOD(PhysicalOperator, push, ExecStatus, ExecChunk* chunk)
+    VMETHOD(PhysicalOperator, finalize, ExecStatus)
+    ,
+    FIELD(type, PhysicalOperatorType)
+    FIELD(next, PhysicalOperator*)
+)
+// clang-format on
+
+/* ---------------- 过滤 ---------------- */
+
+typedef enum
+{
+    EXEC_CMP_EQ = 0,
+    EXEC_CMP_NE,
+    EXEC_CMP_LT,
+    EXEC_CMP_LE,
+    EXEC_CMP_GT,
+    EXEC_CMP_GE,
+    EXEC_CMP_IS_NULL,
+    EXEC_CMP_NOT_NULL,
+} ExecCompareOp;
+
+// col 是批内列号；只支持定宽类型（BOOL / I32 / I64 / F32 / F64）。NULL 值只满足 IS_NULL
+typedef struct
+{
+    u16 col;
+    TupleColType type;
+    ExecCompareOp op;
+    Datum value;
+} ExecPredicate;
+
+typedef struct
+{
+    EXTENDS(PhysicalOperator);
+    ExecPredicate* preds;  // 合取
+    usize npreds;
+} PhysicalFilter;
+
+// 谓词类型不支持时返回 NULL
+PhysicalFilter* PhysicalFilter_create(ExecContext* ctx, const ExecPredicate* preds, usize npreds,
+                                      PhysicalOperator* next);
+
+/* ---------------- 向量 top-k ---------------- */
+
+typedef struct
+{
+    EXTENDS(PhysicalOperator);
+    VectorCondition cond;
+    usize k;
+    usize ncols;
+    usize size;            // 当前候选数
+    usize* heap;           // 候选槽号组成的最大堆（按距离）
+    f32* dist;             // 以下按槽号索引
+    ItemPtr* heap_ctid;
+    ItemPtr* emb_ctid;
+    const f32** vec;
+    u64* null_bits;
+    Datum* vals;           // 列优先：第 c 列槽 s 在 vals[c * k + s]
+    ExecChunk* out;
+} PhysicalTopK;
+
+// 计算每行到 cond.query 的距离，保留最近的 k 行，finalize 时按距离升序输出
+PhysicalTopK* PhysicalTopK_create(ExecContext* ctx, const VectorCondition* cond, usize k,
+                                  usize ncols, PhysicalOperator* next);
+
+/* ---------------- 投影 ---------------- */
+
+typedef struct
+{
+    EXTENDS(PhysicalOperator);
+    u16* cols;  // 输出列 i = 输入列 cols[i]
+    usize ncols;
+    ExecChunk* out;
+} PhysicalProjection;
+
+PhysicalProjection* PhysicalProjection_create(ExecContext* ctx, const u16* cols, usize ncols,
+                                              PhysicalOperator* next);
+
+/* ---------------- limit ---------------- */
+
+typedef struct
+{
+    EXTENDS(PhysicalOperator);
+    usize limit;
+    usize offset;
+    usize seen;  // 已经过的行数（含被 offset 跳过的）
+} PhysicalLimit;
+
+PhysicalLimit* PhysicalLimit_create(ExecContext* ctx, usize limit, usize offset,
+                                    PhysicalOperator* next);
+
+/* ---------------- 汇点 ---------------- */
+
+typedef struct
+{
+    EXTENDS(PhysicalOperator);
+    ExecContext* ctx;
+    TableQueryResult* results;
+    usize cap;
+    usize count;
+} PhysicalCollect;
+
+// payloads 数组按批的列顺序填写，从 ctx->cxt 分配；写满 cap 后返回 EXEC_FINISHED
+PhysicalCollect* PhysicalCollect_create(ExecContext* ctx, TableQueryResult* results, usize cap);
+
+/* ---------------- 扫描（源头） ---------------- */
+
+typedef struct
+{
+    ExecContext* ctx;
+    DataTable* table;
+    HeapStore* heap;
+    EmbeddingStore* emb;  // 纯 heap 表为 NULL
+    u16* col_ids;         // 输出列 i = heap 列 col_ids[i]
+    usize ncols;
+    u64 want;             // col_ids 的位图
+    ExecChunk* out;
+    u64 rows_scanned;     // 解码过的可见行数
+} PhysicalTableScan;
+
+// 支持 HeapTable 和 EmbeddingHeapTable；col_ids 越界或表类型不支持时返回 NULL
+PhysicalTableScan* PhysicalTableScan_create(ExecContext* ctx, DataTable* table, const u16* col_ids,
+                                            usize ncols);
+
+/*
+ * 持表的 AccessShare 锁扫描全表，把批推给 head，扫描结束（或下游返回 EXEC_FINISHED）
+ * 后依次调用整条链的 finalize。成功返回 0，加锁失败或算子出错返回 -1。
+ */
+int physicalTableScan_run(PhysicalTableScan* scan, PhysicalOperator* head);
+
+/* ---------------- 索引扫描（源头） ---------------- */
+
+typedef struct
+{
+    ExecContext* ctx;
+    DataTable* table;
+    EmbeddingHeapTable* et;
+    VectorIndex* index;
+    const f32* query;
+    usize probe_k;         // 向索引要的候选数
+    u16* col_ids;          // 输出列 i = heap 列 col_ids[i]
+    usize ncols;
+    u64 want;
+    ExecPredicate* preds;  // 非空时走 search_filtered，col 是输出批内列号
+    usize npreds;
+    ExecChunk* out;
+    ExecChunk* probe;      // 遍历时过滤用的单行批
+    Snapshot* snap;        // 运行期间有效
+    u64 rows_fetched;      // 回表次数（含过滤回调）
+    u64 rows_returned;     // 推给下游的行数
+} PhysicalIndexScan;
+
+/*
+ * 只支持 EmbeddingHeapTable，index 须已挂在表上。preds 非空时 index 必须实现
+ * search_filtered，谓词在索引遍历中逐候选求值；为空时是普通 top-probe_k 搜索。
+ * 参数不合法时返回 NULL。
+ */
+PhysicalIndexScan* PhysicalIndexScan_create(ExecContext* ctx, DataTable* table, VectorIndex* index,
+                                            const f32* query, usize probe_k, const u16* col_ids,
+                                            usize ncols, const ExecPredicate* preds, usize npreds);
+
+/*
+ * 持 AccessShare 表锁和索引共享锁搜索，按结果顺序回表（跳过对快照不可见的行）推给
+ * head，最后依次 finalize。成功返回 0，失败返回 -1。
+ */
+int physicalIndexScan_run(PhysicalIndexScan* scan, PhysicalOperator* head);
+
+#endif
@@ -0,0 +1,92 @@
+#include <stdlib.h>
+#include <string.h>
+#include "freespace.h"
+
+static u8 fsm_category(usize free_bytes)
+{
+    usize cat = free_bytes / FSM_CAT_STEP;
+    return (u8)(cat >= FSM_CATEGORIES ? FSM_CATEGORIES - 1 : cat);
+}
+
+/* Smallest category whose pages are guaranteed to hold `needed` bytes. */
+static usize fsm_needed_category(usize needed)
+{
+    return (needed + FSM_CAT_STEP - 1) / FSM_CAT_STEP;
+}
+
+void FreeSpaceMap_init(FreeSpaceMap* fsm)
+{
+    fsm->nleaves = 1;
+    fsm->npages = 0;
+    fsm->nodes = calloc(2, sizeof(u8));
+}
+
+void FreeSpaceMap_deinit(FreeSpaceMap* fsm)
+{
+    free(fsm->nodes);
+    fsm->nodes = NULL;
+    fsm->nleaves = 0;
+    fsm->npages = 0;
+}
+
+/* Double the leaf capacity until page_no fits; rebuild inner nodes bottom-up. */
+static void freeSpaceMap_grow(FreeSpaceMap* fsm, u32 page_no)
+{
+    u32 nleaves = fsm->nleaves;
+    while (page_no >= nleaves) nleaves <<= 1;
+    u8* nodes = calloc(2 * (usize)nleaves, sizeof(u8));
+    memcpy(nodes + nleaves, fsm->nodes + fsm->nleaves, fsm->nleaves);
+    for (u32 i = nleaves - 1; i >= 1; i--)
+    {
+        nodes[i] = MAX(nodes[2 * i], nodes[2 * i + 1]);
+    }
+    free(fsm->nodes);
+    fsm->nodes = nodes;
+    fsm->nleaves = nleaves;
+}
+
+void freeSpaceMap_set(FreeSpaceMap* fsm, u32 page_no, usize free_bytes)
+{
+    if (page_no >= fsm->nleaves) freeSpaceMap_grow(fsm, page_no);
+    if (page_no >= fsm->npages) fsm->npages = page_no + 1;
+
+    u32 i = fsm->nleaves + page_no;
+    u8 cat = fsm_category(free_bytes);
+    if (fsm->nodes[i] == cat) return;
+    fsm->nodes[i] = cat;
+    // propagate upward; stop as soon as an ancestor is unchanged
+    for (i >>= 1; i >= 1; i >>= 1)
+    {
+        u8 m = MAX(fsm->nodes[2 * i], fsm->nodes[2 * i + 1]);
+        if (fsm->nodes[i] == m) break;
+        fsm->nodes[i] = m;
+    }
+}
+
+u8 freeSpaceMap_get(const FreeSpaceMap* fsm, u32 page_no)
+{
+    if (page_no >= fsm->npages) return 0;
+    return fsm->nodes[fsm->nleaves + page_no];
+}
+
+u32 freeSpaceMap_search(const FreeSpaceMap* fsm, usize needed)
+{
+    usize want = fsm_needed_category(needed);
+    if (want == 0) want = 1; /* category 0 means "no usable space" */
+    if (want >= FSM_CATEGORIES || fsm->nodes[1] < want) return FSM_NOT_FOUND;
+
+    // descend, preferring the left (lower page number) child
+    u32 i = 1;
+    while (i < fsm->nleaves)
+    {
+        i = fsm->nodes[2 * i] >= want ? 2 * i : 2 * i + 1;
+    }
+    u32 page_no = i - fsm->nleaves;
+    return page_no < fsm->npages ? page_no : FSM_NOT_FOUND;
+}
+
+void freeSpaceMap_reset(FreeSpaceMap* fsm)
+{
+    memset(fsm->nodes, 0, 2 * (usize)fsm->nleaves);
+    fsm->npages = 0;
+}
@@ -0,0 +1,50 @@
+/**
+ * freespace.h — per-table Free Space Map (PostgreSQL FSM style)
+ *
+ * Each heap page is summarised by a one-byte category:
+ *     category = free_bytes / FSM_CAT_STEP   (0 = no usable space)
+ * Categories live in the leaves of a complete binary max-tree; every
+ * inner node holds the max of its two children.  Finding a page with at
+ * least N free bytes is a single root-to-leaf descent — O(log pages) —
+ * instead of walking every page and every slot.
+ *
+ * The map is advisory: a hit must be re-checked against the real page,
+ * and callers fix a stale entry with freeSpaceMap_set() on mismatch.
+ * Not serialized — rebuilt from the pages on load.
+ */
+#ifndef FREESPACE_H
+#define FREESPACE_H
+
+#include "vb_type.h"
+#include "storage.h" /* BLOCK_DATA_SIZE */
+
+#define FSM_CATEGORIES 256
+#define FSM_CAT_STEP   (BLOCK_DATA_SIZE / FSM_CATEGORIES) /* 31 bytes per category */
+#define FSM_NOT_FOUND  UINT32_MAX
+
+typedef struct
+{
+    u8* nodes;   /* heap-ordered max-tree: nodes[1] is the root, leaves at [nleaves, 2*nleaves) */
+    u32 nleaves; /* leaf capacity, always a power of two */
+    u32 npages;  /* pages registered so far (leaves beyond are category 0) */
+} FreeSpaceMap;
+
+void FreeSpaceMap_init(FreeSpaceMap* fsm);
+void FreeSpaceMap_deinit(FreeSpaceMap* fsm);
+
+/** Record free_bytes for page_no (grows the map if needed). */
+void freeSpaceMap_set(FreeSpaceMap* fsm, u32 page_no, usize free_bytes);
+
+/** Return the recorded category of page_no (0 if unknown). */
+u8 freeSpaceMap_get(const FreeSpaceMap* fsm, u32 page_no);
+
+/**
+ * Find the lowest-numbered page whose category guarantees at least
+ * `needed` free bytes.  Returns FSM_NOT_FOUND if none.
+ */
+u32 freeSpaceMap_search(const FreeSpaceMap* fsm, usize needed);
+
+/** Forget all pages (categories reset to 0). */
+void freeSpaceMap_reset(FreeSpaceMap* fsm);
+
+#endif
@@ -4,6 +4,10 @@
 #include <string.h>
 #include "hash.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 // https://nullprogram.com/blog/2018/07/31/
 inline static u64 murmurhash32(u32 x)
 {
@@ -81,13 +85,39 @@ int hmap_int_cmp(const void* a, const void* b)
     return (va > vb) - (va < vb);
 }
 
+u32 hmap_u64_hash(const void* key)
+{
+    // 高 32 位也参与哈希，block_id 这类 64 位 key 不会只按低位分桶
+    return (u32)murmurhash64(*(const u64*)key);
+}
+
+int hmap_u64_cmp(const void* a, const void* b)
+{
+    u64 va = *(const u64*)a, vb = *(const u64*)b;
+    return (va > vb) - (va < vb);
+}
+
 u32 hmap_str_hash(const void* key)
 {
+    // 一次吃 8 字节再做 64 位混合，比逐字节 djb2 快，低位分布也均匀
     const char* s = (const char*)key;
-    u32 hash = 5381;
-    int c;
-    while ((c = *s++)) hash = ((hash << 5) + hash) + c;
-    return hash;
+    usize len = strlen(s);
+    u64 h = UINT64_C(0x9e3779b97f4a7c15) ^ len;
+    usize i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        u64 w;
+        memcpy(&w, s + i, 8);
+        h = (h ^ murmurhash64(w)) * UINT64_C(0xff51afd7ed558ccd);
+    }
+    if (i < len)
+    {
+        u64 w = 0;
+        memcpy(&w, s + i, len - i);
+        h = (h ^ murmurhash64(w)) * UINT64_C(0xff51afd7ed558ccd);
+    }
+    h = murmurhash64(h);
+    return (u32)(h ^ (h >> 32));
 }
 
 int hmap_str_cmp(const void* a, const void* b)
@@ -95,37 +125,138 @@ int hmap_str_cmp(const void* a, const void* b)
     return strcmp((const char*)a, (const char*)b);
 }
 
+/* ---- 控制字节 ---- */
+
+#define CTRL_EMPTY   ((u8)0x80)
+#define CTRL_DELETED ((u8)0xFE)
+#define CTRL_IS_FULL(c) (((c) & 0x80) == 0)
+
+#define HMAP_SLAB_NODES 64
+
+typedef struct hmap_slab
+{
+    struct hmap_slab* next;
+} hmap_slab;
+
+// 把用户哈希再混合一次：h1（高位）定起始组，h2（低 7 位）进控制字节
+static inline u64 hmap_mix(const hmap* hm, const void* key)
+{
+    return murmurhash64((u64)hm->hash_func(key) + UINT64_C(0x9e3779b97f4a7c15));
+}
+
+static inline u8 hmap_h2(u64 h)
+{
+    return (u8)(h & 0x7f);
+}
+
+static inline usize hmap_h1(u64 h)
+{
+    return (usize)(h >> 7);
+}
+
+// 一组 16 个控制字节里等于 b 的位置掩码
+static inline u32 group_match(const u8* ctrl, u8 b)
+{
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)b)));
+#else
+    u32 mask = 0;
+    for (int i = 0; i < HMAP_GROUP_WIDTH; i++)
+        if (ctrl[i] == b) mask |= 1u << i;
+    return mask;
+#endif
+}
+
+// 空位或墓碑（最高位为 1）的位置掩码
+static inline u32 group_match_free(const u8* ctrl)
+{
+#ifdef __SSE2__
+    return (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    u32 mask = 0;
+    for (int i = 0; i < HMAP_GROUP_WIDTH; i++)
+        if (!CTRL_IS_FULL(ctrl[i])) mask |= 1u << i;
+    return mask;
+#endif
+}
+
+static inline void hmap_set_ctrl(hmap* hm, usize i, u8 c)
+{
+    hm->ctrl[i] = c;
+    // 尾部 HMAP_GROUP_WIDTH 字节镜像 ctrl[k % nbuckets]，小表也照此重复
+    for (usize k = i; k < HMAP_GROUP_WIDTH; k += hm->nbuckets) hm->ctrl[hm->nbuckets + k] = c;
+}
+
+// 负载上限 3/4，且至少留一个空位保证探测能结束
+static inline usize hmap_max_load(usize nbuckets)
+{
+    usize limit = nbuckets - (nbuckets >> 2);
+    return limit == nbuckets ? limit - 1 : limit;
+}
+
+static usize round_up_pow2(usize n)
+{
+    usize cap = 1;
+    while (cap < n) cap <<= 1;
+    return cap;
+}
+
+static bool hmap_alloc_table(hmap* hm, usize nbuckets)
+{
+    hmap_node** buckets = calloc(nbuckets, sizeof(hmap_node*));
+    u8* ctrl = malloc(nbuckets + HMAP_GROUP_WIDTH);
+    if (!buckets || !ctrl)
+    {
+        free(buckets);
+        free(ctrl);
+        return false;
+    }
+    memset(ctrl, CTRL_EMPTY, nbuckets + HMAP_GROUP_WIDTH);
+    hm->buckets = buckets;
+    hm->ctrl = ctrl;
+    hm->nbuckets = nbuckets;
+    hm->ndeleted = 0;
+    return true;
+}
+
 void hmap_init(hmap* hm, usize key_size, usize value_size, usize nbuckets,
                u32 (*hash_func)(const void* key),
                int (*key_compare)(const void* key1, const void* key2))
 {
     if (!hm) return;
-    hm->buckets = calloc(nbuckets, sizeof(hmap_node*));
-    hm->nbuckets = nbuckets;
-    hm->len = 0;
+    memset(hm, 0, sizeof(*hm));
     hm->key_size = key_size;
     hm->value_size = value_size;
     hm->hash_func = hash_func;
     hm->key_compare = key_compare;
+    hmap_alloc_table(hm, round_up_pow2(nbuckets));
 }
 
 void hmap_deinit(hmap* hm)
 {
     if (!hm) return;
-    for (usize i = 0; i < hm->nbuckets; i++)
+    if (hm->key_size == 0)
     {
-        hmap_node* node = hm->buckets[i];
-        while (node)
-        {
-            hmap_node* next = node->next;
-            free(node);
-            node = next;
-        }
+        for (usize i = 0; i < hm->nbuckets; i++)
+            if (CTRL_IS_FULL(hm->ctrl[i])) free(hm->buckets[i]);
+    }
+    hmap_slab* slab = hm->slabs;
+    while (slab)
+    {
+        hmap_slab* next = slab->next;
+        free(slab);
+        slab = next;
     }
     free(hm->buckets);
+    free(hm->ctrl);
     hm->buckets = NULL;
+    hm->ctrl = NULL;
     hm->nbuckets = 0;
     hm->len = 0;
+    hm->ndeleted = 0;
+    hm->slabs = NULL;
+    hm->free_nodes = NULL;
 }
 
 void hmap_init_str(hmap* hm, usize value_size)
@@ -143,127 +274,198 @@ hmap* hmap_create(usize key_size, usize value_size, usize nbuckets,
     return hmap;
 }
 
-static void hmap_grow(hmap* hmap)
+/* ---- 探测 ---- */
+
+// 返回 key 所在槽位，不存在返回 -1
+static i64 hmap_find_slot(hmap* hm, const void* key, u64 h)
 {
-    usize new_nbuckets = hmap->nbuckets * 2;
-    hmap_node** new_buckets = calloc(new_nbuckets, sizeof(hmap_node*));
-    if (!new_buckets) return;
-    for (usize i = 0; i < hmap->nbuckets; i++)
+    if (hm->nbuckets == 0) return -1;
+    usize mask = hm->nbuckets - 1;
+    usize pos = hmap_h1(h) & mask;
+    u8 h2 = hmap_h2(h);
+    for (usize step = 0; step <= hm->nbuckets; step += HMAP_GROUP_WIDTH)
     {
-        hmap_node* node = hmap->buckets[i];
-        while (node)
+        const u8* group = hm->ctrl + pos;
+        for (u32 m = group_match(group, h2); m; m &= m - 1)
         {
-            hmap_node* next = node->next;
-            uint32_t hash = hmap->hash_func(node->key);
-            usize new_bucket_index = hash % new_nbuckets;
-            node->next = new_buckets[new_bucket_index];
-            new_buckets[new_bucket_index] = node;
-            node = next;
+            usize slot = (pos + (usize)__builtin_ctz(m)) & mask;
+            if (hm->key_compare(hm->buckets[slot]->key, key) == 0) return (i64)slot;
         }
+        if (group_match(group, CTRL_EMPTY)) return -1;
+        pos = (pos + step + HMAP_GROUP_WIDTH) & mask;
     }
-    free(hmap->buckets);
-    hmap->buckets = new_buckets;
-    hmap->nbuckets = new_nbuckets;
+    return -1;
+}
+
+// 第一个可写入的槽位（空位或墓碑）
+static usize hmap_find_free(hmap* hm, u64 h)
+{
+    usize mask = hm->nbuckets - 1;
+    usize pos = hmap_h1(h) & mask;
+    for (usize step = 0;; step += HMAP_GROUP_WIDTH)
+    {
+        u32 m = group_match_free(hm->ctrl + pos);
+        if (m) return (pos + (usize)__builtin_ctz(m)) & mask;
+        pos = (pos + step + HMAP_GROUP_WIDTH) & mask;
+    }
+}
+
+// 重建槽位数组：墓碑过多时原尺寸重建，否则翻倍。节点本身不动
+static bool hmap_rehash(hmap* hm)
+{
+    usize new_nbuckets = hm->len >= hmap_max_load(hm->nbuckets) / 2 ? hm->nbuckets * 2 : hm->nbuckets;
+    hmap_node** old_buckets = hm->buckets;
+    u8* old_ctrl = hm->ctrl;
+    usize old_nbuckets = hm->nbuckets;
+    if (!hmap_alloc_table(hm, new_nbuckets)) return false;
+    for (usize i = 0; i < old_nbuckets; i++)
+    {
+        if (!CTRL_IS_FULL(old_ctrl[i])) continue;
+        hmap_node* node = old_buckets[i];
+        u64 h = hmap_mix(hm, node->key);
+        usize slot = hmap_find_free(hm, h);
+        hm->buckets[slot] = node;
+        hmap_set_ctrl(hm, slot, hmap_h2(h));
+    }
+    free(old_buckets);
+    free(old_ctrl);
+    return true;
+}
+
+/* ---- 节点分配 ---- */
+
+#define HMAP_ALIGN8(n) (((n) + 7) & ~(usize)7)
+
+static usize hmap_node_stride(const hmap* hm)
+{
+    return sizeof(hmap_node) + HMAP_ALIGN8(hm->key_size) + HMAP_ALIGN8(hm->value_size);
 }
 
 static hmap_node* hmap_alloc_node(hmap* hm, const void* key)
 {
-    usize actual_key_size = hm->key_size > 0 ? hm->key_size : strlen((const char*)key) + 1;
-    usize total = sizeof(hmap_node) + actual_key_size + hm->value_size;
-    hmap_node* node = malloc(total);
-    if (!node) return NULL;
+    hmap_node* node;
+    usize actual_key_size;
+    if (hm->key_size == 0)
+    {
+        // 变长字符串 key 单独分配
+        actual_key_size = strlen((const char*)key) + 1;
+        node = malloc(sizeof(hmap_node) + HMAP_ALIGN8(actual_key_size) + hm->value_size);
+        if (!node) return NULL;
+    }
+    else
+    {
+        actual_key_size = hm->key_size;
+        if (!hm->free_nodes)
+        {
+            usize stride = hmap_node_stride(hm);
+            hmap_slab* slab = malloc(sizeof(hmap_slab) + 8 + stride * HMAP_SLAB_NODES);
+            if (!slab) return NULL;
+            slab->next = hm->slabs;
+            hm->slabs = slab;
+            char* base = (char*)slab + HMAP_ALIGN8(sizeof(hmap_slab));
+            for (usize i = HMAP_SLAB_NODES; i-- > 0;)
+            {
+                hmap_node* n = (hmap_node*)(base + i * stride);
+                n->next = hm->free_nodes;
+                hm->free_nodes = n;
+            }
+        }
+        node = hm->free_nodes;
+        hm->free_nodes = node->next;
+    }
     node->next = NULL;
     node->key = (char*)(node + 1);
-    node->value = (char*)(node + 1) + actual_key_size;
+    node->value = (char*)(node + 1) + HMAP_ALIGN8(actual_key_size);
     memcpy(node->key, key, actual_key_size);
     return node;
 }
 
-hmap_node* hmap_insert(hmap* hmap, const void* key, const void* value)
+static void hmap_free_node(hmap* hm, hmap_node* node)
 {
-    uint32_t hash = hmap->hash_func(key);
-    if (hmap->len >= hmap->nbuckets - (hmap->nbuckets >> 2)) // 75% load factor
+    if (hm->key_size == 0)
     {
-        hmap_grow(hmap);
+        free(node);
+        return;
     }
-    usize bucket_index = hash % hmap->nbuckets;
+    node->next = hm->free_nodes;
+    hm->free_nodes = node;
+}
+
+/* ---- 公开接口 ---- */
+
+hmap_node* hmap_insert(hmap* hmap, const void* key, const void* value)
+{
+    u64 h = hmap_mix(hmap, key);
 
     // 检查键是否已存在，如果存在则更新值
-    hmap_node* existing = hmap->buckets[bucket_index];
-    while (existing)
+    i64 found = hmap_find_slot(hmap, key, h);
+    if (found >= 0)
     {
-        if (hmap->key_compare(existing->key, key) == 0)
-        {
-            memcpy(existing->value, value, hmap->value_size);
-            return existing;
-        }
-        existing = existing->next;
+        hmap_node* existing = hmap->buckets[found];
+        memcpy(existing->value, value, hmap->value_size);
+        return existing;
+    }
+
+    if (hmap->nbuckets == 0 && !hmap_alloc_table(hmap, HMAP_DEFAULT_NBUCKETS)) return NULL;
+    if (hmap->len + hmap->ndeleted + 1 > hmap_max_load(hmap->nbuckets))
+    {
+        if (!hmap_rehash(hmap)) return NULL;
     }
 
     // 键不存在，创建新节点
     hmap_node* node = hmap_alloc_node(hmap, key);
     if (!node) return NULL;
     memcpy(node->value, value, hmap->value_size);
-    node->next = hmap->buckets[bucket_index];
-    hmap->buckets[bucket_index] = node;
+    usize slot = hmap_find_free(hmap, h);
+    if (hmap->ctrl[slot] == CTRL_DELETED) hmap->ndeleted--;
+    hmap->buckets[slot] = node;
+    hmap_set_ctrl(hmap, slot, hmap_h2(h));
     hmap->len++;
     return node;
 }
 
 hmap_node* hmap_get(hmap* hmap, const void* key)
 {
-    uint32_t hash = hmap->hash_func(key);
-    usize bucket_index = hash % hmap->nbuckets;
-    hmap_node* node = hmap->buckets[bucket_index];
-    while (node)
-    {
-        if (hmap->key_compare(node->key, key) == 0) return node;
-        node = node->next;
-    }
-    return NULL;
+    i64 slot = hmap_find_slot(hmap, key, hmap_mix(hmap, key));
+    return slot >= 0 ? hmap->buckets[slot] : NULL;
 }
 
 int hmap_delete(hmap* hmap, const void* key, void* out)
 {
-    uint32_t hash = hmap->hash_func(key);
-    size_t bucket_index = hash % hmap->nbuckets;
-    hmap_node* node = hmap->buckets[bucket_index];
-    hmap_node* prev = NULL;
-
-    while (node)
+    i64 slot = hmap_find_slot(hmap, key, hmap_mix(hmap, key));
+    if (slot < 0) return -1;
+
+    hmap_node* node = hmap->buckets[slot];
+    if (out) memcpy(out, node->value, hmap->value_size);
+    // 槽位前后连续非空的长度 < 组宽时，不会有探测窗口整段越过它，可以直接置空；
+    // 否则必须留墓碑，免得截断别人的探测链
+    usize mask = hmap->nbuckets - 1;
+    bool was_never_full = false;
+    if (hmap->nbuckets >= HMAP_GROUP_WIDTH)
     {
-        if (hmap->key_compare(node->key, key) == 0)
-        {
-            if (out) memcpy(out, node->value, hmap->value_size);
-            if (prev)
-            {
-                prev->next = node->next;
-            }
-            else
-            {
-                hmap->buckets[bucket_index] = node->next;
-            }
-            free(node);
-            hmap->len--;
-            return 0;
-        }
-        prev = node;
-        node = node->next;
+        u32 empty_before = group_match(hmap->ctrl + (((usize)slot - HMAP_GROUP_WIDTH) & mask), CTRL_EMPTY);
+        u32 empty_after = group_match(hmap->ctrl + slot, CTRL_EMPTY);
+        was_never_full = empty_before && empty_after &&
+                         (__builtin_ctz(empty_after) + (__builtin_clz(empty_before) - 16)) < HMAP_GROUP_WIDTH;
     }
-    return -1;
+    if (was_never_full)
+    {
+        hmap_set_ctrl(hmap, (usize)slot, CTRL_EMPTY);
+    }
+    else
+    {
+        hmap_set_ctrl(hmap, (usize)slot, CTRL_DELETED);
+        hmap->ndeleted++;
+    }
+    hmap->buckets[slot] = NULL;
+    hmap_free_node(hmap, node);
+    hmap->len--;
+    return 0;
 }
 
 bool hmap_contains(hmap* hmap, const void* key)
 {
-    uint32_t hash = hmap->hash_func(key);
-    size_t bucket_index = hash % hmap->nbuckets;
-    hmap_node* node = hmap->buckets[bucket_index];
-    while (node)
-    {
-        if (hmap->key_compare(node->key, key) == 0) return true;
-        node = node->next;
-    }
-    return false;
+    return hmap_find_slot(hmap, key, hmap_mix(hmap, key)) >= 0;
 }
 
 void hmap_destroy(hmap* hmap)
@@ -290,21 +492,16 @@ void hmap_iter_init(hmap_iterator* iter, hmap* hmap)
 bool hmap_iter_next(hmap_iterator* iter)
 {
     if (!iter->hmap) return false;
-    if (iter->node)
-    {
-        iter->node = iter->node->next;
-        if (iter->node) return true;
-    }
     while (iter->bucket_idx < iter->hmap->nbuckets)
     {
-        if (iter->hmap->buckets[iter->bucket_idx])
+        usize i = iter->bucket_idx++;
+        if (CTRL_IS_FULL(iter->hmap->ctrl[i]))
         {
-            iter->node = iter->hmap->buckets[iter->bucket_idx];
-            iter->bucket_idx++;
+            iter->node = iter->hmap->buckets[i];
             return true;
         }
-        iter->bucket_idx++;
     }
+    iter->node = NULL;
     return false;
 }
 
@@ -11,25 +11,45 @@ u32 hmap_int_hash(const void* key);
 int hmap_int_cmp(const void* a, const void* b);
 u32 hmap_str_hash(const void* key);
 int hmap_str_cmp(const void* a, const void* b);
+u32 hmap_u64_hash(const void* key);
+int hmap_u64_cmp(const void* a, const void* b);
+
+/**
+ * hmap — Swiss table 风格的开放寻址哈希表
+ *
+ * 每个槽位配一个控制字节：空 / 墓碑 / 哈希值低 7 位 (h2)。查找时一次取 16 个
+ * 控制字节（SSE2 下一条 pcmpeqb），只对 h2 相同的槽位比较 key；探测按 16 槽一组
+ * 三角跳跃，遇到含空位的组即可结束。容量总是 2 的幂，下标用掩码而不是 %。
+ *
+ * 用户给的 hash_func 结果会再经过一次 64 位混合，所以恒等哈希之类的弱哈希也能
+ * 用。节点地址在整个生命周期内不变（insert/get 返回的 hmap_node* 可长期持有，
+ * 扩容只搬槽位里的指针）；定长 key 的节点从 slab 里批量分配，不再每个节点一次 malloc。
+ */
+
+#define HMAP_GROUP_WIDTH 16
 
 typedef struct hmap_node hmap_node;
 
 struct hmap_node
 {
-    hmap_node* next;
+    hmap_node* next; // 仅用于 slab 空闲链表
     void* key;
     void* value;
 };
 
 typedef struct
 {
-    hmap_node** buckets;
-    usize nbuckets;
+    hmap_node** buckets; // 槽位数组，nbuckets 个
+    u8* ctrl;            // 控制字节，nbuckets + HMAP_GROUP_WIDTH 个（尾部镜像开头，组读取不用回绕）
+    usize nbuckets;      // 2 的幂
     usize len; // 当前节点数
+    usize ndeleted;      // 墓碑数，和 len 一起计入负载
     usize key_size;   // 0 表示字符串 key（变长，用 strlen+1）
     usize value_size;
     uint32_t (*hash_func)(const void* key);
     int (*key_compare)(const void* key1, const void* key2);
+    void* slabs;            // 定长节点的 slab 链表
+    hmap_node* free_nodes;  // slab 中回收的节点
 } hmap;
 
 void hmap_init(hmap* hm, usize key_size, usize value_size, usize nbuckets,
@@ -63,7 +83,7 @@ typedef struct hmap_iterator hmap_iterator;
 struct hmap_iterator
 {
     hmap* hmap;
-    usize bucket_idx;
+    usize bucket_idx; // 下一个要检查的槽位
     hmap_node* node;
 };
 
@@ -24,6 +24,12 @@ typedef enum
     INDEX_DISKANN = 3,
 } VectorIndexType;
 
+/*
+ * 遍历时过滤的回调：heap_ctid_packed 对应的行满足查询谓词时返回 true。
+ * 索引在遍历中对每个候选调用它，只有通过的候选进入结果集，被拒的节点仍可用于路由。
+ */
+typedef bool (*IndexFilterFn)(u64 heap_ctid_packed, void* arg);
+
 // clang-format off
 DEFINE_CLASS(VectorIndex,
     VMETHOD(VectorIndex, insert, void, u64 heap_ctid_packed, ItemPtr emb_ctid, const f32* vector)
@@ -32,6 +38,9 @@ DEFINE_CLASS(VectorIndex,
     VMETHOD(VectorIndex, write_blocks, void, BlockManager* bm, MetaBlockWriter* w)
     VMETHOD(VectorIndex, load_blocks, void, BlockManager* bm, MetaBlockReader* r)
     VMETHOD(VectorIndex, destroy, void)
+    /* 可选：为 NULL 表示索引不支持遍历时过滤 */
+    VMETHOD(VectorIndex, search_filtered, usize, const f32* query, usize k, IndexFilterFn filter,
+            void* arg, SearchResult* results)
     ,
     FIELD(type, VectorIndexType)
     FIELD(metric, DistanceType)
@@ -0,0 +1,678 @@
+/**
+ * lmgr.c — RegularLock 锁管理器与死锁检测
+ *
+ * 结构（对应 PG 的 LOCK / PROCLOCK / PGPROC / LOCALLOCK）：
+ *   LOCK       每个被锁对象一个，挂在所属分区的哈希桶上；记录各模式的持有数、
+ *              持有者链表（PROCLOCK）与 FIFO 等待队列，无人持有且无人等待时释放
+ *   PROCLOCK   某线程在某 LOCK 上持有的模式位图
+ *   LockProc   每线程一个，挂在只增不删的全局链表上（线程退出后可复用）；
+ *              含 fast-path 槽位与等待状态
+ *   LocalLock  线程私有的 (tag, mode) → 重入计数表，重复获取不碰共享结构
+ *
+ * 加锁顺序：fpInfoLock → 分区锁。死锁检测按分区下标顺序拿全部分区锁，
+ * 此时不持任何 fpInfoLock。
+ */
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "lock.h"
+
+#define NUM_LOCK_PARTITIONS        16
+#define LOCK_BUCKETS_PER_PARTITION 64
+#define FP_LOCK_SLOTS_PER_PROC     16
+#define FP_LOCK_BITS_PER_SLOT      3 /* AccessShare / RowShare / RowExclusive */
+#define FP_LOCK_STRONG_PARTITIONS  1024
+
+#define PROC_WAIT_OK      0u
+#define PROC_WAIT_WAITING 1u
+
+#define LOCKBIT_RANGE(lo, hi) ((LOCKBIT_ON((hi) + 1) - 1) & ~(LOCKBIT_ON(lo) - 1))
+
+const LOCKMASK LockConflicts[MAX_LOCKMODES] = {
+    0,
+    /* AccessShare */
+    LOCKBIT_ON(AccessExclusiveLock),
+    /* RowShare */
+    LOCKBIT_RANGE(ExclusiveLock, AccessExclusiveLock),
+    /* RowExclusive */
+    LOCKBIT_RANGE(ShareLock, AccessExclusiveLock),
+    /* ShareUpdateExclusive */
+    LOCKBIT_RANGE(ShareUpdateExclusiveLock, AccessExclusiveLock),
+    /* Share */
+    LOCKBIT_RANGE(RowExclusiveLock, ShareUpdateExclusiveLock) |
+        LOCKBIT_RANGE(ShareRowExclusiveLock, AccessExclusiveLock),
+    /* ShareRowExclusive */
+    LOCKBIT_RANGE(RowExclusiveLock, AccessExclusiveLock),
+    /* Exclusive */
+    LOCKBIT_RANGE(RowShareLock, AccessExclusiveLock),
+    /* AccessExclusive */
+    LOCKBIT_RANGE(AccessShareLock, AccessExclusiveLock),
+};
+
+typedef struct LockProc LockProc;
+
+typedef struct PROCLOCK
+{
+    LockProc* proc;
+    LOCKMASK holdMask; /* 0 表示仅在排队 */
+    struct PROCLOCK* next;
+} PROCLOCK;
+
+typedef struct LOCK
+{
+    LOCKTAG tag;
+    uint32_t hashcode;
+    LOCKMASK grantMask;              /* granted[m] > 0 的模式 */
+    LOCKMASK waitMask;               /* 等待队列中请求的模式 */
+    int granted[MAX_LOCKMODES];      /* 持有该模式的线程数 */
+    PROCLOCK* procLocks;
+    LockProc* waitHead;              /* FIFO，经 LockProc.waitNext 串起 */
+    struct LOCK* hashNext;
+} LOCK;
+
+struct LockProc
+{
+    LockProc* next; /* 全局链表，只增不删 */
+    atomic_bool in_use;
+
+    LWLock fpInfoLock; /* 保护下面两个 fast-path 字段 */
+    uint64_t fpRelId[FP_LOCK_SLOTS_PER_PROC];
+    uint64_t fpLockBits; /* 每槽 3 位：AccessShare / RowShare / RowExclusive */
+
+    /* 以下由 waitLock 所在分区锁保护 */
+    LOCK* waitLock;
+    LOCKMODE waitMode;
+    LockProc* waitNext;
+    _Atomic uint32_t waitStatus; /* 睡眠所在的状态字 */
+    uint32_t dlVisit;            /* 死锁检测访问标记（持全部分区锁时读写） */
+};
+
+typedef struct
+{
+    LWLock lock;
+    LOCK* buckets[LOCK_BUCKETS_PER_PARTITION];
+} LockPartition;
+
+typedef struct
+{
+    LOCKTAG tag;
+    LOCKMODE mode;
+    int64_t nLocks;
+    bool fastpath; /* 授予时记在 fast-path 槽位（之后可能被强锁者迁走） */
+    bool strong;   /* 本次获取递增了 strong 计数 */
+} LocalLock;
+
+static LockPartition LockPartitions[NUM_LOCK_PARTITIONS];
+static _Atomic uint32_t FastPathStrongRelationLocks[FP_LOCK_STRONG_PARTITIONS];
+static _Atomic(LockProc*) LockProcs = NULL;
+static uint32_t DeadlockVisitGen = 0; /* 持全部分区锁时递增 */
+
+static __thread LockProc* MyProc = NULL;
+static __thread LocalLock* LocalLocks = NULL;
+static __thread size_t nLocalLocks = 0, maxLocalLocks = 0;
+
+static pthread_key_t lockproc_key;
+static pthread_once_t lockproc_key_once = PTHREAD_ONCE_INIT;
+
+/* ============================================================
+ * LOCKTAG 与哈希
+ * ============================================================ */
+
+static inline bool locktag_equal(const LOCKTAG* a, const LOCKTAG* b)
+{
+    return a->locktag_field1 == b->locktag_field1 && a->locktag_field2 == b->locktag_field2 &&
+           a->locktag_field3 == b->locktag_field3 && a->locktag_type == b->locktag_type;
+}
+
+static inline uint32_t locktag_hash(const LOCKTAG* tag)
+{
+    uint64_t h = tag->locktag_field1 * 0x9E3779B97F4A7C15ull;
+    h ^= ((uint64_t)tag->locktag_field2 << 24) ^ ((uint64_t)tag->locktag_field3 << 8) ^
+         tag->locktag_type;
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 29;
+    return (uint32_t)h;
+}
+
+static inline LockPartition* lock_partition(uint32_t hashcode)
+{
+    return &LockPartitions[hashcode % NUM_LOCK_PARTITIONS];
+}
+
+static inline bool fastpath_eligible(const LOCKTAG* tag, LOCKMODE mode)
+{
+    return tag->locktag_type == LOCKTAG_RELATION && mode < ShareUpdateExclusiveLock;
+}
+
+static inline bool conflicts_with_fastpath(const LOCKTAG* tag, LOCKMODE mode)
+{
+    return tag->locktag_type == LOCKTAG_RELATION && mode > ShareUpdateExclusiveLock;
+}
+
+/* ============================================================
+ * 线程登记
+ * ============================================================ */
+
+static void lockproc_thread_exit(void* arg)
+{
+    LockProc* proc = arg;
+    LockReleaseAll();
+    free(LocalLocks);
+    LocalLocks = NULL;
+    nLocalLocks = maxLocalLocks = 0;
+    MyProc = NULL;
+    atomic_store_explicit(&proc->in_use, false, memory_order_release);
+}
+
+static void lockproc_key_init(void)
+{
+    pthread_key_create(&lockproc_key, lockproc_thread_exit);
+}
+
+static LockProc* lockproc_register(void)
+{
+    pthread_once(&lockproc_key_once, lockproc_key_init);
+    LockProc* proc;
+    for (proc = atomic_load(&LockProcs); proc; proc = proc->next)
+    {
+        bool expected = false;
+        if (!atomic_load_explicit(&proc->in_use, memory_order_relaxed) &&
+            atomic_compare_exchange_strong(&proc->in_use, &expected, true))
+            break;
+    }
+    if (!proc)
+    {
+        proc = calloc(1, sizeof(LockProc));
+        atomic_init(&proc->in_use, true);
+        LWLockInit(&proc->fpInfoLock, "fpInfoLock");
+        proc->next = atomic_load(&LockProcs);
+        while (!atomic_compare_exchange_weak(&LockProcs, &proc->next, proc))
+            ;
+    }
+    pthread_setspecific(lockproc_key, proc);
+    MyProc = proc;
+    return proc;
+}
+
+void VbProcInit(void)
+{
+    if (!MyProc) lockproc_register();
+}
+
+void VbProcRelease(void)
+{
+    LockReleaseAll();
+}
+
+/* ============================================================
+ * LocalLock：线程私有重入计数
+ * ============================================================ */
+
+static LocalLock* locallock_find(const LOCKTAG* tag, LOCKMODE mode)
+{
+    for (size_t i = 0; i < nLocalLocks; i++)
+        if (LocalLocks[i].mode == mode && locktag_equal(&LocalLocks[i].tag, tag))
+            return &LocalLocks[i];
+    return NULL;
+}
+
+static LocalLock* locallock_add(const LOCKTAG* tag, LOCKMODE mode)
+{
+    if (nLocalLocks == maxLocalLocks)
+    {
+        maxLocalLocks = maxLocalLocks ? maxLocalLocks * 2 : 16;
+        LocalLocks = realloc(LocalLocks, maxLocalLocks * sizeof(LocalLock));
+    }
+    LocalLock* ll = &LocalLocks[nLocalLocks++];
+    ll->tag = *tag;
+    ll->mode = mode;
+    ll->nLocks = 0;
+    ll->fastpath = false;
+    ll->strong = false;
+    return ll;
+}
+
+static void locallock_remove(LocalLock* ll)
+{
+    *ll = LocalLocks[--nLocalLocks];
+}
+
+/* ============================================================
+ * 主锁表（调用方持有对应分区锁）
+ * ============================================================ */
+
+static LOCK* lock_lookup(LockPartition* part, const LOCKTAG* tag, uint32_t hashcode, bool create)
+{
+    LOCK** bucket = &part->buckets[(hashcode / NUM_LOCK_PARTITIONS) % LOCK_BUCKETS_PER_PARTITION];
+    for (LOCK* lock = *bucket; lock; lock = lock->hashNext)
+        if (lock->hashcode == hashcode && locktag_equal(&lock->tag, tag)) return lock;
+    if (!create) return NULL;
+    LOCK* lock = calloc(1, sizeof(LOCK));
+    lock->tag = *tag;
+    lock->hashcode = hashcode;
+    lock->hashNext = *bucket;
+    *bucket = lock;
+    return lock;
+}
+
+/* 无人持有且无人等待时从桶上摘下并释放 */
+static void lock_cleanup(LockPartition* part, LOCK* lock)
+{
+    if (lock->procLocks || lock->waitHead) return;
+    LOCK** link =
+        &part->buckets[(lock->hashcode / NUM_LOCK_PARTITIONS) % LOCK_BUCKETS_PER_PARTITION];
+    while (*link != lock) link = &(*link)->hashNext;
+    *link = lock->hashNext;
+    free(lock);
+}
+
+static PROCLOCK* proclock_find(LOCK* lock, LockProc* proc, bool create)
+{
+    for (PROCLOCK* pl = lock->procLocks; pl; pl = pl->next)
+        if (pl->proc == proc) return pl;
+    if (!create) return NULL;
+    PROCLOCK* pl = calloc(1, sizeof(PROCLOCK));
+    pl->proc = proc;
+    pl->next = lock->procLocks;
+    lock->procLocks = pl;
+    return pl;
+}
+
+static void proclock_cleanup(LOCK* lock, PROCLOCK* pl)
+{
+    if (pl->holdMask) return;
+    PROCLOCK** link = &lock->procLocks;
+    while (*link != pl) link = &(*link)->next;
+    *link = pl->next;
+    free(pl);
+}
+
+/* 其他线程持有的、与 mode 冲突的模式是否存在（自己持有的不算冲突） */
+static bool lock_check_conflicts(const LOCK* lock, const PROCLOCK* pl, LOCKMODE mode)
+{
+    LOCKMASK conflict = LockConflicts[mode];
+    if (!(conflict & lock->grantMask)) return false;
+    for (LOCKMODE m = 1; m < MAX_LOCKMODES; m++)
+    {
+        if (!(conflict & LOCKBIT_ON(m))) continue;
+        int others = lock->granted[m] - ((pl->holdMask & LOCKBIT_ON(m)) ? 1 : 0);
+        if (others > 0) return true;
+    }
+    return false;
+}
+
+static void lock_grant(LOCK* lock, PROCLOCK* pl, LOCKMODE mode)
+{
+    pl->holdMask |= LOCKBIT_ON(mode);
+    lock->granted[mode]++;
+    lock->grantMask |= LOCKBIT_ON(mode);
+}
+
+static void lock_recompute_wait_mask(LOCK* lock)
+{
+    lock->waitMask = 0;
+    for (LockProc* w = lock->waitHead; w; w = w->waitNext) lock->waitMask |= LOCKBIT_ON(w->waitMode);
+}
+
+static void proc_wakeup(LockProc* proc)
+{
+    atomic_store_explicit(&proc->waitStatus, PROC_WAIT_OK, memory_order_release);
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t*)&proc->waitStatus, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+/* 按队列顺序授予不再冲突的等待者；前面仍在等的请求挡住与之冲突的后来者 */
+static void lock_wakeup_waiters(LOCK* lock)
+{
+    LOCKMASK aheadRequests = 0;
+    LockProc** link = &lock->waitHead;
+    while (*link)
+    {
+        LockProc* w = *link;
+        PROCLOCK* pl = proclock_find(lock, w, false);
+        if (!(LockConflicts[w->waitMode] & aheadRequests) &&
+            !lock_check_conflicts(lock, pl, w->waitMode))
+        {
+            lock_grant(lock, pl, w->waitMode);
+            *link = w->waitNext;
+            w->waitNext = NULL;
+            w->waitLock = NULL;
+            proc_wakeup(w);
+        }
+        else
+        {
+            aheadRequests |= LOCKBIT_ON(w->waitMode);
+            link = &w->waitNext;
+        }
+    }
+    lock_recompute_wait_mask(lock);
+}
+
+static void lock_release_mode(LockPartition* part, LOCK* lock, PROCLOCK* pl, LOCKMODE mode)
+{
+    pl->holdMask &= ~LOCKBIT_ON(mode);
+    if (--lock->granted[mode] == 0) lock->grantMask &= ~LOCKBIT_ON(mode);
+    proclock_cleanup(lock, pl);
+    lock_wakeup_waiters(lock);
+    lock_cleanup(part, lock);
+}
+
+/* 把等待中的 proc 摘出队列（死锁受害者）；其后的等待者可能因此可授予 */
+static void lock_remove_waiter(LockPartition* part, LockProc* proc)
+{
+    LOCK* lock = proc->waitLock;
+    LockProc** link = &lock->waitHead;
+    while (*link != proc) link = &(*link)->waitNext;
+    *link = proc->waitNext;
+    proc->waitNext = NULL;
+    proc->waitLock = NULL;
+    atomic_store_explicit(&proc->waitStatus, PROC_WAIT_OK, memory_order_relaxed);
+    PROCLOCK* pl = proclock_find(lock, proc, false);
+    if (pl) proclock_cleanup(lock, pl);
+    lock_wakeup_waiters(lock);
+    lock_cleanup(part, lock);
+}
+
+/* ============================================================
+ * 快路径
+ * ============================================================ */
+
+#define FP_BITS(proc, n)      (((proc)->fpLockBits >> (FP_LOCK_BITS_PER_SLOT * (n))) & 7u)
+#define FP_MODE_BIT(n, mode)  (1ull << (FP_LOCK_BITS_PER_SLOT * (n) + (mode) - 1))
+
+/* 调用方持 proc->fpInfoLock；槽位用尽返回 false */
+static bool fastpath_grant(LockProc* proc, uint64_t relid, LOCKMODE mode)
+{
+    int unused = -1;
+    for (int i = 0; i < FP_LOCK_SLOTS_PER_PROC; i++)
+    {
+        if (FP_BITS(proc, i) == 0)
+        {
+            if (unused < 0) unused = i;
+        }
+        else if (proc->fpRelId[i] == relid)
+        {
+            proc->fpLockBits |= FP_MODE_BIT(i, mode);
+            return true;
+        }
+    }
+    if (unused < 0) return false;
+    proc->fpRelId[unused] = relid;
+    proc->fpLockBits |= FP_MODE_BIT(unused, mode);
+    return true;
+}
+
+/* 调用方持 proc->fpInfoLock；锁已被迁入主锁表时返回 false */
+static bool fastpath_ungrant(LockProc* proc, uint64_t relid, LOCKMODE mode)
+{
+    for (int i = 0; i < FP_LOCK_SLOTS_PER_PROC; i++)
+    {
+        if (proc->fpRelId[i] == relid && (proc->fpLockBits & FP_MODE_BIT(i, mode)))
+        {
+            proc->fpLockBits &= ~FP_MODE_BIT(i, mode);
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 强锁者调用：把所有线程槽位里 relid 上的弱锁迁入主锁表 */
+static void fastpath_transfer(const LOCKTAG* tag, uint32_t hashcode)
+{
+    LockPartition* part = lock_partition(hashcode);
+    for (LockProc* proc = atomic_load(&LockProcs); proc; proc = proc->next)
+    {
+        LWLockAcquire(&proc->fpInfoLock, LW_EXCLUSIVE);
+        for (int i = 0; i < FP_LOCK_SLOTS_PER_PROC; i++)
+        {
+            uint32_t bits = (uint32_t)FP_BITS(proc, i);
+            if (!bits || proc->fpRelId[i] != tag->locktag_field1) continue;
+            LWLockAcquire(&part->lock, LW_EXCLUSIVE);
+            LOCK* lock = lock_lookup(part, tag, hashcode, true);
+            PROCLOCK* pl = proclock_find(lock, proc, true);
+            for (LOCKMODE m = AccessShareLock; m <= RowExclusiveLock; m++)
+                if (bits & (1u << (m - 1))) lock_grant(lock, pl, m);
+            LWLockRelease(&part->lock);
+            proc->fpLockBits &= ~(7ull << (FP_LOCK_BITS_PER_SLOT * i));
+        }
+        LWLockRelease(&proc->fpInfoLock);
+    }
+}
+
+/* ============================================================
+ * 死锁检测
+ * ============================================================ */
+
+static bool deadlock_visit(LockProc* cur, LockProc* target, uint32_t gen);
+
+static bool deadlock_edge(LockProc* to, LockProc* target, uint32_t gen)
+{
+    if (to == target) return true;
+    if (to->dlVisit == gen) return false;
+    to->dlVisit = gen;
+    return deadlock_visit(to, target, gen);
+}
+
+/* cur 在等谁：持有冲突模式的线程，以及队列中排在它前面、请求冲突模式的线程 */
+static bool deadlock_visit(LockProc* cur, LockProc* target, uint32_t gen)
+{
+    LOCK* lock = cur->waitLock;
+    if (!lock) return false;
+    LOCKMASK conflict = LockConflicts[cur->waitMode];
+    for (PROCLOCK* pl = lock->procLocks; pl; pl = pl->next)
+        if (pl->proc != cur && (pl->holdMask & conflict) && deadlock_edge(pl->proc, target, gen))
+            return true;
+    for (LockProc* w = lock->waitHead; w && w != cur; w = w->waitNext)
+        if ((LOCKBIT_ON(w->waitMode) & conflict) && deadlock_edge(w, target, gen)) return true;
+    return false;
+}
+
+/* 若 proc 仍在等待且处于 wait-for 环上，把它摘出队列并返回 true */
+static bool deadlock_check(LockProc* proc)
+{
+    for (int i = 0; i < NUM_LOCK_PARTITIONS; i++)
+        LWLockAcquire(&LockPartitions[i].lock, LW_EXCLUSIVE);
+
+    bool deadlocked = false;
+    if (atomic_load_explicit(&proc->waitStatus, memory_order_relaxed) == PROC_WAIT_WAITING)
+    {
+        uint32_t gen = ++DeadlockVisitGen;
+        if (deadlock_visit(proc, proc, gen))
+        {
+            lock_remove_waiter(lock_partition(proc->waitLock->hashcode), proc);
+            deadlocked = true;
+        }
+    }
+
+    for (int i = NUM_LOCK_PARTITIONS - 1; i >= 0; i--) LWLockRelease(&LockPartitions[i].lock);
+    return deadlocked;
+}
+
+/* ============================================================
+ * 等待
+ * ============================================================ */
+
+static void proc_wait(LockProc* proc, const struct timespec* timeout)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t*)&proc->waitStatus, FUTEX_WAIT_PRIVATE, PROC_WAIT_WAITING,
+            timeout, NULL, 0);
+#else
+    (void)proc;
+    (void)timeout;
+    sched_yield();
+#endif
+}
+
+static int64_t monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* 睡到被授予；超时后做一次死锁检测，是受害者则返回 false */
+static bool proc_sleep(LockProc* proc)
+{
+    int64_t deadline = monotonic_ms() + LOCK_DEADLOCK_TIMEOUT_MS;
+    bool checked = false;
+    while (atomic_load_explicit(&proc->waitStatus, memory_order_acquire) == PROC_WAIT_WAITING)
+    {
+        if (checked)
+        {
+            proc_wait(proc, NULL);
+            continue;
+        }
+        int64_t left = deadline - monotonic_ms();
+        if (left > 0)
+        {
+            struct timespec ts = {left / 1000, (left % 1000) * 1000000};
+            proc_wait(proc, &ts);
+            continue;
+        }
+        if (deadlock_check(proc)) return false;
+        checked = true;
+    }
+    return true;
+}
+
+/* ============================================================
+ * 对外接口
+ * ============================================================ */
+
+LockAcquireResult LockAcquire(const LOCKTAG* tag, LOCKMODE lockmode, bool dontWait)
+{
+    LockProc* proc = MyProc ? MyProc : lockproc_register();
+    LocalLock* ll = locallock_find(tag, lockmode);
+    if (ll)
+    {
+        ll->nLocks++;
+        return LOCKACQUIRE_ALREADY_HELD;
+    }
+    ll = locallock_add(tag, lockmode);
+
+    uint32_t hashcode = locktag_hash(tag);
+    _Atomic uint32_t* strong = &FastPathStrongRelationLocks[hashcode % FP_LOCK_STRONG_PARTITIONS];
+    if (fastpath_eligible(tag, lockmode))
+    {
+        /* strong 计数在 fpInfoLock 下复查：强锁者递增计数后才会来拿这把锁迁移槽位 */
+        LWLockAcquire(&proc->fpInfoLock, LW_EXCLUSIVE);
+        bool granted = atomic_load(strong) == 0 &&
+                       fastpath_grant(proc, tag->locktag_field1, lockmode);
+        LWLockRelease(&proc->fpInfoLock);
+        if (granted)
+        {
+            ll->nLocks = 1;
+            ll->fastpath = true;
+            return LOCKACQUIRE_OK;
+        }
+    }
+    else if (conflicts_with_fastpath(tag, lockmode))
+    {
+        atomic_fetch_add(strong, 1);
+        ll->strong = true;
+        fastpath_transfer(tag, hashcode);
+    }
+
+    LockPartition* part = lock_partition(hashcode);
+    LWLockAcquire(&part->lock, LW_EXCLUSIVE);
+    LOCK* lock = lock_lookup(part, tag, hashcode, true);
+    PROCLOCK* pl = proclock_find(lock, proc, true);
+    /* 已持有该对象的线程不必排在冲突的等待者之后（否则升级必然自锁） */
+    bool blocked_by_waiters = !pl->holdMask && (LockConflicts[lockmode] & lock->waitMask);
+    if (!blocked_by_waiters && !lock_check_conflicts(lock, pl, lockmode))
+    {
+        lock_grant(lock, pl, lockmode);
+        LWLockRelease(&part->lock);
+        ll->nLocks = 1;
+        return LOCKACQUIRE_OK;
+    }
+
+    if (dontWait)
+    {
+        proclock_cleanup(lock, pl);
+        lock_cleanup(part, lock);
+        LWLockRelease(&part->lock);
+        if (ll->strong) atomic_fetch_sub(strong, 1);
+        locallock_remove(ll);
+        return LOCKACQUIRE_NOT_AVAIL;
+    }
+
+    proc->waitLock = lock;
+    proc->waitMode = lockmode;
+    atomic_store_explicit(&proc->waitStatus, PROC_WAIT_WAITING, memory_order_relaxed);
+    LockProc** link = &lock->waitHead;
+    if (!pl->holdMask)
+        while (*link) link = &(*link)->waitNext;
+    proc->waitNext = *link;
+    *link = proc;
+    lock->waitMask |= LOCKBIT_ON(lockmode);
+    LWLockRelease(&part->lock);
+
+    if (!proc_sleep(proc))
+    {
+        if (ll->strong) atomic_fetch_sub(strong, 1);
+        locallock_remove(ll);
+        return LOCKACQUIRE_DEADLOCK;
+    }
+    ll->nLocks = 1;
+    return LOCKACQUIRE_OK;
+}
+
+bool LockRelease(const LOCKTAG* tag, LOCKMODE lockmode)
+{
+    LocalLock* ll = locallock_find(tag, lockmode);
+    if (!ll) return false;
+    if (--ll->nLocks > 0) return true;
+    bool fastpath = ll->fastpath;
+    bool strong = ll->strong;
+    locallock_remove(ll);
+
+    LockProc* proc = MyProc;
+    uint32_t hashcode = locktag_hash(tag);
+    if (fastpath)
+    {
+        LWLockAcquire(&proc->fpInfoLock, LW_EXCLUSIVE);
+        bool released = fastpath_ungrant(proc, tag->locktag_field1, lockmode);
+        LWLockRelease(&proc->fpInfoLock);
+        if (released) return true;
+        /* 已被强锁者迁入主锁表 */
+    }
+
+    LockPartition* part = lock_partition(hashcode);
+    LWLockAcquire(&part->lock, LW_EXCLUSIVE);
+    LOCK* lock = lock_lookup(part, tag, hashcode, false);
+    PROCLOCK* pl = lock ? proclock_find(lock, proc, false) : NULL;
+    if (pl && (pl->holdMask & LOCKBIT_ON(lockmode))) lock_release_mode(part, lock, pl, lockmode);
+    LWLockRelease(&part->lock);
+
+    if (strong) atomic_fetch_sub(&FastPathStrongRelationLocks[hashcode % FP_LOCK_STRONG_PARTITIONS], 1);
+    return true;
+}
+
+void LockReleaseAll(void)
+{
+    while (nLocalLocks > 0)
+    {
+        LocalLock* ll = &LocalLocks[nLocalLocks - 1];
+        LOCKTAG tag = ll->tag;
+        ll->nLocks = 1;
+        LockRelease(&tag, ll->mode);
+    }
+}
+
+bool LockHeldByMe(const LOCKTAG* tag, LOCKMODE lockmode)
+{
+    return locallock_find(tag, lockmode) != NULL;
+}
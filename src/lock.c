@@ -1,7 +1,104 @@
 /**
- * lock.c — 空编译单元
+ * lock.c — LWLock / SpinLock 慢路径
  *
- * 所有 LWLock / SpinLock 函数均已在 lock.h 中实现为 static inline。
- * 保留此文件仅为让 Makefile 的 $(wildcard src/*.c) 正常编译。
+ * 快路径（一次原子操作）在 lock.h 中内联；这里只处理冲突：
+ *   LWLock   先指数退避自旋，再置 LW_FLAG_HAS_WAITERS 后在状态字上 futex 等待
+ *   SpinLock 只读自旋 + 指数退避 pause，长时间拿不到时 sched_yield
+ * 非 Linux 平台没有 futex，退化为 sched_yield 轮询。
  */
+#include <limits.h>
+#include <sched.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include "lock.h"
+
+#define LW_SPIN_ROUNDS         6u    /* 退避 1, 2, 4 ... 32 次 pause 后转入等待 */
+#define S_LOCK_MAX_DELAY       64u   /* 单轮最多 pause 次数 */
+#define S_LOCK_SPINS_PER_YIELD 1000u /* 自旋这么多轮仍未拿到则让出 CPU */
+
+static inline void spin_delay(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline bool lwlock_free_for(uint32_t state, LWLockMode mode)
+{
+    return mode == LW_SHARED ? !(state & LW_VAL_EXCLUSIVE) : !(state & LW_LOCK_MASK);
+}
+
+/* 状态字仍等于 expected 时睡眠；任何修改（释放、唤醒清位）都会让它返回 */
+static void lwlock_wait(LWLock* lock, uint32_t expected)
+{
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t*)&lock->state, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+#else
+    (void)lock;
+    (void)expected;
+    sched_yield();
+#endif
+}
+
+/* 清除 HAS_WAITERS 并唤醒所有等待者，由它们重新竞争 */
+void LWLockWakeup(LWLock* lock)
+{
+    atomic_fetch_and_explicit(&lock->state, ~LW_FLAG_HAS_WAITERS, memory_order_relaxed);
+#ifdef __linux__
+    syscall(SYS_futex, (uint32_t*)&lock->state, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+void LWLockAcquireSlow(LWLock* lock, LWLockMode mode)
+{
+    for (;;)
+    {
+        uint32_t delay = 1;
+        for (uint32_t round = 0; round < LW_SPIN_ROUNDS; round++, delay <<= 1)
+        {
+            for (uint32_t i = 0; i < delay; i++) spin_delay();
+            uint32_t s = atomic_load_explicit(&lock->state, memory_order_relaxed);
+            if (lwlock_free_for(s, mode) && LWLockAttemptLock(lock, mode)) return;
+        }
+
+        /* 置等待位与释放者的 fetch_sub 通过同一状态字排序：释放若先发生，CAS 失败重试；
+         * 若后发生，释放者必然看到等待位并唤醒，或 futex 因状态已变而立即返回 */
+        uint32_t s = atomic_load_explicit(&lock->state, memory_order_relaxed);
+        if (lwlock_free_for(s, mode)) continue;
+        if (!(s & LW_FLAG_HAS_WAITERS))
+        {
+            if (!atomic_compare_exchange_strong_explicit(&lock->state, &s, s | LW_FLAG_HAS_WAITERS,
+                                                         memory_order_relaxed, memory_order_relaxed))
+                continue;
+            s |= LW_FLAG_HAS_WAITERS;
+        }
+        lwlock_wait(lock, s);
+    }
+}
+
+void s_lock(slock_t* lock)
+{
+    uint32_t delay = 1;
+    uint32_t spins = 0;
+    for (;;)
+    {
+        /* 只读等待，避免反复原子交换抢占缓存行 */
+        while (atomic_load_explicit(lock, memory_order_relaxed) != 0)
+        {
+            for (uint32_t i = 0; i < delay; i++) spin_delay();
+            if (delay < S_LOCK_MAX_DELAY) delay <<= 1;
+            if (++spins >= S_LOCK_SPINS_PER_YIELD)
+            {
+                sched_yield();
+                spins = 0;
+            }
+        }
+        if (atomic_exchange_explicit(lock, 1, memory_order_acquire) == 0) return;
+    }
+}
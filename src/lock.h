@@ -8,12 +8,13 @@
  * Tier 3: RegularLock — full deadlock-detecting lock manager (LOCKTAG-based)
  *
  * This is a self-contained module: do NOT include vb_type.h here.
- * All thread-using code must call VbProcInit() once per thread.
+ * Threads register with the lock manager lazily on their first RegularLock
+ * call; VbProcInit() only makes that explicit.
  */
 
 #ifndef LOCK_H
 #define LOCK_H
-#include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -28,36 +29,71 @@ typedef enum
 } LWLockMode;
 
 /* ============================================================
- * LWLock — pthread_rwlock_t 薄包装
+ * LWLock — 单个原子状态字（PG lwlock.c 的 state 布局）
  *
- * 结构体只含一个 rwlock 字段；旧版的 state/_Atomic/head/tail
- * 全部移除。调用方以 LWLock 为类型，不直接访问内部字段。
+ *   bit 0..23  共享持有者计数（LW_VAL_SHARED 为单位）
+ *   bit 24     LW_VAL_EXCLUSIVE
+ *   bit 30     LW_FLAG_HAS_WAITERS：有线程在 futex 上等待
+ *
+ * 快路径内联：共享获取是一次 fetch_add，排他获取是一次 0 → EXCLUSIVE 的 CAS；
+ * 冲突时进入 lock.c 的慢路径：先指数退避自旋，仍拿不到则置 HAS_WAITERS
+ * 并在状态字上 futex 等待。释放时若见 HAS_WAITERS 则清位并唤醒所有等待者，
+ * 由它们重新竞争（共享等待者可一起进入）。
+ * 调用方以 LWLock 为类型，不直接访问内部字段。
  * ============================================================ */
+#define LW_VAL_SHARED       1u
+#define LW_SHARED_MASK      ((1u << 24) - 1)
+#define LW_VAL_EXCLUSIVE    (1u << 24)
+#define LW_LOCK_MASK        (LW_SHARED_MASK | LW_VAL_EXCLUSIVE)
+#define LW_FLAG_HAS_WAITERS (1u << 30)
+
 typedef struct LWLock
 {
-    pthread_rwlock_t rwlock;
+    _Atomic uint32_t state;
 } LWLock;
 
+/* 慢路径（lock.c） */
+void LWLockAcquireSlow(LWLock* lock, LWLockMode mode);
+void LWLockWakeup(LWLock* lock);
+
 static inline void LWLockInit(LWLock* lock, const char* name)
 {
     (void)name;   /* 嵌入式不需要锁名称 */
-    pthread_rwlock_init(&lock->rwlock, NULL);
+    atomic_init(&lock->state, 0);
 }
 
-static inline void LWLockAcquire(LWLock* lock, LWLockMode mode)
+/* 单次尝试获取；共享模式下若撞上排他持有者，撤销计数后返回 false */
+static inline bool LWLockAttemptLock(LWLock* lock, LWLockMode mode)
 {
     if (mode == LW_SHARED)
-        pthread_rwlock_rdlock(&lock->rwlock);
-    else
-        pthread_rwlock_wrlock(&lock->rwlock);
+    {
+        uint32_t old = atomic_fetch_add_explicit(&lock->state, LW_VAL_SHARED, memory_order_acquire);
+        if (!(old & LW_VAL_EXCLUSIVE)) return true;
+        old = atomic_fetch_sub_explicit(&lock->state, LW_VAL_SHARED, memory_order_release);
+        /* 撤销期间排他者已释放且有人在等：计数归零的这一刻由我们负责唤醒 */
+        if ((old & LW_FLAG_HAS_WAITERS) && (old & LW_LOCK_MASK) == LW_VAL_SHARED)
+            LWLockWakeup(lock);
+        return false;
+    }
+    uint32_t old = atomic_load_explicit(&lock->state, memory_order_relaxed);
+    while (!(old & LW_LOCK_MASK))
+    {
+        if (atomic_compare_exchange_weak_explicit(&lock->state, &old, old | LW_VAL_EXCLUSIVE,
+                                                  memory_order_acquire, memory_order_relaxed))
+            return true;
+    }
+    return false;
+}
+
+static inline void LWLockAcquire(LWLock* lock, LWLockMode mode)
+{
+    if (!LWLockAttemptLock(lock, mode)) LWLockAcquireSlow(lock, mode);
 }
 
 /* 非阻塞尝试：成功返回 true，已被锁定返回 false */
 static inline bool LWLockConditionalAcquire(LWLock* lock, LWLockMode mode)
 {
-    int rc = (mode == LW_SHARED) ? pthread_rwlock_tryrdlock(&lock->rwlock)
-                                 : pthread_rwlock_trywrlock(&lock->rwlock);
-    return rc == 0;
+    return LWLockAttemptLock(lock, mode);
 }
 
 /* 等价于 LWLockAcquire（嵌入式无区别） */
@@ -67,21 +103,25 @@ static inline bool LWLockAcquireOrWait(LWLock* lock, LWLockMode mode)
     return true;
 }
 
+/* 排他位只可能属于调用方自己，据此区分释放的是哪种模式 */
 static inline void LWLockRelease(LWLock* lock)
 {
-    pthread_rwlock_unlock(&lock->rwlock);
+    uint32_t old = atomic_load_explicit(&lock->state, memory_order_relaxed);
+    uint32_t sub = (old & LW_VAL_EXCLUSIVE) ? LW_VAL_EXCLUSIVE : LW_VAL_SHARED;
+    old = atomic_fetch_sub_explicit(&lock->state, sub, memory_order_release);
+    if ((old & LW_FLAG_HAS_WAITERS) && (old & LW_LOCK_MASK) == sub) LWLockWakeup(lock);
 }
 
 /* 释放锁并将 *var 设为 val（原子保证：先赋值再解锁） */
 static inline void LWLockReleaseClearVar(LWLock* lock, uint64_t* var, uint64_t val)
 {
     *var = val;
-    pthread_rwlock_unlock(&lock->rwlock);
+    LWLockRelease(lock);
 }
 
 static inline void LWLockDestroy(LWLock* lock)
 {
-    pthread_rwlock_destroy(&lock->rwlock);
+    (void)lock;
 }
 
 /* 嵌入式中不跟踪持锁线程，始终返回 false */
@@ -93,27 +133,150 @@ static inline bool LWLockHeldByMe(LWLock* lock)
 static inline void LWLockReleaseAll(void) {}
 
 /* ============================================================
- * SpinLock — pthread_mutex_t 薄包装
+ * SpinLock — test-and-test-and-set（PG s_lock.h 的 TAS_SPIN）
  *
- * 嵌入式场景用 mutex 替代 x86 TAS spinlock：
- *   - 无忙等 + 无 inline asm，移植性好
- *   - 临界区极短（计数器读写），mutex 开销可接受
+ * 快路径一次原子交换；失败后在 lock.c 的 s_lock 中只读自旋
+ * （不抢缓存行），带指数退避的 pause，长时间拿不到再让出 CPU。
+ * 临界区必须极短，且不能在持有期间阻塞。
  * ============================================================ */
-typedef pthread_mutex_t slock_t;
+typedef _Atomic uint32_t slock_t;
+
+void s_lock(slock_t* lock);
+
+static inline void SpinLockAcquire_(slock_t* lock)
+{
+    if (atomic_exchange_explicit(lock, 1, memory_order_acquire) != 0) s_lock(lock);
+}
 
-#define SpinLockInit(lock)    pthread_mutex_init((lock), NULL)
-#define SpinLockAcquire(lock) pthread_mutex_lock(lock)
-#define SpinLockRelease(lock) pthread_mutex_unlock(lock)
-#define SpinLockFree(lock)    pthread_mutex_destroy(lock)
+#define SpinLockInit(lock)    atomic_init((lock), 0)
+#define SpinLockAcquire(lock) SpinLockAcquire_(lock)
+#define SpinLockRelease(lock) atomic_store_explicit((lock), 0, memory_order_release)
+#define SpinLockFree(lock)    ((void)(lock))
 
 /* ============================================================
- * VbProcInit / VbProcRelease — 嵌入式无需手动管理线程槽
+ * RegularLock — 重量级锁管理器（PG lock.c / deadlock.c 的精简移植，实现在 lmgr.c）
+ *
+ * 以 LOCKTAG 标识被锁对象（表或行），表级锁模式与冲突矩阵同 PG：
+ *   AccessShare（读）与 RowExclusive（增删改）互不冲突；
+ *   ShareUpdateExclusive（vacuum）自身互斥，但不挡读写；
+ *   Exclusive 只放行 AccessShare；AccessExclusive（DDL）与一切冲突。
+ * 主锁表按 LOCKTAG 哈希分成 NUM_LOCK_PARTITIONS 个分区，各由一把 LWLock 保护，
+ * 没有全局互斥。
+ *
+ * 快路径：表上的弱锁（AccessShare / RowShare / RowExclusive）在该表没有强锁时
+ * 只记录到本线程的 fast-path 槽位，不碰共享锁表。强锁（Share 及以上）先递增
+ * 该表所在桶的 strong 计数，再把所有线程槽位中该表的弱锁迁入主锁表，之后
+ * 按常规冲突检查；计数非零期间新的弱锁也走主锁表。
+ *
+ * 等待者按 FIFO 排队，在自己的等待状态字上睡眠；等待超过
+ * LOCK_DEADLOCK_TIMEOUT_MS 后持全部分区锁构造 wait-for 图，若自己在环上
+ * 则放弃等待，返回 LOCKACQUIRE_DEADLOCK（嵌入式不抛错，由调用方回滚）。
+ * 锁归线程所有，可重入：同一线程重复获取同一模式只计数，释放同样次数。
+ * ============================================================ */
+typedef int LOCKMODE;
+typedef uint32_t LOCKMASK;
+
+#define NoLock                   0
+#define AccessShareLock          1 /* 读 */
+#define RowShareLock             2 /* 读并锁行 */
+#define RowExclusiveLock         3 /* INSERT / UPDATE / DELETE */
+#define ShareUpdateExclusiveLock 4 /* VACUUM */
+#define ShareLock                5 /* 建索引 */
+#define ShareRowExclusiveLock    6
+#define ExclusiveLock            7 /* 只放行 AccessShare */
+#define AccessExclusiveLock      8 /* DDL */
+#define MAX_LOCKMODES            9
+
+#define LOCKBIT_ON(lockmode) (1u << (lockmode))
+
+#define LOCK_DEADLOCK_TIMEOUT_MS 50 /* 等待这么久后才做死锁检测 */
+
+extern const LOCKMASK LockConflicts[MAX_LOCKMODES];
+
+typedef enum
+{
+    LOCKTAG_RELATION = 0, /* field1 = relid */
+    LOCKTAG_TUPLE = 1,    /* field1 = relid, field2 = block, field3 = slot */
+} LockTagType;
+
+typedef struct LOCKTAG
+{
+    uint64_t locktag_field1;
+    uint32_t locktag_field2;
+    uint16_t locktag_field3;
+    uint8_t locktag_type;
+} LOCKTAG;
+
+#define SET_LOCKTAG_RELATION(tag, relid)                                                           \
+    ((tag).locktag_field1 = (relid), (tag).locktag_field2 = 0, (tag).locktag_field3 = 0,           \
+     (tag).locktag_type = LOCKTAG_RELATION)
+
+#define SET_LOCKTAG_TUPLE(tag, relid, blk, slot)                                                   \
+    ((tag).locktag_field1 = (relid), (tag).locktag_field2 = (blk), (tag).locktag_field3 = (slot),  \
+     (tag).locktag_type = LOCKTAG_TUPLE)
+
+typedef enum
+{
+    LOCKACQUIRE_NOT_AVAIL,    /* dontWait 且有冲突 */
+    LOCKACQUIRE_OK,           /* 新获取 */
+    LOCKACQUIRE_ALREADY_HELD, /* 本线程已持有该模式，计数加一 */
+    LOCKACQUIRE_DEADLOCK,     /* 等待会造成死锁，未获取 */
+} LockAcquireResult;
+
+LockAcquireResult LockAcquire(const LOCKTAG* tag, LOCKMODE lockmode, bool dontWait);
+/* 释放一次；本线程未持有返回 false */
+bool LockRelease(const LOCKTAG* tag, LOCKMODE lockmode);
+/* 释放本线程持有的全部 RegularLock（含重入计数） */
+void LockReleaseAll(void);
+bool LockHeldByMe(const LOCKTAG* tag, LOCKMODE lockmode);
+
+static inline LockAcquireResult LockRelation(uint64_t relid, LOCKMODE lockmode)
+{
+    LOCKTAG tag;
+    SET_LOCKTAG_RELATION(tag, relid);
+    return LockAcquire(&tag, lockmode, false);
+}
+
+static inline bool ConditionalLockRelation(uint64_t relid, LOCKMODE lockmode)
+{
+    LOCKTAG tag;
+    SET_LOCKTAG_RELATION(tag, relid);
+    return LockAcquire(&tag, lockmode, true) != LOCKACQUIRE_NOT_AVAIL;
+}
+
+static inline void UnlockRelation(uint64_t relid, LOCKMODE lockmode)
+{
+    LOCKTAG tag;
+    SET_LOCKTAG_RELATION(tag, relid);
+    LockRelease(&tag, lockmode);
+}
+
+static inline LockAcquireResult LockTuple(uint64_t relid, uint32_t blk, uint16_t slot,
+                                          LOCKMODE lockmode)
+{
+    LOCKTAG tag;
+    SET_LOCKTAG_TUPLE(tag, relid, blk, slot);
+    return LockAcquire(&tag, lockmode, false);
+}
+
+static inline void UnlockTuple(uint64_t relid, uint32_t blk, uint16_t slot, LOCKMODE lockmode)
+{
+    LOCKTAG tag;
+    SET_LOCKTAG_TUPLE(tag, relid, blk, slot);
+    LockRelease(&tag, lockmode);
+}
+
+/* ============================================================
+ * VbProcInit / VbProcRelease — 线程在锁管理器中的登记
+ *
+ * 首次使用 RegularLock 时自动登记，线程退出时自动释放全部锁并归还槽位；
+ * VbProcInit 只是提前登记，VbProcRelease 释放本线程的全部 RegularLock。
  * ============================================================ */
-static inline void VbProcInit(void) {}
-static inline void VbProcRelease(void) {}
+void VbProcInit(void);
+void VbProcRelease(void);
 
 /* ============================================================
- * LockSubsystemInit — 嵌入式无需全局初始化
+ * LockSubsystemInit — 锁表静态初始化，无需调用
  * ============================================================ */
 static inline void LockSubsystemInit(void) {}
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <string.h>
+#include "memctx.h"
+
+struct MemoryBlock
+{
+    MemoryBlock* next;
+    usize cap;
+    usize used;
+    u8 data[];
+};
+
+static MemoryBlock* memoryBlock_new(MemoryContext* cxt, usize cap)
+{
+    MemoryBlock* b = malloc(sizeof(MemoryBlock) + cap);
+    if (!b) return NULL;
+    b->next = NULL;
+    b->cap = cap;
+    b->used = 0;
+    cxt->mem_allocated += cap;
+    return b;
+}
+
+static void memoryContext_link(MemoryContext* cxt, MemoryContext* parent)
+{
+    cxt->parent = parent;
+    cxt->prev_sibling = NULL;
+    cxt->next_sibling = parent ? parent->first_child : NULL;
+    if (parent)
+    {
+        if (parent->first_child) parent->first_child->prev_sibling = cxt;
+        parent->first_child = cxt;
+    }
+}
+
+static void memoryContext_unlink(MemoryContext* cxt)
+{
+    if (!cxt->parent) return;
+    if (cxt->prev_sibling)
+        cxt->prev_sibling->next_sibling = cxt->next_sibling;
+    else
+        cxt->parent->first_child = cxt->next_sibling;
+    if (cxt->next_sibling) cxt->next_sibling->prev_sibling = cxt->prev_sibling;
+    cxt->parent = NULL;
+    cxt->prev_sibling = cxt->next_sibling = NULL;
+}
+
+void MemoryContext_init(MemoryContext* cxt, MemoryContext* parent, const char* name,
+                        usize block_size)
+{
+    cxt->name = name;
+    cxt->first_child = NULL;
+    cxt->blocks = NULL;
+    cxt->block_size = block_size ? block_size : MEMCTX_DEFAULT_BLOCK_SIZE;
+    cxt->mem_allocated = 0;
+    cxt->heap_owned = false;
+    memoryContext_link(cxt, parent);
+}
+
+MemoryContext* MemoryContext_create(MemoryContext* parent, const char* name, usize block_size)
+{
+    MemoryContext* cxt = malloc(sizeof(MemoryContext));
+    if (!cxt) return NULL;
+    MemoryContext_init(cxt, parent, name, block_size);
+    cxt->heap_owned = true;
+    return cxt;
+}
+
+static void memoryContext_delete_children(MemoryContext* cxt)
+{
+    while (cxt->first_child) memoryContext_delete(cxt->first_child);
+}
+
+void memoryContext_delete(MemoryContext* cxt)
+{
+    if (!cxt) return;
+    memoryContext_delete_children(cxt);
+    MemoryBlock* b = cxt->blocks;
+    while (b)
+    {
+        MemoryBlock* next = b->next;
+        free(b);
+        b = next;
+    }
+    cxt->blocks = NULL;
+    cxt->mem_allocated = 0;
+    memoryContext_unlink(cxt);
+    if (cxt->heap_owned) free(cxt);
+}
+
+void memoryContext_reset(MemoryContext* cxt)
+{
+    memoryContext_delete_children(cxt);
+    MemoryBlock* keep = NULL;
+    MemoryBlock* b = cxt->blocks;
+    while (b)
+    {
+        MemoryBlock* next = b->next;
+        if (!keep && b->cap == cxt->block_size)
+        {
+            keep = b;
+            keep->used = 0;
+            keep->next = NULL;
+        }
+        else
+        {
+            cxt->mem_allocated -= b->cap;
+            free(b);
+        }
+        b = next;
+    }
+    cxt->blocks = keep;
+}
+
+void* memoryContext_alloc(MemoryContext* cxt, usize size)
+{
+    size = (size + 7) & ~(usize)7;
+    MemoryBlock* b = cxt->blocks;
+    if (!b || b->cap - b->used < size)
+    {
+        MemoryBlock* nb = memoryBlock_new(cxt, size > cxt->block_size ? size : cxt->block_size);
+        if (!nb) return NULL;
+        if (b && size > cxt->block_size)
+        {
+            // 超大请求：插在当前块后面，当前块剩余空间继续用
+            nb->next = b->next;
+            b->next = nb;
+            nb->used = size;
+            return nb->data;
+        }
+        nb->next = b;
+        cxt->blocks = b = nb;
+    }
+    void* ptr = b->data + b->used;
+    b->used += size;
+    return ptr;
+}
+
+void* memoryContext_alloc_zero(MemoryContext* cxt, usize size)
+{
+    void* ptr = memoryContext_alloc(cxt, size);
+    if (ptr) memset(ptr, 0, size);
+    return ptr;
+}
+
+char* memoryContext_strdup(MemoryContext* cxt, const char* str)
+{
+    usize len = strlen(str) + 1;
+    char* copy = memoryContext_alloc(cxt, len);
+    if (copy) memcpy(copy, str, len);
+    return copy;
+}
+
+usize memoryContext_mem_allocated(const MemoryContext* cxt, bool recurse)
+{
+    usize total = cxt->mem_allocated;
+    if (recurse)
+    {
+        for (const MemoryContext* c = cxt->first_child; c; c = c->next_sibling)
+            total += memoryContext_mem_allocated(c, true);
+    }
+    return total;
+}
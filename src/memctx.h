@@ -0,0 +1,60 @@
+#ifndef MEMCTX_H
+#define MEMCTX_H
+#include "vb_type.h"
+
+/**
+ * memctx.h — 内存上下文（PG MemoryContext 的精简版）
+ *
+ * 每个上下文是一个 bump arena：分配只是在当前块里移动指针，不支持单独释放；
+ * 整批内存随 memoryContext_reset（保留一个块、回绕，供下一轮复用）或
+ * memoryContext_delete 一次性归还，代价与分配次数无关。
+ *
+ * 上下文组成树：reset / delete 会先删除全部子上下文，所以查询级上下文下面
+ * 挂的扫描级、行级上下文不用逐个清理。典型生命周期：
+ *
+ *   catalog      ── Catalog 存续期（列名等目录字符串）
+ *   checkpoint   ── 一次 checkpoint 加载，按 schema / 表逐个 reset
+ *   query        ── 一次查询（扫描候选的 Datum 数组、varlena 拷贝）
+ *
+ * 单个上下文不是线程安全的；并发任务各用自己的（子）上下文。
+ */
+
+#define MEMCTX_DEFAULT_BLOCK_SIZE 8192
+
+typedef struct MemoryBlock MemoryBlock;
+typedef struct MemoryContext MemoryContext;
+
+struct MemoryContext
+{
+    const char* name;
+    MemoryContext* parent;
+    MemoryContext* first_child;
+    MemoryContext* next_sibling;
+    MemoryContext* prev_sibling;
+    MemoryBlock* blocks;     // 当前块在链表头
+    usize block_size;
+    usize mem_allocated;     // 本上下文持有的块字节数（不含子上下文）
+    bool heap_owned;         // 由 MemoryContext_create 分配，delete 时连结构体一起释放
+};
+
+// 初始化嵌入在其他结构里的上下文；parent 可为 NULL，block_size 为 0 时取默认值
+void MemoryContext_init(MemoryContext* cxt, MemoryContext* parent, const char* name,
+                        usize block_size);
+
+MemoryContext* MemoryContext_create(MemoryContext* parent, const char* name, usize block_size);
+
+// 释放全部内存和子上下文，并从父上下文摘除；对 MemoryContext_init 的上下文相当于 deinit
+void memoryContext_delete(MemoryContext* cxt);
+
+// 删除子上下文，只保留一个标准大小的块并回绕
+void memoryContext_reset(MemoryContext* cxt);
+
+// 按 8 字节对齐分配；超过 block_size 的请求单独占一块。失败返回 NULL
+void* memoryContext_alloc(MemoryContext* cxt, usize size);
+void* memoryContext_alloc_zero(MemoryContext* cxt, usize size);
+char* memoryContext_strdup(MemoryContext* cxt, const char* str);
+
+// 本上下文（recurse 时含全部子孙）持有的块字节数
+usize memoryContext_mem_allocated(const MemoryContext* cxt, bool recurse);
+
+#endif
@@ -0,0 +1,557 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "optimizer.h"
+
+/* ================= 统计收集 ================= */
+
+void TableStats_init(TableStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void TableStats_deinit(TableStats* stats)
+{
+    free(stats->cols);
+    memset(stats, 0, sizeof(*stats));
+}
+
+static bool stats_type_supported(TupleColType type)
+{
+    switch (type)
+    {
+        case TUPLE_COL_BOOL:
+        case TUPLE_COL_I32:
+        case TUPLE_COL_I64:
+        case TUPLE_COL_F32:
+        case TUPLE_COL_F64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static f64 datum_to_f64(TupleColType type, Datum d)
+{
+    switch (type)
+    {
+        case TUPLE_COL_BOOL:
+            return DatumGetBool(d) ? 1.0 : 0.0;
+        case TUPLE_COL_I32:
+            return (f64)DatumGetInt32(d);
+        case TUPLE_COL_I64:
+            return (f64)DatumGetInt64(d);
+        case TUPLE_COL_F32:
+            return (f64)DatumGetFloat32(d);
+        case TUPLE_COL_F64:
+            return DatumGetFloat64(d);
+        default:
+            return 0.0;
+    }
+}
+
+/* 采样汇点：对扫描推来的每一行做水塘抽样（Algorithm R），样本按行优先存成 f64 */
+typedef struct
+{
+    EXTENDS(PhysicalOperator);
+    const u8* types;  // 批内第 c 列的 TupleColType
+    usize ncols;
+    usize cap;
+    usize nsample;
+    u64 seen;
+    u64 rng;
+    f64* vals;        // 样本 s 的第 c 列在 vals[s * ncols + c]
+    u64* nulls;
+} AnalyzeSink;
+
+static u64 analyze_rand(AnalyzeSink* sink)
+{
+    /* xorshift64：固定种子，同一张表的统计可复现 */
+    u64 x = sink->rng;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    sink->rng = x;
+    return x;
+}
+
+static ExecStatus analyzeSink_push(PhysicalOperator* op, ExecChunk* chunk)
+{
+    AnalyzeSink* sink = (AnalyzeSink*)op;
+    usize rows = execChunk_rows(chunk);
+    for (usize i = 0; i < rows; i++)
+    {
+        usize r = execChunk_row(chunk, i);
+        sink->seen++;
+        usize slot;
+        if (sink->nsample < sink->cap)
+            slot = sink->nsample++;
+        else
+        {
+            u64 j = analyze_rand(sink) % sink->seen;
+            if (j >= sink->cap) continue;
+            slot = (usize)j;
+        }
+        f64* dst = sink->vals + slot * sink->ncols;
+        for (usize c = 0; c < sink->ncols; c++)
+            dst[c] = datum_to_f64((TupleColType)sink->types[c], execChunk_col(chunk, c)[r]);
+        sink->nulls[slot] = chunk->null_bits[r];
+    }
+    return EXEC_CONTINUE;
+}
+
+static ExecStatus analyzeSink_finalize(PhysicalOperator* op)
+{
+    (void)op;
+    return EXEC_CONTINUE;
+}
+
+static const PhysicalOperatorVTable analyze_sink_vtable = {
+    .push = analyzeSink_push,
+    .finalize = analyzeSink_finalize,
+};
+
+static int cmp_f64(const void* a, const void* b)
+{
+    f64 x = *(const f64*)a, y = *(const f64*)b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * 由排好序的非 NULL 样本 vals[0, n) 填一列的统计。total_nonnull 是全表非 NULL 行数
+ * 的估计；样本覆盖全表时不同值个数是精确的，否则用 Haas-Stokes 的 Duj1 估计量
+ * n*d / (n - f1 + f1*n/N)（PG 的 ANALYZE 同款）。
+ */
+static void columnStats_build(ColumnStats* cs, const f64* vals, usize n, bool full,
+                              f64 total_nonnull)
+{
+    cs->nbounds = 0;
+    cs->ndistinct = 0;
+    if (n == 0) return;
+    cs->min = vals[0];
+    cs->max = vals[n - 1];
+
+    usize d = 0, f1 = 0;
+    for (usize i = 0; i < n;)
+    {
+        usize j = i + 1;
+        while (j < n && vals[j] == vals[i]) j++;
+        d++;
+        f1 += (j - i == 1);
+        i = j;
+    }
+    f64 nd = (f64)d;
+    if (!full)
+    {
+        if (f1 == n)
+            nd = total_nonnull;  // 样本里没有重复：视为唯一列，不同值个数随行数增长
+        else
+            nd = (f64)n * (f64)d / ((f64)(n - f1) + (f64)f1 * (f64)n / total_nonnull);
+        if (nd < (f64)d) nd = (f64)d;
+        if (nd > total_nonnull) nd = total_nonnull;
+    }
+    cs->ndistinct = nd;
+
+    /* 等高直方图：边界取样本的等距分位点，相邻边界之间的行数相同 */
+    usize nb = n < STATS_HIST_BOUNDS ? n : STATS_HIST_BOUNDS;
+    for (usize b = 0; b < nb; b++)
+        cs->bounds[b] = nb > 1 ? vals[b * (n - 1) / (nb - 1)] : vals[0];
+    cs->nbounds = (u16)nb;
+}
+
+int tableStats_analyze(TableStats* stats, ExecContext* ctx, DataTable* table)
+{
+    HeapStore* hs;
+    switch (table->table->type)
+    {
+        case TABLE_AM_ROUTINE_EMBEDDING:
+            hs = &((EmbeddingHeapTable*)table->table)->heap_table.store;
+            break;
+        case TABLE_AM_ROUTINE_ROW:
+            hs = &((HeapTable*)table->table)->store;
+            break;
+        default:
+            return -1;
+    }
+    const TupleDesc* desc = &hs->desc;
+
+    MemoryContext* cxt = MemoryContext_create(ctx->cxt, "analyze", 0);
+    if (!cxt) return -1;
+    ExecContext actx = {cxt, ctx->snapshot};
+    int rc = -1;
+
+    u16 col_ids[HEAP_MAX_COLS];
+    u8 types[HEAP_MAX_COLS];
+    usize ncols = 0;
+    for (u16 c = 0; c < desc->natts; c++)
+    {
+        if (!stats_type_supported((TupleColType)desc->atttype[c])) continue;
+        col_ids[ncols] = c;
+        types[ncols++] = desc->atttype[c];
+    }
+
+    AnalyzeSink* sink = memoryContext_alloc_zero(cxt, sizeof(AnalyzeSink));
+    if (!sink) goto out;
+    sink->base.vtable = (PhysicalOperatorVTable*)&analyze_sink_vtable;
+    sink->base.type = PHYSICAL_ANALYZE;
+    sink->types = types;
+    sink->ncols = ncols;
+    sink->cap = STATS_SAMPLE_ROWS;
+    sink->rng = 0x9E3779B97F4A7C15ull;
+    sink->vals = memoryContext_alloc(cxt, (ncols > 0 ? ncols : 1) * sink->cap * sizeof(f64));
+    sink->nulls = memoryContext_alloc(cxt, sink->cap * sizeof(u64));
+    PhysicalTableScan* scan = PhysicalTableScan_create(&actx, table, col_ids, ncols);
+    if (!sink->vals || !sink->nulls || !scan) goto out;
+    if (physicalTableScan_run(scan, &sink->base) != 0) goto out;
+
+    ColumnStats* cols = calloc(desc->natts > 0 ? desc->natts : 1, sizeof(ColumnStats));
+    usize nvals = sink->nsample > 0 ? sink->nsample : 1;
+    f64* colvals = memoryContext_alloc(cxt, nvals * sizeof(f64));
+    if (!cols || !colvals)
+    {
+        free(cols);
+        goto out;
+    }
+    bool full = sink->nsample == sink->seen;
+    for (usize c = 0; c < ncols; c++)
+    {
+        ColumnStats* cs = &cols[col_ids[c]];
+        usize n = 0;
+        for (usize s = 0; s < sink->nsample; s++)
+        {
+            if ((sink->nulls[s] >> c) & 1) continue;
+            colvals[n++] = sink->vals[s * ncols + c];
+        }
+        qsort(colvals, n, sizeof(f64), cmp_f64);
+        cs->valid = true;
+        cs->type = (TupleColType)types[c];
+        cs->null_frac = sink->nsample > 0 ? (f64)(sink->nsample - n) / (f64)sink->nsample : 0.0;
+        columnStats_build(cs, colvals, n, full, (f64)sink->seen * (1.0 - cs->null_frac));
+    }
+    for (u16 c = 0; c < desc->natts; c++) cols[c].type = (TupleColType)desc->atttype[c];
+
+    free(stats->cols);
+    stats->cols = cols;
+    stats->ncols = desc->natts;
+    stats->nrows = sink->seen;
+    stats->sample_rows = sink->nsample;
+    rc = 0;
+out:
+    memoryContext_delete(cxt);
+    return rc;
+}
+
+/* ================= 选择率估计 ================= */
+
+// 非 NULL 值中严格小于 v 的比例：在等高直方图上定位桶，桶内线性插值
+static f64 columnStats_frac_lt(const ColumnStats* cs, f64 v)
+{
+    usize nb = cs->nbounds;
+    if (nb == 0) return 0.0;
+    if (nb == 1) return v > cs->bounds[0] ? 1.0 : 0.0;
+    usize lo = 0, hi = nb;  // 严格小于 v 的边界个数
+    while (lo < hi)
+    {
+        usize mid = (lo + hi) / 2;
+        if (cs->bounds[mid] < v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0) return 0.0;
+    if (lo == nb) return 1.0;
+    f64 lb = cs->bounds[lo - 1], ub = cs->bounds[lo];
+    f64 within = (v - lb) / (ub - lb);  // lb < v <= ub
+    return ((f64)(lo - 1) + within) / (f64)(nb - 1);
+}
+
+// 非 NULL 值中等于 v 的比例：值域外为 0，否则按均匀分布取 1 / 不同值个数
+static f64 columnStats_frac_eq(const ColumnStats* cs, f64 v)
+{
+    if (cs->ndistinct < 1.0 || v < cs->min || v > cs->max) return 0.0;
+    return 1.0 / cs->ndistinct;
+}
+
+static f64 clamp_prob(f64 p)
+{
+    return p < 0.0 ? 0.0 : (p > 1.0 ? 1.0 : p);
+}
+
+f64 optimizer_clause_selectivity(const TableStats* stats, const ExecPredicate* pred)
+{
+    const ColumnStats* cs = NULL;
+    if (stats && pred->col < stats->ncols && stats->cols[pred->col].valid)
+        cs = &stats->cols[pred->col];
+
+    if (pred->op == EXEC_CMP_IS_NULL) return cs ? cs->null_frac : DEFAULT_NULL_SEL;
+    if (pred->op == EXEC_CMP_NOT_NULL) return cs ? 1.0 - cs->null_frac : 1.0 - DEFAULT_NULL_SEL;
+    if (!cs)
+    {
+        if (pred->op == EXEC_CMP_EQ) return DEFAULT_EQ_SEL;
+        if (pred->op == EXEC_CMP_NE) return 1.0 - DEFAULT_EQ_SEL;
+        return DEFAULT_INEQ_SEL;
+    }
+
+    f64 v = datum_to_f64(pred->type, pred->value);
+    f64 nonnull = 1.0 - cs->null_frac;
+    f64 eq = columnStats_frac_eq(cs, v);
+    f64 lt = columnStats_frac_lt(cs, v);
+    f64 le = clamp_prob(lt + eq);
+    f64 sel;
+    switch (pred->op)
+    {
+        case EXEC_CMP_EQ:
+            sel = eq;
+            break;
+        case EXEC_CMP_NE:
+            sel = 1.0 - eq;
+            break;
+        case EXEC_CMP_LT:
+            sel = lt;
+            break;
+        case EXEC_CMP_LE:
+            sel = le;
+            break;
+        case EXEC_CMP_GT:
+            sel = 1.0 - le;
+            break;
+        case EXEC_CMP_GE:
+            sel = 1.0 - lt;
+            break;
+        default:
+            sel = DEFAULT_INEQ_SEL;
+            break;
+    }
+    return clamp_prob(nonnull * sel);
+}
+
+f64 optimizer_selectivity(const TableStats* stats, const ExecPredicate* preds, usize npreds)
+{
+    f64 sel = 1.0;
+    for (usize p = 0; p < npreds; p++) sel *= optimizer_clause_selectivity(stats, &preds[p]);
+    return clamp_prob(sel);
+}
+
+/* ================= 代价模型 ================= */
+
+/*
+ * 近似索引为给出 c 个候选要访问的节点数：图 / 倒排索引按 (c + ef) * log2(n) 估计，
+ * FLAT 索引总是穷举。
+ */
+static f64 index_visited(const VectorIndex* index, f64 c, f64 n)
+{
+    if (index->type == INDEX_FLAT) return n;
+    f64 visited = (c + OPT_INDEX_EF) * log2(n + 1.0);
+    return visited < n ? visited : n;
+}
+
+int optimizer_plan(const TableStats* stats, DataTable* table, const VectorQuery* query,
+                   QueryPlan* plan)
+{
+    if (!table || !query || !query->cond || !plan) return -1;
+    if (table->table->type != TABLE_AM_ROUTINE_EMBEDDING) return -1;
+    EmbeddingHeapTable* et = (EmbeddingHeapTable*)table->table;
+    usize dim = query->cond->query.count;
+    if (dim != (usize)et->embed_store.dimension) return -1;
+
+    memset(plan, 0, sizeof(*plan));
+    f64 nrows = stats ? (f64)stats->nrows : (f64)embeddingStore_published(&et->embed_store);
+    f64 sel = optimizer_selectivity(stats, query->preds, query->npreds);
+    plan->selectivity = sel;
+    plan->est_rows = sel * nrows;
+
+    f64 k = (f64)query->k;
+    f64 dist = (f64)dim * OPT_DIST_COST_PER_DIM;
+    f64 qual = (f64)query->npreds * OPT_CPU_OPERATOR_COST;
+    f64 topk = dist + log2(k + 1.0) * OPT_CPU_OPERATOR_COST;  // 一行进 top-k：算距离 + 堆比较
+    /* 至少有一行满足谓词，避免 k / 选择率 除零 */
+    f64 s = sel > 1.0 / (nrows > 1.0 ? nrows : 1.0) ? sel : 1.0 / (nrows > 1.0 ? nrows : 1.0);
+
+    /* 暴力：每行解码并求谓词，只对存活行算距离 */
+    plan->costs[PLAN_BRUTE_FORCE] = nrows * (OPT_CPU_TUPLE_COST + qual) + s * nrows * topk;
+    plan->costs[PLAN_INDEX_POSTFILTER] = INFINITY;
+    plan->costs[PLAN_INDEX_FILTERED] = INFINITY;
+    usize post_probe = 0, filt_probe = 0;
+    VectorIndex* post_index = NULL;
+    VectorIndex* filt_index = NULL;
+
+    LWLockAcquire(&et->index_lock, LW_SHARED);
+    VECTOR_FOREACH(&et->indexes, idx)
+    {
+        VectorIndex* index = *(VectorIndex**)idx;
+        if (index->metric != query->cond->metric || (usize)index->dimension != dim) continue;
+        f64 n = (f64)index->vector_count;
+        if (n < 1.0) n = 1.0;
+
+        /* 后过滤：多取 k / 选择率 个候选，全部回表求谓词，存活行重排 */
+        f64 probe = query->npreds > 0 ? ceil(k * OPT_POSTFILTER_OVERFETCH / s) : k;
+        if (query->npreds == 0 || probe <= k * OPT_POSTFILTER_MAX_EXPAND || probe >= n)
+        {
+            if (probe > n) probe = n;
+            f64 cost = index_visited(index, probe, n) * dist +
+                       probe * (OPT_RANDOM_FETCH_COST + qual) + s * probe * topk;
+            if (cost < plan->costs[PLAN_INDEX_POSTFILTER])
+            {
+                plan->costs[PLAN_INDEX_POSTFILTER] = cost;
+                post_index = index;
+                post_probe = (usize)probe;
+            }
+        }
+
+        /* 遍历时过滤：为凑出 k 个通过的候选要走过 k / 选择率 个，每个访问节点都回表求谓词 */
+        if (query->npreds > 0 && index->vtable->search_filtered)
+        {
+            f64 target = k / s < n ? k / s : n;
+            f64 visited = index_visited(index, target, n);
+            f64 cost = visited * (dist + OPT_RANDOM_FETCH_COST + qual) + k * topk;
+            if (cost < plan->costs[PLAN_INDEX_FILTERED])
+            {
+                plan->costs[PLAN_INDEX_FILTERED] = cost;
+                filt_index = index;
+                filt_probe = query->k;
+            }
+        }
+    }
+    LWLockRelease(&et->index_lock);
+
+    /* 代价相同时按枚举顺序取，优先不依赖索引召回的暴力扫描 */
+    plan->strategy = PLAN_BRUTE_FORCE;
+    for (int st = PLAN_INDEX_POSTFILTER; st < PLAN_STRATEGY_COUNT; st++)
+    {
+        if (plan->costs[st] < plan->costs[plan->strategy]) plan->strategy = (PlanStrategy)st;
+    }
+    plan->cost = plan->costs[plan->strategy];
+    if (plan->strategy == PLAN_INDEX_POSTFILTER)
+    {
+        plan->index = post_index;
+        plan->probe_k = post_probe;
+    }
+    else if (plan->strategy == PLAN_INDEX_FILTERED)
+    {
+        plan->index = filt_index;
+        plan->probe_k = filt_probe;
+    }
+    return 0;
+}
+
+/* ================= 执行 ================= */
+
+// 扫描列表里 heap 列 col 的位置，不在时追加
+static usize scan_cols_add(u16* cols, usize* n, u16 col)
+{
+    for (usize i = 0; i < *n; i++)
+    {
+        if (cols[i] == col) return i;
+    }
+    cols[*n] = col;
+    return (*n)++;
+}
+
+/*
+ * 搭流水线：<源头> ──► [filter] ──► topk(k) ──► project(query->cols) ──► collect。
+ * 扫描列是输出列和谓词列的并集，preds 已改写成批内列号。
+ */
+static int optimizer_run(ExecContext* ctx, DataTable* table, const VectorQuery* query,
+                         PlanStrategy strategy, const QueryPlan* plan, const u16* scan_cols,
+                         usize nscan, const ExecPredicate* preds, const u16* proj_cols,
+                         TableQueryResult* results)
+{
+    PhysicalCollect* collect = PhysicalCollect_create(ctx, results, query->k);
+    if (!collect) return -1;
+    PhysicalProjection* proj =
+        PhysicalProjection_create(ctx, proj_cols, query->ncols, &collect->base);
+    if (!proj) return -1;
+    PhysicalTopK* topk = PhysicalTopK_create(ctx, query->cond, query->k, nscan, &proj->base);
+    if (!topk) return -1;
+    PhysicalOperator* head = &topk->base;
+    if (strategy != PLAN_INDEX_FILTERED && query->npreds > 0)
+    {
+        PhysicalFilter* filter = PhysicalFilter_create(ctx, preds, query->npreds, head);
+        if (!filter) return -1;
+        head = &filter->base;
+    }
+
+    int rc;
+    const f32* q = (const f32*)query->cond->query.data;
+    switch (strategy)
+    {
+        case PLAN_BRUTE_FORCE:
+        {
+            PhysicalTableScan* scan = PhysicalTableScan_create(ctx, table, scan_cols, nscan);
+            rc = scan ? physicalTableScan_run(scan, head) : -1;
+            break;
+        }
+        case PLAN_INDEX_POSTFILTER:
+        {
+            PhysicalIndexScan* scan = PhysicalIndexScan_create(ctx, table, plan->index, q,
+                                                               plan->probe_k, scan_cols, nscan,
+                                                               NULL, 0);
+            rc = scan ? physicalIndexScan_run(scan, head) : -1;
+            break;
+        }
+        case PLAN_INDEX_FILTERED:
+        {
+            PhysicalIndexScan* scan = PhysicalIndexScan_create(ctx, table, plan->index, q,
+                                                               plan->probe_k, scan_cols, nscan,
+                                                               preds, query->npreds);
+            rc = scan ? physicalIndexScan_run(scan, head) : -1;
+            break;
+        }
+        default:
+            rc = -1;
+            break;
+    }
+    return rc == 0 ? (int)collect->count : -1;
+}
+
+int optimizer_execute(ExecContext* ctx, DataTable* table, const VectorQuery* query,
+                      QueryPlan* plan, TableQueryResult* results)
+{
+    if (query->ncols > HEAP_MAX_COLS || query->npreds > HEAP_MAX_COLS) return -1;
+    if (plan->strategy != PLAN_BRUTE_FORCE && !plan->index) return -1;
+
+    u16 scan_cols[HEAP_MAX_COLS * 2];
+    usize nscan = 0;
+    u16 proj_cols[HEAP_MAX_COLS];
+    for (usize i = 0; i < query->ncols; i++)
+        proj_cols[i] = (u16)scan_cols_add(scan_cols, &nscan, query->cols[i]);
+    ExecPredicate* preds = NULL;
+    if (query->npreds > 0)
+    {
+        preds = memoryContext_alloc(ctx->cxt, query->npreds * sizeof(ExecPredicate));
+        if (!preds) return -1;
+        for (usize p = 0; p < query->npreds; p++)
+        {
+            preds[p] = query->preds[p];
+            preds[p].col = (u16)scan_cols_add(scan_cols, &nscan, query->preds[p].col);
+        }
+    }
+
+    plan->fell_back = false;
+    int n = optimizer_run(ctx, table, query, plan->strategy, plan, scan_cols, nscan, preds,
+                          proj_cols, results);
+    /* 选择率被高估时后过滤凑不满 k 行；索引里还有没取的候选就退回暴力扫描 */
+    if (n >= 0 && plan->strategy == PLAN_INDEX_POSTFILTER && (usize)n < query->k &&
+        plan->probe_k < plan->index->vector_count)
+    {
+        plan->fell_back = true;
+        n = optimizer_run(ctx, table, query, PLAN_BRUTE_FORCE, plan, scan_cols, nscan, preds,
+                          proj_cols, results);
+    }
+    return n;
+}
+
+const char* planStrategy_name(PlanStrategy strategy)
+{
+    switch (strategy)
+    {
+        case PLAN_BRUTE_FORCE:
+            return "brute_force";
+        case PLAN_INDEX_POSTFILTER:
+            return "index_postfilter";
+        case PLAN_INDEX_FILTERED:
+            return "index_filtered";
+        default:
+            return "unknown";
+    }
+}
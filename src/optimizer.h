@@ -0,0 +1,126 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "executor.h"
+
+/**
+ * optimizer.h — 基于代价的向量查询优化器
+ *
+ * 一条「带 payload 过滤的 top-k 向量查询」有三条访问路径：
+ *
+ *   PLAN_BRUTE_FORCE       全表扫描 ──► 过滤 ──► 精确 top-k
+ *                          每行都要解码和求谓词，但只对存活行算距离。
+ *   PLAN_INDEX_POSTFILTER  索引取 probe_k ≈ k / 选择率 个候选 ──► 回表 ──► 过滤 ──► top-k
+ *                          过滤宽松时最便宜；选择率一低，需要的候选数超出索引能
+ *                          可靠给出的范围，召回掉得厉害，此时不考虑这条路径。
+ *   PLAN_INDEX_FILTERED    索引遍历时逐候选回表求谓词（VectorIndex.search_filtered），
+ *                          只有通过的候选进入结果；被拒节点也要付回表代价。
+ *
+ * 优化器先用 tableStats_analyze 采样得到的列统计（空值比例、不同值个数、等高直方图）
+ * 估计谓词合取的选择率（列间按独立假设相乘），再按下面的代价常数给三条路径估代价，
+ * 取最小者。过滤越严格越偏向暴力扫描存活行，越宽松越偏向走索引。
+ *
+ * 代价单位和 PG 一样是抽象的「一次顺序解码一行 = OPT_CPU_TUPLE_COST」。
+ */
+
+#define OPT_CPU_TUPLE_COST        0.01    // 顺序扫描解码一行
+#define OPT_CPU_OPERATOR_COST     0.0025  // 对一行求一个谓词 / 一次堆比较
+#define OPT_DIST_COST_PER_DIM     0.0005  // 距离计算的每维代价
+#define OPT_RANDOM_FETCH_COST     0.04    // 按 ctid 回表一行（随机访问页）
+#define OPT_INDEX_EF              64      // 近似索引搜索的最小候选宽度
+#define OPT_POSTFILTER_OVERFETCH  1.5     // 后过滤多取的候选倍数，吸收选择率估计误差
+#define OPT_POSTFILTER_MAX_EXPAND 10      // probe_k 超过 k 的这个倍数时不走后过滤
+
+#define STATS_SAMPLE_ROWS  30000  // 采样行数上限（水塘抽样）
+#define STATS_HIST_BOUNDS  33     // 直方图边界数（32 个等高桶）
+
+/* 缺少统计时的默认选择率，取值同 PG（DEFAULT_EQ_SEL / DEFAULT_INEQ_SEL） */
+#define DEFAULT_EQ_SEL     0.005
+#define DEFAULT_INEQ_SEL   0.3333333333333333
+#define DEFAULT_NULL_SEL   0.005
+
+typedef struct
+{
+    bool valid;          // 只有定宽列（BOOL / I32 / I64 / F32 / F64）会收集统计
+    TupleColType type;
+    f64 null_frac;       // NULL 行比例
+    f64 ndistinct;       // 非 NULL 不同值个数估计
+    f64 min;
+    f64 max;
+    u16 nbounds;         // 等高直方图边界数，0 表示没有直方图
+    f64 bounds[STATS_HIST_BOUNDS];
+} ColumnStats;
+
+typedef struct
+{
+    u64 nrows;           // 可见行数
+    u64 sample_rows;     // 参与统计的采样行数
+    u16 ncols;
+    ColumnStats* cols;   // 按 heap 列号索引
+} TableStats;
+
+void TableStats_init(TableStats* stats);
+void TableStats_deinit(TableStats* stats);
+
+/*
+ * 扫描全表，对定宽列做水塘抽样并建立统计。中间数据从 cxt 的子上下文分配，
+ * 返回前删除；stats->cols 由 TableStats_deinit 释放。成功返回 0，失败返回 -1。
+ */
+int tableStats_analyze(TableStats* stats, ExecContext* ctx, DataTable* table);
+
+/* 单个谓词的选择率；pred->col 是 heap 列号。stats 为 NULL 时用默认值 */
+f64 optimizer_clause_selectivity(const TableStats* stats, const ExecPredicate* pred);
+
+/* 合取谓词的选择率（独立假设），结果在 [0, 1] */
+f64 optimizer_selectivity(const TableStats* stats, const ExecPredicate* preds, usize npreds);
+
+/* 一条带过滤的 top-k 向量查询。谓词和输出列都用 heap 列号 */
+typedef struct
+{
+    const VectorCondition* cond;
+    usize k;
+    const ExecPredicate* preds;  // 合取
+    usize npreds;
+    const u16* cols;             // 结果 payload 的 heap 列
+    usize ncols;
+} VectorQuery;
+
+typedef enum
+{
+    PLAN_BRUTE_FORCE = 0,
+    PLAN_INDEX_POSTFILTER,
+    PLAN_INDEX_FILTERED,
+    PLAN_STRATEGY_COUNT,
+} PlanStrategy;
+
+typedef struct
+{
+    PlanStrategy strategy;
+    VectorIndex* index;               // 索引路径使用的索引
+    usize probe_k;                    // 索引路径向索引要的候选数
+    f64 selectivity;
+    f64 est_rows;                     // 估计满足谓词的行数
+    f64 cost;                         // 所选路径的代价
+    f64 costs[PLAN_STRATEGY_COUNT];   // 各路径代价，不可用为 INFINITY
+    bool fell_back;                   // 执行时后过滤结果不足 k 行，改用暴力扫描重做
+} QueryPlan;
+
+/*
+ * 为 query 选择访问路径。只支持 EmbeddingHeapTable；表上挂的索引度量和维数与
+ * query 一致时才参与比较。stats 为 NULL 时按默认选择率和当前向量数估计。
+ * 成功返回 0，参数不合法返回 -1。
+ */
+int optimizer_plan(const TableStats* stats, DataTable* table, const VectorQuery* query,
+                   QueryPlan* plan);
+
+/*
+ * 按 plan 搭执行器流水线运行，结果按距离升序写入 results（容量 query->k），payload
+ * 按 query->cols 的顺序，都从 ctx->cxt 分配。后过滤路径得到的行数少于 k 而索引
+ * 还有没取到的候选时，改用暴力扫描重做并置 plan->fell_back。返回结果行数，失败返回 -1。
+ */
+int optimizer_execute(ExecContext* ctx, DataTable* table, const VectorQuery* query,
+                      QueryPlan* plan, TableQueryResult* results);
+
+const char* planStrategy_name(PlanStrategy strategy);
+
+#endif
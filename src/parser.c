@@ -23,24 +23,27 @@ TypeID get_internal_type(SQLType type)
     }
 }
 
-void createSchemaInfo_deserialize(CreateSchemaInfo* info, MetaBlockReader* reader)
+void createSchemaInfo_deserialize(CreateSchemaInfo* info, MetaBlockReader* reader,
+                                  MemoryContext* cxt)
 {
-    info->schema_name = DESERIALIZER_READ_STRING(reader);
+    info->schema_name = DESERIALIZER_READ_STRING_CXT(reader, cxt);
     info->if_not_exists = false;
     // table_count 和 index_count 由 checkpointManager_read_schema 负责读取
 }
 
-void createTableInfo_deserialize(CreateTableInfo* info, MetaBlockReader* reader)
+void createTableInfo_deserialize(CreateTableInfo* info, MetaBlockReader* reader,
+                                 MemoryContext* cxt)
 {
-    info->schema_name = DESERIALIZER_READ_STRING(reader);
-    info->table_name = DESERIALIZER_READ_STRING(reader);
+    info->schema_name = DESERIALIZER_READ_STRING_CXT(reader, cxt);
+    info->table_name = DESERIALIZER_READ_STRING_CXT(reader, cxt);
     info->if_not_exists = true;
     info->col_count = DESERIALIZER_READ_U32(reader);
-    info->columns = malloc(info->col_count * sizeof(ColumnDefinition));
+    usize cols_size = info->col_count * sizeof(ColumnDefinition);
+    info->columns = cxt ? memoryContext_alloc(cxt, cols_size) : malloc(cols_size);
     for (usize i = 0; i < info->col_count; ++i)
     {
         ColumnDefinition* col = &info->columns[i];
-        col->name = DESERIALIZER_READ_STRING(reader);
+        col->name = DESERIALIZER_READ_STRING_CXT(reader, cxt);
         col->oid = i;
         col->type = (SQLType)DESERIALIZER_READ_U8(reader);
         switch (col->type)
@@ -2,6 +2,7 @@
 #define PARSER_H
 #include "vb_type.h"
 #include "types.h"
+#include "memctx.h"
 
 // 前向声明，避免 parser.h → storage.h → catalog.h → parser.h 循环依赖
 typedef struct MetaBlockReader MetaBlockReader;
@@ -25,7 +26,9 @@ typedef struct
     char* schema_name;
     bool if_not_exists;
 } CreateSchemaInfo;
-void createSchemaInfo_deserialize(CreateSchemaInfo* info, MetaBlockReader* reader);
+// 字符串从 cxt 分配（cxt 为 NULL 时 malloc，调用方逐个释放）
+void createSchemaInfo_deserialize(CreateSchemaInfo* info, MetaBlockReader* reader,
+                                  MemoryContext* cxt);
 
 typedef struct
 {
@@ -52,5 +55,7 @@ typedef struct
     ColumnDefinition* columns;
     usize col_count;
 } CreateTableInfo;
-void createTableInfo_deserialize(CreateTableInfo* info, MetaBlockReader* reader);
+// 字符串和 columns 数组从 cxt 分配（cxt 为 NULL 时 malloc）
+void createTableInfo_deserialize(CreateTableInfo* info, MetaBlockReader* reader,
+                                 MemoryContext* cxt);
 #endif
\ No newline at end of file
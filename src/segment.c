@@ -1,4 +1,6 @@
 #include <stdlib.h>
+#include <string.h>
+#include "epoch.h"
 #include "segment.h"
 #include "storage.h"
 #include "vector.h"
@@ -26,6 +28,8 @@ void SegmentTree_deinit(SegmentTree* tree, void (*node_destroy)(SegmentBase*))
     {
         vector_destroy(tree->nodes);
         tree->nodes = NULL;
+        // 扩容时退休的旧目录可能还在等待回收，销毁前把它们一并释放
+        epoch_synchronize();
     }
     tree->root_node = NULL;
 }
@@ -41,6 +45,7 @@ BlockSegment* BlockSegment_create1(BlockManager* manager, block_id_t block_id, u
     segment->byte_offset = offset;
     segment->block_manager = manager;
     segment->block = NULL; /* lazy loaded via segment_get_data */
+    LWLockInit(&segment->content_lock, "BlockSegment.content_lock");
     return segment;
 }
 
@@ -54,6 +59,7 @@ BlockSegment* BlockSegment_create2(usize start)
     segment->byte_offset = 0;
     segment->block_manager = NULL;
     segment->block = NULL;
+    LWLockInit(&segment->content_lock, "BlockSegment.content_lock");
     return segment;
 }
 
@@ -92,35 +98,108 @@ SegmentBase* segmentTree_get_root_segment(SegmentTree* tree)
     return tree->root_node;
 }
 
+// 读者一侧：不持页闩锁读段的行数，与写者在页闩锁下的 release 自增配对
+static inline usize segment_load_count(const SegmentBase* node)
+{
+    return __atomic_load_n(&node->count, __ATOMIC_ACQUIRE);
+}
+
+// 读者一侧：acquire 读目录指针与 size，与写者的 release 发布配对
+static inline Vector* segmentTree_load_nodes(SegmentTree* tree, usize* size)
+{
+    Vector* nodes = __atomic_load_n(&tree->nodes, __ATOMIC_ACQUIRE);
+    *size = __atomic_load_n(&nodes->size, __ATOMIC_ACQUIRE);
+    return nodes;
+}
+
 SegmentBase* SegmentTree_get_segment(SegmentTree* tree, usize row_number)
 {
-    // return vector_get(tree->nodes, index)->node;
+    epoch_enter();
+    usize n;
+    SegmentNode* entries = (SegmentNode*)segmentTree_load_nodes(tree, &n)->data;
+    SegmentBase* found = NULL;
+    usize lower = 0;
+    usize upper = n;
+    // binary search to find the node
+    while (lower < upper)
+    {
+        usize index = lower + (upper - lower) / 2;
+        SegmentNode* entry = &entries[index];
+        if (row_number < entry->row_start)
+        {
+            upper = index;
+        }
+        else if (row_number >= entry->row_start + segment_load_count(entry->node))
+        {
+            lower = index + 1;
+        }
+        else
+        {
+            found = entry->node;
+            break;
+        }
+    }
+    epoch_exit();
+    return found;
+}
+
+usize segmentTree_get_segment_index(SegmentTree* tree, usize row_number)
+{
+    epoch_enter();
+    usize n;
+    SegmentNode* entries = (SegmentNode*)segmentTree_load_nodes(tree, &n)->data;
+    usize found = (usize)-1;
     usize lower = 0;
-    usize upper = vector_size(tree->nodes) - 1;
-        // binary search to find the node
-    while (lower <= upper)
+    usize upper = n;
+    while (lower < upper)
     {
-        usize index = (lower + upper) / 2;
-        SegmentNode* entry = vector_get(tree->nodes, index);
+        usize index = lower + (upper - lower) / 2;
+        SegmentNode* entry = &entries[index];
         if (row_number < entry->row_start)
         {
-            upper = index - 1;
+            upper = index;
         }
-        else if (row_number >= entry->row_start + entry->node->count)
+        else if (row_number >= entry->row_start + segment_load_count(entry->node))
         {
             lower = index + 1;
         }
         else
         {
-            return entry->node;
+            found = index;
+            break;
         }
     }
-    return NULL;
+    epoch_exit();
+    return found;
 }
 
 SegmentBase* segmentTree_get_last_segment(SegmentTree* tree)
 {
-    return ((SegmentNode*)vector_back(tree->nodes))->node;
+    epoch_enter();
+    usize n;
+    Vector* nodes = segmentTree_load_nodes(tree, &n);
+    SegmentBase* last = n ? ((SegmentNode*)nodes->data)[n - 1].node : NULL;
+    epoch_exit();
+    return last;
+}
+
+usize segmentTree_segment_count(SegmentTree* tree)
+{
+    epoch_enter();
+    usize n;
+    segmentTree_load_nodes(tree, &n);
+    epoch_exit();
+    return n;
+}
+
+SegmentBase* segmentTree_get_node(SegmentTree* tree, usize index)
+{
+    epoch_enter();
+    usize n;
+    Vector* nodes = segmentTree_load_nodes(tree, &n);
+    SegmentBase* seg = index < n ? ((SegmentNode*)nodes->data)[index].node : NULL;
+    epoch_exit();
+    return seg;
 }
 
 data_ptr_t segment_get_data(BlockSegment* segment)
@@ -136,17 +215,37 @@ data_ptr_t segment_get_data(BlockSegment* segment)
     return segment->block->fb->buffer;
 }
 
+static void segmentTree_free_nodes(void* nodes)
+{
+    vector_destroy((Vector*)nodes);
+}
+
+// 写者由调用方串行化；读者随时可能在读旧目录，所以扩容不能 realloc
 void segmentTree_append_segment(SegmentTree* tree, SegmentBase* segment)
 {
     SegmentNode node = {segment->start, segment};
-    vector_push_back(tree->nodes, &node);
-    if (vector_size(tree->nodes) > 1)
+    Vector* nodes = tree->nodes;
+    usize n = nodes->size;
+    if (n > 0)
     {
-        SegmentNode* last = vector_get(tree->nodes, vector_size(tree->nodes) - 2);
-        last->node->next = segment;
+        ((SegmentNode*)nodes->data)[n - 1].node->next = segment;
     }
     else
     {
         tree->root_node = segment;
     }
+
+    if (n < nodes->capacity)
+    {
+        ((SegmentNode*)nodes->data)[n] = node;
+        __atomic_store_n(&nodes->size, n + 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    Vector* grown = NEW(Vector, sizeof(SegmentNode), n ? n * 2 : 1);
+    memcpy(grown->data, nodes->data, n * sizeof(SegmentNode));
+    ((SegmentNode*)grown->data)[n] = node;
+    grown->size = n + 1;
+    __atomic_store_n(&tree->nodes, grown, __ATOMIC_RELEASE);
+    epoch_retire(nodes, segmentTree_free_nodes);
 }
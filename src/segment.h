@@ -31,6 +31,12 @@ typedef struct
 } SegmentNode;
 
 // 行存储树
+//
+// nodes 是段目录。写者（由所属 store 的锁串行化）追加时：容量够则先写入新项再
+// release 发布 size；容量不够则复制到两倍容量的新目录，release 发布新的 nodes 指针，
+// 旧目录交给 epoch 延迟回收（见 epoch.h），从不原地 realloc。
+// 因此下面的查找函数无需持锁：它们在 epoch 临界区内读目录，读者从不因追加而阻塞。
+// 段本身在 tree 销毁前不会释放，返回的 SegmentBase* 离开临界区后依旧有效。
 typedef struct
 {
     SegmentBase* root_node;
@@ -51,6 +57,7 @@ typedef struct
     usize byte_offset; // 指向的字节偏移量
     BlockManager* block_manager; // 指向的块管理器
     Block* block; // 指向的块
+    LWLock content_lock; // 页内容闩锁：读页 SHARED，改页 EXCLUSIVE（HeapStore 页使用）
 } BlockSegment;
 
 BlockSegment* BlockSegment_create1(BlockManager* manager, block_id_t block_id, usize offset,
@@ -82,8 +89,18 @@ SegmentBase* segmentTree_get_root_segment(SegmentTree* tree);
 
 SegmentBase* SegmentTree_get_segment(SegmentTree* tree, usize index);
 
+// 返回包含 row_number 的段在 nodes 中的下标，不存在返回 (usize)-1
+usize segmentTree_get_segment_index(SegmentTree* tree, usize row_number);
+
+// 空树返回 NULL
 SegmentBase* segmentTree_get_last_segment(SegmentTree* tree);
 
+// 已发布的段数（无锁快照；并发追加下只会变大）
+usize segmentTree_segment_count(SegmentTree* tree);
+
+// 目录中第 index 个段，越界返回 NULL（无锁）
+SegmentBase* segmentTree_get_node(SegmentTree* tree, usize index);
+
 data_ptr_t segment_get_data(BlockSegment* segment);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "slab.h"
+
+// 映射一个 SLAB_SIZE 对齐的 slab：先试显式大页，再退回普通页 + 透明大页提示
+static void* slab_map(bool* huge)
+{
+#ifdef MAP_HUGETLB
+    void* p = mmap(NULL, SLAB_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED)
+    {
+        *huge = true;
+        return p;
+    }
+#endif
+    *huge = false;
+    // 多映射一个 slab 的余量，裁掉首尾让起点落在 2MB 边界上，THP 才能整块合并
+    usize span = SLAB_SIZE * 2;
+    u8* raw = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return NULL;
+    u8* base = (u8*)(((uintptr_t)raw + SLAB_SIZE - 1) & ~(uintptr_t)(SLAB_SIZE - 1));
+    if (base > raw) munmap(raw, (usize)(base - raw));
+    usize tail = (usize)(raw + span - (base + SLAB_SIZE));
+    if (tail) munmap(base + SLAB_SIZE, tail);
+#ifdef MADV_HUGEPAGE
+    madvise(base, SLAB_SIZE, MADV_HUGEPAGE);
+#endif
+    return base;
+}
+
+void SlabPool_init(SlabPool* pool, usize obj_size)
+{
+    memset(pool, 0, sizeof(*pool));
+    usize size = sizeof(void*);
+    while (size < obj_size) size <<= 1;
+    pool->obj_size = size;
+    SpinLockInit(&pool->lock);
+}
+
+void SlabPool_deinit(SlabPool* pool)
+{
+    for (usize i = 0; i < pool->nslabs; i++) munmap(pool->slabs[i].base, pool->slabs[i].size);
+    free(pool->slabs);
+    pool->slabs = NULL;
+    pool->nslabs = pool->slab_cap = 0;
+    pool->free_list = NULL;
+    pool->nfree = 0;
+    pool->nhuge = 0;
+    SpinLockFree(&pool->lock);
+}
+
+// 在锁内调用：登记新 slab，把除 keep 外的对象压入空闲链表
+static bool slabPool_add_slab(SlabPool* pool, u8* base, bool huge, void* keep)
+{
+    if (pool->nslabs == pool->slab_cap)
+    {
+        usize cap = pool->slab_cap ? pool->slab_cap * 2 : 8;
+        SlabChunk* slabs = realloc(pool->slabs, cap * sizeof(SlabChunk));
+        if (!slabs) return false;
+        pool->slabs = slabs;
+        pool->slab_cap = cap;
+    }
+    pool->slabs[pool->nslabs++] = (SlabChunk){base, SLAB_SIZE, huge};
+    if (huge) pool->nhuge++;
+    // 逆序压栈，按地址升序取出，相邻申请落在相邻页上
+    for (usize off = SLAB_SIZE; off >= pool->obj_size; off -= pool->obj_size)
+    {
+        void* obj = base + off - pool->obj_size;
+        if (obj == keep) continue;
+        *(void**)obj = pool->free_list;
+        pool->free_list = obj;
+        pool->nfree++;
+    }
+    return true;
+}
+
+void* slabPool_alloc(SlabPool* pool)
+{
+    SpinLockAcquire(&pool->lock);
+    void* obj = pool->free_list;
+    if (obj)
+    {
+        pool->free_list = *(void**)obj;
+        pool->nfree--;
+    }
+    SpinLockRelease(&pool->lock);
+    if (obj) return obj;
+
+    // 空闲链表耗尽：在锁外映射新 slab（系统调用不占自旋锁），第一个对象直接返回
+    bool huge;
+    u8* base = slab_map(&huge);
+    if (!base) return NULL;
+    SpinLockAcquire(&pool->lock);
+    bool ok = slabPool_add_slab(pool, base, huge, base);
+    SpinLockRelease(&pool->lock);
+    if (!ok)
+    {
+        munmap(base, SLAB_SIZE);
+        return NULL;
+    }
+    return base;
+}
+
+void slabPool_free(SlabPool* pool, void* obj)
+{
+    if (!obj) return;
+    SpinLockAcquire(&pool->lock);
+    *(void**)obj = pool->free_list;
+    pool->free_list = obj;
+    pool->nfree++;
+    SpinLockRelease(&pool->lock);
+}
+
+usize slabPool_mapped_bytes(SlabPool* pool)
+{
+    SpinLockAcquire(&pool->lock);
+    usize bytes = pool->nslabs * SLAB_SIZE;
+    SpinLockRelease(&pool->lock);
+    return bytes;
+}
+
+usize slabPool_free_count(SlabPool* pool)
+{
+    SpinLockAcquire(&pool->lock);
+    usize n = pool->nfree;
+    SpinLockRelease(&pool->lock);
+    return n;
+}
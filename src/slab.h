@@ -0,0 +1,55 @@
+#ifndef SLAB_H
+#define SLAB_H
+#include "vb_type.h"
+#include "lock.h"
+
+/**
+ * slab.h — 定长、按自身大小对齐的对象池
+ *
+ * 用于块缓冲区这类大小固定、频繁申请释放的内存：每次向系统要一整个 slab
+ * （SLAB_SIZE，2MB 对齐），切成 obj_size 的对象，空闲对象串在侵入式空闲链表上。
+ * 对象大小是 2 的幂时每个对象天然按 obj_size 对齐，没有 malloc 加对齐余量的浪费。
+ *
+ * slab 优先用显式大页（MAP_HUGETLB）；系统没有预留大页时退回普通映射并
+ * madvise(MADV_HUGEPAGE) 请求透明大页，都不可用时就是普通页。slab 只在
+ * SlabPool_deinit 时归还系统。
+ *
+ * 申请 / 释放只在空闲链表上加一把自旋锁，线程安全。
+ */
+
+#define SLAB_SIZE ((usize)2 << 20)
+
+typedef struct
+{
+    void* base;
+    usize size;
+    bool huge; // MAP_HUGETLB 映射
+} SlabChunk;
+
+typedef struct
+{
+    usize obj_size;      // 2 的幂，且不超过 SLAB_SIZE
+    slock_t lock;
+    void* free_list;     // 空闲对象链表，next 指针存在对象开头
+    SlabChunk* slabs;
+    usize nslabs;
+    usize slab_cap;
+    usize nfree;
+    usize nhuge;         // 用显式大页映射的 slab 数
+} SlabPool;
+
+void SlabPool_init(SlabPool* pool, usize obj_size);
+
+// 释放所有 slab；调用前对象必须都已归还（否则指针悬空）
+void SlabPool_deinit(SlabPool* pool);
+
+// 取一个对象，内容未定义；失败返回 NULL
+void* slabPool_alloc(SlabPool* pool);
+
+void slabPool_free(SlabPool* pool, void* obj);
+
+// 已映射的总字节数 / 空闲对象数
+usize slabPool_mapped_bytes(SlabPool* pool);
+usize slabPool_free_count(SlabPool* pool);
+
+#endif
@@ -3,6 +3,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <math.h>
 #include "catalog.h"
 #include "hash.h"
 #include "interface.h"
@@ -13,19 +17,53 @@
 #include "table.h"
 #include "operator.h"
 
+static SlabPool block_buffer_pool;
+static pthread_once_t block_buffer_pool_once = PTHREAD_ONCE_INIT;
+
+static void blockBuffer_pool_init(void)
+{
+    SlabPool_init(&block_buffer_pool, BLOCK_SIZE);
+}
+
+SlabPool* blockBuffer_pool(void)
+{
+    pthread_once(&block_buffer_pool_once, blockBuffer_pool_init);
+    return &block_buffer_pool;
+}
+
+// 从池里取一块 BLOCK_SIZE 缓冲区挂到 fb 上；池里的对象按 BLOCK_SIZE 对齐，不需要对齐余量
+static bool fileBuffer_attach_pooled(FileBuffer* fb)
+{
+    u8* buf = slabPool_alloc(blockBuffer_pool());
+    if (!buf)
+    {
+        return false;
+    }
+    memset(buf, 0, BLOCK_SIZE);
+    fb->internal_buf = buf;
+    fb->internal_size = BLOCK_SIZE;
+    fb->buffer = buf + FILE_BUFFER_HEADER_SIZE;
+    fb->size = BLOCK_SIZE - FILE_BUFFER_HEADER_SIZE;
+    fb->flags |= FILEBUFFER_POOLED;
+    return true;
+}
+
 Block* Block_create(block_id_t block_id)
 {
-    Block* block = (Block*)malloc(sizeof(Block));
+    // Block 和 FileBuffer 结构体放在同一次分配里，缓冲区来自池
+    Block* block = (Block*)malloc(sizeof(Block) + sizeof(FileBuffer));
     if (!block)
     {
         return NULL;  // 内存分配失败
     }
     block->id = block_id;  // 分配新的块 ID
-    block->fb = NEW(FileBuffer, BLOCK_SIZE);  // 创建新的 FileBuffer
-    if (!block->fb)
+    block->fb = (FileBuffer*)(block + 1);
+    memset(block->fb, 0, sizeof(FileBuffer));
+    block->fb->flags = FILEBUFFER_EMBEDDED;
+    if (!fileBuffer_attach_pooled(block->fb))
     {
         free(block);
-        return NULL;  // FileBuffer 创建失败
+        return NULL;  // 缓冲区分配失败
     }
     return block;
 }
@@ -45,6 +83,20 @@ void block_destroy(Block* block)
 
 FileBuffer* FileBuffer_create(usize bufsiz)
 {
+    if (bufsiz == BLOCK_SIZE)
+    {
+        FileBuffer* fb = (FileBuffer*)calloc(1, sizeof(FileBuffer));
+        if (!fb)
+        {
+            return NULL;
+        }
+        if (!fileBuffer_attach_pooled(fb))
+        {
+            free(fb);
+            return NULL;
+        }
+        return fb;
+    }
     // 计算总内存：结构体 + 实际需要的缓冲区大小 + 对齐空间
     size_t total_size = sizeof(FileBuffer) + bufsiz + (FILE_BUFFER_BLOCK_SIZE - 1);
     // 分配内存
@@ -111,7 +163,18 @@ void fileBuffer_clear(FileBuffer* fb)
 
 void fileBuffer_destroy(FileBuffer* buffer)
 {
-    if (buffer)
+    if (!buffer)
+    {
+        return;
+    }
+    if (buffer->flags & FILEBUFFER_POOLED)
+    {
+        slabPool_free(blockBuffer_pool(), buffer->internal_buf);
+        buffer->internal_buf = NULL;
+        buffer->flags &= ~FILEBUFFER_POOLED;
+    }
+    // 嵌在 Block 里的结构体随 Block 一起释放
+    if (!(buffer->flags & FILEBUFFER_EMBEDDED))
     {
         free(buffer);
     }
@@ -225,8 +288,7 @@ static void metaBlockReader_read_new_block(MetaBlockReader* reader, block_id_t b
 void MetaBlockReader_init(MetaBlockReader* reader, BlockManager* manager, block_id_t block_id)
 {
     reader->manager = manager;
-    reader->block = (Block*)malloc(sizeof(Block));
-    reader->block->fb = NEW(FileBuffer, BLOCK_SIZE);
+    reader->block = Block_create(INVALID_BLOCK);
     reader->offset = 0;
     reader->next_block_id = -1;
     metaBlockReader_read_new_block(reader, block_id);
@@ -312,8 +374,7 @@ static void metaBlockWriter_deinit(MetaBlockWriter* writer)
     metaBlockWriter_flush(writer);
     if (writer->block)
     {
-        fileBuffer_destroy(writer->block->fb);
-        free(writer->block);
+        block_destroy(writer->block);
         writer->block = NULL;
     }
 }
@@ -386,6 +447,7 @@ void destory_single_manager(SingleFileBlockManager* manager)
     // 释放 used_blocks 和 free_list
     vector_deinit(&manager->used_blocks);
     vector_deinit(&manager->free_list);
+    LWLockDestroy(&manager->lock);
 
     // 释放 manager 本身
     free(manager);
@@ -395,28 +457,37 @@ static void single_file_block_manager_read(BlockManager* self, Block* block)
 {
     SingleFileBlockManager* manager = (SingleFileBlockManager*)self;
     assert(block->id >= 0);
+    LWLockAcquire(&manager->lock, LW_EXCLUSIVE);
     // 记录读取的块 → 这些是旧检查点的块
     vector_push_back(&manager->used_blocks, &block->id);
     fileBuffer_read(block->fb, manager->file_handle, BLOCK_START + block->id * BLOCK_SIZE);
+    LWLockRelease(&manager->lock);
 }
 
 static void single_file_block_manager_write(BlockManager* self, Block* block)
 {
     SingleFileBlockManager* manager = (SingleFileBlockManager*)self;
     assert(block->id >= 0);
+    LWLockAcquire(&manager->lock, LW_EXCLUSIVE);
     fileBuffer_write(block->fb, manager->file_handle, BLOCK_START + block->id * BLOCK_SIZE);
+    LWLockRelease(&manager->lock);
 }
 
 static block_id_t single_file_block_manager_get_free_block_id(BlockManager* self)
 {
     SingleFileBlockManager* manager = (SingleFileBlockManager*)self;
+    block_id_t block_id;
+    LWLockAcquire(&manager->lock, LW_EXCLUSIVE);
     if (manager->free_list.size > 0)
     {
-        block_id_t block_id;
         vector_pop_back(&manager->free_list, &block_id);
-        return block_id;
     }
-    return manager->max_block++;
+    else
+    {
+        block_id = manager->max_block++;
+    }
+    LWLockRelease(&manager->lock);
+    return block_id;
 }
 
 static block_id_t single_file_block_manager_get_frist_meta_block(BlockManager* self)
@@ -487,9 +558,12 @@ static Block* single_file_block_manager_create_block(BlockManager* self)
  */
 static void single_file_block_manager_write_header(BlockManager* self, DatabaseHeader header)
 {
+    // 注意：不持有 manager->lock —— 下面的 MetaBlockWriter 会经由 vtable 再次分配/写块。
+    // write_header 只在 checkpoint 收尾阶段由单线程调用，此时所有 worker 已经 join。
     SingleFileBlockManager* manager = DOWNCAST(self, SingleFileBlockManager);
     header.iteration = ++manager->iteration_count;
     header.block_count = manager->max_block;
+    header.checkpoint_format = CHECKPOINT_FORMAT;
     if (manager->used_blocks.size > 0)
     {
         MetaBlockWriter writer;
@@ -518,6 +592,7 @@ static void single_file_block_manager_write_header(BlockManager* self, DatabaseH
                      // 写入 H2 时，偏移量为 HEADER_SIZE * 2
     manager->active_header = 1 - manager->active_header;// 切换到 H2
     manager->meta_block = header.meta_block;
+    self->checkpoint_format = header.checkpoint_format;
     fileHandle_sync(manager->file_handle);
     vector_deinit(&manager->free_list);
     manager->free_list = manager->used_blocks;
@@ -561,6 +636,7 @@ static void initialize_manager(SingleFileBlockManager* manager, DatabaseHeader*
     manager->meta_block = header->meta_block;
     manager->iteration_count = header->iteration;
     manager->max_block = header->block_count;
+    manager->base.checkpoint_format = header->checkpoint_format;
 }
 
 /**
@@ -582,10 +658,12 @@ SingleFileBlockManager* create_new_database(const char* path, bool create_new)
         return NULL;  // 内存分配失败
     }
     memset(manager, 0, sizeof(SingleFileBlockManager));
+    LWLockInit(&manager->lock, "SingleFileBlockManager.lock");
 
     // 初始化 BlockManager 基类字段
     manager->base.vtable = &single_file_block_manager_vtable;
     manager->base.type = BLOCK_MANAGER_SINGLE_FILE;
+    manager->base.checkpoint_format = CHECKPOINT_FORMAT;
     manager->file_path = strdup(path);
     Vector used_blocks = VEC(block_id_t, 0);
     manager->used_blocks = used_blocks;
@@ -629,6 +707,7 @@ SingleFileBlockManager* create_new_database(const char* path, bool create_new)
         db_header->meta_block = INVALID_BLOCK;
         db_header->free_list_id = INVALID_BLOCK;
         db_header->block_count = 0;
+        db_header->checkpoint_format = CHECKPOINT_FORMAT;
         fileBuffer_write(header_buffer, (FileHandle*)file_handle, HEADER_SIZE);
         // header 2
         db_header->iteration = 1;
@@ -678,12 +757,6 @@ static void schema_scan_fn(CatalogEntry* entry, void* ctx)
     vector_push_back(schemas, schema);
 }
 
-static void checkpointManager_destroy(CheckpointManager* self)
-{
-    metaBlockWriter_destroy(self->meta_block_writer);
-    free(self);
-}
-
 static void checkpointManager_write_table_catalog(CheckpointManager* self, TableCatalogEntry* entry)
 {
     // 写入 schema 名称
@@ -724,16 +797,24 @@ static void TableDataWriter_init(TableDataWriter* self, CheckpointManager* manag
     Vector_init(&self->tuple_counts, sizeof(usize), 0);
     Vector_init(&self->row_numbers, sizeof(usize), 0);
     Vector_init(&self->indexes, sizeof(usize), 0);
+    Vector_init(&self->mins, sizeof(f64), 0);
+    Vector_init(&self->maxs, sizeof(f64), 0);
     Vector_init(&self->data_pointers, sizeof(Vector), table->column_count);
 }
 
 static void tableDataWriter_deinit(TableDataWriter* self)
 {
+    VECTOR_FOREACH(&self->blocks, blk)
+    {
+        block_destroy(*(Block**)blk);
+    }
     vector_deinit(&self->blocks);
     vector_deinit(&self->offsets);
     vector_deinit(&self->tuple_counts);
     vector_deinit(&self->row_numbers);
     vector_deinit(&self->indexes);
+    vector_deinit(&self->mins);
+    vector_deinit(&self->maxs);
     VECTOR_FOREACH(&self->data_pointers, data_pointer)
     {
         vector_deinit(data_pointer);
@@ -753,8 +834,9 @@ static void TableDataWriter_flush_block(TableDataWriter* self, usize col)
     DataPointer data;
     Block* blk = VECTOR_AT(&self->blocks, col, Block*);
     blk->id = VCALL(self->manager->block_manager, get_free_block_id);
-    data.min = 0;
-    data.max = 0;
+    data.min = VECTOR_AT(&self->mins, col, f64);
+    data.max = VECTOR_AT(&self->maxs, col, f64);
+    data.has_stats = true;
     data.block_id = blk->id;
     data.offset = 0;
     data.tuple_count = VECTOR_AT(&self->tuple_counts, col, usize);
@@ -768,6 +850,9 @@ static void TableDataWriter_flush_block(TableDataWriter* self, usize col)
     usize new_row_number = row_number + VECTOR_AT(&self->tuple_counts, col, usize);
     vector_set(&self->row_numbers, col, &new_row_number);
     vector_set(&self->tuple_counts, col, &zero);
+    f64 empty_min = INFINITY, empty_max = -INFINITY;
+    vector_set(&self->mins, col, &empty_min);
+    vector_set(&self->maxs, col, &empty_max);
 }
 
 static void TableDataWriter_flush_if_full(TableDataWriter* self, usize col, usize write_size)
@@ -788,6 +873,9 @@ static void tableDataWriter_writecolumndata(TableDataWriter* self, DataChunk* ch
                      VECTOR_AT(&self->offsets, column_index, usize);
     VectorBase source = chunk->arrays[column_index];
     copy_to_storage(&source, ptr, 0, source.count);
+    // 维护当前块的 zone map，flush 时写入 DataPointer
+    VectorBase_update_minmax(&source, VECTOR_GET(&self->mins, column_index, f64),
+                             VECTOR_GET(&self->maxs, column_index, f64));
 
     usize new_offset = VECTOR_AT(&self->offsets, column_index, usize) + size;
     vector_set(&self->offsets, column_index, &new_offset);
@@ -810,6 +898,7 @@ static void tableDataWriter_write_data_pointers(TableDataWriter* self)
             SERIALIZER_WRITE_U64(self->manager->tabledata_writer, data_pointer->tuple_count);
             SERIALIZER_WRITE_U64(self->manager->tabledata_writer, data_pointer->block_id);
             SERIALIZER_WRITE_U32(self->manager->tabledata_writer, data_pointer->offset);
+            SERIALIZER_WRITE_U8(self->manager->tabledata_writer, (u8)data_pointer->has_stats);
         }
     }
 }
@@ -827,6 +916,7 @@ static void tableDataWriter_write_data(TableDataWriter* self)
     Vector types = tableCatalogEntry_get_types(self->table);
     DataChunk chunk = MAKE(DataChunk, types);
     usize zero = 0;
+    f64 empty_min = INFINITY, empty_max = -INFINITY;
     for (int i = 0; i < self->table->column_count; i++)
     {
         // for each column, create a block that serves as the buffer for that blocks data
@@ -835,6 +925,8 @@ static void tableDataWriter_write_data(TableDataWriter* self)
         vector_push_back(&self->offsets, &zero);
         vector_push_back(&self->tuple_counts, &zero);
         vector_push_back(&self->row_numbers, &zero);
+        vector_push_back(&self->mins, &empty_min);
+        vector_push_back(&self->maxs, &empty_max);
         Vector dp_list;
         Vector_init(&dp_list, sizeof(DataPointer), 0);
         vector_push_back(&self->data_pointers, &dp_list);
@@ -860,68 +952,172 @@ static void tableDataWriter_write_data(TableDataWriter* self)
     scanstate_deinit(&state);
     vector_deinit(&column_ids);
     vector_deinit(&types);
-    tableDataWriter_write_data_pointers(self);
+    // DataPointer 只保存在内存里，由 checkpointManager_write_table_meta 串行写入 tabledata 链
 }
 
-//   DBHeader.meta_block
-//       → metadata_writer 链 (Schema 定义 + Table 定义 + td_block/td_offset)
-//           → tabledata_writer 链 (每列的 DataPointer 索引数组)
-//               → DataPointer.block_id → 实际列数据 Block (256KB 原始数据)
-void checkpointManager_write_table(CheckpointManager* self, TableCatalogEntry* entry)
+/* 写表的元数据：catalog 定义 + td_block/td_offset + 各列 DataPointer（拼接阶段，串行）。 */
+static void checkpointManager_write_table_meta(CheckpointManager* self, TableDataWriter* writer)
 {
-    checkpointManager_write_table_catalog(self, entry);
+    checkpointManager_write_table_catalog(self, writer->table);
     // 写入 td_block_id
     SERIALIZER_WRITE_U64(self->meta_block_writer, self->tabledata_writer->block->id);
     // 写入 td_offset
     SERIALIZER_WRITE_U64(self->meta_block_writer, self->tabledata_writer->offset);
+    tableDataWriter_write_data_pointers(writer);
+}
 
+//   DBHeader.meta_block
+//       → metadata_writer 链 (Schema 定义 + Table 定义 + td_block/td_offset)
+//           → tabledata_writer 链 (每列的 DataPointer 索引数组)
+//               → DataPointer.block_id → 实际列数据 Block (256KB 原始数据)
+void checkpointManager_write_table(CheckpointManager* self, TableCatalogEntry* entry)
+{
     TableDataWriter writer = MAKE(TableDataWriter, self, entry);
     tableDataWriter_write_data(&writer);
+    checkpointManager_write_table_meta(self, &writer);
     tableDataWriter_deinit(&writer);
 }
 
-static void checkpointManager_write_schema(CheckpointManager* self, SchemaCatalogEntry* entry)
+/* 收集 schema 下所有未删除的表，按 HMAP 迭代顺序为每张表准备一个 TableDataWriter。 */
+static void checkpointManager_collect_tables(CheckpointManager* self, SchemaCatalogEntry* entry,
+                                             Vector* writers)
 {
-    // 写入 schema 名称
-    SERIALIZER_WRITE_STRING(self->meta_block_writer, GET_PARENT_FIELD(entry, name));
-    // 写 table 数量
-    SERIALIZER_WRITE_U32(self->meta_block_writer, catalogSet_get_entry_count(&entry->tables));
     HMAP_FOREACH(&entry->tables.data, _table_raw)
     {
         TableCatalogEntry* tbl = *(TableCatalogEntry**)_table_raw;
        // 跳过已删除的条目（与 catalogSet_get_entry_count 计数逻辑一致）
         if (tbl->base.deleted) continue;
-        checkpointManager_write_table(self, tbl);
+        // 懒加载模式下尚未读入的表必须先加载，否则会把空表写进新的 checkpoint
+        tableCatalogEntry_ensure_loaded(tbl);
+        TableDataWriter writer = MAKE(TableDataWriter, self, tbl);
+        vector_push_back(writers, &writer);
+    }
+}
+
+/* 写 schema 元数据；writers 是 collect 阶段准备好、已写完列数据的 TableDataWriter 游标。 */
+static void checkpointManager_write_schema(CheckpointManager* self, SchemaCatalogEntry* entry,
+                                           TableDataWriter** writers)
+{
+    // 写入 schema 名称
+    SERIALIZER_WRITE_STRING(self->meta_block_writer, GET_PARENT_FIELD(entry, name));
+    // 写 table 数量
+    u32 table_count = catalogSet_get_entry_count(&entry->tables);
+    SERIALIZER_WRITE_U32(self->meta_block_writer, table_count);
+    for (u32 i = 0; i < table_count; i++)
+    {
+        checkpointManager_write_table_meta(self, *writers);
+        tableDataWriter_deinit(*writers);
+        (*writers)++;
     }
     // 写索引数量（当前阶段为 0，占位）
     SERIALIZER_WRITE_U32(self->meta_block_writer, 0);
 }
 
+/*
+ * 并行 checkpoint 的工作队列。
+ *
+ * 每张表的列数据块由一个 TableDataWriter 独立写出（各自 Block_create 写缓冲、
+ * 各自向 BlockManager 申请块号），worker 通过原子计数领取下一张表。
+ * worker 是共享线程池上的任务（threadPool_shared），不再单独起线程。
+ * DataPointer 留在各 writer 内存中，全部 worker join 之后再由主线程按
+ * 原顺序拼接进 meta / tabledata 链，因此磁盘格式与串行 checkpoint 完全一致。
+ */
+typedef struct
+{
+    TableDataWriter* writers;
+    usize count;
+    _Atomic usize next;
+} CheckpointWorkQueue;
+
+static void checkpoint_worker_main(void* arg)
+{
+    CheckpointWorkQueue* queue = (CheckpointWorkQueue*)arg;
+    for (;;)
+    {
+        usize i = atomic_fetch_add_explicit(&queue->next, 1, memory_order_relaxed);
+        if (i >= queue->count) break;
+        tableDataWriter_write_data(&queue->writers[i]);
+    }
+}
+
+static void checkpointManager_write_tables_parallel(CheckpointManager* self,
+                                                    CheckpointWorkQueue* queue)
+{
+    usize nthreads = MIN((usize)self->nworkers, queue->count);
+    TaskGroup group;
+    TaskGroup_init(&group, nthreads > 1 ? threadPool_shared() : NULL);
+    for (usize i = 0; i + 1 < nthreads; i++)
+    {
+        taskGroup_spawn(&group, checkpoint_worker_main, queue);
+    }
+    // 当前线程也作为一个 worker；池里的 worker 忙于别的任务时剩余的表由它完成
+    checkpoint_worker_main(queue);
+    taskGroup_wait(&group);
+}
+
 CheckpointManager* CheckpointManager_create(BlockManager* block_manager, Catalog* catalog)
 {
     CheckpointManager* self = (CheckpointManager*)malloc(sizeof(CheckpointManager));
     self->block_manager = block_manager;
     self->catalog = catalog;
+    self->meta_block_writer = NULL;
+    self->tabledata_writer = NULL;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    self->nworkers = ncpu > 0 ? (u32)ncpu : 1;
+    self->load_mode = CHECKPOINT_LOAD_EAGER;
+    self->prefetch_workers = 0;
+    self->pending_tables = VEC(TableCatalogEntry*, 0);
+    atomic_init(&self->prefetch_next, 0);
+    TaskGroup_init(&self->prefetch_group, NULL);
 
     return self;
 }
 
+void checkpointManager_set_load_mode(CheckpointManager* self, CheckpointLoadMode mode,
+                                     u32 prefetch_workers)
+{
+    self->load_mode = mode;
+    self->prefetch_workers = prefetch_workers;
+}
+
+void checkpointManager_set_workers(CheckpointManager* self, u32 nworkers)
+{
+    self->nworkers = nworkers > 0 ? nworkers : 1;
+}
+
 void checkpointManager_createpoint(CheckpointManager* self)
 {
     BlockManager* block_manager = self->block_manager;
+    Vector schemas = VEC(SchemaCatalogEntry, 0);
+    catalogSet_scan(&self->catalog->schemas, schema_scan_fn, &schemas);
+
+    // 1. 收集所有表，并行写出列数据块
+    Vector writers = VEC(TableDataWriter, 0);
+    VECTOR_FOREACH(&schemas, schema_raw)
+    {
+        checkpointManager_collect_tables(self, schema_raw, &writers);
+    }
+    CheckpointWorkQueue queue = {
+        .writers = (TableDataWriter*)writers.data,
+        .count = writers.size,
+    };
+    atomic_init(&queue.next, 0);
+    checkpointManager_write_tables_parallel(self, &queue);
+
+    // 2. 串行拼接：schema / table 定义 + 每张表的 DataPointer
     self->meta_block_writer = MetaBlockWriter_create(block_manager);
     self->tabledata_writer = MetaBlockWriter_create(block_manager);
     MetaBlockWriter* meta_block_writer = self->meta_block_writer;
     block_id_t meta_block = meta_block_writer->block->id;
-    Vector schemas = VEC(SchemaCatalogEntry, 0);
-    catalogSet_scan(&self->catalog->schemas, schema_scan_fn, &schemas);
     u32 schema_count = (u32)schemas.size;
     SERIALIZER_WRITE_TYPE(meta_block_writer, (data_ptr_t)&schema_count, u32);
+    TableDataWriter* cursor = (TableDataWriter*)writers.data;
     VECTOR_FOREACH(&schemas, schema)
     {
         // 写入 schema 到元数据块
-        checkpointManager_write_schema(self, schema);
+        checkpointManager_write_schema(self, schema, &cursor);
     }
+    vector_deinit(&writers);
     vector_deinit(&schemas);
     metaBlockWriter_flush(meta_block_writer);
     metaBlockWriter_flush(self->tabledata_writer);
@@ -951,6 +1147,8 @@ static void TableDataReader_init(TableDataReader* self, CheckpointManager* manag
     Vector_init(&self->row_numbers, sizeof(usize), 0);
     Vector_init(&self->indexes, sizeof(usize), 0);
     Vector_init(&self->data_pointers, sizeof(Vector), table->column_count);
+    self->blocks_read = 0;
+    self->blocks_skipped = 0;
 }
 
 static void TableDataReader_deinit(TableDataReader* self)
@@ -974,6 +1172,7 @@ static void TableDataReader_deinit(TableDataReader* self)
 
 static void tableDataReader_read_data_pointers(TableDataReader* self)
 {
+    u64 format = self->manager->block_manager->checkpoint_format;
     for (usize i = 0; i < self->table->column_count; i++)
     {
         u64 dp_count = DESERIALIZER_READ_U64(self->reader);
@@ -987,147 +1186,253 @@ static void tableDataReader_read_data_pointers(TableDataReader* self)
             dp.tuple_count = DESERIALIZER_READ_U64(self->reader);
             dp.block_id = DESERIALIZER_READ_U64(self->reader);
             dp.offset = DESERIALIZER_READ_U32(self->reader);
+            // 旧格式没有这个标志，min/max 恒为 0，不能用来跳块
+            dp.has_stats = format >= CHECKPOINT_FORMAT_ZONE_MAP
+                               ? DESERIALIZER_READ_U8(self->reader) != 0
+                               : false;
             vector_push_back(&dp_list, &dp);
         }
         vector_push_back(&self->data_pointers, &dp_list);
     }
 }
 
-static bool tableDataReader_read_block(TableDataReader* self, usize col)
+bool dataPointer_may_match(const DataPointer* dp, const ZoneMapPredicate* pred)
 {
-    usize idx = VECTOR_AT(&self->indexes, col, usize);
-    Vector* dp_list = VECTOR_GET(&self->data_pointers, col, Vector);
-    if (idx >= vector_size(dp_list)) return false;
+    if (!dp->has_stats) return true;
+    return dp->min <= pred->max && dp->max >= pred->min;
+}
+
+typedef struct
+{
+    u64 start; // 起始行（含）
+    u64 end;   // 结束行（不含）
+} RowRange;
+
+/* 收集 pred 所在列中可能匹配的块覆盖的行区间，相邻区间合并。 */
+static void tableDataReader_zone_ranges(TableDataReader* self, const ZoneMapPredicate* pred,
+                                        Vector* ranges)
+{
+    Vector* dp_list = VECTOR_GET(&self->data_pointers, pred->column, Vector);
+    VECTOR_FOREACH(dp_list, raw)
+    {
+        DataPointer* dp = (DataPointer*)raw;
+        if (!dataPointer_may_match(dp, pred)) continue;
+        RowRange r = {dp->row_start, dp->row_start + dp->tuple_count};
+        if (vector_size(ranges) > 0)
+        {
+            RowRange* last = VECTOR_GET(ranges, vector_size(ranges) - 1, RowRange);
+            if (last->end == r.start)
+            {
+                last->end = r.end;
+                continue;
+            }
+        }
+        vector_push_back(ranges, &r);
+    }
+}
 
-    DataPointer* dp = vector_get(dp_list, idx);
+/* 两个有序区间列表求交（多个谓词之间是 AND）。 */
+static void row_ranges_intersect(Vector* a, Vector* b, Vector* out)
+{
+    usize i = 0, j = 0;
+    while (i < vector_size(a) && j < vector_size(b))
+    {
+        RowRange* ra = VECTOR_GET(a, i, RowRange);
+        RowRange* rb = VECTOR_GET(b, j, RowRange);
+        RowRange r = {MAX(ra->start, rb->start), MIN(ra->end, rb->end)};
+        if (r.start < r.end) vector_push_back(out, &r);
+        if (ra->end < rb->end)
+            i++;
+        else
+            j++;
+    }
+}
+
+/*
+ * 把 col 列的 [row, row + n) 行拷贝进 chunk。各列的块边界互不相同，
+ * indexes[col] 记录该列当前所在的 DataPointer 下标（行号单调递增，只会向前移动），
+ * 块只有在真正被访问时才从磁盘读取，因此 zone map 排除的行区间对应的块不会被读到。
+ */
+static void tableDataReader_copy_rows(TableDataReader* self, usize col, u64 row, usize n,
+                                      DataChunk* chunk)
+{
+    TypeID type = get_internal_type(self->table->columns[col].type);
+    usize type_size = get_typeid_size(type);
+    Vector* dp_list = VECTOR_GET(&self->data_pointers, col, Vector);
     Block* blk = VECTOR_AT(&self->blocks, col, Block*);
-    blk->id = dp->block_id;
-    // read the data for the block from disk
-    VCALL(self->manager->block_manager, read, blk);
-    usize off = (usize)dp->offset;
-    vector_set(&self->offsets, col, &off);
-    usize zero = 0;
-    vector_set(&self->tuple_counts, col, &zero);
-    usize next_idx = idx + 1;
-    vector_set(&self->indexes, col, &next_idx);
-    return true;
+    usize idx = VECTOR_AT(&self->indexes, col, usize);
+    usize filled = 0;
+    while (filled < n && idx < vector_size(dp_list))
+    {
+        DataPointer* dp = VECTOR_GET(dp_list, idx, DataPointer);
+        u64 cur = row + filled;
+        u64 block_end = dp->row_start + dp->tuple_count;
+        if (cur >= block_end)
+        {
+            idx++;
+            continue;
+        }
+        if (blk->id != dp->block_id)
+        {
+            // read the data for the block from disk
+            blk->id = dp->block_id;
+            VCALL(self->manager->block_manager, read, blk);
+            self->blocks_read++;
+        }
+        usize to_read = MIN(n - filled, block_end - cur);
+        data_ptr_t src = blk->fb->buffer + dp->offset + (cur - dp->row_start) * type_size;
+        memcpy(chunk->arrays[col].data + filled * type_size, src, to_read * type_size);
+        filled += to_read;
+    }
+    vector_set(&self->indexes, col, &idx);
+    chunk->arrays[col].type = type;
+    chunk->arrays[col].count = filled;
 }
 
-static void tableDataReader_read_table(TableDataReader* self)
+/* 读 DataPointer，按 zone map 算出候选行区间，再按 STANDARD_VECTOR_SIZE 分批回调。 */
+static void tableDataReader_scan(TableDataReader* self, const ZoneMapPredicate* preds,
+                                 usize npreds, TableDataScanFn fn, void* arg)
 {
-    // 读取数据指针
     tableDataReader_read_data_pointers(self);
     usize col_count = self->table->column_count;
+    if (col_count == 0) return;
     Vector* dp0 = VECTOR_GET(&self->data_pointers, 0, Vector);
     if (vector_size(dp0) == 0) return; // 空表
 
+    DataPointer* tail = VECTOR_GET(dp0, vector_size(dp0) - 1, DataPointer);
+    Vector ranges = VEC(RowRange, 1);
+    RowRange all = {0, tail->row_start + tail->tuple_count};
+    vector_push_back(&ranges, &all);
+    for (usize p = 0; p < npreds; p++)
+    {
+        if (preds[p].column >= col_count) continue;
+        Vector zone = VEC(RowRange, 0);
+        tableDataReader_zone_ranges(self, &preds[p], &zone);
+        Vector merged = VEC(RowRange, 0);
+        row_ranges_intersect(&ranges, &zone, &merged);
+        vector_deinit(&zone);
+        vector_deinit(&ranges);
+        ranges = merged;
+    }
+
     usize zero = 0;
+    usize total_blocks = 0;
     for (usize col = 0; col < col_count; col++)
     {
         Block* blk = Block_create(INVALID_BLOCK);
         vector_push_back(&self->blocks, &blk);
-        vector_push_back(&self->offsets, &zero);
-        vector_push_back(&self->tuple_counts, &zero);
         vector_push_back(&self->indexes, &zero);
-        tableDataReader_read_block(self, col);
+        total_blocks += vector_size(VECTOR_GET(&self->data_pointers, col, Vector));
     }
 
     Vector types = tableCatalogEntry_get_types(self->table);
     DataChunk chunk = MAKE(DataChunk, types); // DataChunk_init
-    while (true)
+    VECTOR_FOREACH(&ranges, raw)
     {
-        dataChunk_reset(&chunk);
-        for (usize col = 0; col < col_count; col++)
+        RowRange* range = (RowRange*)raw;
+        for (u64 row = range->start; row < range->end;)
         {
-            TypeID type = get_internal_type(self->table->columns[col].type);
-            usize type_size = get_typeid_size(type);
-            usize filled = 0;
-            while (filled < STANDARD_VECTOR_SIZE)
+            usize n = MIN((u64)STANDARD_VECTOR_SIZE, range->end - row);
+            dataChunk_reset(&chunk);
+            for (usize col = 0; col < col_count; col++)
             {
-                usize idx = VECTOR_AT(&self->indexes, col, usize);
-                if (idx == 0) break;
-                Vector* dp_list = VECTOR_GET(&self->data_pointers, col, Vector);
-                DataPointer* dp = VECTOR_GET(dp_list, idx - 1, DataPointer);
-                usize tc = VECTOR_AT(&self->tuple_counts, col, usize);
-                // 计算当前块中剩余的元组数量
-                usize remaining_in_block = dp->tuple_count - tc;
-                if (remaining_in_block == 0)
-                {
-                    // no tuples left in this block
-                    // move to next block
-                    if (!tableDataReader_read_block(self, col)) break;
-                    continue;
-                }
-                usize to_read = MIN(STANDARD_VECTOR_SIZE - filled, remaining_in_block);
-                usize off = VECTOR_AT(&self->offsets, col, usize);
-                Block* blk = VECTOR_AT(&self->blocks, col, Block*);
-                data_ptr_t src = blk->fb->buffer + off;
-                data_ptr_t dst = chunk.arrays[col].data + filled * type_size;
-                memcpy(dst, src, to_read * type_size);
-                filled += to_read;
-                usize new_off = off + to_read * type_size;
-                vector_set(&self->offsets, col, &new_off);
-                usize new_tc = tc + to_read;
-                vector_set(&self->tuple_counts, col, &new_tc);
+                tableDataReader_copy_rows(self, col, row, n, &chunk);
             }
-            chunk.arrays[col].type = type;
-            chunk.arrays[col].count = filled;
+            if (dataChunk_size(&chunk) == 0) break;
+            fn(&chunk, row, arg);
+            row += n;
         }
-        if (dataChunk_size(&chunk) == 0) break;
-        datatable_append_column(self->table->datatable, &chunk);
     }
+    self->blocks_skipped = total_blocks - self->blocks_read;
     dataChunk_deinit(&chunk);
     vector_deinit(&types);
+    vector_deinit(&ranges);
+}
+
+usize checkpointManager_scan_table(CheckpointManager* self, TableCatalogEntry* entry,
+                                   const ZoneMapPredicate* preds, usize npreds,
+                                   TableDataScanFn fn, void* arg)
+{
+    if (entry->td_block_id == (block_id_t)INVALID_BLOCK) return 0; // 从未 checkpoint 过
+    MetaBlockReader td_reader = MAKE(MetaBlockReader, self->block_manager, entry->td_block_id);
+    td_reader.offset = entry->td_offset;
+
+    TableDataReader data_reader = MAKE(TableDataReader, self, entry, &td_reader);
+    tableDataReader_scan(&data_reader, preds, npreds, fn, arg);
+    usize skipped = data_reader.blocks_skipped;
+    TableDataReader_deinit(&data_reader);
+    metaBlockReader_deinit(&td_reader);
+    return skipped;
 }
 
-void checkpointManager_read_table(CheckpointManager* self, MetaBlockReader* reader)
+static void checkpointManager_append_chunk(DataChunk* chunk, u64 row_start, void* arg)
+{
+    TableCatalogEntry* entry = (TableCatalogEntry*)arg;
+    (void)row_start;
+    datatable_append_column(entry->datatable, chunk);
+}
+
+/* 从 tabledata 链中 entry 记录的位置读入一张表的列数据（TableDataLoadFn）。 */
+static void checkpointManager_load_table_data(TableCatalogEntry* entry, void* arg)
+{
+    CheckpointManager* self = (CheckpointManager*)arg;
+    checkpointManager_scan_table(self, entry, NULL, 0, checkpointManager_append_chunk, entry);
+}
+
+void checkpointManager_read_table(CheckpointManager* self, MetaBlockReader* reader,
+                                  MemoryContext* cxt)
 {
     CreateTableInfo info;
-    createTableInfo_deserialize(&info, reader);
+    createTableInfo_deserialize(&info, reader, cxt);
     // 写入 table 到 catalog
     catalog_create_table(self->catalog, &info);
     block_id_t td_block_id = DESERIALIZER_READ_U64(reader);
     // 读取 td_offset
     u64 td_offset = DESERIALIZER_READ_U64(reader);
 
-    MetaBlockReader td_reader = MAKE(MetaBlockReader, self->block_manager, td_block_id);
-    td_reader.offset = td_offset;
-
     TableCatalogEntry* table_entry =
         catalog_get_table(self->catalog, info.schema_name, info.table_name);
+    table_entry->td_block_id = td_block_id;
+    table_entry->td_offset = td_offset;
 
-    TableDataReader data_reader = MAKE(TableDataReader, self, table_entry, &td_reader);
-    tableDataReader_read_table(&data_reader);
-    TableDataReader_deinit(&data_reader);
-    metaBlockReader_deinit(&td_reader);
-
-    // 5. 释放：table_name 和 columns 数组已由 catalog 拷贝，可安全释放
-   //    schema_name 被 DataTable 直接持有，不释放
-    //    columns[i].name 被 catalog memcpy 共享，不释放
-    free(info.table_name);
-    free(info.columns);
+    if (self->load_mode == CHECKPOINT_LOAD_LAZY)
+    {
+        // 只记录表数据位置，首次 catalog_get_table 或预取线程再读
+        tableCatalogEntry_set_pending(table_entry, checkpointManager_load_table_data, self);
+        vector_push_back(&self->pending_tables, &table_entry);
+    }
+    else
+    {
+        checkpointManager_load_table_data(table_entry, self);
+    }
+    // info 的字符串和 columns 都在 cxt 里，catalog 已各自拷贝，由调用方 reset cxt 回收
 }
 
-static void checkpointManager_read_schema(CheckpointManager* self, MetaBlockReader* reader)
+static void checkpointManager_read_schema(CheckpointManager* self, MetaBlockReader* reader,
+                                          MemoryContext* cxt)
 {
     CreateSchemaInfo schema;
-    createSchemaInfo_deserialize(&schema, reader);
+    createSchemaInfo_deserialize(&schema, reader, cxt);
     // 写入 schema 到 catalog
     catalog_create_schema(self->catalog, &schema);
     // 读取 table 数量
     u32 table_count = DESERIALIZER_READ_U32(reader);
+    // 每张表的反序列化结果用完即弃，子上下文逐表 reset
+    MemoryContext* table_cxt = MemoryContext_create(cxt, "checkpoint_table", 0);
     for (u32 i = 0; i < table_count; i++)
     {
-        checkpointManager_read_table(self, reader);
+        checkpointManager_read_table(self, reader, table_cxt);
+        memoryContext_reset(table_cxt);
     }
 
     // 读取 index_count（对称 write_schema 写入的 index_count = 0）
     u32 index_count = DESERIALIZER_READ_U32(reader);
     (void)index_count;
-        // 释放反序列化分配的 schema_name
-    free(schema.schema_name);
+    // schema_name 和 table_cxt 随 cxt 一起回收
 }
 
+static void checkpointManager_start_prefetch(CheckpointManager* self);
+
 void checkpointManager_loadfromstorage(CheckpointManager* self)
 {
     BlockManager* block_manager = self->block_manager;
@@ -1135,11 +1440,64 @@ void checkpointManager_loadfromstorage(CheckpointManager* self)
     if (meta_block == INVALID_BLOCK) return;
     DatabaseHeader header;
     MetaBlockReader reader = MAKE(MetaBlockReader, block_manager, meta_block);
+    MemoryContext* load_cxt = MemoryContext_create(NULL, "checkpoint_load", 0);
     u32 schema_count = DESERIALIZER_READ_U32(&reader);
     for (u32 i = 0; i < schema_count; i++)
     {
         // 读取 schema 到元数据块
-        checkpointManager_read_schema(self, &reader);
+        checkpointManager_read_schema(self, &reader, load_cxt);
+        memoryContext_reset(load_cxt);
     }
+    memoryContext_delete(load_cxt);
     metaBlockReader_deinit(&reader);
+
+    if (self->load_mode == CHECKPOINT_LOAD_LAZY)
+    {
+        checkpointManager_start_prefetch(self);
+    }
+}
+
+/*
+ * 懒加载的后台预取：catalog 加载完即可对外服务，预取任务（共享线程池上）按
+ * pending_tables 顺序通过原子游标领取表并调用 ensure_loaded。前台查询访问到尚未
+ * 加载的表时，由 entry 上的锁保证同一张表只加载一次，先到者加载、后到者等待。
+ */
+static void checkpoint_prefetch_main(void* arg)
+{
+    CheckpointManager* self = (CheckpointManager*)arg;
+    for (;;)
+    {
+        usize i = atomic_fetch_add_explicit(&self->prefetch_next, 1, memory_order_relaxed);
+        if (i >= self->pending_tables.size) break;
+        TableCatalogEntry* entry = *(TableCatalogEntry**)vector_get(&self->pending_tables, i);
+        tableCatalogEntry_ensure_loaded(entry);
+    }
+}
+
+static void checkpointManager_start_prefetch(CheckpointManager* self)
+{
+    usize ntasks = MIN((usize)self->prefetch_workers, self->pending_tables.size);
+    if (ntasks == 0) return;
+    TaskGroup_init(&self->prefetch_group, threadPool_shared());
+    for (usize i = 0; i < ntasks; i++)
+    {
+        taskGroup_spawn(&self->prefetch_group, checkpoint_prefetch_main, self);
+    }
+}
+
+void checkpointManager_wait_prefetch(CheckpointManager* self)
+{
+    // 等待期间当前线程也领取预取任务
+    taskGroup_wait(&self->prefetch_group);
+}
+
+void CheckpointManager_destroy(CheckpointManager* self)
+{
+    if (!self) return;
+    // 预取任务还在读 pending_tables 和 self，先等它们结束
+    checkpointManager_wait_prefetch(self);
+    vector_deinit(&self->pending_tables);
+    metaBlockWriter_destroy(self->meta_block_writer);
+    metaBlockWriter_destroy(self->tabledata_writer);
+    free(self);
 }
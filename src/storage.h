@@ -2,18 +2,29 @@
 #define STORAGE_H
 
 #include <stdio.h>
+#include <pthread.h>
 #include "vb_type.h"
 #include "interface.h"
 #include "vector.h"
 #include "wal.h"
 #include "catalog.h"
+#include "lock.h"
+#include "threadpool.h"
+#include "memctx.h"
+#include "slab.h"
+
+typedef struct DataChunk DataChunk;
 
 #define BLOCK_SIZE             8192 // 8KB
+#define BLOCK_DATA_SIZE        ((usize)BLOCK_SIZE - sizeof(u64)) // 块内可用字节数（去掉 checksum 头）
 #define HEADER_SIZE            4096   // 数据库头大小
 #define FILE_BUFFER_BLOCK_SIZE 4096   // 文件缓冲区块大小
 #define VERSION_NUMBER         1      // 数据库版本号
 #define INVALID_BLOCK          -1    // 无效块标识
 #define MAGIC_NUMBER           0x5645434442  // "VECDB"
+// checkpoint 数据格式（DatabaseHeader.checkpoint_format）。旧文件的 header 里这个位置是 0
+#define CHECKPOINT_FORMAT_ZONE_MAP 1  // DataPointer 带 has_stats 标志，min/max 可信
+#define CHECKPOINT_FORMAT          CHECKPOINT_FORMAT_ZONE_MAP
 
 static int FILE_BUFFER_HEADER_SIZE = sizeof(u64);// 文件缓冲区块头大小 存储 checksum 校验和
 static int BLOCK_START = HEADER_SIZE * 3; // 数据块起始位置，从第3个 HEADER_SIZE 开始
@@ -44,6 +55,9 @@ typedef struct
     // 文件中的块数量。如果文件大于 BLOCK_SIZE * block_count，
     // 则出现在 block_count 之后的任何块都隐式地属于 free_list
     u64 block_count;
+    // 该 header 指向的 checkpoint 的数据格式（CHECKPOINT_FORMAT_*）。
+    // 早于 zone map 的文件这里是 0，其 DataPointer 的 min/max 恒为 0，读入时视为无统计。
+    u64 checkpoint_format;
 } DatabaseHeader;
 
 typedef struct
@@ -52,12 +66,22 @@ typedef struct
     data_ptr_t internal_buf;
     usize internal_size;
     data_ptr_t buffer;
+    u8 flags;             // FILEBUFFER_POOLED / FILEBUFFER_EMBEDDED
     // data数组是柔性数组，它不占用结构体本身的大小，而是紧跟在结构体之后
     u8 data[];
 } FileBuffer;
 
+// internal_buf 取自块缓冲区池，destroy 时归还池而不是 free
+#define FILEBUFFER_POOLED   0x1
+// 结构体与 Block 同一次 malloc（见 Block_create），destroy 时不单独 free 结构体
+#define FILEBUFFER_EMBEDDED 0x2
+
+// size == BLOCK_SIZE 时缓冲区取自块缓冲区池，其余大小走 malloc + 对齐
 FileBuffer* FileBuffer_create(usize size);
 
+// 进程内共享的 BLOCK_SIZE 缓冲区池（首次使用时初始化）
+SlabPool* blockBuffer_pool(void);
+
 // BlockManager 类型枚举 - 用于区分不同的实现
 typedef enum
 {
@@ -107,6 +131,8 @@ typedef struct Block
     FileBuffer* fb;
 } Block;
 
+// Block 与其 FileBuffer 结构体一次分配，缓冲区取自块缓冲区池。
+// 兼容旧的释放方式：block_destroy(b) 与 fileBuffer_destroy(b->fb); free(b) 等价
 Block* Block_create(block_id_t block_id);
 void block_destroy(Block* block);
 
@@ -156,6 +182,7 @@ DEFINE_CLASS(BlockManager,
     VMETHOD(BlockManager, destroy, void)
     ,
     FIELD(type, BlockManagerType)
+    FIELD(checkpoint_format, u64) // 活跃 header 的 checkpoint 格式，决定 DataPointer 的读法
 )
 // clang-format on
 
@@ -180,6 +207,10 @@ typedef struct
     block_id_t meta_block;
     // 迭代次数，用于版本控制和元数据更新。
     u64 iteration_count;
+    // 保护块分配和文件读写（FILE* 的 fseek + fread/fwrite 不是原子的），
+    // 并行 checkpoint 的各个 worker 会同时分配块、写块。持有期间会做文件 IO，
+    // 所以用会睡眠的 LWLock 而不是自旋锁。
+    LWLock lock;
 } SingleFileBlockManager;
 
 SingleFileBlockManager* create_new_database(const char* path, bool create_new);
@@ -257,16 +288,22 @@ void metaBlockReader_destroy(MetaBlockReader* reader);
 #define DESERIALIZER_READ_I32(dr_ptr) DESERIALIZER_READ_TYPE(dr_ptr, (data_ptr_t) & _tmp, i32)
 #define DESERIALIZER_READ_I64(dr_ptr) DESERIALIZER_READ_TYPE(dr_ptr, (data_ptr_t) & _tmp, i64)
 
-#define DESERIALIZER_READ_STRING(dr_ptr)                                   \
+// 从内存上下文 cxt 分配字符串；cxt 为 NULL 时 malloc
+#define DESERIALIZER_READ_STRING_CXT(dr_ptr, cxt)                          \
     ({                                                                     \
         usize _tmp_len;                                                    \
+        MemoryContext* _tmp_cxt = (cxt);                                   \
         DESERIALIZER_READ(dr_ptr, (data_ptr_t) & _tmp_len, sizeof(usize)); \
-        char* _tmp_str = malloc(_tmp_len + 1);                             \
+        char* _tmp_str =                                               \
+            _tmp_cxt ? memoryContext_alloc(_tmp_cxt, _tmp_len + 1)     \
+                     : malloc(_tmp_len + 1);                           \
         DESERIALIZER_READ(dr_ptr, (data_ptr_t)_tmp_str, _tmp_len);         \
         _tmp_str[_tmp_len] = '\0';                                         \
         _tmp_str;                                                          \
     })
 
+#define DESERIALIZER_READ_STRING(dr_ptr) DESERIALIZER_READ_STRING_CXT(dr_ptr, NULL)
+
 typedef enum
 {
     META_BLOCK_WRITER = 0,   // 元数据块写入器
@@ -336,17 +373,39 @@ typedef struct StorageManager
     WALManager* wal_manager; // WAL 管理器指针
 } StorageManager;
 
+// 启动加载模式：EAGER 在 loadfromstorage 中读完所有表数据；
+// LAZY 只加载 catalog，表数据推迟到首次访问或由后台预取线程加载
+typedef enum
+{
+    CHECKPOINT_LOAD_EAGER = 0,
+    CHECKPOINT_LOAD_LAZY = 1,
+} CheckpointLoadMode;
+
 typedef struct
 {
     BlockManager* block_manager; // 存储管理器指针
     Catalog* catalog; // 目录指针
     MetaBlockWriter* meta_block_writer; // 元数据块写入器指针
     MetaBlockWriter* tabledata_writer; // 元数据块读取器指针
+    u32 nworkers; // checkpoint 并行写表数据的 worker 数（1 = 串行），默认等于 CPU 核数
+    CheckpointLoadMode load_mode; // 启动加载模式，默认 EAGER
+    u32 prefetch_workers; // LAZY 模式下后台预取表数据的并发任务数（0 = 只在首次访问时加载）
+    Vector pending_tables; // LAZY 模式下待加载的表 vector<TableCatalogEntry*>
+    _Atomic usize prefetch_next; // 预取任务领取 pending_tables 的游标
+    TaskGroup prefetch_group; // 共享线程池上的预取任务
 } CheckpointManager;
 
 CheckpointManager* CheckpointManager_create(BlockManager* block_manager, Catalog* catalog);
+void checkpointManager_set_workers(CheckpointManager* self, u32 nworkers);
 void checkpointManager_createpoint(CheckpointManager* self);
 void checkpointManager_loadfromstorage(CheckpointManager* self);
+// 设置启动加载模式；LAZY 模式下 CheckpointManager 必须比所有待加载的表活得久
+void checkpointManager_set_load_mode(CheckpointManager* self, CheckpointLoadMode mode,
+                                     u32 prefetch_workers);
+// 等待后台预取任务结束（之后所有表数据都已加载）
+void checkpointManager_wait_prefetch(CheckpointManager* self);
+// 等待预取结束后释放 CheckpointManager（含 pending_tables）；self 可为 NULL
+void CheckpointManager_destroy(CheckpointManager* self);
 
 MetaBlockWriter* MetaBlockWriter_create(BlockManager* manager);
 void metaBlockWriter_flush(MetaBlockWriter* writer);
@@ -354,7 +413,9 @@ void metaBlockWriter_destroy(MetaBlockWriter* writer);
 void MetaBlockReader_init(MetaBlockReader* reader, BlockManager* manager, block_id_t block_id);
 void metaBlockReader_deinit(MetaBlockReader* reader);
 void checkpointManager_write_table(CheckpointManager* self, TableCatalogEntry* entry);
-void checkpointManager_read_table(CheckpointManager* self, MetaBlockReader* reader);
+// 反序列化出的临时字符串从 cxt 分配，调用方负责 reset
+void checkpointManager_read_table(CheckpointManager* self, MetaBlockReader* reader,
+                                  MemoryContext* cxt);
 
 typedef struct
 {
@@ -366,17 +427,20 @@ typedef struct
     Vector tuple_counts; // 元组数量向量 vector<usize>
     Vector row_numbers; // 行号向量 vector<usize>
     Vector indexes; // 索引偏移量向量 vector<usize>
+    Vector mins; // 每列当前块的最小值 vector<f64>（zone map）
+    Vector maxs; // 每列当前块的最大值 vector<f64>（zone map）
     Vector data_pointers;// vector<vector<DataPointer>> data_pointers;
 } TableDataWriter;
 
 typedef struct
 {
-    f64 min; // 指向数据的最小偏移量
-    f64 max; // 指向数据的最大偏移量
+    f64 min; // 块内该列的最小值（zone map），块内无有效值时 min > max
+    f64 max; // 块内该列的最大值（zone map）
     u64 row_start; // 指向数据的行号开始偏移量
     u64 tuple_count; // 指向数据的行号结束偏移量
     block_id_t block_id; // 指向数据的块 ID
     u32 offset;// 指向数据的偏移量
+    bool has_stats; // min/max 有效；旧格式 checkpoint 读入的块为 false，按“可能匹配”处理
 } DataPointer;
 
 typedef struct
@@ -394,6 +458,30 @@ typedef struct
     // 记录列 col 下一个待读取的数据块在 data_pointers[col] 中的下标
     Vector indexes; // 索引偏移量向量 vector<usize>
     Vector data_pointers; // vector<vector<DataPointer>> data_pointers;
+    usize blocks_read; // 实际从磁盘读取的块数
+    usize blocks_skipped; // 被 zone map 跳过的块数
 } TableDataReader;
 
+// 区间谓词 min <= columns[column] <= max，开区间一侧用 ±INFINITY。
+// zone map 只用于跳过整块，扫描结果是满足谓词的行的超集，精确过滤仍由调用方完成。
+typedef struct
+{
+    usize column;
+    f64 min;
+    f64 max;
+} ZoneMapPredicate;
+
+// 块的 [min, max] 与谓词区间有交集时才可能包含匹配行；没有统计的块总是可能匹配
+bool dataPointer_may_match(const DataPointer* dp, const ZoneMapPredicate* pred);
+
+// 扫描回调：chunk 中第 0 行对应表中的 row_start 行
+typedef void (*TableDataScanFn)(DataChunk* chunk, u64 row_start, void* arg);
+
+// 按 zone map 扫描已 checkpoint 的表数据，跳过不可能匹配 preds（AND）的块。
+// td_block_id/td_offset 取自 TableCatalogEntry；返回跳过的块数。
+// 启动加载走同一条路径（不带谓词）
+usize checkpointManager_scan_table(CheckpointManager* self, TableCatalogEntry* entry,
+                                   const ZoneMapPredicate* preds, usize npreds,
+                                   TableDataScanFn fn, void* arg);
+
 #endif  // STORAGE_H
\ No newline at end of file
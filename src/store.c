@@ -1,6 +1,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <stddef.h>
+#include <sched.h>
 
 #include "store.h"
 #include "table.h"
@@ -14,9 +16,10 @@
 void EmbeddingStore_init(EmbeddingStore* store, i16 dimension)
 {
     store->dimension = dimension;
-    store->count = 0;
+    atomic_init(&store->count, 0);
+    atomic_init(&store->published, 0);
     store->elem_size = (usize)dimension * sizeof(f32);
-    store->vecs_per_blk = BLOCK_SIZE / store->elem_size;
+    store->vecs_per_blk = BLOCK_DATA_SIZE / store->elem_size;
 
     SegmentTree_init(&store->tree);
     BlockSegment* first = BlockSegment_create2(0);
@@ -25,7 +28,8 @@ void EmbeddingStore_init(EmbeddingStore* store, i16 dimension)
     segmentTree_append_segment(&store->tree, (SegmentBase*)first);
 
     Vector_init(&store->free_list, sizeof(ItemPtr), 0);
-    store->last_ctid = INVALID_ITEM_PTR;
+    Vector_init(&store->back_ctids, sizeof(ItemPtr), 0);
+    Vector_init(&store->live_bits, sizeof(u64), 0);
     LWLockInit(&store->lock, "EmbeddingStore.lock");
 }
 
@@ -33,99 +37,155 @@ void EmbeddingStore_deinit(EmbeddingStore* store)
 {
     if (!store) return;
     SegmentTree_deinit(&store->tree, BlockSegment_destroy);
-    store->count = 0;
+    vector_deinit(&store->free_list);
+    vector_deinit(&store->back_ctids);
+    vector_deinit(&store->live_bits);
+    atomic_store(&store->count, 0);
+    atomic_store(&store->published, 0);
+}
+
+static inline ItemPtr emb_ctid_from_row_idx(const EmbeddingStore* store, usize row_idx)
+{
+    usize seg_idx = row_idx / store->vecs_per_blk;
+    usize local_idx = row_idx % store->vecs_per_blk;
+    return make_item_ptr((block_id_t)seg_idx, (u16)local_idx);
 }
 
 /**
- * Internal: append one embedding to the store.
- * Handles segment overflow by creating a new BlockSegment.
+ * Data of segment seg_idx, creating segments up to it when an appender has
+ * reserved past the end.  The directory lookup is lock-free; store->lock only
+ * serializes growth.  Segments never move once created.
  */
-static void embedding_store_append(EmbeddingStore* store, VectorBase* vec)
+static u8* embeddingStore_seg_data(EmbeddingStore* store, usize seg_idx)
 {
-    BlockSegment* seg = (BlockSegment*)segmentTree_get_last_segment(&store->tree);
-    usize start_pos = seg->byte_offset;
-    usize remaining_space = BLOCK_SIZE - start_pos;
+    BlockSegment* seg = (BlockSegment*)segmentTree_get_node(&store->tree, seg_idx);
+    if (seg) return (u8*)segment_get_data(seg);
 
-    if (remaining_space >= store->elem_size)
+    LWLockAcquire(&store->lock, LW_EXCLUSIVE);
+    while (vector_size(store->tree.nodes) <= seg_idx)
     {
-        /* Fits in current segment */
-        data_ptr_t data = segment_get_data(seg) + start_pos;
-        memcpy(data, vec->data, store->elem_size);
-        seg->base.count++;
-        seg->byte_offset += store->elem_size;
+        BlockSegment* ns = BlockSegment_create2(vector_size(store->tree.nodes) * store->vecs_per_blk);
+        ns->block = Block_create(INVALID_BLOCK);
+        segmentTree_append_segment(&store->tree, (SegmentBase*)ns);
     }
-    else
+    seg = (BlockSegment*)VECTOR_AT(store->tree.nodes, seg_idx, SegmentNode).node;
+    LWLockRelease(&store->lock);
+    return (u8*)segment_get_data(seg);
+}
+
+#define EMB_PUBLISH_SPINS 64 /* busy polls before yielding to a slower predecessor */
+
+void embeddingStore_append_batch(EmbeddingStore* store, const VectorBase* vecs, usize n,
+                                 ItemPtr* out_ctids)
+{
+    usize done = 0;
+
+    /* 1. vacuumed slots first.  They carry no live owner, so scans skip them
+     *    and the copy needs no lock. */
+    LWLockAcquire(&store->lock, LW_EXCLUSIVE);
+    usize nfree = vector_size(&store->free_list);
+    usize take = nfree < n ? nfree : n;
+    ItemPtr* reused = take ? malloc(take * sizeof(ItemPtr)) : NULL;
+    for (usize i = 0; i < take; i++) vector_pop_back(&store->free_list, &reused[i]);
+    LWLockRelease(&store->lock);
+    for (; done < take; done++)
+    {
+        usize seg_idx = (usize)item_ptr_block_id(reused[done]);
+        u8* dst = embeddingStore_seg_data(store, seg_idx) + item_ptr_slot(reused[done]) * store->elem_size;
+        memcpy(dst, vecs[done].data, store->elem_size);
+        if (out_ctids) out_ctids[done] = reused[done];
+    }
+    free(reused);
+    if (done == n) return;
+
+    /* 2. reserve the rest at the tail with one fetch_add and fill it unlocked,
+     *    a segment-sized run at a time */
+    usize start = atomic_fetch_add_explicit(&store->count, n - done, memory_order_relaxed);
+    usize end = start + (n - done);
+    for (usize row = start; row < end;)
     {
-        /* Need a new segment */
-        BlockSegment* new_seg = BlockSegment_create2(seg->base.start + seg->base.count);
-        new_seg->block = Block_create(INVALID_BLOCK);
-        segmentTree_append_segment(&store->tree, (SegmentBase*)new_seg);
+        usize seg_idx = row / store->vecs_per_blk;
+        usize local = row % store->vecs_per_blk;
+        usize run = store->vecs_per_blk - local;
+        if (run > end - row) run = end - row;
+        u8* dst = embeddingStore_seg_data(store, seg_idx) + local * store->elem_size;
+        for (usize j = 0; j < run; j++, done++)
+        {
+            memcpy(dst + j * store->elem_size, vecs[done].data, store->elem_size);
+            if (out_ctids) out_ctids[done] = emb_ctid_from_row_idx(store, row + j);
+        }
+        row += run;
+    }
 
-        /* Write to new segment */
-        data_ptr_t data = segment_get_data(new_seg);
-        memcpy(data, vec->data, store->elem_size);
-        new_seg->base.count++;
-        new_seg->byte_offset = store->elem_size;
+    /* 3. publish in reservation order: published only ever covers fully
+     *    written slots */
+    for (unsigned spins = 0;
+         atomic_load_explicit(&store->published, memory_order_acquire) != start; spins++)
+    {
+        if (spins >= EMB_PUBLISH_SPINS) sched_yield();
     }
-    store->count++;
+    atomic_store_explicit(&store->published, end, memory_order_release);
 }
 
-static inline ItemPtr emb_ctid_from_row_idx(const EmbeddingStore* store, usize row_idx)
+ItemPtr embeddingStore_append_and_get_ctid(EmbeddingStore* store, VectorBase* vec)
 {
-    usize seg_idx = row_idx / store->vecs_per_blk;
-    usize local_idx = row_idx % store->vecs_per_blk;
-    return make_item_ptr((block_id_t)seg_idx, (u16)local_idx);
+    ItemPtr ctid;
+    embeddingStore_append_batch(store, vec, 1, &ctid);
+    return ctid;
 }
 
-/**
- * Overwrite an existing embedding at emb_ctid in-place.
- */
-static void embedding_store_write_at_ctid(EmbeddingStore* store, ItemPtr ctid, VectorBase* vec)
+static void embeddingStore_set_live(EmbeddingStore* store, usize i, bool live)
 {
-    usize seg_idx = (usize)item_ptr_block_id(ctid);
-    usize local_idx = (usize)item_ptr_slot(ctid);
-    SegmentNode* sn = (SegmentNode*)vector_get(store->tree.nodes, seg_idx);
-    if (!sn) return;
-    BlockSegment* seg = (BlockSegment*)sn->node;
-    u8* dst = (u8*)segment_get_data(seg) + local_idx * store->elem_size;
-    memcpy(dst, vec->data, store->elem_size);
+    if (i / 64 >= vector_size(&store->live_bits))
+    {
+        u64 zero = 0;
+        vector_reserve(&store->live_bits, 2 * (i / 64 + 1));
+        vector_resize(&store->live_bits, i / 64 + 1, &zero);
+    }
+    u64* word = VECTOR_GET(&store->live_bits, i / 64, u64);
+    if (live)
+        *word |= (u64)1 << (i % 64);
+    else
+        *word &= ~((u64)1 << (i % 64));
 }
 
-ItemPtr embeddingStore_append_and_get_ctid(EmbeddingStore* store, VectorBase* vec)
+void embeddingStore_set_owner(EmbeddingStore* store, ItemPtr emb_ctid, ItemPtr heap_ctid)
 {
-    usize free_n = vector_size(&store->free_list);
-    if (free_n > 0)
+    usize i = embeddingStore_slot_index(store, emb_ctid);
+    if (i >= vector_size(&store->back_ctids))
     {
-        /* Pop last element from free_list */
-        ItemPtr ctid;
-        vector_pop_back(&store->free_list, &ctid);
-        embedding_store_write_at_ctid(store, ctid, vec);
-        store->last_ctid = ctid;
-        return ctid;
+        ItemPtr none = INVALID_ITEM_PTR;
+        vector_reserve(&store->back_ctids, 2 * (i + 1));
+        vector_resize(&store->back_ctids, i + 1, &none);
     }
-    else
+    vector_set(&store->back_ctids, i, &heap_ctid);
+    embeddingStore_set_live(store, i, true);
+}
+
+void embeddingStore_mark_dead(EmbeddingStore* store, ItemPtr emb_ctid)
+{
+    embeddingStore_set_live(store, embeddingStore_slot_index(store, emb_ctid), false);
+}
+
+void embeddingStore_release(EmbeddingStore* store, ItemPtr emb_ctid)
+{
+    usize i = embeddingStore_slot_index(store, emb_ctid);
+    if (i < vector_size(&store->back_ctids))
     {
-        usize row_idx = store->count;
-        embedding_store_append(store, vec);
-        store->last_ctid = emb_ctid_from_row_idx(store, row_idx);
-        return store->last_ctid;
+        ItemPtr none = INVALID_ITEM_PTR;
+        vector_set(&store->back_ctids, i, &none);
     }
+    embeddingStore_set_live(store, i, false);
+    vector_push_back(&store->free_list, &emb_ctid);
 }
 
 const f32* embedding_store_get_ptr_ctid(EmbeddingStore* store, ItemPtr emb_ctid)
 {
-    LWLockAcquire(&store->lock, LW_SHARED);
     usize seg_idx = (usize)item_ptr_block_id(emb_ctid);
     usize local_idx = (usize)item_ptr_slot(emb_ctid);
-    SegmentNode* sn = (SegmentNode*)vector_get(store->tree.nodes, seg_idx);
-    const f32* ptr = NULL;
-    if (sn)
-    {
-        BlockSegment* seg = (BlockSegment*)sn->node;
-        ptr = (const f32*)((u8*)segment_get_data(seg) + local_idx * store->elem_size);
-    }
-    LWLockRelease(&store->lock);
-    return ptr;
+    BlockSegment* seg = (BlockSegment*)segmentTree_get_node(&store->tree, seg_idx);
+    if (!seg) return NULL;
+    return (const f32*)((u8*)segment_get_data(seg) + local_idx * store->elem_size);
 }
 
 /* ============================================================
@@ -157,105 +217,266 @@ static inline u16 heapStore_free_space(u8* page)
     return *heapStore_pd_upper(page) - *heapStore_pd_lower(page);
 }
 
-/*
- * datum_deform_copy — read one column from page into Datum (copy path).
- *
- * Fixed-size types: by-value Datum, no malloc.
- * Varlena types (TEXT/BYTEA/JSONB): malloc'd copy — caller must free.
- *
- * Returns pointer past the column bytes on success, NULL on malloc failure.
- */
-static const u8* datum_deform_copy(const u8* p, TupleColType type, Datum* out)
+/* Fixed-width column: by-value Datum straight from the page. */
+static inline Datum datum_fetch_fixed(const u8* p, TupleColType type)
 {
     switch (type)
     {
         case TUPLE_COL_BOOL:
-            *out = BoolGetDatum(*p != 0);
-            p += 1;
-            break;
+            return BoolGetDatum(*p != 0);
         case TUPLE_COL_I32:
         {
             i32 v;
             memcpy(&v, p, 4);
-            *out = Int32GetDatum(v);
-            p += 4;
-            break;
+            return Int32GetDatum(v);
         }
         case TUPLE_COL_I64:
         {
             i64 v;
             memcpy(&v, p, 8);
-            *out = Int64GetDatum(v);
-            p += 8;
-            break;
+            return Int64GetDatum(v);
         }
         case TUPLE_COL_F32:
         {
             f32 v;
             memcpy(&v, p, 4);
-            *out = Float32GetDatum(v);
-            p += 4;
-            break;
+            return Float32GetDatum(v);
         }
         case TUPLE_COL_F64:
         {
             f64 v;
             memcpy(&v, p, 8);
-            *out = Float64GetDatum(v);
-            p += 8;
-            break;
+            return Float64GetDatum(v);
         }
         default:
-            *out = (Datum)0;
-            break;
+            return (Datum)0;
+    }
+}
+
+static inline u16 tuple_col_fixed_len(TupleColType type)
+{
+    switch (type)
+    {
+        case TUPLE_COL_BOOL:
+            return 1;
+        case TUPLE_COL_I32:
+        case TUPLE_COL_F32:
+            return 4;
+        case TUPLE_COL_I64:
+        case TUPLE_COL_F64:
+            return 8;
+        default:
+            return 0; /* varlena */
     }
-    return p;
+}
+
+static inline bool tuple_col_is_varlena(TupleColType type)
+{
+    return type == TUPLE_COL_TEXT || type == TUPLE_COL_JSONB;
+}
+
+static inline u32 varlena_word(const u8* p)
+{
+    u32 w;
+    memcpy(&w, p, 4);
+    return w;
+}
+
+/*
+ * Varlena bytes on page, identical to the in-memory Datum layout:
+ *   TEXT:  [u32 content_len][data...]
+ *   JSONB: VbJsonb, [u32 vl_len_ (total, header included)][body...]
+ *   compressed / external (toast.h): [u32 tag | n][n bytes]
+ */
+static inline usize varlena_size(const u8* p, TupleColType type)
+{
+    u32 len = varlena_word(p);
+    if (len & VARLENA_TAG_MASK) return (usize)4 + (len & VARLENA_LEN_MASK);
+    return type == TUPLE_COL_JSONB ? (len < 4 ? 4 : (usize)len) : (usize)4 + len;
+}
+
+/* Size of the plain value behind a toasted varlena. */
+static inline usize varlena_raw_size(const u8* p)
+{
+    if (varlena_word(p) & VARLENA_COMPRESSED) return varlena_word(p + 4);
+    ToastPointer tp;
+    memcpy(&tp, p + 4, sizeof(tp));
+    return tp.rawsize;
+}
+
+/* Expand a compressed / external varlena into dst (varlena_raw_size bytes). */
+static bool varlena_detoast_into(const ToastStore* ts, const u8* p, u8* dst)
+{
+    u32 w = varlena_word(p);
+    if (w & VARLENA_COMPRESSED)
+        return toast_decompress(p + 8, (w & VARLENA_LEN_MASK) - 4, dst, varlena_word(p + 4));
+    ToastPointer tp;
+    memcpy(&tp, p + 4, sizeof(tp));
+    if (!ts) return false;
+    if (!(tp.flags & TOAST_PTR_COMPRESSED)) return tp.extsize == tp.rawsize && toastStore_fetch(ts, &tp, dst);
+    u8* tmp = malloc(tp.extsize);
+    if (!tmp) return false;
+    bool ok = toastStore_fetch(ts, &tp, tmp) && toast_decompress(tmp, tp.extsize, dst, tp.rawsize);
+    free(tmp);
+    return ok;
 }
 
 /*
- * rs_deform_all — deserialize all non-null columns from page into Datum[].
+ * datum_deform_varlena — read one varlena column from page into Datum.
+ *
+ * VARLENA_BYREF:      pointer into the page, no copy.
+ * VARLENA_COPY_ARENA: copy carved from arena.
+ * VARLENA_COPY_MALLOC: malloc'd copy — caller must free.
  *
- * Returns 0 on success, -1 on malloc failure (partial datums freed on error).
+ * Returns pointer past the column bytes on success, NULL on allocation failure.
  */
-static int heapStore_deform_all(const u8* col_data, const TableSchema* schema, u64 null_bits,
-                                Datum* out)
+static const u8* datum_deform_varlena(const u8* p, TupleColType type, Datum* out,
+                                      VarlenaMode mode, MemoryContext* arena, const ToastStore* ts)
 {
-    const u8* p = col_data;
-    for (u16 i = 0; i < schema->ncols; i++)
+    usize size = varlena_size(p, type);
+    if (mode == VARLENA_BYREF)
+    {
+        *out = PointerGetDatum(p); /* toasted values stay toasted: heapStore_detoast */
+        return p + size;
+    }
+    bool toasted = (varlena_word(p) & VARLENA_TAG_MASK) != 0;
+    usize raw = toasted ? varlena_raw_size(p) : size;
+    void* copy = mode == VARLENA_COPY_ARENA ? memoryContext_alloc(arena, raw) : malloc(raw);
+    if (!copy) return NULL;
+    if (!toasted)
+    {
+        memcpy(copy, p, size);
+    }
+    else if (!varlena_detoast_into(ts, p, copy))
     {
-        if (null_bits & ((u64)1 << i))
+        if (mode == VARLENA_COPY_MALLOC) free(copy);
+        return NULL;
+    }
+    *out = PointerGetDatum(copy);
+    return p + size;
+}
+
+/* Free the malloc'd varlena copies among out[cols in done] after a failed deform. */
+static void tupleDesc_free_partial(const TupleDesc* desc, u64 done, const Datum* out)
+{
+    while (done)
+    {
+        u16 i = (u16)__builtin_ctzll(done);
+        done &= done - 1;
+        if (tuple_col_is_varlena(desc->atttype[i])) free(DatumGetPointer(out[i]));
+    }
+}
+
+void tupleDesc_free_datums(const TupleDesc* desc, u64 cols, u64 null_bits, const Datum* out)
+{
+    tupleDesc_free_partial(desc, cols & ~null_bits & tupleDesc_cols_mask(desc->natts), out);
+}
+
+/*
+ * Columns in want below the first NULL and inside the fixed prefix come
+ * straight from attcacheoff.  Returns the first column the caller still has
+ * to walk to (> the highest wanted column when nothing is left).
+ */
+static inline u16 tupleDesc_deform_cached(const TupleDesc* desc, const u8* col_data,
+                                          u64 null_bits, u64 want, Datum* out)
+{
+    u16 first_null = null_bits ? (u16)__builtin_ctzll(null_bits) : desc->natts;
+    u16 cached = first_null < desc->nfixed ? first_null : desc->nfixed;
+    u64 fast = want & tupleDesc_cols_mask(cached);
+    while (fast)
+    {
+        u16 i = (u16)__builtin_ctzll(fast);
+        fast &= fast - 1;
+        out[i] = datum_fetch_fixed(col_data + desc->attcacheoff[i], (TupleColType)desc->atttype[i]);
+    }
+    return cached;
+}
+
+/* Deform routine for schemas without varlena columns: no malloc, no failure. */
+static int tupleDesc_deform_fixed(const TupleDesc* desc, const u8* col_data, u64 null_bits,
+                                  u64 want, Datum* out, VarlenaMode mode, MemoryContext* arena)
+{
+    (void)mode;
+    (void)arena;
+    if (!want) return 0;
+    u16 last = (u16)(63 - __builtin_clzll(want));
+    u16 i = tupleDesc_deform_cached(desc, col_data, null_bits, want, out);
+    const u8* p = col_data + desc->attcacheoff[i];
+    for (; i <= last; i++)
+    {
+        bool wanted = (want >> i) & 1;
+        if ((null_bits >> i) & 1)
+        {
+            if (wanted) out[i] = (Datum)0;
+            continue;
+        }
+        if (wanted) out[i] = datum_fetch_fixed(p, (TupleColType)desc->atttype[i]);
+        p += desc->attlen[i];
+    }
+    return 0;
+}
+
+/* General deform routine: wanted varlena columns per mode, others skipped by length. */
+static int tupleDesc_deform_generic(const TupleDesc* desc, const u8* col_data, u64 null_bits,
+                                    u64 want, Datum* out, VarlenaMode mode, MemoryContext* arena)
+{
+    if (!want) return 0;
+    u16 last = (u16)(63 - __builtin_clzll(want));
+    u16 i = tupleDesc_deform_cached(desc, col_data, null_bits, want, out);
+    const u8* p = col_data + desc->attcacheoff[i];
+    for (; i <= last; i++)
+    {
+        bool wanted = (want >> i) & 1;
+        if ((null_bits >> i) & 1)
+        {
+            if (wanted) out[i] = (Datum)0;
+            continue;
+        }
+        TupleColType type = (TupleColType)desc->atttype[i];
+        if (desc->attlen[i])
         {
-            out[i] = (Datum)0;
+            if (wanted) out[i] = datum_fetch_fixed(p, type);
+            p += desc->attlen[i];
             continue;
         }
-        p = datum_deform_copy(p, schema->cols[i], &out[i]);
+        if (!wanted)
+        {
+            p += varlena_size(p, type);
+            continue;
+        }
+        p = datum_deform_varlena(p, type, &out[i], mode, arena, desc->toast);
         if (!p)
         {
-            /* malloc failure: free already-allocated varlena Datums */
-            u64 done = 0;
-            for (u16 j = 0; j < i; j++)
-            {
-                if (null_bits & ((u64)1 << j)) continue;
-                TupleColType ct = schema->cols[j];
-                if (ct == TUPLE_COL_TEXT || ct == TUPLE_COL_JSONB)
-                {
-                    void* ptr = DatumGetPointer(out[j]);
-                    if (ptr) free(ptr);
-                }
-                done |= ((u64)1 << j);
-            }
-            (void)done;
+            if (mode == VARLENA_COPY_MALLOC)
+                tupleDesc_free_partial(desc, want & ~null_bits & tupleDesc_cols_mask(i), out);
             return -1;
         }
     }
     return 0;
 }
 
-/** Initialise a fresh page (pd_lower=6, pd_upper=BLOCK_SIZE, pd_flags=0). */
+void TupleDesc_init(TupleDesc* desc, const TableSchema* schema)
+{
+    desc->natts = schema ? schema->ncols : 0;
+    assert(desc->natts <= HEAP_MAX_COLS);
+    desc->nfixed = desc->natts;
+    desc->attcacheoff[0] = 0;
+    for (u16 i = 0; i < desc->natts; i++)
+    {
+        desc->atttype[i] = (u8)schema->cols[i];
+        desc->attlen[i] = (u8)tuple_col_fixed_len(schema->cols[i]);
+        if (desc->nfixed == desc->natts && desc->attlen[i] == 0) desc->nfixed = i;
+        if (i < desc->nfixed) desc->attcacheoff[i + 1] = (u16)(desc->attcacheoff[i] + desc->attlen[i]);
+    }
+    desc->deform = desc->nfixed == desc->natts ? tupleDesc_deform_fixed : tupleDesc_deform_generic;
+    desc->toast = NULL;
+}
+
+/** Initialise a fresh page (pd_lower=6, pd_upper=BLOCK_DATA_SIZE, pd_flags=0). */
 static void heapStore_page_init(u8* page)
 {
     *heapStore_pd_lower(page) = (u16)HS_BLOCK_HDR_SIZE;
-    *heapStore_pd_upper(page) = (u16)BLOCK_SIZE;
+    *heapStore_pd_upper(page) = (u16)BLOCK_DATA_SIZE;
     *heapStore_pd_flags(page) = 0;
 }
 
@@ -263,8 +484,19 @@ void HeapStore_init(HeapStore* store, const TableSchema* schema, BlockManager* b
 {
     store->block_manager = bm;
     store->schema = schema;
-    store->hint_free_seg = NULL;
-    LWLockInit(&store->lock, "HeapStore.content_lock");
+    TupleDesc_init(&store->desc, schema);
+    ToastStore_init(&store->toast, bm);
+    store->desc.toast = &store->toast;
+    store->toast_compression = true;
+    atomic_init(&store->next_txn_id, 0);
+    store->txn_mgr = NULL;
+    store->page_count = 1;
+    FreeSpaceMap_init(&store->fsm);
+    VisibilityMap_init(&store->vm);
+    hmap_init(&store->block_map, sizeof(block_id_t), sizeof(BlockSegment*), HMAP_DEFAULT_NBUCKETS,
+              hmap_u64_hash, hmap_u64_cmp);
+    LWLockInit(&store->lock, "HeapStore.lock");
+    LWLockInit(&store->map_lock, "HeapStore.map_lock");
 
     SegmentTree_init(&store->tree);
 
@@ -283,12 +515,18 @@ void HeapStore_init(HeapStore* store, const TableSchema* schema, BlockManager* b
     seg->block = Block_create(bid);
     heapStore_page_init((u8*)segment_get_data(seg));
     segmentTree_append_segment(&store->tree, (SegmentBase*)seg);
+    hmap_insert(&store->block_map, &bid, &seg);
+    freeSpaceMap_set(&store->fsm, 0, 0);
 }
 
 void HeapStore_deinit(HeapStore* store)
 {
     if (!store) return;
     SegmentTree_deinit(&store->tree, BlockSegment_destroy);
+    FreeSpaceMap_deinit(&store->fsm);
+    VisibilityMap_deinit(&store->vm);
+    hmap_deinit(&store->block_map);
+    ToastStore_deinit(&store->toast);
     store->page_count = 0;
 }
 
@@ -302,18 +540,60 @@ void HeapStore_deinit(HeapStore* store)
  * Returns 0 on success, -1 on malloc failure.
  */
 int heapStore_deform_tuple(const HeapTupleRef* ref, Datum* out, usize ncols)
+{
+    return heapStore_deform_cols(ref, tupleDesc_cols_mask(ncols), out);
+}
+
+static int heapStore_deform_ref(const HeapTupleRef* ref, u64 want, Datum* out, VarlenaMode mode,
+                                MemoryContext* arena)
 {
     if (!ref->col_data || !out) return -1;
-    usize use_ncols = ncols < (usize)ref->schema->ncols ? ncols : (usize)ref->schema->ncols;
-    return heapStore_deform_all(ref->col_data, ref->schema, ref->hdr->null_bits, out);
-    (void)use_ncols;
+    if (ref->store)
+        return tupleDesc_deform_ex(&ref->store->desc, ref->col_data, ref->hdr->null_bits, want, out,
+                                   mode, arena);
+    TupleDesc desc;
+    TupleDesc_init(&desc, ref->schema);
+    return tupleDesc_deform_ex(&desc, ref->col_data, ref->hdr->null_bits, want, out, mode, arena);
+}
+
+int heapStore_deform_cols(const HeapTupleRef* ref, u64 want, Datum* out)
+{
+    return heapStore_deform_ref(ref, want, out, VARLENA_COPY_MALLOC, NULL);
+}
+
+int heapStore_deform_cols_byref(const HeapTupleRef* ref, u64 want, Datum* out)
+{
+    return heapStore_deform_ref(ref, want, out, VARLENA_BYREF, NULL);
+}
+
+int heapStore_deform_cols_arena(const HeapTupleRef* ref, u64 want, Datum* out, MemoryContext* arena)
+{
+    return heapStore_deform_ref(ref, want, out, VARLENA_COPY_ARENA, arena);
+}
+
+Datum heapStore_detoast(const HeapStore* store, Datum d, MemoryContext* arena)
+{
+    const u8* p = DatumGetPointer(d);
+    if (!p || !(varlena_word(p) & VARLENA_TAG_MASK)) return d;
+    usize raw = varlena_raw_size(p);
+    u8* copy = arena ? memoryContext_alloc(arena, raw) : malloc(raw);
+    if (!copy) return (Datum)0;
+    if (!varlena_detoast_into(&store->toast, p, copy))
+    {
+        if (!arena) free(copy);
+        return (Datum)0;
+    }
+    return PointerGetDatum(copy);
 }
 
 u64 heapStore_slot_count(HeapStore* store)
 {
-    SegmentBase* last = segmentTree_get_last_segment(&store->tree);
+    BlockSegment* last = (BlockSegment*)segmentTree_get_last_segment(&store->tree);
     if (!last) return 0;
-    return (u64)(last->start + last->count);
+    LWLockAcquire(&last->content_lock, LW_SHARED);
+    u64 n = (u64)(last->base.start + last->base.count);
+    LWLockRelease(&last->content_lock);
+    return n;
 }
 
 static u8* wirte_col(u8* p, TupleColType type, Datum d)
@@ -340,14 +620,13 @@ static u8* wirte_col(u8* p, TupleColType type, Datum d)
             memcpy(p, &v4, sizeof(f64));
             return p + sizeof(f64);
         case TUPLE_COL_TEXT:
+        case TUPLE_COL_JSONB:
         {
-            /* In-memory: [u32 content_len][data...] — same as on-disk. */
-            u8* ptr = (u8*)DatumGetPointer(d);
-            u32 len = 0;
-            memcpy(&len, ptr, 4);
-            memcpy(p, ptr, (usize)4 + len);
-            p += (usize)4 + len;
-            return p;
+            /* In-memory: [u32 len][data...] — same as on-disk. */
+            const u8* ptr = (const u8*)DatumGetPointer(d);
+            usize size = varlena_size(ptr, type);
+            memcpy(p, ptr, size);
+            return p + size;
         }
         default:
             return p; /* should not happen */
@@ -373,12 +652,10 @@ static usize compute_col_size(TupleColType type, Datum d)
         case TUPLE_COL_F64:
             return 8;
         case TUPLE_COL_TEXT:
-        {
-            /* In-memory layout: [u32 content_len][data...] — disk format is identical. */
-            u32 len = 0;
-            memcpy(&len, DatumGetPointer(d), 4);
-            return (usize)4 + len;
-        }
+        case TUPLE_COL_JSONB:
+            /* In-memory layout is the disk format (see varlena_size). */
+            if (!DatumGetPointer(d)) return 0; /* NULL column */
+            return varlena_size((const u8*)DatumGetPointer(d), type);
         default:
             return 0;
     }
@@ -410,6 +687,187 @@ static void serialize_tuple_into(u8* dst, const TupleHdr* hdr, const TableSchema
     }
 }
 
+/* A TEXT / JSONB Datum without a pointer is stored as NULL: its null bit is set. */
+static u64 heapStore_varlena_nulls(const HeapStore* store, const Datum* values)
+{
+    u64 bits = 0;
+    if (!values) return 0;
+    for (u16 i = 0; i < store->desc.natts; i++)
+    {
+        if (!store->desc.attlen[i] && !DatumGetPointer(values[i])) bits |= (u64)1 << i;
+    }
+    return bits;
+}
+
+/* ============================================================
+ * TOAST — shrink oversized tuples before placement (PG toast_insert_or_update)
+ * ============================================================ */
+
+/* Replacement values for one tuple; bufs own the compressed / external words. */
+typedef struct
+{
+    Datum vals[HEAP_MAX_COLS];
+    void* bufs[HEAP_MAX_COLS];
+    u16 nbufs;
+} ToastScratch;
+
+static void toastScratch_free(ToastScratch* sc)
+{
+    for (u16 i = 0; i < sc->nbufs; i++) free(sc->bufs[i]);
+    sc->nbufs = 0;
+}
+
+/* Failed toasting: give back the chunks already moved out of line, then the scratch. */
+static void heapStore_toast_abort(HeapStore* store, ToastScratch* sc)
+{
+    for (u16 i = 0; i < sc->nbufs; i++)
+    {
+        const u8* p = sc->bufs[i];
+        if (!(varlena_word(p) & VARLENA_EXTERNAL)) continue;
+        ToastPointer tp;
+        memcpy(&tp, p + 4, sizeof(tp));
+        toastStore_delete(&store->toast, &tp);
+    }
+    toastScratch_free(sc);
+}
+
+/* Largest toastable varlena column whose current form is bigger than min_size. */
+static int heapStore_toast_pick(const HeapStore* store, u64 null_bits, const Datum* vals,
+                                u64 skip, u32 tag_skip, usize min_size)
+{
+    int best = -1;
+    usize best_size = min_size;
+    for (u16 i = 0; i < store->desc.natts; i++)
+    {
+        if (store->desc.attlen[i] || ((null_bits | skip) >> i) & 1) continue;
+        const u8* p = DatumGetPointer(vals[i]);
+        if (!p || (varlena_word(p) & tag_skip)) continue;
+        usize size = varlena_size(p, (TupleColType)store->desc.atttype[i]);
+        if (size > best_size)
+        {
+            best = i;
+            best_size = size;
+        }
+    }
+    return best;
+}
+
+/*
+ * Returns values unchanged when the tuple fits under TOAST_TUPLE_THRESHOLD;
+ * otherwise sc->vals with the largest TEXT / JSONB values compressed inline
+ * and, if that is not enough, moved to the overflow pages.  Out-of-line
+ * values handed in (zero-copy Datums) are expanded first so each tuple owns
+ * its chunks.  Caller frees sc.  NULL for non-NULL values on allocation
+ * failure, with sc already freed and any chunks moved out of line given back.
+ */
+static const Datum* heapStore_toast_values(HeapStore* store, u64 null_bits, const Datum* values,
+                                           ToastScratch* sc)
+{
+    sc->nbufs = 0;
+    const TupleDesc* desc = &store->desc;
+    if (!values || desc->nfixed == desc->natts) return values;
+
+    bool copied = false;
+    for (u16 i = 0; i < desc->natts; i++)
+    {
+        const u8* p = DatumGetPointer(values[i]);
+        if (desc->attlen[i] || (null_bits >> i) & 1 || !p) continue;
+        if (!(varlena_word(p) & VARLENA_EXTERNAL)) continue;
+        if (!copied) memcpy(sc->vals, values, desc->natts * sizeof(Datum));
+        copied = true;
+        Datum plain = heapStore_detoast(store, values[i], NULL);
+        if (plain) sc->bufs[sc->nbufs++] = DatumGetPointer(plain);
+        sc->vals[i] = plain;
+    }
+    const Datum* vals = copied ? sc->vals : values;
+    usize size = compute_tuple_size(store->schema, vals);
+    if (size <= TOAST_TUPLE_THRESHOLD) return vals;
+    if (!copied) memcpy(sc->vals, values, desc->natts * sizeof(Datum));
+
+    /* 1. compress inline, largest first */
+    u64 tried = 0;
+    while (store->toast_compression && size > TOAST_TUPLE_THRESHOLD)
+    {
+        int i = heapStore_toast_pick(store, null_bits, sc->vals, tried, VARLENA_TAG_MASK,
+                                     TOAST_MIN_COMPRESS);
+        if (i < 0) break;
+        tried |= (u64)1 << i;
+        const u8* p = DatumGetPointer(sc->vals[i]);
+        usize plain = varlena_size(p, (TupleColType)desc->atttype[i]);
+        u8* buf = malloc(plain);
+        if (!buf) break;
+        usize clen = toast_compress(p, plain, buf + 8, plain - 9);
+        if (clen == 0)
+        {
+            free(buf); /* incompressible */
+            continue;
+        }
+        u32 word = VARLENA_COMPRESSED | (u32)(clen + 4);
+        u32 raw = (u32)plain;
+        memcpy(buf, &word, 4);
+        memcpy(buf + 4, &raw, 4);
+        sc->bufs[sc->nbufs++] = buf;
+        sc->vals[i] = PointerGetDatum(buf);
+        size -= plain - (clen + 8);
+    }
+
+    /* 2. move out of line, largest first */
+    const usize ext_size = 4 + sizeof(ToastPointer);
+    while (size > TOAST_TUPLE_THRESHOLD)
+    {
+        int i = heapStore_toast_pick(store, null_bits, sc->vals, 0, VARLENA_EXTERNAL, ext_size);
+        if (i < 0) break;
+        const u8* p = DatumGetPointer(sc->vals[i]);
+        usize cur = varlena_size(p, (TupleColType)desc->atttype[i]);
+        u8* buf = malloc(ext_size);
+        if (!buf)
+        {
+            heapStore_toast_abort(store, sc);
+            return NULL;
+        }
+        ToastPointer tp;
+        if (varlena_word(p) & VARLENA_COMPRESSED)
+            tp = toastStore_put(&store->toast, p + 8, (u32)(cur - 8), varlena_word(p + 4),
+                                TOAST_PTR_COMPRESSED);
+        else
+            tp = toastStore_put(&store->toast, p, (u32)cur, (u32)cur, 0);
+        u32 word = VARLENA_EXTERNAL | (u32)sizeof(ToastPointer);
+        memcpy(buf, &word, 4);
+        memcpy(buf + 4, &tp, sizeof(tp));
+        sc->bufs[sc->nbufs++] = buf;
+        sc->vals[i] = PointerGetDatum(buf);
+        size -= cur - ext_size;
+    }
+    assert(size <= HS_MAX_TUPLE_SIZE && "tuple too large even after toasting");
+    return sc->vals;
+}
+
+/* Give back the overflow chunks of a tuple that is being reclaimed. */
+static void heapStore_toast_release(HeapStore* store, const u8* tup)
+{
+    const TupleDesc* desc = &store->desc;
+    if (desc->nfixed == desc->natts) return;
+    u64 null_bits;
+    memcpy(&null_bits, tup + offsetof(TupleHdr, null_bits), sizeof(u64));
+    const u8* p = tup + sizeof(TupleHdr);
+    for (u16 i = 0; i < desc->natts; i++)
+    {
+        if ((null_bits >> i) & 1) continue;
+        if (desc->attlen[i])
+        {
+            p += desc->attlen[i];
+            continue;
+        }
+        if (varlena_word(p) & VARLENA_EXTERNAL)
+        {
+            ToastPointer tp;
+            memcpy(&tp, p + 4, sizeof(tp));
+            toastStore_delete(&store->toast, &tp);
+        }
+        p += varlena_size(p, (TupleColType)desc->atttype[i]);
+    }
+}
+
 /* ============================================================
  * rs_page_compact — in-place page defragmentation (PG PageRepairFragmentation)
  *
@@ -418,20 +876,46 @@ static void serialize_tuple_into(u8* dst, const TupleHdr* hdr, const TableSchema
  * Updates each live slot's lp_off; resets pd_upper.
  * Dead slots (lp_len == 0) are left unchanged in the slot array.
  *
- * Move direction: always upward (src ≤ dest), so memmove is correct even
- * when adjacent blocks overlap.  O(page_size).
+ * Slot order is not address order: a reused LP_UNUSED slot gets its tuple
+ * at pd_upper, below the tuples of later slots.  Live tuples are therefore
+ * packed in descending lp_off order; each one then only moves upward
+ * (src ≤ dest) into space whose previous occupants have already moved, so
+ * memmove never clobbers a tuple that is still to be moved.
+ * O(page_size + n log n).
  * ============================================================ */
+#define HS_MAX_SLOTS (BLOCK_DATA_SIZE / HS_SLOT_SIZE)
+
+typedef struct
+{
+    u16 slot;
+    u16 off;
+} CompactItem;
+
+static int compact_item_cmp(const void* a, const void* b)
+{
+    u16 x = ((const CompactItem*)a)->off, y = ((const CompactItem*)b)->off;
+    return (x < y) - (x > y); /* descending lp_off */
+}
+
 static void heapStore_page_compact(u8* page)
 {
     u16 pd_lower = *heapStore_pd_lower(page);
     usize n_slots = (pd_lower - HS_BLOCK_HDR_SIZE) / HS_SLOT_SIZE;
-    u16 new_upper = (u16)BLOCK_SIZE;
+    CompactItem items[HS_MAX_SLOTS];
+    usize n_live = 0;
 
     for (usize i = 0; i < n_slots; i++)
     {
         TupleSlotId* sl = &heapStore_slots(page)[i];
         if (sl->lp_len == 0) continue; /* LP_UNUSED: skip */
+        items[n_live++] = (CompactItem){(u16)i, sl->lp_off};
+    }
+    qsort(items, n_live, sizeof(CompactItem), compact_item_cmp);
 
+    u16 new_upper = (u16)BLOCK_DATA_SIZE;
+    for (usize k = 0; k < n_live; k++)
+    {
+        TupleSlotId* sl = &heapStore_slots(page)[items[k].slot];
         u16 tup_len = sl->lp_len;
         new_upper -= tup_len;
         if (sl->lp_off != new_upper)
@@ -445,21 +929,144 @@ static void heapStore_page_compact(u8* page)
     *heapStore_pd_upper(page) = new_upper;
 }
 
-/* Forward declaration — defined later in this file. */
-static BlockSegment* heapStore_find_seg_by_block(const HeapStore* store, block_id_t block_id);
-
 static TxnId rs_alloc_xid(HeapStore* store)
 {
-    return ++store->next_txn_id;
+    return atomic_fetch_add(&store->next_txn_id, 1) + 1;
 }
 
-static ItemPtr heapStore_reuse_slot(HeapStore* store, ItemPtr ctid, TupleHdr* hdr,
-                                    const Datum* vals)
+void heapStore_set_txn_manager(HeapStore* store, TransactionManager* mgr)
 {
-    BlockSegment* seg = heapStore_find_seg_by_block(store, item_ptr_block_id(ctid));
-    if (!seg) return INVALID_ITEM_PTR;
+    store->txn_mgr = mgr;
+}
 
-    u16 slot_idx = item_ptr_slot(ctid);
+/* Without a txn manager every stamped xid counts as committed. */
+static inline TxnStatus heapStore_xid_status(const HeapStore* store, TxnId xid)
+{
+    return store->txn_mgr ? transactionManager_status(store->txn_mgr, xid) : TXN_STATUS_COMMITTED;
+}
+
+/* ============================================================
+ * Latching
+ *
+ * Each page carries its own content latch (BlockSegment.content_lock):
+ * SHARED to read its tuples, EXCLUSIVE to change them.  store->lock is only
+ * the structure latch over block_map / page_count and the writer side of
+ * tree.nodes, held for a lookup or for linking a new page, never while
+ * waiting on a page latch.  Page-number lookups in tree.nodes take no latch:
+ * the directory is epoch-protected (see segment.h).
+ * store->map_lock guards the FSM and VM.  Both, like the TOAST store's own
+ * lock, are leaves taken under page latches.  A writer needing two pages
+ * latches them in ascending page order; a lower page is only tried with
+ * LWLockConditionalAcquire, and on failure the tuple goes elsewhere.
+ * ============================================================ */
+
+/** Segment of page page_no, NULL past the end. */
+static inline BlockSegment* heapStore_page_seg(HeapStore* store, u32 page_no)
+{
+    return (BlockSegment*)segmentTree_get_node(&store->tree, page_no);
+}
+
+/**
+ * Last page and its page number; it stays last only while latched.  The
+ * count is read first, so a page linked in between shows up as seg->next
+ * once the caller latches seg.
+ */
+static inline BlockSegment* heapStore_last_page(HeapStore* store, u32* page_no)
+{
+    *page_no = (u32)(segmentTree_segment_count(&store->tree) - 1);
+    return heapStore_page_seg(store, *page_no);
+}
+
+/** Page number (position in tree.nodes) of a non-empty page segment; seg latched. */
+static inline u32 heapStore_seg_page_no(HeapStore* store, BlockSegment* seg)
+{
+    return (u32)segmentTree_get_segment_index(&store->tree, seg->base.start);
+}
+
+static BlockSegment* heapStore_find_seg_by_block(HeapStore* store, block_id_t block_id)
+{
+    LWLockAcquire(&store->lock, LW_SHARED);
+    hmap_node* node = hmap_get(&store->block_map, &block_id);
+    BlockSegment* seg = node ? HMAP_VALUE(node, BlockSegment*) : NULL;
+    LWLockRelease(&store->lock);
+    return seg;
+}
+
+static inline void heapStore_fsm_set(HeapStore* store, u32 page_no, usize avail)
+{
+    LWLockAcquire(&store->map_lock, LW_EXCLUSIVE);
+    freeSpaceMap_set(&store->fsm, page_no, avail);
+    LWLockRelease(&store->map_lock);
+}
+
+static inline u32 heapStore_fsm_search(HeapStore* store, usize needed)
+{
+    LWLockAcquire(&store->map_lock, LW_SHARED);
+    u32 page_no = freeSpaceMap_search(&store->fsm, needed);
+    LWLockRelease(&store->map_lock);
+    return page_no;
+}
+
+static inline u8 heapStore_vm_get(HeapStore* store, u32 page_no)
+{
+    LWLockAcquire(&store->map_lock, LW_SHARED);
+    u8 flags = visibilityMap_get(&store->vm, page_no);
+    LWLockRelease(&store->map_lock);
+    return flags;
+}
+
+static inline void heapStore_vm_set(HeapStore* store, u32 page_no, u8 flags)
+{
+    LWLockAcquire(&store->map_lock, LW_EXCLUSIVE);
+    visibilityMap_set(&store->vm, page_no, flags);
+    LWLockRelease(&store->map_lock);
+}
+
+static inline void heapStore_vm_clear(HeapStore* store, u32 page_no)
+{
+    LWLockAcquire(&store->map_lock, LW_EXCLUSIVE);
+    visibilityMap_clear(&store->vm, page_no);
+    LWLockRelease(&store->map_lock);
+}
+
+/* ============================================================
+ * Free space map maintenance
+ *
+ * Only LP_UNUSED slots can take a new tuple on a non-last page (row
+ * numbers are start + slot index, so the slot array of an earlier page
+ * cannot grow).  A page's FSM value is therefore 0 unless it has an
+ * unused slot, and otherwise the bytes available after compaction.
+ * New slots on the last page are handled by heapStore_append_tuple.
+ * ============================================================ */
+
+/** Recompute one page's reusable space, refresh PD_HAS_FREE_LINES and its FSM entry.
+ *  Page latched EXCLUSIVE. */
+static void heapStore_fsm_update_page(HeapStore* store, u32 page_no, u8* page)
+{
+    u16 pd_lower = *heapStore_pd_lower(page);
+    usize n_slots = (pd_lower - HS_BLOCK_HDR_SIZE) / HS_SLOT_SIZE;
+    usize live_bytes = 0;
+    bool has_unused = false;
+    for (usize i = 0; i < n_slots; i++)
+    {
+        u16 len = heapStore_slots(page)[i].lp_len;
+        if (len == 0)
+            has_unused = true;
+        else
+            live_bytes += len;
+    }
+    if (has_unused)
+        *heapStore_pd_flags(page) |= PD_HAS_FREE_LINES;
+    else
+        *heapStore_pd_flags(page) &= (u16)~PD_HAS_FREE_LINES;
+    usize avail = has_unused ? BLOCK_DATA_SIZE - pd_lower - live_bytes : 0;
+    heapStore_fsm_set(store, page_no, avail);
+}
+
+static ItemPtr heapStore_reuse_slot(HeapStore* store, BlockSegment* seg, u16 slot_idx,
+                                    TupleHdr* hdr, const Datum* vals)
+{
+    ItemPtr ctid = make_item_ptr(seg->block_id, slot_idx);
     u8* page = (u8*)segment_get_data(seg);
     if ((usize)slot_idx >= seg->base.count) return INVALID_ITEM_PTR;
 
@@ -481,7 +1088,9 @@ static ItemPtr heapStore_reuse_slot(HeapStore* store, ItemPtr ctid, TupleHdr* hd
     /* Stamp physical ctid: (block_id, slot_idx) — unchanged within the same page. */
     hdr->t_ctid = make_item_ptr(seg->block_id, slot_idx);
 
-    /* Carve tuple space from pd_upper downward. */
+    /* Carve tuple space from pd_upper downward.  The tuple lands below those of
+     * later slots, so lp_off is no longer monotonic in slot order —
+     * heapStore_page_compact sorts by lp_off rather than relying on it. */
     *heapStore_pd_upper(page) -= (u16)ser_size;
     u16 tup_off = *heapStore_pd_upper(page);
 
@@ -519,61 +1128,93 @@ static u8* heapStore_page_reserve_slot(u8* page, u16 len, u16* out_slot_idx)
     return page + tup_off;
 }
 
-static ItemPtr heapStore_append_tuple(HeapStore* store, TupleHdr* hdr, const Datum* vals)
+/* Add a slot to seg's page (latched EXCLUSIVE, room already checked) and
+ * serialize the tuple into it. */
+static ItemPtr heapStore_page_append(HeapStore* store, BlockSegment* seg, usize ser_size,
+                                     TupleHdr* hdr, const Datum* vals)
 {
-    /* 1. Compute serialized size first (t_ctid not yet stamped, but TupleHdr
-     *    size is fixed — ctid doesn't affect total tuple size). */
-    usize ser_size = compute_tuple_size(store->schema, vals);
-    assert(ser_size <= HS_MAX_TUPLE_SIZE && "tuple too large for one page");
-
-    /* 2. Find current page; create a new one if it won't fit. */
-    BlockSegment* seg = (BlockSegment*)segmentTree_get_last_segment(&store->tree);
     u8* page = (u8*)segment_get_data(seg);
 
-    if (heapStore_free_space(page) < (u16)(HS_SLOT_SIZE + ser_size))
-    {
-        /* Compute start for new segment from last segment. */
-        usize new_start = seg->base.start + seg->base.count;
-        BlockSegment* ns = BlockSegment_create2(new_start);
-
-        /* Assign real block_id at segment creation time (true physical ctid). */
-        block_id_t bid;
-        if (store->block_manager != NULL)
-        {
-            bid = VCALL(store->block_manager, get_free_block_id);
-            ns->block_manager = store->block_manager;
-        }
-        else
-        {
-            bid = (block_id_t)store->page_count; /* sequential local fallback */
-        }
-        ns->block_id = bid;
-        ns->block = Block_create(bid);
-
-        page = (u8*)segment_get_data(ns);
-        heapStore_page_init(page);
-        segmentTree_append_segment(&store->tree, (SegmentBase*)ns);
-        seg = ns;
-        store->page_count++;
-    }
-
-    /* 3. Compute slot index from current pd_lower (= number of existing slots). */
+    /* Compute slot index from current pd_lower (= number of existing slots). */
     u16 slot_idx = (u16)((*heapStore_pd_lower(page) - HS_BLOCK_HDR_SIZE) / HS_SLOT_SIZE);
 
-    /* 4. Stamp ctid using the segment's real disk block_id. */
-    block_id_t block_id = seg->block_id;
-    hdr->t_ctid = make_item_ptr(block_id, slot_idx);
+    /* Stamp ctid using the segment's real disk block_id. */
+    hdr->t_ctid = make_item_ptr(seg->block_id, slot_idx);
 
-    /* 5. Reserve page slot and serialize directly into it (zero intermediate buffer). */
+    /* Reserve page slot and serialize directly into it (zero intermediate buffer). */
     u16 actual_slot;
     u8* dest = heapStore_page_reserve_slot(page, (u16)ser_size, &actual_slot);
     assert(actual_slot == slot_idx); /* must match pre-computed slot */
     serialize_tuple_into(dest, hdr, store->schema, vals);
 
-    seg->base.count++;
+    /* release: lock-free row lookups (segmentTree_get_segment) read count with acquire */
+    __atomic_store_n(&seg->base.count, seg->base.count + 1, __ATOMIC_RELEASE);
     return hdr->t_ctid;
 }
 
+/* Link a fresh page after last (latched EXCLUSIVE by the caller, which keeps
+ * it last).  The new page is returned latched EXCLUSIVE: scans that follow
+ * last->next wait on it until the first tuple is in. */
+static BlockSegment* heapStore_extend(HeapStore* store, BlockSegment* last, u32* page_no)
+{
+    /* Compute start for new segment from last segment. */
+    BlockSegment* ns = BlockSegment_create2(last->base.start + last->base.count);
+    ns->block_manager = store->block_manager;
+    ns->block = Block_create(INVALID_BLOCK);
+    heapStore_page_init((u8*)segment_get_data(ns));
+    LWLockAcquire(&ns->content_lock, LW_EXCLUSIVE);
+
+    LWLockAcquire(&store->lock, LW_EXCLUSIVE);
+    /* Assign real block_id at segment creation time (true physical ctid). */
+    block_id_t bid = store->block_manager != NULL ? VCALL(store->block_manager, get_free_block_id)
+                                                  : (block_id_t)store->page_count; /* sequential local fallback */
+    ns->block_id = bid;
+    ns->block->id = bid;
+    segmentTree_append_segment(&store->tree, (SegmentBase*)ns);
+    hmap_insert(&store->block_map, &bid, &ns);
+    *page_no = (u32)(vector_size(store->tree.nodes) - 1);
+    store->page_count++;
+    LWLockRelease(&store->lock);
+
+    heapStore_fsm_set(store, *page_no, 0);
+    return ns;
+}
+
+/* Append to the last page, extending the heap when it is full.  held is a page
+ * the caller already latches EXCLUSIVE (or NULL); any other page is latched
+ * here.  Clears the target page's VM bit. */
+static ItemPtr heapStore_append_tuple(HeapStore* store, TupleHdr* hdr, const Datum* vals,
+                                      BlockSegment* held)
+{
+    /* TupleHdr size is fixed — ctid doesn't affect total tuple size. */
+    usize ser_size = compute_tuple_size(store->schema, vals);
+    assert(ser_size <= HS_MAX_TUPLE_SIZE && "tuple too large for one page");
+
+    for (;;)
+    {
+        u32 page_no;
+        BlockSegment* seg = heapStore_last_page(store, &page_no);
+        /* the last page is never below held: ascending order, blocking is safe */
+        if (seg != held) LWLockAcquire(&seg->content_lock, LW_EXCLUSIVE);
+        if (seg->base.next != NULL)
+        {
+            /* another writer extended the heap meanwhile */
+            if (seg != held) LWLockRelease(&seg->content_lock);
+            continue;
+        }
+
+        BlockSegment* target = seg;
+        if (heapStore_free_space((u8*)segment_get_data(seg)) < (u16)(HS_SLOT_SIZE + ser_size))
+            target = heapStore_extend(store, seg, &page_no);
+        if (target != seg && seg != held) LWLockRelease(&seg->content_lock);
+
+        ItemPtr ctid = heapStore_page_append(store, target, ser_size, hdr, vals);
+        heapStore_vm_clear(store, page_no);
+        if (target != held) LWLockRelease(&target->content_lock);
+        return ctid;
+    }
+}
+
 //   地址 0
 //   ┌──────────────────────────────────────────┐
 //   │ pd_lower = 26  (6 + 5×4 = 5个slot)      │ offset=0
@@ -595,66 +1236,115 @@ static ItemPtr heapStore_append_tuple(HeapStore* store, TupleHdr* hdr, const Dat
 //   │ (gap: tuple[2] 已被vacuum清零)           │ ← 死区（lp_off/lp_len=0,不占逻辑空间）
 //   │ tuple[1] data  48B                       │
 //   │ tuple[0] data  48B                       │
-//   └──────────────────────────────────────────┘ offset=8192
+//   └──────────────────────────────────────────┘ offset=8184
 
 //   ---
-ItemPtr heapStore_insert(HeapStore* store, TxnId xid, ItemPtr emb_ctid, const Datum* values,
-                         u64 null_bits)
+/* Place a stamped header + values anywhere: an FSM-advertised LP_UNUSED slot,
+ * else the last page (or a fresh one).  held is a page the caller already
+ * latches EXCLUSIVE (NULL if none) and held_page_no its number.  Returns the
+ * new ctid. */
+static ItemPtr heapStore_put_tuple(HeapStore* store, TupleHdr* hdr, const Datum* values,
+                                   BlockSegment* held, u32 held_page_no)
 {
-    TupleHdr hdr;
-    memset(&hdr, 0, sizeof(hdr));
-    hdr.t_xmin = xid ? xid : rs_alloc_xid(store);
-    hdr.t_xmax = INVALID_TXN_ID;
-    hdr.t_emb_ctid = emb_ctid;
-    hdr.null_bits = null_bits;
-    // tuple->row_id = row_id;
     ItemPtr ctid = INVALID_ITEM_PTR;
 
-    if (store->hint_free_seg != NULL)
+    /* FSM lookup: O(log pages) to a page that has an LP_UNUSED slot and room
+     * for the tuple after compaction.  The hit is re-checked on the page; a
+     * stale entry is corrected and the search repeated. */
+    usize ser_size = compute_tuple_size(store->schema, values);
+    for (;;)
     {
-        BlockSegment* scan = store->hint_free_seg;
-        while (scan != NULL)
+        u32 page_no = heapStore_fsm_search(store, ser_size);
+        if (page_no == FSM_NOT_FOUND) break;
+
+        BlockSegment* seg = heapStore_page_seg(store, page_no);
+        if (seg != held)
         {
-            data_ptr_t page = segment_get_data(scan);
-            // Find a page with free space
-            if (*heapStore_pd_flags(page) & PD_HAS_FREE_LINES)
+            /* below the held page: out of latch order, only try it */
+            if (held && page_no < held_page_no)
             {
-                usize n_slots = (*heapStore_pd_lower(page) - HS_BLOCK_HDR_SIZE) / HS_SLOT_SIZE;
-                for (usize i = 0; i < n_slots; i++)
-                {
-                    if (heapStore_slots(page)[i].lp_len != 0) continue; /* not LP_UNUSED */
-
-                    ItemPtr free_ctid = make_item_ptr(scan->block_id, (u16)i);
-                    ItemPtr ctid = heapStore_reuse_slot(store, free_ctid, &hdr, values);
-                    if (item_ptr_is_valid(ctid))
-                    {
-                        break;
-                    }
-                }
-
-                /* No usable LP_UNUSED slot on this page — clear its hint bit. */
-                *heapStore_pd_flags(page) &= (u16)~PD_HAS_FREE_LINES;
+                if (!LWLockConditionalAcquire(&seg->content_lock, LW_EXCLUSIVE)) break;
             }
-            scan = (BlockSegment*)scan->base.next;
+            else
+            {
+                LWLockAcquire(&seg->content_lock, LW_EXCLUSIVE);
+            }
+        }
+        u8* page = (u8*)segment_get_data(seg);
+        usize n_slots = (*heapStore_pd_lower(page) - HS_BLOCK_HDR_SIZE) / HS_SLOT_SIZE;
+        for (usize i = 0; i < n_slots; i++)
+        {
+            if (heapStore_slots(page)[i].lp_len != 0) continue; /* not LP_UNUSED */
+            ctid = heapStore_reuse_slot(store, seg, (u16)i, hdr, values);
+            heapStore_vm_clear(store, page_no);
+            break;
         }
-        if (!item_ptr_is_valid(ctid))
-            store->hint_free_seg = NULL; /* no free pages remain; reset hint */
+        heapStore_fsm_update_page(store, page_no, page);
+        if (seg != held) LWLockRelease(&seg->content_lock);
+        if (item_ptr_is_valid(ctid)) break;
     }
-    if (!item_ptr_is_valid(ctid))
+    if (!item_ptr_is_valid(ctid)) ctid = heapStore_append_tuple(store, hdr, values, held);
+    return ctid;
+}
+
+/* HOT placement: put the tuple on seg (page page_no, latched EXCLUSIVE) itself —
+ * into an LP_UNUSED slot, or a new slot when it is the last page.
+ * INVALID_ITEM_PTR if it won't fit. */
+static ItemPtr heapStore_put_tuple_on_page(HeapStore* store, BlockSegment* seg, u32 page_no,
+                                           TupleHdr* hdr, const Datum* values)
+{
+    u8* page = (u8*)segment_get_data(seg);
+    ItemPtr ctid = INVALID_ITEM_PTR;
+    if (*heapStore_pd_flags(page) & PD_HAS_FREE_LINES)
     {
-        ctid = heapStore_append_tuple(store, &hdr, values);
+        usize n_slots = (*heapStore_pd_lower(page) - HS_BLOCK_HDR_SIZE) / HS_SLOT_SIZE;
+        for (usize i = 0; i < n_slots; i++)
+        {
+            if (heapStore_slots(page)[i].lp_len != 0) continue;
+            ctid = heapStore_reuse_slot(store, seg, (u16)i, hdr, values);
+            break;
+        }
+        heapStore_fsm_update_page(store, page_no, page);
+    }
+    usize ser_size = compute_tuple_size(store->schema, values);
+    if (!item_ptr_is_valid(ctid) && seg->base.next == NULL &&
+        (usize)heapStore_free_space(page) >= HS_SLOT_SIZE + ser_size)
+    {
+        /* fits: stays on the last page */
+        ctid = heapStore_page_append(store, seg, ser_size, hdr, values);
     }
+    if (item_ptr_is_valid(ctid)) heapStore_vm_clear(store, page_no);
     return ctid;
 }
 
-static BlockSegment* heapStore_find_seg_by_block(const HeapStore* store, block_id_t block_id)
+ItemPtr heapStore_insert(HeapStore* store, TxnId xid, ItemPtr emb_ctid, const Datum* values,
+                         u64 null_bits)
 {
-    for (SegmentBase* s = segmentTree_get_root_segment(&store->tree); s != NULL; s = s->next)
+    TxnId autocommit = INVALID_TXN_ID;
+    if (!xid && store->txn_mgr)
     {
-        BlockSegment* seg = (BlockSegment*)s;
-        if (seg->block_id == block_id) return seg;
+        xid = autocommit = transactionManager_begin(store->txn_mgr);
+        if (!xid) return INVALID_ITEM_PTR;
     }
-    return NULL;
+
+    TupleHdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.t_xmin = xid ? xid : rs_alloc_xid(store);
+    hdr.t_xmax = INVALID_TXN_ID;
+    hdr.t_emb_ctid = emb_ctid;
+    null_bits |= heapStore_varlena_nulls(store, values);
+    hdr.null_bits = null_bits;
+    ToastScratch sc;
+    const Datum* vals = heapStore_toast_values(store, null_bits, values, &sc);
+    if (values && !vals)
+    {
+        if (autocommit) transactionManager_abort(store->txn_mgr, autocommit);
+        return INVALID_ITEM_PTR;
+    }
+    ItemPtr ctid = heapStore_put_tuple(store, &hdr, vals, NULL, 0);
+    toastScratch_free(&sc);
+    if (autocommit) transactionManager_commit(store->txn_mgr, autocommit);
+    return ctid;
 }
 
 /** Return a pointer to the tuple at slot_idx within page. */
@@ -702,21 +1392,21 @@ static const u8* read_col_ptr(const u8* src, TupleVal* out)
  * Deserialize one tuple from a contiguous memory pointer.
  * out->cols is heap-allocated (Datum[]); call row_tuple_free(out, schema) when done.
  */
-static bool deserialize_tuple_from_ptr(const u8* p, const TableSchema* schema, HeapTuple* out)
+static bool deserialize_tuple_from_ptr(const u8* p, const TupleDesc* desc, HeapTuple* out)
 {
     memcpy(&out->hdr, p, sizeof(TupleHdr));
     p += sizeof(TupleHdr);
 
-    out->ncols = schema->ncols;
-    if (schema->ncols == 0)
+    out->ncols = desc->natts;
+    if (desc->natts == 0)
     {
         out->cols = NULL;
         return true;
     }
-    out->cols = (Datum*)calloc(schema->ncols, sizeof(Datum));
+    out->cols = (Datum*)calloc(desc->natts, sizeof(Datum));
     if (!out->cols) return false;
 
-    if (heapStore_deform_all(p, schema, out->hdr.null_bits, out->cols) != 0)
+    if (tupleDesc_deform(desc, p, out->hdr.null_bits, tupleDesc_cols_mask(desc->natts), out->cols) != 0)
     {
         free(out->cols);
         out->cols = NULL;
@@ -728,7 +1418,7 @@ static bool deserialize_tuple_from_ptr(const u8* p, const TableSchema* schema, H
 /**
  * Free heap-allocated column data in a HeapTuple (varlena Datums + the cols array itself).
  */
-static void row_tuple_free(HeapTuple* out, const TableSchema* schema)
+void row_tuple_free(HeapTuple* out, const TableSchema* schema)
 {
     if (!out->cols) return;
     for (u16 i = 0; i < out->ncols && i < schema->ncols; i++)
@@ -745,25 +1435,126 @@ static void row_tuple_free(HeapTuple* out, const TableSchema* schema)
     out->cols = NULL;
 }
 
-int heapStore_get_by_ctid(HeapStore* store, const TableSchema* schema, ItemPtr ctid, HeapTuple* out)
+/*
+ * Resolve ctid to its tuple, following a HEAP_REDIRECT stub (pruned HOT root)
+ * to the live chain member it points at.  On success the page is left latched
+ * in mode and *out_seg receives it (release its content_lock when done);
+ * NULL, with nothing latched, if the slot is LP_UNUSED or the ctid invalid.
+ * out_slot (optional) receives the resolved slot.
+ */
+static u8* heapStore_resolve_ctid(HeapStore* store, ItemPtr ctid, LWLockMode mode,
+                                  BlockSegment** out_seg, u16* out_slot)
 {
-    block_id_t block_id = item_ptr_block_id(ctid);
+    BlockSegment* seg = heapStore_find_seg_by_block(store, item_ptr_block_id(ctid));
+    if (!seg) return NULL;
+    LWLockAcquire(&seg->content_lock, mode);
     u16 slot_idx = item_ptr_slot(ctid);
-    BlockSegment* seg = heapStore_find_seg_by_block(store, block_id);
-    if (!seg) return -1;
-
     u8* page = (u8*)segment_get_data(seg);
-    if ((usize)slot_idx >= seg->base.count) return -1;
+    for (int hop = 0; hop < 2; hop++)
+    {
+        if ((usize)slot_idx >= seg->base.count) break;
+        if (heapStore_slots(page)[slot_idx].lp_len == 0) break; /* LP_UNUSED */
+        u8* tup = heapStore_page_get_tuple(page, slot_idx);
+        if (!(((const TupleHdr*)tup)->t_infomask & HEAP_REDIRECT))
+        {
+            *out_seg = seg;
+            if (out_slot) *out_slot = slot_idx;
+            return tup;
+        }
+        /* redirect targets are always on the same page */
+        slot_idx = item_ptr_slot(((const TupleHdr*)tup)->t_ctid);
+    }
+    LWLockRelease(&seg->content_lock);
+    return NULL;
+}
+
+static inline void heapStore_fill_ref(HeapStore* store, BlockSegment* seg, const u8* tup,
+                                      HeapTupleRef* ref)
+{
+    ref->hdr = (const TupleHdr*)tup;
+    ref->col_data = tup + sizeof(TupleHdr);
+    ref->schema = store->schema;
+    ref->store = store;
+    ref->page = seg;
+}
+
+int heapStore_fetch_ref(HeapStore* store, ItemPtr ctid, HeapTupleRef* ref)
+{
+    BlockSegment* seg;
+    const u8* tup = heapStore_resolve_ctid(store, ctid, LW_SHARED, &seg, NULL);
+    if (!tup) return -1;
+    heapStore_fill_ref(store, seg, tup, ref);
+    return 0;
+}
+
+/*
+ * Index entries point at a HOT chain's root, so the visible version may be
+ * any same-page member reachable through t_ctid while HEAP_HOT_UPDATED is set
+ * (cf. PG heap_hot_search_buffer).  A successor whose t_xmin does not match
+ * the predecessor's t_xmax belongs to a different chain (the slot was reused)
+ * and ends the walk.
+ */
+int heapStore_fetch_visible(HeapStore* store, ItemPtr ctid, const Snapshot* snap,
+                            HeapTupleRef* ref, ItemPtr* out_ctid)
+{
+    BlockSegment* seg;
+    u16 slot_idx;
+    const u8* tup = heapStore_resolve_ctid(store, ctid, LW_SHARED, &seg, &slot_idx);
+    if (!tup) return -1;
+    const u8* page = (const u8*)segment_get_data(seg);
+    for (usize hop = 0; hop < seg->base.count; hop++)
+    {
+        const TupleHdr* hdr = (const TupleHdr*)tup;
+        bool visible = snap ? snapshot_tuple_visible(snap, hdr->t_xmin, hdr->t_xmax)
+                            : hdr->t_xmax == INVALID_TXN_ID;
+        if (visible)
+        {
+            heapStore_fill_ref(store, seg, tup, ref);
+            if (out_ctid) *out_ctid = make_item_ptr(seg->block_id, slot_idx);
+            return 0;
+        }
+        if (!(hdr->t_infomask & HEAP_HOT_UPDATED)) break;
+
+        TxnId prev_xmax = hdr->t_xmax;
+        slot_idx = item_ptr_slot(hdr->t_ctid);
+        if ((usize)slot_idx >= seg->base.count) break;
+        if (heapStore_slots((u8*)page)[slot_idx].lp_len == 0) break; /* LP_UNUSED */
+        tup = heapStore_page_get_tuple((u8*)page, slot_idx);
+        hdr = (const TupleHdr*)tup;
+        if (!(hdr->t_infomask & HEAP_ONLY_TUPLE) || hdr->t_xmin != prev_xmax) break;
+    }
+    LWLockRelease(&seg->content_lock);
+    return -1;
+}
 
-    TupleSlotId* slot = &heapStore_slots(page)[slot_idx];
-    if (slot->lp_len == 0) return -1; /* LP_UNUSED */
+void heapStore_release_ref(HeapTupleRef* ref)
+{
+    if (!ref->page) return;
+    LWLockRelease(&ref->page->content_lock);
+    ref->page = NULL;
+}
 
-    u8* tup_ptr = heapStore_page_get_tuple(page, slot_idx);
+int heapStore_get_by_ctid(HeapStore* store, const TableSchema* schema, ItemPtr ctid, HeapTuple* out)
+{
+    BlockSegment* seg;
+    u16 slot_idx;
+    u8* tup_ptr = heapStore_resolve_ctid(store, ctid, LW_SHARED, &seg, &slot_idx);
+    if (!tup_ptr) return -1;
 
     memset(out, 0, sizeof(HeapTuple));
     out->ncols = schema->ncols;
 
-    if (!deserialize_tuple_from_ptr(tup_ptr, schema, out)) return -1;
+    TupleDesc local;
+    const TupleDesc* desc = &store->desc;
+    if (schema != store->schema &&
+        (schema->cols != store->schema->cols || schema->ncols != store->desc.natts))
+    {
+        TupleDesc_init(&local, schema);
+        desc = &local;
+    }
+    bool ok = deserialize_tuple_from_ptr(tup_ptr, desc, out);
+    LWLockRelease(&seg->content_lock);
+    if (!ok) return -1;
 
     // PostgreSQL 里 t_ctid 有两种状态：
 
@@ -794,80 +1585,358 @@ int heapStore_get_by_ctid(HeapStore* store, const TableSchema* schema, ItemPtr c
     return 0;
 }
 
-/* Lookup tuple pointer from ctid. Returns NULL if slot is LP_UNUSED or ctid invalid. */
-static u8* heapStore_lookup_ctid(HeapStore* store, ItemPtr ctid)
+/* Forget an aborted updater/deleter: t_xmax cleared, t_ctid back to self. */
+static inline void heapStore_clear_aborted_xmax(TupleHdr* hdr, block_id_t block_id, u16 slot_idx)
 {
-    block_id_t block_id = item_ptr_block_id(ctid);
-    u16 slot_idx = item_ptr_slot(ctid);
-    BlockSegment* seg = heapStore_find_seg_by_block(store, block_id);
-    if (!seg) return NULL;
-    if ((usize)slot_idx >= seg->base.count) return NULL;
-    u8* page = (u8*)segment_get_data(seg);
-    if (heapStore_slots(page)[slot_idx].lp_len == 0) return NULL;
-    return heapStore_page_get_tuple(page, slot_idx);
-}
-
-// TxnId heapStore_update_by_ctid(HeapStore* store, ItemPtr old_ctid, HeapTuple* new_tuple)
-// {
-//     u8* old_tup = heapStore_lookup_ctid(store, old_ctid);
-//     if (!old_tup) return INVALID_TXN_ID;
-
-//     /* Verify old version is alive */
-//     TupleHdr old_hdr;
-//     memcpy(&old_hdr, old_tup, sizeof(TupleHdr));
-//     if (old_hdr.t_xmax != INVALID_TXN_ID) return INVALID_TXN_ID;
-
-//     TxnId txn_id = store->next_txn_id++;
-
-//     /* Stamp new-version header (t_ctid set by rs_append_to_store). */
-//     new_tuple->hdr.t_xmin = txn_id;
-//     new_tuple->hdr.t_xmax = INVALID_TXN_ID;
-
-//     ItemPtr new_ctid = heapStore_append_tuple(store, new_tuple);
-//     /* new_tuple->hdr.t_ctid now holds the physical ctid of the new version. */
-//     ItemPtr new_ptr = new_tuple->hdr.t_ctid; /* (new_block_id, new_slot+1) */
-
-//     /* Re-lookup defensively: rs_append_to_store may realloc the SegmentTree
-//      * node array, but block->data buffers are stable (separate allocations).
-//      * The re-lookup is technically unnecessary but guards against future
-//      * layout changes that inline block data into the node array. */
-//     old_tup = heapStore_lookup_ctid(store, old_ctid);
-//     if (old_tup)
-//     {
-//         memcpy(&old_hdr, old_tup, sizeof(TupleHdr));
-//         old_hdr.t_xmax = txn_id;
-//         old_hdr.t_ctid = new_ptr; /* forward pointer to new physical location */
-//         memcpy(old_tup, &old_hdr, sizeof(TupleHdr));
-//     }
-
-//     (void)new_ctid; /* ctid is encoded in new_tuple->hdr.t_ctid for caller */
-//     return txn_id;
-// }
+    hdr->t_xmax = INVALID_TXN_ID;
+    hdr->t_ctid = make_item_ptr(block_id, slot_idx);
+    hdr->t_infomask &= (u16) ~(HEAP_HOT_UPDATED | HEAP_EMB_PASSED);
+}
 
-TxnId heapStore_delete_by_ctid(HeapStore* store, ItemPtr ctid)
+static TxnId heapStore_update_impl(HeapStore* store, TxnId xid, ItemPtr old_ctid,
+                                   HeapTuple* new_tuple, bool allow_hot)
+{
+    BlockSegment* seg;
+    u16 old_slot;
+    u8* old_tup = heapStore_resolve_ctid(store, old_ctid, LW_EXCLUSIVE, &seg, &old_slot);
+    if (!old_tup) return INVALID_TXN_ID;
+
+    TupleHdr old_hdr;
+    memcpy(&old_hdr, old_tup, sizeof(TupleHdr));
+    if (old_hdr.t_xmax != INVALID_TXN_ID)
+    {
+        if (heapStore_xid_status(store, old_hdr.t_xmax) != TXN_STATUS_ABORTED)
+        {
+            LWLockRelease(&seg->content_lock);
+            return INVALID_TXN_ID; /* superseded, deleted, or a concurrent writer is running */
+        }
+        heapStore_clear_aborted_xmax(&old_hdr, seg->block_id, old_slot);
+    }
+
+    TxnId txn_id = xid ? xid : rs_alloc_xid(store);
+
+    TupleHdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.t_xmin = txn_id;
+    hdr.t_xmax = INVALID_TXN_ID;
+    hdr.t_emb_ctid = new_tuple->hdr.t_emb_ctid;
+    hdr.null_bits = new_tuple->hdr.null_bits | heapStore_varlena_nulls(store, new_tuple->cols);
+    bool emb_shared = item_ptr_is_valid(hdr.t_emb_ctid) &&
+                      item_ptr_equal(hdr.t_emb_ctid, old_hdr.t_emb_ctid);
+    if (emb_shared) hdr.t_infomask |= HEAP_EMB_FROM_PREV;
+
+    /* HOT first: same page keeps the chain reachable from the root's index entry. */
+    ToastScratch sc;
+    const Datum* vals = heapStore_toast_values(store, hdr.null_bits, new_tuple->cols, &sc);
+    if (new_tuple->cols && !vals)
+    {
+        LWLockRelease(&seg->content_lock);
+        return INVALID_TXN_ID;
+    }
+    u32 page_no = heapStore_seg_page_no(store, seg);
+    ItemPtr new_ctid = INVALID_ITEM_PTR;
+    if (allow_hot)
+    {
+        hdr.t_infomask |= HEAP_ONLY_TUPLE;
+        new_ctid = heapStore_put_tuple_on_page(store, seg, page_no, &hdr, vals);
+        if (!item_ptr_is_valid(new_ctid)) hdr.t_infomask &= (u16)~HEAP_ONLY_TUPLE;
+    }
+    if (!item_ptr_is_valid(new_ctid)) new_ctid = heapStore_put_tuple(store, &hdr, vals, seg, page_no);
+    toastScratch_free(&sc);
+
+    /* Slot reuse may have compacted the old page: re-read the tuple position. */
+    old_tup = heapStore_page_get_tuple((u8*)segment_get_data(seg), old_slot);
+    old_hdr.t_xmax = txn_id;
+    old_hdr.t_ctid = new_ctid;
+    if (hdr.t_infomask & HEAP_ONLY_TUPLE) old_hdr.t_infomask |= HEAP_HOT_UPDATED;
+    if (emb_shared) old_hdr.t_infomask |= HEAP_EMB_PASSED;
+    memcpy(old_tup, &old_hdr, sizeof(TupleHdr));
+    heapStore_vm_clear(store, page_no);
+    LWLockRelease(&seg->content_lock);
+
+    new_tuple->hdr = hdr;
+    return txn_id;
+}
+
+TxnId heapStore_update_xid(HeapStore* store, TxnId xid, ItemPtr old_ctid, HeapTuple* new_tuple,
+                           bool allow_hot)
 {
-    u8* tup = heapStore_lookup_ctid(store, ctid);
+    if (xid || !store->txn_mgr) return heapStore_update_impl(store, xid, old_ctid, new_tuple, allow_hot);
+
+    xid = transactionManager_begin(store->txn_mgr);
+    if (!xid) return INVALID_TXN_ID;
+    TxnId r = heapStore_update_impl(store, xid, old_ctid, new_tuple, allow_hot);
+    if (r != INVALID_TXN_ID)
+        transactionManager_commit(store->txn_mgr, xid);
+    else
+        transactionManager_abort(store->txn_mgr, xid);
+    return r;
+}
+
+TxnId heapStore_update_by_ctid(HeapStore* store, ItemPtr old_ctid, HeapTuple* new_tuple)
+{
+    return heapStore_update_xid(store, INVALID_TXN_ID, old_ctid, new_tuple, true);
+}
+
+/* xid == 0: allocate from the local counter once the tuple is known live. */
+static TxnId heapStore_delete_impl(HeapStore* store, TxnId xid, ItemPtr ctid, ItemPtr* emb_ctid)
+{
+    BlockSegment* seg;
+    u16 slot_idx;
+    u8* tup = heapStore_resolve_ctid(store, ctid, LW_EXCLUSIVE, &seg, &slot_idx);
     if (!tup) return INVALID_TXN_ID;
 
     TupleHdr hdr;
     memcpy(&hdr, tup, sizeof(TupleHdr));
-    if (hdr.t_xmax != INVALID_TXN_ID) return INVALID_TXN_ID; /* already dead */
+    if (hdr.t_xmax != INVALID_TXN_ID)
+    {
+        if (heapStore_xid_status(store, hdr.t_xmax) != TXN_STATUS_ABORTED)
+        {
+            LWLockRelease(&seg->content_lock);
+            return INVALID_TXN_ID; /* already dead, or a concurrent deleter is running */
+        }
+        heapStore_clear_aborted_xmax(&hdr, seg->block_id, slot_idx);
+    }
 
-    TxnId txn_id = store->next_txn_id++;
+    TxnId txn_id = xid ? xid : rs_alloc_xid(store);
 
     /* Mutate TupleHdr in-place: t_xmax = deleter XID; t_ctid stays self-pointing. */
     hdr.t_xmax = txn_id;
     memcpy(tup, &hdr, sizeof(TupleHdr));
+    if (emb_ctid) *emb_ctid = hdr.t_emb_ctid;
 
+    heapStore_vm_clear(store, heapStore_seg_page_no(store, seg));
+    LWLockRelease(&seg->content_lock);
     return txn_id;
 }
 
+TxnId heapStore_delete_returning(HeapStore* store, TxnId xid, ItemPtr ctid, ItemPtr* emb_ctid)
+{
+    if (xid || !store->txn_mgr) return heapStore_delete_impl(store, xid, ctid, emb_ctid);
+
+    xid = transactionManager_begin(store->txn_mgr);
+    if (!xid) return INVALID_TXN_ID;
+    TxnId r = heapStore_delete_impl(store, xid, ctid, emb_ctid);
+    if (r != INVALID_TXN_ID)
+        transactionManager_commit(store->txn_mgr, xid);
+    else
+        transactionManager_abort(store->txn_mgr, xid);
+    return r;
+}
+
+TxnId heapStore_delete_by_ctid(HeapStore* store, ItemPtr ctid)
+{
+    return heapStore_delete_returning(store, INVALID_TXN_ID, ctid, NULL);
+}
+
+TxnId heapStore_delete_xid(HeapStore* store, TxnId xid, ItemPtr ctid)
+{
+    if (xid == INVALID_TXN_ID) return INVALID_TXN_ID;
+    return heapStore_delete_impl(store, xid, ctid, NULL);
+}
+
+/* Per-slot pruning decision in heapStore_vacuum_page. */
+enum
+{
+    PRUNE_UNUSED = 0, /* LP_UNUSED, nothing to do */
+    PRUNE_LIVE,       /* kept as is */
+    PRUNE_DEAD,       /* reclaimed: slot becomes LP_UNUSED */
+    PRUNE_REDIRECT,   /* dead HOT root with a live chain member: shrunk to a stub */
+};
+
+static inline TupleHdr heapStore_slot_hdr(u8* page, usize slot_idx)
+{
+    TupleHdr hdr;
+    memcpy(&hdr, heapStore_page_get_tuple(page, (u16)slot_idx), sizeof(TupleHdr));
+    return hdr;
+}
+
+/*
+ * Prune one page (PG heap_page_prune):
+ *   1. classify every tuple; a t_xmax left by an aborted writer is cleared;
+ *   2. walk HOT chains from their roots: a dead root whose chain still has a
+ *      live member is kept as a HEAP_REDIRECT stub to it, so index entries keyed
+ *      by the root ctid stay valid; a dead stub whose chain died is reclaimed;
+ *   3. LP_UNUSED every other dead slot, compact, refresh FSM, and mark the page
+ *      all-visible when every survivor is live and older than horizon.
+ * All-visible pages cannot hold dead tuples and are skipped.  seg (page
+ * page_no) is latched EXCLUSIVE.
+ */
+static u64 heapStore_vacuum_page(HeapStore* store, BlockSegment* seg, u32 page_no, TxnId horizon,
+                                 HeapVacuumCallback callback, void* arg)
+{
+    if (heapStore_vm_get(store, page_no) & VM_ALL_VISIBLE) return 0;
+
+    u8* page = (u8*)segment_get_data(seg);
+    usize n_slots = (*heapStore_pd_lower(page) - HS_BLOCK_HDR_SIZE) / HS_SLOT_SIZE;
+    u8 state[HS_MAX_SLOTS];
+    u16 redirect_to[HS_MAX_SLOTS];
+    bool all_visible = true;
+
+    /* 1. classify */
+    for (usize i = 0; i < n_slots; i++)
+    {
+        TupleSlotId* sl = &heapStore_slots(page)[i];
+        state[i] = PRUNE_UNUSED;
+        if (sl->lp_len == 0) continue; /* already LP_UNUSED */
+
+        TupleHdr hdr = heapStore_slot_hdr(page, i);
+        if (hdr.t_infomask & HEAP_REDIRECT)
+        {
+            state[i] = PRUNE_DEAD; /* re-evaluated from its chain in step 2 */
+            continue;
+        }
+        TxnStatus xmin_status = heapStore_xid_status(store, hdr.t_xmin);
+        if (hdr.t_xmax != INVALID_TXN_ID &&
+            heapStore_xid_status(store, hdr.t_xmax) == TXN_STATUS_ABORTED)
+        {
+            /* aborted deleter / updater: the tuple is live again */
+            heapStore_clear_aborted_xmax(&hdr, seg->block_id, (u16)i);
+            memcpy(page + sl->lp_off, &hdr, sizeof(TupleHdr));
+        }
+        bool dead = xmin_status == TXN_STATUS_ABORTED ||
+                    (hdr.t_xmax != INVALID_TXN_ID && hdr.t_xmax < horizon &&
+                     heapStore_xid_status(store, hdr.t_xmax) == TXN_STATUS_COMMITTED);
+        state[i] = dead ? PRUNE_DEAD : PRUNE_LIVE;
+        if (!dead && (hdr.t_xmax != INVALID_TXN_ID || hdr.t_xmin >= horizon ||
+                      xmin_status != TXN_STATUS_COMMITTED))
+            all_visible = false;
+    }
+
+    /* 2. HOT chains: find the first live member behind each dead root */
+    for (usize r = 0; r < n_slots; r++)
+    {
+        if (state[r] != PRUNE_DEAD) continue;
+        TupleHdr root = heapStore_slot_hdr(page, r);
+        if (root.t_infomask & HEAP_ONLY_TUPLE) continue;
+        if (!(root.t_infomask & (HEAP_HOT_UPDATED | HEAP_REDIRECT))) continue;
+
+        usize cur = item_ptr_slot(root.t_ctid);
+        for (usize hops = 0; hops < n_slots && cur < n_slots; hops++)
+        {
+            if (state[cur] == PRUNE_LIVE)
+            {
+                state[r] = PRUNE_REDIRECT;
+                redirect_to[r] = (u16)cur;
+                break;
+            }
+            if (state[cur] != PRUNE_DEAD) break;
+            TupleHdr member = heapStore_slot_hdr(page, cur);
+            if (!(member.t_infomask & HEAP_HOT_UPDATED)) break;
+            cur = item_ptr_slot(member.t_ctid);
+        }
+    }
+
+    /* 3. reclaim */
+    u64 pruned = 0;
+    bool changed = false;
+    for (usize i = 0; i < n_slots; i++)
+    {
+        if (state[i] != PRUNE_DEAD && state[i] != PRUNE_REDIRECT) continue;
+        TupleSlotId* sl = &heapStore_slots(page)[i];
+        TupleHdr hdr = heapStore_slot_hdr(page, i);
+        bool is_stub = (hdr.t_infomask & HEAP_REDIRECT) != 0;
+        changed = true;
+
+        if (state[i] == PRUNE_REDIRECT && is_stub)
+        {
+            hdr.t_ctid = make_item_ptr(seg->block_id, redirect_to[i]); /* retarget */
+            memcpy(page + sl->lp_off, &hdr, sizeof(TupleHdr));
+            continue;
+        }
+
+        if (callback)
+        {
+            TupleHdr cb = hdr;
+            bool keeps_index_entry = (hdr.t_infomask & HEAP_ONLY_TUPLE) || state[i] == PRUNE_REDIRECT;
+            cb.t_ctid = keeps_index_entry ? INVALID_ITEM_PTR : make_item_ptr(seg->block_id, (u16)i);
+            bool emb_shared = is_stub || (hdr.t_infomask & HEAP_EMB_PASSED) ||
+                              ((hdr.t_infomask & HEAP_EMB_FROM_PREV) &&
+                               heapStore_xid_status(store, hdr.t_xmin) == TXN_STATUS_ABORTED);
+            if (emb_shared) cb.t_emb_ctid = INVALID_ITEM_PTR;
+            callback(&cb, arg);
+        }
+        if (!is_stub)
+        {
+            heapStore_toast_release(store, page + sl->lp_off);
+            pruned++;
+        }
+
+        if (state[i] == PRUNE_REDIRECT)
+        {
+            hdr.t_infomask = (u16)((hdr.t_infomask & ~(HEAP_HOT_UPDATED | HEAP_EMB_PASSED)) |
+                                   HEAP_REDIRECT);
+            hdr.t_ctid = make_item_ptr(seg->block_id, redirect_to[i]);
+            hdr.t_emb_ctid = INVALID_ITEM_PTR;
+            memcpy(page + sl->lp_off, &hdr, sizeof(TupleHdr));
+            sl->lp_len = (u16)sizeof(TupleHdr);
+        }
+        else
+        {
+            sl->lp_off = 0;
+            sl->lp_len = 0;
+        }
+    }
+    if (changed)
+    {
+        heapStore_page_compact(page);
+        heapStore_fsm_update_page(store, page_no, page);
+    }
+    /* 64-bit xids never wrap, so there is nothing to freeze: all-visible
+     * implies all-frozen. */
+    if (all_visible) heapStore_vm_set(store, page_no, VM_ALL_VISIBLE | VM_ALL_FROZEN);
+    return pruned;
+}
+
+u64 heapStore_vacuum_pages(HeapStore* store, TxnId horizon, u32* next_page, u32 npages,
+                           HeapVacuumCallback callback, void* arg)
+{
+    if (store->txn_mgr)
+    {
+        TxnId oldest = transactionManager_oldest_xmin(store->txn_mgr);
+        if (oldest < horizon) horizon = oldest;
+    }
+    u64 removed = 0;
+    u32 page_no = *next_page;
+    u32 end = npages < HEAP_VACUUM_DONE - page_no ? page_no + npages : HEAP_VACUUM_DONE;
+    for (; page_no < end; page_no++)
+    {
+        BlockSegment* seg = heapStore_page_seg(store, page_no);
+        if (!seg)
+        {
+            *next_page = HEAP_VACUUM_DONE;
+            return removed;
+        }
+        LWLockAcquire(&seg->content_lock, LW_EXCLUSIVE);
+        removed += heapStore_vacuum_page(store, seg, page_no, horizon, callback, arg);
+        LWLockRelease(&seg->content_lock);
+    }
+    *next_page = page_no;
+    return removed;
+}
+
+u64 heapStore_vacuum(HeapStore* store, TxnId horizon, HeapVacuumCallback callback, void* arg)
+{
+    u64 removed = 0;
+    for (u32 page_no = 0; page_no != HEAP_VACUUM_DONE;)
+        removed += heapStore_vacuum_pages(store, horizon, &page_no, HEAP_VACUUM_DONE, callback, arg);
+    return removed;
+}
+
 void heapStoreIter_begin(HeapStoreIter* iter, HeapStore* store)
 {
-    LWLockAcquire(&store->lock, LW_SHARED);
+    heapStoreIter_begin_snapshot(iter, store, NULL);
+}
+
+void heapStoreIter_begin_snapshot(HeapStoreIter* iter, HeapStore* store, const Snapshot* snapshot)
+{
     iter->store = store;
+    iter->snapshot = snapshot;
     iter->curr_seg = segmentTree_get_root_segment(&store->tree);
     iter->slot_idx = 0;
+    iter->page_no = 0;
+    LWLockAcquire(&((BlockSegment*)iter->curr_seg)->content_lock, LW_SHARED);
+    iter->page_all_visible = (heapStore_vm_get(store, 0) & VM_ALL_VISIBLE) != 0;
 }
 
 const TupleHdr* heapStoreIter_next(HeapStoreIter* iter)
@@ -876,8 +1945,18 @@ const TupleHdr* heapStoreIter_next(HeapStoreIter* iter)
     {
         if ((usize)iter->slot_idx >= iter->curr_seg->count)
         {
-            iter->curr_seg = iter->curr_seg->next;
+            /* page boundary: drop this page's latch before taking the next so
+             * writers and vacuum proceed during long scans.  next is only set
+             * under this page's latch, and pages are never unlinked. */
+            SegmentBase* next = iter->curr_seg->next;
+            LWLockRelease(&((BlockSegment*)iter->curr_seg)->content_lock);
+            iter->curr_seg = next;
             iter->slot_idx = 0;
+            iter->page_no++;
+            if (!next) break;
+            LWLockAcquire(&((BlockSegment*)next)->content_lock, LW_SHARED);
+            iter->page_all_visible =
+                (heapStore_vm_get(iter->store, iter->page_no) & VM_ALL_VISIBLE) != 0;
             continue;
         }
 
@@ -888,8 +1967,12 @@ const TupleHdr* heapStoreIter_next(HeapStoreIter* iter)
         TupleSlotId* sl = &heapStore_slots(page)[slot];
         if (sl->lp_len == 0) continue; /* LP_UNUSED */
         const TupleHdr* hdr = (const TupleHdr*)heapStore_page_get_tuple(page, (u16)slot);
+        if (hdr->t_infomask & HEAP_REDIRECT) continue; /* pruned HOT root: no tuple data */
+        if (iter->snapshot && !iter->page_all_visible &&
+            !snapshot_tuple_visible(iter->snapshot, hdr->t_xmin, hdr->t_xmax))
+            continue;
         /* Expose tuple length and col_data pointer (PG lp_len style).
-         * col_data points directly into the page buffer — valid while LW_SHARED held. */
+         * col_data points directly into the page buffer — valid while the page latch is held. */
         iter->curr_tup_len = sl->lp_len;
         iter->curr_col_data = (const u8*)hdr + sizeof(TupleHdr);
         return hdr;
@@ -901,7 +1984,8 @@ void heapStoreIter_end(HeapStoreIter* iter)
 {
     if (iter->store)
     {
-        LWLockRelease(&iter->store->lock);
+        if (iter->curr_seg) LWLockRelease(&((BlockSegment*)iter->curr_seg)->content_lock);
+        iter->curr_seg = NULL;
         iter->store = NULL;
     }
 }
@@ -6,6 +6,12 @@
 #include "types.h"
 #include "vb_type.h"
 #include "lock.h"
+#include "freespace.h"
+#include "visibilitymap.h"
+#include "transaction.h"
+#include "toast.h"
+#include "memctx.h"
+#include "hash.h"
 
 typedef struct TableSchema TableSchema;
 
@@ -29,7 +35,7 @@ typedef struct DataChunk DataChunk;
 #define PD_HAS_FREE_LINES 0x0001u
 
 // Max tuple size in heap store
-#define HS_MAX_TUPLE_SIZE ((usize)(BLOCK_SIZE - HS_BLOCK_HDR_SIZE - HS_SLOT_SIZE))
+#define HS_MAX_TUPLE_SIZE ((usize)(BLOCK_DATA_SIZE - HS_BLOCK_HDR_SIZE - HS_SLOT_SIZE))
 
 typedef enum
 {
@@ -74,6 +80,7 @@ typedef struct
  *     JSONB:        VbJsonb* — vl_len_ bytes total (includes 4-byte header)
  *
  * null_bits (u64 in TupleHdr): bit i set → col i is NULL → Datum[i] undefined.
+ * Writers also treat a by-reference Datum of 0 as NULL and set its bit.
  * ============================================================ */
 
 typedef u64 Datum;  // 每个字段的数据载体
@@ -135,8 +142,16 @@ typedef struct
     TxnId t_xmax;      /*  8: deleting/updating transaction; 0 = alive        */
     ItemPtr t_emb_ctid;  /* 16: EmbeddingStore ctid (INVALID_ITEM_PTR if none)  */
     ItemPtr t_ctid;      /* 22: heap physical location or UPDATE forward ptr    */
+    u16 t_infomask;      /* 28: HEAP_* flags below (2 bytes padding follow)      */
     u64 null_bits;   /* 32: bit i set → user col i is NULL                  */
-} TupleHdr; /* 40 bytes: 8+8+4+6+2+2+1+1+8 = 40                  */
+} TupleHdr; /* 40 bytes: 8+8+6+6+2+2(pad)+8 = 40                  */
+
+/* t_infomask bits (subset of PG htup_details.h, plus embedding ownership) */
+#define HEAP_EMB_PASSED    0x0100u /* updated; the successor inherited t_emb_ctid            */
+#define HEAP_EMB_FROM_PREV 0x0200u /* t_emb_ctid inherited from the predecessor              */
+#define HEAP_REDIRECT      0x0400u /* pruned HOT root: header-only stub, t_ctid → live member */
+#define HEAP_HOT_UPDATED   0x4000u /* updated on the same page; t_ctid → heap-only successor */
+#define HEAP_ONLY_TUPLE    0x8000u /* reachable only via a HOT chain; no index entries       */
 
 typedef struct
 {
@@ -144,6 +159,96 @@ typedef struct
     u16 lp_len;  /* 2: length of the tuple data in bytes */
 } TupleSlotId;
 
+/* JSONB datum: [u32 vl_len_ (total bytes, header included)][binary body] */
+typedef struct VbJsonb
+{
+    u32 vl_len_;
+    u8 data[];
+} VbJsonb;
+
+/* ============================================================
+ * TupleDesc — per-schema deform plan (PG TupleDesc + attcacheoff).
+ *
+ * Columns are packed back to back without alignment and NULL columns take
+ * no bytes, so a column's offset is a constant only while every column in
+ * front of it is fixed-width and non-NULL.  attcacheoff[i] caches it for
+ * the fixed-width prefix (i <= nfixed; attcacheoff[nfixed] is where the
+ * prefix ends).  A tuple with no NULL ahead of a requested column reads it
+ * straight from its cached offset; otherwise decoding walks from the last
+ * cached offset before the first NULL, skipping unrequested columns
+ * without materializing them.
+ *
+ * TupleDesc_init also picks the deform routine for the schema: an
+ * all-fixed-width schema gets a walker with no varlena branches.
+ * ============================================================ */
+#define HEAP_MAX_COLS 64 /* one null bit per column in TupleHdr.null_bits */
+
+/* How deform materializes varlena (TEXT / JSONB) columns. */
+typedef enum
+{
+    VARLENA_COPY_MALLOC = 0, /* malloc'd copy per Datum; caller frees (row_tuple_free) */
+    VARLENA_BYREF = 1,       /* pointer into the page; valid only while the page is
+                              * locked (HeapTupleRef lifetime / until the next
+                              * heapStoreIter_next) */
+    VARLENA_COPY_ARENA = 2,  /* copy carved from a per-query MemoryContext; freed when the
+                              * context is reset or deleted, not per Datum */
+} VarlenaMode;
+
+typedef struct TupleDesc TupleDesc;
+typedef int (*TupleDeformFn)(const TupleDesc* desc, const u8* col_data, u64 null_bits, u64 want,
+                             Datum* out, VarlenaMode mode, MemoryContext* arena);
+
+struct TupleDesc
+{
+    u16 natts;
+    u16 nfixed;                             /* cols [0, nfixed) are fixed-width */
+    u8 atttype[HEAP_MAX_COLS];              /* TupleColType */
+    u8 attlen[HEAP_MAX_COLS];               /* byte width, 0 for varlena */
+    u16 attcacheoff[HEAP_MAX_COLS + 1];     /* valid for i <= nfixed */
+    TupleDeformFn deform;
+    const ToastStore* toast;                /* owning store's overflow pages, or NULL */
+};
+
+void TupleDesc_init(TupleDesc* desc, const TableSchema* schema);
+
+/** Bitmap of columns [0, ncols) for the want argument of the deform calls. */
+static inline u64 tupleDesc_cols_mask(usize ncols)
+{
+    return ncols >= HEAP_MAX_COLS ? ~(u64)0 : (((u64)1 << ncols) - 1);
+}
+
+/**
+ * Deform the columns whose bit is set in want into out[col] (indexed by
+ * column number; other out entries are left untouched).  Requested NULL
+ * columns read as 0; varlena columns are malloc'd copies the caller frees.
+ * Returns 0 on success, -1 on malloc failure (nothing left allocated).
+ */
+static inline int tupleDesc_deform(const TupleDesc* desc, const u8* col_data, u64 null_bits,
+                                   u64 want, Datum* out)
+{
+    return desc->deform(desc, col_data, null_bits, want & tupleDesc_cols_mask(desc->natts), out,
+                        VARLENA_COPY_MALLOC, NULL);
+}
+
+/** tupleDesc_deform with an explicit varlena mode (arena only for VARLENA_COPY_ARENA). */
+static inline int tupleDesc_deform_ex(const TupleDesc* desc, const u8* col_data, u64 null_bits,
+                                      u64 want, Datum* out, VarlenaMode mode, MemoryContext* arena)
+{
+    return desc->deform(desc, col_data, null_bits, want & tupleDesc_cols_mask(desc->natts), out,
+                        mode, arena);
+}
+
+/* True for a compressed or out-of-line varlena (only VARLENA_BYREF yields these). */
+static inline bool datum_is_toasted(Datum d)
+{
+    u32 w;
+    memcpy(&w, DatumGetPointer(d), 4);
+    return (w & VARLENA_TAG_MASK) != 0;
+}
+
+/** Free the malloc'd varlena Datums among cols (VARLENA_COPY_MALLOC results). */
+void tupleDesc_free_datums(const TupleDesc* desc, u64 cols, u64 null_bits, const Datum* out);
+
 typedef struct
 {
     TupleHdr hdr; /* MVCC header (written by row_store_*; read back by get) */
@@ -160,36 +265,75 @@ typedef struct EmbeddingStore EmbeddingStore;
 
 void EmbeddingStore_init(EmbeddingStore* store, i16 dimension);
 void EmbeddingStore_deinit(EmbeddingStore* store);
+/**
+ * Append n vectors and return their ctids in out_ctids (may be NULL).  Slots
+ * on free_list are reused first.  Fresh slots are reserved with one fetch_add
+ * on count and filled without holding store->lock, so concurrent appenders
+ * only meet on that counter; store->lock is taken briefly to pop free slots
+ * and to add segments.  The range becomes visible to slot scans once
+ * published (ranges publish in reservation order).  Caller must not hold
+ * store->lock.
+ */
+void embeddingStore_append_batch(EmbeddingStore* store, const VectorBase* vecs, usize n,
+                                 ItemPtr* out_ctids);
+/** Single-vector embeddingStore_append_batch. */
 ItemPtr embeddingStore_append_and_get_ctid(EmbeddingStore* store, VectorBase* vec);
+/**
+ * Pointer to the embedding at emb_ctid, NULL past the last segment.  Lock-free.
+ * A published slot is never overwritten in place (an update writes a new
+ * slot): its bytes only change after vacuum has released it — once no
+ * snapshot can see its owner — and an append refills it, so the pointer stays
+ * valid for as long as the reader can see the owning tuple.
+ */
 const f32* embedding_store_get_ptr_ctid(EmbeddingStore* store, ItemPtr emb_ctid);
 
 typedef struct
 {
     SegmentTree tree;              /* one SegmentTree of slotted-page BlockSegments */
-    TxnId next_txn_id;       /* MVCC transaction counter */
+    _Atomic TxnId next_txn_id; /* local xid counter, used when txn_mgr is NULL */
+    TransactionManager* txn_mgr; /* optional, not owned: commit log + snapshots.  NULL →
+                                  * every xid counts as committed (legacy auto-commit). */
     u32 page_count;
     BlockManager* block_manager;
-    BlockSegment* hint_free_seg; /* PG-style: first segment that may have LP_UNUSED
-                                  * slots (PD_HAS_FREE_LINES set on its page).
-                                  * NULL = no known free page.  Set by vacuum_row_store;
-                                  * consumed lazily by row_store_insert.
-                                  * Not serialized — rebuilt from pd_flags on load. */
+    hmap block_map;          /* block_id → BlockSegment*, O(1) ctid → page lookup */
+    FreeSpaceMap fsm;        /* per-page reusable space, indexed by page number (position
+                              * in tree.nodes).  Only pages with an LP_UNUSED slot carry a
+                              * non-zero category.  Vacuum refreshes a page's entry after
+                              * reclaiming slots.  Not serialized — loaded pages start with
+                              * no FSM space until vacuum visits them. */
+    VisibilityMap vm;        /* per-page all-visible / all-frozen bits, same indexing as
+                              * fsm.  Set by vacuum, cleared by insert / delete.  Not
+                              * serialized — every page starts not-all-visible. */
     const TableSchema* schema;
-    LWLock lock;  /* EXCLUSIVE=write/vacuum, SHARED=read*/
+    TupleDesc desc;          /* deform plan for schema, built by HeapStore_init */
+    ToastStore toast;        /* overflow pages for out-of-line TEXT / JSONB values */
+    bool toast_compression;  /* try inline compression before moving values out of
+                              * line (default on) */
+    LWLock lock;     /* structure latch: block_map, page_count, and growth of
+                      * tree.nodes (whose lookups are lock-free, epoch-protected).
+                      * Held only for a lookup or while linking a new page; tuple
+                      * data is guarded by each page's BlockSegment.content_lock */
+    LWLock map_lock; /* fsm and vm */
 } HeapStore;
 
 void HeapStore_init(HeapStore* store, const TableSchema* schema, BlockManager* bm);
 void HeapStore_deinit(HeapStore* store);
 
+/**
+ * Attach a transaction manager.  Must be called before the first write:
+ * xids already stamped by the local counter are unknown to its commit log.
+ */
+void heapStore_set_txn_manager(HeapStore* store, TransactionManager* mgr);
+
 /* ============================================================
  * HeapTupleRef — zero-copy in-page tuple view (PG buffer-pin style)
  *
- * Holds LW_SHARED on store->content_lock for the ref lifetime.
+ * Holds LW_SHARED on the page's content_lock for the ref lifetime.
  * hdr / col_data point directly into the page buffer.
  *
  * Lifecycle:
- *   row_store_acquire_ref() → use hdr / col_data / heap_deform_tuple()
- *   row_store_release_ref() → LW_SHARED released
+ *   heapStore_fetch_ref()   → use hdr / col_data / heap_deform_tuple()
+ *   heapStore_release_ref() → LW_SHARED released
  * ============================================================ */
 typedef struct
 {
@@ -197,13 +341,36 @@ typedef struct
     const u8* col_data;  /* hdr + sizeof(TupleHdr)     */
     const TableSchema* schema;
     HeapStore* store;
+    BlockSegment* page;  /* latched page (heapStore_fetch_ref), NULL for a caller-built ref */
 } HeapTupleRef;
 
+/** Deform the first ncols columns (uses ref->store->desc when store is set). */
 int heapStore_deform_tuple(const HeapTupleRef* ref, Datum* out, usize ncols);
 
+/** Deform only the columns in the want bitmap into out[col]; see tupleDesc_deform. */
+int heapStore_deform_cols(const HeapTupleRef* ref, u64 want, Datum* out);
+
+/** Zero-copy: varlena Datums point into the page and die with the ref's lock. */
+int heapStore_deform_cols_byref(const HeapTupleRef* ref, u64 want, Datum* out);
+
+/** Varlena Datums are copied into arena (per-query lifetime), not malloc'd. */
+int heapStore_deform_cols_arena(const HeapTupleRef* ref, u64 want, Datum* out, MemoryContext* arena);
+
+/**
+ * Expand a zero-copy varlena Datum that datum_is_toasted() into a plain one,
+ * allocated from arena (or malloc'd when arena is NULL).  Plain Datums are
+ * returned unchanged.  0 on allocation failure or a damaged value.  Caller
+ * keeps the page the Datum points into latched.
+ */
+Datum heapStore_detoast(const HeapStore* store, Datum d, MemoryContext* arena);
+
 /**
  * Insert a new tuple.
  *
+ * xid == 0 auto-commits: with a txn_mgr a one-statement transaction is
+ * begun and committed around the write.  Update and delete do the same; all
+ * three fail (INVALID_ITEM_PTR / INVALID_TXN_ID) if no xid can be begun.
+ *
  * Caller must fill: tuple->cols, tuple->ncols (= schema->ncols), tuple->hdr.null_bits.
  * row_store_insert fills hdr.{t_xmin,t_xmax,t_ctid} (t_emb_ctid set by table_am layer).
  *
@@ -223,6 +390,27 @@ ItemPtr heapStore_insert(HeapStore* store, TxnId xid, ItemPtr emb_ctid, const Da
 int heapStore_get_by_ctid(HeapStore* store, const TableSchema* schema, ItemPtr ctid,
                           HeapTuple* out);
 
+/**
+ * Zero-copy variant: point ref at the tuple stored at ctid (HEAP_REDIRECT
+ * stubs followed), regardless of MVCC status.  No store-wide lock is taken:
+ * only the tuple's page stays latched SHARED until heapStore_release_ref, so
+ * the caller must not write to that page in between (the write would wait on
+ * its own latch).  Returns 0, or -1 (nothing latched) if the ctid is invalid
+ * or the slot unused.
+ */
+int heapStore_fetch_ref(HeapStore* store, ItemPtr ctid, HeapTupleRef* ref);
+void heapStore_release_ref(HeapTupleRef* ref);
+
+/**
+ * Index-scan fetch: like heapStore_fetch_ref, but follow the same-page HOT
+ * chain from ctid and point ref at the member visible to snap (NULL snap: the
+ * member not yet deleted or superseded).  out_ctid (optional) receives that
+ * member's ctid.  Returns 0 with the page latched SHARED, or -1 (nothing
+ * latched) if no chain member is visible.
+ */
+int heapStore_fetch_visible(HeapStore* store, ItemPtr ctid, const Snapshot* snap,
+                            HeapTupleRef* ref, ItemPtr* out_ctid);
+
 /**
  * MVCC delete: mark the current version as deleted.
  *
@@ -231,18 +419,56 @@ int heapStore_get_by_ctid(HeapStore* store, const TableSchema* schema, ItemPtr c
  * Returns the txn_id used on success, INVALID_TXN_ID if ctid is not found or already dead.
  */
 TxnId heapStore_delete_by_ctid(HeapStore* store, ItemPtr ctid);
+
+/**
+ * Delete on behalf of running transaction xid (txn_mgr required for the
+ * conflict check).  A t_xmax left by an aborted deleter is overwritten; a
+ * committed or still-running deleter makes this fail with INVALID_TXN_ID.
+ */
+TxnId heapStore_delete_xid(HeapStore* store, TxnId xid, ItemPtr ctid);
+
+/**
+ * Delete (xid == 0 auto-commits) and report the deleted version's t_emb_ctid
+ * in *emb_ctid (may be NULL), read under the same page latch as the delete.
+ */
+TxnId heapStore_delete_returning(HeapStore* store, TxnId xid, ItemPtr ctid, ItemPtr* emb_ctid);
 /**
- * MVCC update: append a new version and mark the old one superseded.
+ * MVCC update: write a new version and mark the old one superseded.
  *
  * OLD tuple: t_xmax=txn, t_ctid=new_location (forward pointer).
  * NEW tuple: t_xmin=txn, t_xmax=INVALID_TXN_ID, t_ctid=self.
  *
- * Caller fills: new_tuple->cols, new_tuple->ncols, new_tuple->hdr.null_bits.
- * After return, new_tuple->hdr.t_ctid holds the new physical ctid.
+ * HOT (PG heap-only tuple): when the new version fits on the old version's
+ * page it is placed there, the old one gets HEAP_HOT_UPDATED and the new one
+ * HEAP_ONLY_TUPLE.  Index entries keyed by the chain's root ctid stay valid —
+ * ctid lookups follow the chain's redirect once vacuum prunes the root — so
+ * callers need not touch indexes.  Otherwise the new version goes wherever
+ * heapStore_insert would put it and needs index entries of its own.
+ *
+ * When new_tuple->hdr.t_emb_ctid equals the old version's, the embedding slot
+ * is shared and passes to the new version (vacuum frees it only once).
+ *
+ * Caller fills: new_tuple->cols, new_tuple->ncols, new_tuple->hdr.null_bits,
+ * new_tuple->hdr.t_emb_ctid.  After return, new_tuple->hdr holds the new
+ * version's header (t_ctid = new physical ctid, t_infomask & HEAP_ONLY_TUPLE
+ * tells whether the update was HOT).
  * Returns the txn_id used on success, INVALID_TXN_ID if old_ctid is not found or dead.
  */
 TxnId heapStore_update_by_ctid(HeapStore* store, ItemPtr old_ctid, HeapTuple* new_tuple);
 
+/**
+ * heapStore_update_by_ctid with an explicit transaction (xid == 0 auto-commits,
+ * as in heapStore_insert).  allow_hot = false forces a non-HOT update, e.g.
+ * when an indexed value (the embedding) changes.  The old version's page is
+ * latched EXCLUSIVE for the whole update, so concurrent writers of the same row
+ * serialize on it and the loser sees t_xmax set.
+ */
+TxnId heapStore_update_xid(HeapStore* store, TxnId xid, ItemPtr old_ctid, HeapTuple* new_tuple,
+                           bool allow_hot);
+
+/** Free the cols array (and varlena values) filled by heapStore_get_by_ctid. */
+void row_tuple_free(HeapTuple* out, const TableSchema* schema);
+
 typedef struct
 {
     HeapStore* store;
@@ -250,10 +476,21 @@ typedef struct
     u32 slot_idx;
     u16 curr_tup_len;
     const TupleHdr* hdr;
-    const u8* curr_col_data; /* points directly into page buffer (valid while lock held) */
+    const u8* curr_col_data; /* points directly into page buffer (valid while latched) */
+    const Snapshot* snapshot; /* NULL: every tuple.  Set: only tuples visible to
+                               * snapshot.  Either way only curr_seg is latched
+                               * (SHARED), and the latch moves page by page so
+                               * writers and vacuum proceed during long scans.
+                               * Pointers stay valid until the next
+                               * heapStoreIter_next / _end call.  Do not write to
+                               * the store while iterating. */
+    u32 page_no;             /* page number of curr_seg */
+    bool page_all_visible;   /* VM_ALL_VISIBLE for curr_seg: every tuple on it is live and
+                              * visible to all — callers may skip t_xmin / t_xmax checks */
 } HeapStoreIter;
 
 void heapStoreIter_begin(HeapStoreIter* iter, HeapStore* store);
+void heapStoreIter_begin_snapshot(HeapStoreIter* iter, HeapStore* store, const Snapshot* snapshot);
 const TupleHdr* heapStoreIter_next(HeapStoreIter* iter);
 void heapStoreIter_end(HeapStoreIter* iter);
 
@@ -269,6 +506,15 @@ static inline ItemPtr make_item_ptr(block_id_t block_id, u16 slot_idx)
                      .ip_posid = (u16)(slot_idx + 1)};
 }
 
+/**
+ * Physical ctid of the tuple last returned by heapStoreIter_next.  Unlike
+ * hdr->t_ctid this never follows an update chain forward.
+ */
+static inline ItemPtr heapStoreIter_ctid(const HeapStoreIter* iter)
+{
+    return make_item_ptr(((const BlockSegment*)iter->curr_seg)->block_id, (u16)(iter->slot_idx - 1));
+}
+
 /**
  * Return the disk block_id encoded in an ItemPtr.
  * Note: only the lower 32 bits of block_id_t are stored in ip_blkid.
@@ -295,8 +541,78 @@ static inline bool item_ptr_is_valid(ItemPtr p)
     return p.ip_blkid_hi != UINT16_MAX;
 }
 
+static inline bool item_ptr_equal(ItemPtr a, ItemPtr b)
+{
+    return a.ip_blkid_hi == b.ip_blkid_hi && a.ip_blkid_lo == b.ip_blkid_lo &&
+           a.ip_posid == b.ip_posid;
+}
+
+/** Pack an ItemPtr into a u64 key: (block_id << 16) | ip_posid. */
+static inline u64 item_ptr_pack(ItemPtr p)
+{
+    return ((u64)item_ptr_block_id(p) << 16) | (u64)p.ip_posid;
+}
+
+/** Inverse of item_ptr_pack. */
+static inline ItemPtr item_ptr_unpack(u64 packed)
+{
+    u32 blk = (u32)(packed >> 16);
+    return (ItemPtr){.ip_blkid_hi = (u16)(blk >> 16),
+                     .ip_blkid_lo = (u16)(blk & 0xFFFFu),
+                     .ip_posid = (u16)(packed & 0xFFFFu)};
+}
+
 u64 heapStore_slot_count(HeapStore* store);
 
+/* ============================================================
+ * VACUUM — reclaim dead tuples
+ * ============================================================ */
+
+/** Horizon meaning "no snapshot is active": every deleted tuple is reclaimable. */
+#define VACUUM_HORIZON_ALL ((TxnId)UINT64_MAX)
+
+/**
+ * Called for each dead tuple just before its slot is reclaimed (page latch held,
+ * so it must not call back into the store).
+ * hdr is a copy normalised for cleanup:
+ *   t_ctid     — the index key to drop, INVALID_ITEM_PTR for heap-only tuples and
+ *                for HOT roots kept as redirects (their index entries stay valid);
+ *   t_emb_ctid — the embedding slot to free, INVALID_ITEM_PTR when the slot is
+ *                shared with another version.
+ */
+typedef void (*HeapVacuumCallback)(const TupleHdr* hdr, void* arg);
+
+/**
+ * Reclaim tuples whose deleter precedes `horizon` (t_xmax != 0 && t_xmax < horizon),
+ * i.e. versions no snapshot can still see.
+ *
+ * With a txn_mgr the horizon is further clamped to transactionManager_oldest_xmin(),
+ * only committed deleters count, tuples of aborted inserters are reclaimed and
+ * t_xmax of aborted deleters is reset so the tuple is plainly live again.
+ *
+ * Works one page at a time under that page's LW_EXCLUSIVE latch, so readers
+ * and writers of other pages are never blocked and those of this page interleave
+ * between pages instead of waiting for the whole table.  Dead slots become LP_UNUSED (ctids of live tuples never move), the page
+ * is compacted and its free space map entry refreshed.  A dead HOT chain root
+ * whose chain still has a live member is shrunk to a header-only HEAP_REDIRECT
+ * stub pointing at that member, so its ctid keeps resolving.
+ *
+ * Caller must not hold any page latch.  Returns the number of tuples reclaimed.
+ */
+u64 heapStore_vacuum(HeapStore* store, TxnId horizon, HeapVacuumCallback callback, void* arg);
+
+#define HEAP_VACUUM_DONE UINT32_MAX
+
+/**
+ * Batched heapStore_vacuum: process at most npages pages starting at
+ * *next_page and advance it, setting HEAP_VACUUM_DONE once the last page is
+ * done.  Lets a caller hold its own lock (e.g. over the indexes the callback
+ * edits) per batch instead of across the whole heap.  Returns the number of
+ * tuples reclaimed in this batch.
+ */
+u64 heapStore_vacuum_pages(HeapStore* store, TxnId horizon, u32* next_page, u32 npages,
+                           HeapVacuumCallback callback, void* arg);
+
 /* ============================================================
  * embedding store
  * ============================================================*/
@@ -305,16 +621,61 @@ u64 heapStore_slot_count(HeapStore* store);
  * Must match the layout in tmp/src/embedding_store.h for ABI compatibility. */
 struct EmbeddingStore
 {
-    SegmentTree tree;
+    SegmentTree tree;         /* segments of vecs_per_blk slots each; slot i lives in
+                               * segment i / vecs_per_blk.  Segment base.count is not
+                               * maintained — published bounds the written slots. */
     i16 dimension;
-    usize count;
+    _Atomic usize count;      /* slots reserved by appenders (fetch_add) */
+    _Atomic usize published;  /* slots [0, published) are written (release / acquire) */
     usize elem_size;
-    usize vecs_per_blk;       /* = BLOCK_SIZE / elem_size  (computed once at init)*/
+    usize vecs_per_blk;       /* = BLOCK_DATA_SIZE / elem_size  (computed once at init)*/
     Vector free_list;
-    ItemPtr last_ctid;
-    LWLock lock;   /* EXCLUSIVE=write, SHARED=read*/
+    LWLock lock;   /* EXCLUSIVE: add segments, free_list, reverse map;
+                    * SHARED: read them.  Fresh appends copy without it, and
+                    * segment lookups never take it (tree.nodes is epoch-protected). */
+    Vector back_ctids; /* vector<ItemPtr> — per slot (row order): heap version owning it */
+    Vector live_bits;  /* vector<u64> — per slot: owner not deleted */
 };
 
+/*
+ * Reverse map emb slot → heap ctid.  The owning table keeps it current:
+ * insert / update record the newest version owning a slot, delete clears its
+ * live bit, vacuum releases the slot to free_list.  Live bits are set and
+ * cleared eagerly (an aborted delete is not undone), so MVCC readers must
+ * still check the heap; without a TransactionManager they are exact.
+ * Callers hold store->lock (EXCLUSIVE to modify).
+ */
+void embeddingStore_set_owner(EmbeddingStore* store, ItemPtr emb_ctid, ItemPtr heap_ctid);
+void embeddingStore_mark_dead(EmbeddingStore* store, ItemPtr emb_ctid);
+/** Clear the slot's back pointer and return it to free_list for reuse. */
+void embeddingStore_release(EmbeddingStore* store, ItemPtr emb_ctid);
+
+/** Number of slots readable by a scan over slot order. */
+static inline usize embeddingStore_published(EmbeddingStore* store)
+{
+    return atomic_load_explicit(&store->published, memory_order_acquire);
+}
+
+static inline usize embeddingStore_slot_index(const EmbeddingStore* store, ItemPtr emb_ctid)
+{
+    return (usize)item_ptr_block_id(emb_ctid) * store->vecs_per_blk + item_ptr_slot(emb_ctid);
+}
+
+static inline bool embeddingStore_is_live(const EmbeddingStore* store, ItemPtr emb_ctid)
+{
+    usize i = embeddingStore_slot_index(store, emb_ctid);
+    if (i / 64 >= vector_size(&store->live_bits)) return false;
+    return (VECTOR_AT(&store->live_bits, i / 64, u64) >> (i % 64)) & 1u;
+}
+
+/** Heap ctid of the slot's owner; INVALID_ITEM_PTR if none was recorded. */
+static inline ItemPtr embeddingStore_heap_ctid(const EmbeddingStore* store, ItemPtr emb_ctid)
+{
+    usize i = embeddingStore_slot_index(store, emb_ctid);
+    if (i >= vector_size(&store->back_ctids)) return INVALID_ITEM_PTR;
+    return VECTOR_AT(&store->back_ctids, i, ItemPtr);
+}
+
 /* ============================================================
  * column store
  * ============================================================*/
@@ -14,6 +14,10 @@ static int heapTable_scan(TableAmRoutine* am, TamScanCtx* ctx, TableQueryResult*
                           usize max_results);
 static void heapTable_write_blocks(TableAmRoutine* am, BlockManager* bm, MetaBlockWriter* w);
 static void heapTable_load_blocks(TableAmRoutine* am, BlockManager* bm, MetaBlockReader* r);
+static u64 heapTable_vacuum(TableAmRoutine* am, TxnId horizon);
+static int heapTable_update(TableAmRoutine* am, VectorBase* v, const Datum* payloads,
+                            TamUpdateCtx* ctx);
+static int heapTable_delete(TableAmRoutine* am, TamDeleteCtx* ctx);
 static void heapTable_destory(TableAmRoutine* am);
 
 static void embeddingHeapTable_append(TableAmRoutine* am, VectorBase* v, TupleVal* payloads,
@@ -26,14 +30,21 @@ static void embeddingHeapTable_write_blocks(TableAmRoutine* am, BlockManager* bm
                                             MetaBlockWriter* w);
 static void embeddingHeapTable_load_blocks(TableAmRoutine* am, BlockManager* bm,
                                            MetaBlockReader* r);
+static u64 embeddingHeapTable_vacuum(TableAmRoutine* am, TxnId horizon);
+static int embeddingHeapTable_update(TableAmRoutine* am, VectorBase* v, const Datum* payloads,
+                                     TamUpdateCtx* ctx);
+static int embeddingHeapTable_delete(TableAmRoutine* am, TamDeleteCtx* ctx);
 static void embeddingHeapTable_destory(TableAmRoutine* am);
 
 static const TableAmRoutineVTable heap_am_routine = {
     .append = heapTable_append,
     .append_chunk = heapTable_append_chunk,
     .scan = heapTable_scan,
+    .update = heapTable_update,
+    .delete = heapTable_delete,
     .write_blocks = heapTable_write_blocks,
     .load_blocks = heapTable_load_blocks,
+    .vacuum = heapTable_vacuum,
     .destroy = heapTable_destory,
 };
 
@@ -41,16 +52,23 @@ static const TableAmRoutineVTable embedding_heap_am_routine = {
     .append = embeddingHeapTable_append,
     .append_chunk = embeddingHeapTable_append_chunk,
     .scan = embeddingHeapTable_scan_chunk,
+    .update = embeddingHeapTable_update,
+    .delete = embeddingHeapTable_delete,
     .write_blocks = embeddingHeapTable_write_blocks,
     .load_blocks = embeddingHeapTable_load_blocks,
+    .vacuum = embeddingHeapTable_vacuum,
     .destroy = embeddingHeapTable_destory,
 };
 
+/* DataTable.relid 分配器；0 保留不用 */
+static _Atomic u64 datatable_next_relid = 1;
+
 /* 创建旧版 DataTable 对象；当前只分配壳结构，具体存储初始化已迁移到新路径。 */
 DataTable* Datatable_create(StorageManager* manager, char* schema_name, char* table_name,
                             usize column_count, TypeID* column_types)
 {
     DataTable* table = malloc(sizeof(DataTable));
+    table->relid = atomic_fetch_add(&datatable_next_relid, 1);
     (void)manager;
     (void)schema_name;
     (void)table_name;
@@ -193,8 +211,8 @@ static void build_heap_tuple(const HeapTable* heap, ItemPtr emb_ctid, const Tupl
     out->hdr.t_emb_ctid = emb_ctid;
 }
 
-/* 执行一次 heap 侧真实插入，必要时从批量上下文读取 emb_ctid 和 xid。 */
-static void heapTable_append_impl(TableAmRoutine* am, TamInsertCtx* ctx, VectorBase* v,
+/* 执行一次 heap 侧真实插入，必要时从批量上下文读取 emb_ctid 和 xid；返回新元组的 ctid。 */
+static ItemPtr heapTable_append_impl(TableAmRoutine* am, TamInsertCtx* ctx, VectorBase* v,
                                   const Datum* val, usize n_payloads)
 {
     HeapTable* ht = (HeapTable*)am;
@@ -203,7 +221,9 @@ static void heapTable_append_impl(TableAmRoutine* am, TamInsertCtx* ctx, VectorB
         (ctx && ctx->emb_ctids) ? ctx->emb_ctids[ctx->current_index] : INVALID_ITEM_PTR;
     (void)v;
     (void)n_payloads;
-    heapStore_insert(&ht->store, xid, emb_ctid, val, 0);
+    ItemPtr heap_ctid = heapStore_insert(&ht->store, xid, emb_ctid, val, 0);
+    if (ctx && ctx->heap_ctids) ctx->heap_ctids[ctx->current_index] = heap_ctid;
+    return heap_ctid;
 }
 
 /* 处理单行 heap 追加；当前路径不携带 embedding 位置。 */
@@ -211,26 +231,21 @@ static void heapTable_append(TableAmRoutine* am, VectorBase* v, TupleVal* payloa
                              usize n_payloads)
 {
     HeapTable* ht = (HeapTable*)am;
-    LWLockAcquire(&ht->store.lock, LW_EXCLUSIVE);
     heapStore_insert(&ht->store, 0, INVALID_ITEM_PTR, NULL, 0);
-    LWLockRelease(&ht->store.lock);
     (void)v;
     (void)payloads;
     (void)n_payloads;
 }
 
-/* 批量把 DataChunk 中的行写入 heap 存储。 */
+/* 批量把 DataChunk 中的行写入 heap 存储；页闩锁由 heapStore_insert 逐行获取。 */
 static void heapTable_append_chunk(TableAmRoutine* am, const DataChunk* chunk, TamInsertCtx* ctx)
 {
-    HeapTable* ht = (HeapTable*)am;
-    LWLockAcquire(&ht->store.lock, LW_EXCLUSIVE);
     for (usize i = 0; i < chunk->count; i++)
     {
         ctx->current_index = i;
         heapTable_append_impl(am, ctx, &chunk->arrays[i],
                               chunk->payloads ? chunk->payloads[i] : NULL, chunk->n_payloads);
     }
-    LWLockRelease(&ht->store.lock);
 }
 
 /* heap 扫描接口的旧实现占位；当前未完成具体逻辑。 */
@@ -261,12 +276,43 @@ static void heapTable_load_blocks(TableAmRoutine* am, BlockManager* bm, MetaBloc
     (void)r;
 }
 
+/* 回收 heap 中对所有快照都不可见的死元组。 */
+static u64 heapTable_vacuum(TableAmRoutine* am, TxnId horizon)
+{
+    HeapTable* ht = (HeapTable*)am;
+    return heapStore_vacuum(&ht->store, horizon, NULL, NULL);
+}
+
+/* 更新一行 heap 元组；同页放得下时走 HOT。v 对纯 heap 表无意义。 */
+static int heapTable_update(TableAmRoutine* am, VectorBase* v, const Datum* payloads,
+                            TamUpdateCtx* ctx)
+{
+    HeapTable* ht = (HeapTable*)am;
+    (void)v;
+    HeapTuple nt = {.cols = (Datum*)payloads, .ncols = ht->schema.ncols};
+    nt.hdr.null_bits = ctx->null_bits;
+    nt.hdr.t_emb_ctid = INVALID_ITEM_PTR;
+    TxnId xid = heapStore_update_xid(&ht->store, ctx->xid, ctx->heap_ctid, &nt, true);
+    if (xid == INVALID_TXN_ID) return -1;
+    ctx->new_heap_ctid = nt.hdr.t_ctid;
+    return 0;
+}
+
+/* 删除一行 heap 元组：只设置 t_xmax，空间由 vacuum 回收。ctx->xid 为 0 时自动提交。 */
+static int heapTable_delete(TableAmRoutine* am, TamDeleteCtx* ctx)
+{
+    HeapTable* ht = (HeapTable*)am;
+    TxnId xid = heapStore_delete_returning(&ht->store, ctx->xid, ctx->heap_ctid, NULL);
+    return xid == INVALID_TXN_ID ? -1 : 0;
+}
+
 /* 初始化 HeapTable，包括底层 HeapStore 和对应的 vtable。 */
 void HeapTable_init(HeapTable* table, const TableSchema* schema, BlockManager* bm)
 {
-    HeapStore_init(&table->store, schema, bm);
     table->schema = *schema;
+    HeapStore_init(&table->store, &table->schema, bm);
     table->base.vtable = (TableAmRoutineVTable*)&heap_am_routine;
+    table->base.type = TABLE_AM_ROUTINE_ROW;
 }
 
 /* 销毁 HeapTable 的 vtable 入口；当前不额外释放资源。 */
@@ -286,8 +332,10 @@ void EmbeddingHeapTable_deinit(EmbeddingHeapTable* table)
 {
     EmbeddingStore_deinit(&table->embed_store);
     HeapStore_deinit(&table->heap_table.store);
+    vector_deinit(&table->indexes);
     LWLockDestroy(&table->embed_store.lock);
     LWLockDestroy(&table->heap_table.store.lock);
+    LWLockDestroy(&table->index_lock);
 }
 
 /* 初始化向量+heap 组合表，使其同时具备向量存储和 heap 存储能力。 */
@@ -296,7 +344,150 @@ void EmbeddingHeapTable_init(EmbeddingHeapTable* table, i16 dimension, const Tab
 {
     HeapTable_init(&table->heap_table, schema, bm);
     EmbeddingStore_init(&table->embed_store, dimension);
+    Vector_init(&table->indexes, sizeof(VectorIndex*), 0);
+    LWLockInit(&table->index_lock, "EmbeddingHeapTable.index_lock");
     table->base.vtable = (TableAmRoutineVTable*)&embedding_heap_am_routine;
+    table->base.type = TABLE_AM_ROUTINE_EMBEDDING;
+}
+
+/* 挂载向量索引（不转移所有权），vacuum 时同步删除死元组对应的索引项。 */
+void embeddingHeapTable_attach_index(EmbeddingHeapTable* table, VectorIndex* index)
+{
+    vector_push_back(&table->indexes, &index);
+}
+
+/* vacuum 回调：在 heap 页闩锁下删除索引项，并收集 emb ctid（归还槽位留到闩锁之外）。 */
+typedef struct
+{
+    EmbeddingHeapTable* et;
+    Vector emb_ctids; /* vector<ItemPtr> */
+} EmbVacuumDead;
+
+static void embeddingHeapTable_vacuum_collect(const TupleHdr* hdr, void* arg)
+{
+    EmbVacuumDead* dead = (EmbVacuumDead*)arg;
+    /* t_ctid 无效：heap-only 元组或保留为 redirect 的 HOT 根，索引项仍然有效 */
+    if (item_ptr_is_valid(hdr->t_ctid))
+    {
+        VECTOR_FOREACH(&dead->et->indexes, idx)
+        {
+            VCALL(*(VectorIndex**)idx, remove, item_ptr_pack(hdr->t_ctid));
+        }
+    }
+    if (item_ptr_is_valid(hdr->t_emb_ctid)) vector_push_back(&dead->emb_ctids, &hdr->t_emb_ctid);
+}
+
+/* vacuum 每批处理的 heap 页数：index_lock 只在一批内持有，批间让出给索引搜索 */
+#define VACUUM_INDEX_BATCH_PAGES 8
+
+/*
+ * 组合表 vacuum：
+ *   1. heap 逐页回收死元组（每页短暂持有该页排他闩锁，其他页的读写不受影响），
+ *      回调在槽位可被复用之前从所有挂载的向量索引中删除对应的 heap ctid；
+ *   2. 死元组的 emb 槽位清除反向指针并归还 EmbeddingStore.free_list，供后续插入复用。
+ * 每批 VACUUM_INDEX_BATCH_PAGES 页持有一次 index_lock 排他锁：并发插入/更新即使复用了
+ * 本批刚释放的 heap ctid，也要等这一批结束才能登记索引，此时旧索引项已删除，不会被
+ * vacuum 误删新行的索引项；批与批之间索引搜索可以继续。
+ * 加锁顺序 index_lock → 页闩锁，与带过滤的索引搜索一致。
+ * 第 2 步在 heap 页闩锁之外进行：元组已不可见，不会再有扫描通过它访问 emb 槽位。
+ */
+static u64 embeddingHeapTable_vacuum(TableAmRoutine* am, TxnId horizon)
+{
+    EmbeddingHeapTable* et = (EmbeddingHeapTable*)am;
+    EmbVacuumDead dead = {.et = et};
+    Vector_init(&dead.emb_ctids, sizeof(ItemPtr), 0);
+
+    u64 removed = 0;
+    for (u32 page_no = 0; page_no != HEAP_VACUUM_DONE;)
+    {
+        LWLockAcquire(&et->index_lock, LW_EXCLUSIVE);
+        removed += heapStore_vacuum_pages(&et->heap_table.store, horizon, &page_no,
+                                          VACUUM_INDEX_BATCH_PAGES,
+                                          embeddingHeapTable_vacuum_collect, &dead);
+        LWLockRelease(&et->index_lock);
+    }
+
+    if (vector_size(&dead.emb_ctids) > 0)
+    {
+        LWLockAcquire(&et->embed_store.lock, LW_EXCLUSIVE);
+        VECTOR_FOREACH(&dead.emb_ctids, ctid)
+        {
+            embeddingStore_release(&et->embed_store, *(ItemPtr*)ctid);
+        }
+        LWLockRelease(&et->embed_store.lock);
+    }
+
+    vector_deinit(&dead.emb_ctids);
+    return removed;
+}
+
+/* 在所有挂载的索引中登记 heap_ctid → 向量；replace 时先删除旧索引项。 */
+static void embeddingHeapTable_index_put(EmbeddingHeapTable* et, ItemPtr heap_ctid,
+                                         ItemPtr emb_ctid, const f32* vec, bool replace)
+{
+    LWLockAcquire(&et->index_lock, LW_EXCLUSIVE);
+    VECTOR_FOREACH(&et->indexes, idx)
+    {
+        VectorIndex* index = *(VectorIndex**)idx;
+        if (replace) VCALL(index, remove, item_ptr_pack(heap_ctid));
+        VCALL(index, insert, item_ptr_pack(heap_ctid), emb_ctid, vec);
+    }
+    LWLockRelease(&et->index_lock);
+}
+
+/*
+ * 组合表更新：
+ *   1. 仅 payload 变化（v == NULL）：新版本继承 emb 槽位，优先 HOT 同页更新，索引不动；
+ *   2. 向量变化：新向量写入新的 emb 槽位，非 HOT 更新 heap（索引列变了），新版本登记索引。
+ *      已发布的槽位从不原地覆盖：扫描在页闩锁之外仍可能拿着旧向量的指针，旧槽位随旧版本
+ *      一起由 vacuum 回收。
+ * 同一行的并发写由 heapStore_update_xid 在页闩锁下检查 t_xmax 裁决。
+ */
+static int embeddingHeapTable_update(TableAmRoutine* am, VectorBase* v, const Datum* payloads,
+                                     TamUpdateCtx* ctx)
+{
+    EmbeddingHeapTable* et = (EmbeddingHeapTable*)am;
+    HeapStore* hs = &et->heap_table.store;
+    const TableSchema* schema = &et->heap_table.schema;
+    HeapTuple old;
+    if (heapStore_get_by_ctid(hs, schema, ctx->heap_ctid, &old) != 0) return -1;
+
+    int rc = 0;
+    ItemPtr emb_ctid = old.hdr.t_emb_ctid;
+    if (v) emb_ctid = embeddingStore_append_and_get_ctid(&et->embed_store, v);
+    HeapTuple nt = {.cols = payloads ? (Datum*)payloads : old.cols, .ncols = schema->ncols};
+    nt.hdr.null_bits = payloads ? ctx->null_bits : old.hdr.null_bits;
+    nt.hdr.t_emb_ctid = emb_ctid;
+    if (heapStore_update_xid(hs, ctx->xid, ctx->heap_ctid, &nt, v == NULL) == INVALID_TXN_ID)
+    {
+        rc = -1;
+        if (v)
+        {
+            LWLockAcquire(&et->embed_store.lock, LW_EXCLUSIVE);
+            embeddingStore_release(&et->embed_store, emb_ctid);
+            LWLockRelease(&et->embed_store.lock);
+        }
+    }
+    else
+    {
+        ctx->new_heap_ctid = nt.hdr.t_ctid;
+        ctx->emb_ctid = emb_ctid;
+        /* 反向指针指向最新版本；换了新向量时旧槽位随旧版本一起失效 */
+        LWLockAcquire(&et->embed_store.lock, LW_EXCLUSIVE);
+        if (item_ptr_is_valid(emb_ctid))
+            embeddingStore_set_owner(&et->embed_store, emb_ctid, nt.hdr.t_ctid);
+        if (v && item_ptr_is_valid(old.hdr.t_emb_ctid))
+            embeddingStore_mark_dead(&et->embed_store, old.hdr.t_emb_ctid);
+        LWLockRelease(&et->embed_store.lock);
+        if (!(nt.hdr.t_infomask & HEAP_ONLY_TUPLE) && item_ptr_is_valid(emb_ctid))
+        {
+            const f32* vec = v ? (const f32*)v->data
+                               : embedding_store_get_ptr_ctid(&et->embed_store, emb_ctid);
+            embeddingHeapTable_index_put(et, nt.hdr.t_ctid, emb_ctid, vec, false);
+        }
+    }
+    row_tuple_free(&old, schema);
+    return rc;
 }
 
 /* 处理组合表的单行追加；当前未实现具体逻辑。 */
@@ -309,28 +500,64 @@ static void embeddingHeapTable_append(TableAmRoutine* am, VectorBase* v, TupleVa
     (void)n_payloads;
 }
 
-/* 先写 embedding，再把对应 payload 写入 heap，完成组合表批量插入。 */
+/*
+ * 先写 embedding，再把对应 payload 写入 heap，完成组合表批量插入，最后逐行登记挂载的索引。
+ * 向量整批无锁追加（fetch_add 预留槽位后各自拷贝），并发批量导入互不阻塞。
+ */
 static void embeddingHeapTable_append_chunk(TableAmRoutine* am, const DataChunk* chunk,
                                             TamInsertCtx* ctx)
 {
     EmbeddingHeapTable* et = (EmbeddingHeapTable*)am;
-    LWLockAcquire(&et->embed_store.lock, LW_EXCLUSIVE);
+    embeddingStore_append_batch(&et->embed_store, chunk->arrays, chunk->count,
+                                ctx ? ctx->emb_ctids : NULL);
+
+    /* 登记 emb 槽位 → heap ctid 反向指针。扫描在 heap 页闩锁下读 embedding，
+     * 所以 embedding 锁只能在 heap 插入返回（页闩锁已释放）之后获取；
+     * 有 heap_ctids 时整批登记，只加一次锁 */
+    TableAmRoutine* heap_am = (TableAmRoutine*)&et->heap_table;
     for (usize i = 0; i < chunk->count; i++)
     {
-        ItemPtr ctid = embeddingStore_append_and_get_ctid(&et->embed_store, &chunk->arrays[i]);
-        if (ctx && ctx->emb_ctids) ctx->emb_ctids[i] = ctid;
+        ctx->current_index = i;
+        ItemPtr heap_ctid =
+            heapTable_append_impl(heap_am, ctx, &chunk->arrays[i],
+                                  chunk->payloads ? chunk->payloads[i] : NULL, chunk->n_payloads);
+        if (!ctx->emb_ctids || !item_ptr_is_valid(heap_ctid)) continue;
+        if (!ctx->heap_ctids)
+        {
+            LWLockAcquire(&et->embed_store.lock, LW_EXCLUSIVE);
+            embeddingStore_set_owner(&et->embed_store, ctx->emb_ctids[i], heap_ctid);
+            LWLockRelease(&et->embed_store.lock);
+        }
+        if (vector_size(&et->indexes) > 0)
+            embeddingHeapTable_index_put(et, heap_ctid, ctx->emb_ctids[i],
+                                         (const f32*)chunk->arrays[i].data, false);
     }
+    if (!ctx->emb_ctids || !ctx->heap_ctids) return;
+    LWLockAcquire(&et->embed_store.lock, LW_EXCLUSIVE);
+    for (usize i = 0; i < chunk->count; i++)
+        embeddingStore_set_owner(&et->embed_store, ctx->emb_ctids[i], ctx->heap_ctids[i]);
     LWLockRelease(&et->embed_store.lock);
+}
 
-    TableAmRoutine* heap_am = (TableAmRoutine*)&et->heap_table;
-    LWLockAcquire(&et->heap_table.store.lock, LW_EXCLUSIVE);
-    for (usize i = 0; i < chunk->count; i++)
+/*
+ * 组合表删除：heap 元组设置 t_xmax，emb 槽位清除活性位（反向指针保留到 vacuum）。
+ * 索引项和槽位都等 vacuum 确认元组对所有快照不可见后再回收。
+ */
+static int embeddingHeapTable_delete(TableAmRoutine* am, TamDeleteCtx* ctx)
+{
+    EmbeddingHeapTable* et = (EmbeddingHeapTable*)am;
+    ItemPtr emb_ctid = INVALID_ITEM_PTR;
+    TxnId xid = heapStore_delete_returning(&et->heap_table.store, ctx->xid, ctx->heap_ctid, &emb_ctid);
+    if (xid == INVALID_TXN_ID) return -1;
+
+    ctx->emb_ctid = emb_ctid;
+    if (item_ptr_is_valid(emb_ctid))
     {
-        ctx->current_index = i;
-        heapTable_append_impl(heap_am, ctx, &chunk->arrays[i],
-                              chunk->payloads ? chunk->payloads[i] : NULL, chunk->n_payloads);
+        LWLockAcquire(&et->embed_store.lock, LW_EXCLUSIVE);
+        embeddingStore_mark_dead(&et->embed_store, emb_ctid);
+        LWLockRelease(&et->embed_store.lock);
     }
-    LWLockRelease(&et->heap_table.store.lock);
+    return 0;
 }
 
 typedef struct
@@ -340,6 +567,7 @@ typedef struct
     Datum* vals;
     const f32* vec;
     u64 null_bits;
+    ItemPtr emb_ctid;
 } EmbScanCand;
 
 /* 比较两个扫描候选的距离，用于按距离排序。 */
@@ -366,10 +594,26 @@ static void topk_push(EmbScanCand* h, usize* sz, EmbScanCand c)
     }
 }
 
+/*
+ * 释放候选的 payload。owner 非空表示没有查询级 arena：Datum 数组和其中的
+ * varlena 都是 malloc 拷贝，一并释放；owner 为空时它们在 arena 里，随 arena 回收。
+ */
+static void emb_scan_cand_free(EmbScanCand* c, const TupleDesc* owner, u64 want)
+{
+    if (!c->vals) return;
+    if (owner)
+    {
+        tupleDesc_free_datums(owner, want, c->null_bits >> 1, c->vals);
+        free(c->vals);
+    }
+    c->vals = NULL;
+}
+
 /* 用更好的候选替换堆顶，并重新维护最大堆性质。 */
-static void topk_replace_root(EmbScanCand* h, usize n, EmbScanCand c)
+static void topk_replace_root(EmbScanCand* h, usize n, EmbScanCand c, const TupleDesc* owner,
+                              u64 want)
 {
-    free(h[0].vals);
+    emb_scan_cand_free(&h[0], owner, want);
     h[0] = c;
     usize i = 0;
     for (;;)
@@ -387,6 +631,106 @@ static void topk_replace_root(EmbScanCand* h, usize n, EmbScanCand c)
 
 #define TOPK_STACK_MAX 64
 
+/*
+ * embedding 优先扫描（无事务管理器时活性位是精确的）：按槽位顺序连续读取向量，
+ * 活性位过滤已删除的向量而不访问 heap，只为最终 top-k 经反向指针回表解码 payload。
+ * 活性位只由本表的 delete / update 维护；若 top-k 中有元组已被绕过本表删除，
+ * 返回 -1，由调用方退回 heap 扫描。
+ */
+static int embeddingHeapTable_scan_emb_first(EmbeddingHeapTable* et, TamScanCtx* ctx,
+                                             TableQueryResult* results, usize max_results)
+{
+    const VectorCondition* vc = ctx->vec_cond;
+    EmbeddingStore* es = &et->embed_store;
+    HeapStore* hs = &et->heap_table.store;
+    usize heap_ncols = (usize)et->heap_table.schema.ncols;
+    EmbScanCand stack_buf[TOPK_STACK_MAX];
+    EmbScanCand* topk =
+        max_results <= TOPK_STACK_MAX ? stack_buf : malloc(max_results * sizeof(EmbScanCand));
+    usize ksz = 0;
+
+    LWLockAcquire(&es->lock, LW_SHARED);
+    usize nslots = embeddingStore_published(es);
+    for (usize s = 0; s * es->vecs_per_blk < nslots; s++)
+    {
+        BlockSegment* seg = (BlockSegment*)segmentTree_get_node(&es->tree, s);
+        const u8* base = (const u8*)segment_get_data(seg);
+        usize n = nslots - s * es->vecs_per_blk;
+        if (n > es->vecs_per_blk) n = es->vecs_per_blk;
+        for (usize j = 0; j < n; j++)
+        {
+            ItemPtr emb_ctid = make_item_ptr((block_id_t)s, (u16)j);
+            if (!embeddingStore_is_live(es, emb_ctid)) continue;
+            ItemPtr heap_ctid = embeddingStore_heap_ctid(es, emb_ctid);
+            if (!item_ptr_is_valid(heap_ctid)) continue;
+            const f32* vec = (const f32*)(base + j * es->elem_size);
+            VectorBase stored = {TYPE_FLOAT32, vc->query.count, (data_ptr_t)vec};
+            f32 dist = vec_compute_distance(&stored, &vc->query, vc->metric);
+            if (ksz == max_results && dist >= topk[0].dist) continue;
+
+            EmbScanCand c = {heap_ctid, dist, NULL, vec, 0, emb_ctid};
+            if (ksz < max_results)
+                topk_push(topk, &ksz, c);
+            else
+                topk_replace_root(topk, ksz, c, NULL, 0);
+        }
+    }
+    LWLockRelease(&es->lock);
+    qsort(topk, ksz, sizeof(EmbScanCand), emb_scan_cand_cmp);
+
+    u64 all_cols = tupleDesc_cols_mask(heap_ncols);
+    u64 want = ctx->payload_cols ? (ctx->payload_cols & all_cols) : all_cols;
+    VarlenaMode mode = ctx->arena ? VARLENA_COPY_ARENA : VARLENA_COPY_MALLOC;
+    usize nout = 0;
+    bool stale = false;
+    for (usize i = 0; i < ksz && !stale; i++)
+    {
+        HeapTupleRef ref;
+        stale = heapStore_fetch_ref(hs, topk[i].heap_ctid, &ref) != 0;
+        if (stale) break;
+        stale = ref.hdr->t_xmax != INVALID_TXN_ID;
+        heapStore_release_ref(&ref);
+    }
+    /* 候选不足 k 个时所有活槽位都已在 top-k 中，剔除死元组即可 */
+    if (stale && ksz == max_results)
+    {
+        if (topk != stack_buf) free(topk);
+        return -1;
+    }
+    for (usize i = 0; i < ksz; i++)
+    {
+        HeapTupleRef ref;
+        if (heapStore_fetch_ref(hs, topk[i].heap_ctid, &ref) != 0) continue;
+        Datum* vals = NULL;
+        bool ok = ref.hdr->t_xmax == INVALID_TXN_ID;
+        if (ok && heap_ncols > 0)
+        {
+            vals = ctx->arena ? memoryContext_alloc(ctx->arena, heap_ncols * sizeof(Datum))
+                              : malloc(heap_ncols * sizeof(Datum));
+            if (vals) memset(vals, 0, heap_ncols * sizeof(Datum));
+            ok = vals && tupleDesc_deform_ex(&hs->desc, ref.col_data, ref.hdr->null_bits, want,
+                                             vals, mode, ctx->arena) == 0;
+        }
+        heapStore_release_ref(&ref);
+        if (!ok)
+        {
+            if (!ctx->arena) free(vals);
+            continue;
+        }
+        results[nout].heap_ctid = topk[i].heap_ctid;
+        results[nout].emb_ctid = topk[i].emb_ctid;
+        results[nout].distance = topk[i].dist;
+        results[nout].payloads = vals;
+        results[nout].vector.data = (data_ptr_t)topk[i].vec;
+        results[nout].vector.count = vc->query.count;
+        results[nout].vector.type = TYPE_FLOAT32;
+        nout++;
+    }
+
+    if (topk != stack_buf) free(topk);
+    return (int)nout;
+}
+
 /* 对组合表执行向量扫描，返回距离最近的 top-k 结果。 */
 static int embeddingHeapTable_scan_chunk(TableAmRoutine* am, TamScanCtx* ctx,
                                          TableQueryResult* results, usize max_results)
@@ -394,6 +738,11 @@ static int embeddingHeapTable_scan_chunk(TableAmRoutine* am, TamScanCtx* ctx,
     const VectorCondition* vc = ctx->vec_cond;
     if (max_results == 0 || !vc) return 0;
     EmbeddingHeapTable* et = (EmbeddingHeapTable*)am;
+    if (!ctx->snapshot && !et->heap_table.store.txn_mgr)
+    {
+        int nout = embeddingHeapTable_scan_emb_first(et, ctx, results, max_results);
+        if (nout >= 0) return nout;
+    }
     const TableSchema* schema = &et->heap_table.schema;
     usize heap_ncols = (usize)schema->ncols;
     usize heap_cap = max_results;
@@ -401,12 +750,32 @@ static int embeddingHeapTable_scan_chunk(TableAmRoutine* am, TamScanCtx* ctx,
     EmbScanCand* topk =
         heap_cap <= TOPK_STACK_MAX ? stack_buf : malloc(heap_cap * sizeof(EmbScanCand));
     usize ksz = 0; /* 当前最大堆中的候选数量 */
+    /* 迭代器只持有当前页的共享闩锁，写入和 vacuum 不被长扫描阻塞；有事务管理器时按快照过滤 */
+    HeapStore* hs = &et->heap_table.store;
+    /* 只解码请求的 payload 列 */
+    u64 all_cols = tupleDesc_cols_mask(heap_ncols);
+    u64 want = ctx->payload_cols ? (ctx->payload_cols & all_cols) : all_cols;
+    /* varlena payload 优先拷进查询级 arena；否则逐个 malloc，淘汰的候选要释放 */
+    VarlenaMode mode = ctx->arena ? VARLENA_COPY_ARENA : VARLENA_COPY_MALLOC;
+    const TupleDesc* owner = ctx->arena ? NULL : &hs->desc;
+    Snapshot* snap = ctx->snapshot;
+    Snapshot* own_snap = NULL;
+    if (!snap && hs->txn_mgr)
+    {
+        snap = own_snap = transactionManager_get_snapshot(hs->txn_mgr, 0);
+        if (!snap)
+        {
+            if (topk != stack_buf) free(topk);
+            return -1;
+        }
+    }
     HeapStoreIter iter;
-    heapStoreIter_begin(&iter, &et->heap_table.store);
+    heapStoreIter_begin_snapshot(&iter, hs, snap);
     const TupleHdr* hdr;
     while ((hdr = heapStoreIter_next(&iter)) != NULL)
     {
-        if (hdr->t_xmax != INVALID_TXN_ID) continue;
+        /* 快照迭代器已过滤不可见元组；all-visible 页上的元组必然存活，跳过逐行 t_xmax 检查 */
+        if (!snap && !iter.page_all_visible && hdr->t_xmax != INVALID_TXN_ID) continue;
         if (!item_ptr_is_valid(hdr->t_emb_ctid)) continue;
         const f32* vec = embedding_store_get_ptr_ctid(&et->embed_store, hdr->t_emb_ctid);
         if (!vec) continue;
@@ -415,42 +784,43 @@ static int embeddingHeapTable_scan_chunk(TableAmRoutine* am, TamScanCtx* ctx,
 
         if (ksz == heap_cap && dist >= topk[0].dist) continue;
 
-        Datum* vals = (heap_ncols > 0) ? malloc(heap_ncols * sizeof(Datum)) : NULL;
-        if (heap_ncols > 0 && !vals) continue;
+        /* 有 arena 时 Datum 数组也从 arena 切，被淘汰的候选不用逐个 free */
+        Datum* vals = NULL;
+        if (heap_ncols > 0)
+        {
+            usize bytes = heap_ncols * sizeof(Datum);
+            vals = ctx->arena ? memoryContext_alloc(ctx->arena, bytes) : malloc(bytes);
+            if (!vals) continue;
+        }
         u64 null_bits = 0;
-        if (!vals) continue;
 
         if (heap_ncols > 0)
         {
-            HeapTupleRef ref = {
-                .hdr = hdr,
-                .col_data = iter.curr_col_data,
-                .schema = schema,
-                .store = NULL,
-            };
-            if (heapStore_deform_tuple(&ref, vals, heap_ncols) != 0)
+            if (want != all_cols) memset(vals, 0, heap_ncols * sizeof(Datum));
+            if (tupleDesc_deform_ex(&hs->desc, iter.curr_col_data, hdr->null_bits, want, vals,
+                                    mode, ctx->arena) != 0)
             {
-                free(vals);
+                if (!ctx->arena) free(vals);
                 continue;
             }
             null_bits = hdr->null_bits << 1;
         }
 
-        EmbScanCand c = {hdr->t_ctid, dist, vals, vec, null_bits};
+        EmbScanCand c = {heapStoreIter_ctid(&iter), dist, vals, vec, null_bits, hdr->t_emb_ctid};
         if (ksz < heap_cap)
             topk_push(topk, &ksz, c);
         else
-            topk_replace_root(topk, ksz, c);
+            topk_replace_root(topk, ksz, c, owner, want);
     }
     heapStoreIter_end(&iter);
+    if (own_snap) transactionManager_release_snapshot(hs->txn_mgr, own_snap);
 
     qsort(topk, ksz, sizeof(EmbScanCand), emb_scan_cand_cmp);
     usize nout = 0;
     for (usize i = 0; i < ksz && nout < max_results; i++)
     {
-        if (!topk[i].vals) continue;
-
         results[nout].heap_ctid = topk[i].heap_ctid;
+        results[nout].emb_ctid = topk[i].emb_ctid;
         results[nout].distance = topk[i].dist;
         results[nout].payloads = topk[i].vals;
         results[nout].vector.data = (data_ptr_t)topk[i].vec;
@@ -460,10 +830,7 @@ static int embeddingHeapTable_scan_chunk(TableAmRoutine* am, TamScanCtx* ctx,
         nout++;
     }
 
-    for (usize i = 0; i < ksz; i++)
-    {
-        if (topk[i].vals) free(topk[i].vals);
-    }
+    for (usize i = 0; i < ksz; i++) emb_scan_cand_free(&topk[i], owner, want);
     if (topk != stack_buf) free(topk);
 
     return (int)nout;
@@ -492,8 +859,13 @@ static void embeddingHeapTable_destory(TableAmRoutine* am)
     (void)am;
 }
 
-/* 通过表的 append_chunk 接口把一个 DataChunk 写入 DataTable。 */
-void dataTable_insert_datachunk(DataTable* datatable, DataChunk* chunk)
+/*
+ * 表级锁：读取 AccessShare，增删改 RowExclusive，vacuum ShareUpdateExclusive，
+ * 拆表 AccessExclusive。锁只在单次调用内持有；等待超时且构成死锁时调用失败返回。
+ */
+
+/* 通过表的 append_chunk 接口把一个 DataChunk 写入 DataTable。成功返回 0，死锁返回 -1。 */
+int dataTable_insert_datachunk(DataTable* datatable, DataChunk* chunk)
 {
     ItemPtr heap_ctid_stack[TAM_CTX_STACK_MAX];
     ItemPtr emb_ctid_stack[TAM_CTX_STACK_MAX];
@@ -505,9 +877,54 @@ void dataTable_insert_datachunk(DataTable* datatable, DataChunk* chunk)
         .current_index = 0,
     };
 
+    if (LockRelation(datatable->relid, RowExclusiveLock) == LOCKACQUIRE_DEADLOCK) return -1;
     VCALL(datatable->table, append_chunk, chunk, &ctx);
+    UnlockRelation(datatable->relid, RowExclusiveLock);
+    return 0;
+}
+
+/*
+ * 按 heap ctid 更新一行：v 为新向量（NULL 表示不变），payloads 为新的 heap 列（NULL 表示不变），
+ * null_bits 标出 payloads 中的 NULL 列。
+ */
+int dataTable_update(DataTable* datatable, ItemPtr old_heap_ctid, VectorBase* v,
+                     const Datum* payloads, u64 null_bits)
+{
+    TamUpdateCtx ctx = {
+        .heap_ctid = old_heap_ctid,
+        .emb_ctid = INVALID_ITEM_PTR,
+        .new_heap_ctid = INVALID_ITEM_PTR,
+        .null_bits = null_bits,
+    };
+    if (LockRelation(datatable->relid, RowExclusiveLock) == LOCKACQUIRE_DEADLOCK) return -1;
+    int rc = VCALL(datatable->table, update, v, payloads, &ctx);
+    UnlockRelation(datatable->relid, RowExclusiveLock);
+    return rc;
+}
 
-    // 索引插入逻辑待实现
+/* 按 heap ctid 删除一行（自动提交）。成功返回 0，死锁或删除失败返回 -1。 */
+int dataTable_delete(DataTable* datatable, ItemPtr old_heap_ctid)
+{
+    TamDeleteCtx ctx = {
+        .heap_ctid = old_heap_ctid,
+        .emb_ctid = INVALID_ITEM_PTR,
+    };
+    if (LockRelation(datatable->relid, RowExclusiveLock) == LOCKACQUIRE_DEADLOCK) return -1;
+    int rc = VCALL(datatable->table, delete, &ctx);
+    UnlockRelation(datatable->relid, RowExclusiveLock);
+    return rc;
+}
+
+/*
+ * 对 DataTable 执行 vacuum，回收 t_xmax 早于 horizon 的死元组；与读写并发，多个 vacuum 串行。
+ * 返回回收的元组数，死锁返回 -1。
+ */
+i64 dataTable_vacuum(DataTable* datatable, TxnId horizon)
+{
+    if (LockRelation(datatable->relid, ShareUpdateExclusiveLock) == LOCKACQUIRE_DEADLOCK) return -1;
+    u64 removed = VCALL(datatable->table, vacuum, horizon);
+    UnlockRelation(datatable->relid, ShareUpdateExclusiveLock);
+    return (i64)removed;
 }
 
 /* 按向量条件扫描 DataTable，并把结果写入调用方缓冲区。 */
@@ -519,7 +936,10 @@ int dataTable_scan(DataTable* datatable, const VectorCondition* vec_cond, TableQ
         .k = max_results,
     };
 
-    return VCALL(datatable->table, scan, &ctx, results, max_results);
+    if (LockRelation(datatable->relid, AccessShareLock) == LOCKACQUIRE_DEADLOCK) return -1;
+    int n = VCALL(datatable->table, scan, &ctx, results, max_results);
+    UnlockRelation(datatable->relid, AccessShareLock);
+    return n;
 }
 
 /* 把 DataTable 结构体字段重置到默认空状态。 */
@@ -529,15 +949,20 @@ void DataTable_init(DataTable* datatable)
     datatable->table_name = NULL;
     datatable->table = NULL;
     datatable->ncols = 0;
+    datatable->relid = atomic_fetch_add(&datatable_next_relid, 1);
 }
 
-/* 释放 DataTable 自身持有的名称字符串并清空字段。 */
-void DataTable_deinit(DataTable* datatable)
+/* 释放 DataTable 自身持有的名称字符串并清空字段。成功返回 0，死锁返回 -1（不做任何释放）。 */
+int DataTable_deinit(DataTable* datatable)
 {
-    if (!datatable) return;
+    if (!datatable) return 0;
+    /* 等进行中的读写、vacuum 全部结束再拆 */
+    if (LockRelation(datatable->relid, AccessExclusiveLock) == LOCKACQUIRE_DEADLOCK) return -1;
     free(datatable->schema_name);
     free(datatable->table_name);
     datatable->schema_name = NULL;
     datatable->table_name = NULL;
     datatable->table = NULL;
+    UnlockRelation(datatable->relid, AccessExclusiveLock);
+    return 0;
 }
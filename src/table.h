@@ -7,6 +7,7 @@
 #include "vector.h"
 #include "types.h"
 #include "operator.h"
+#include "index.h"
 
 typedef struct DataChunk DataChunk;
 typedef struct TableQueryResult TableQueryResult;
@@ -115,18 +116,25 @@ typedef struct
 {
     VectorCondition* vec_cond;
     usize k;         /* max rows to return */
+    Snapshot* snapshot; /* 可选；为 NULL 且存储挂了事务管理器时，扫描自取一个快照 */
+    u64 payload_cols;   /* 需要返回的 payload 列位图（bit i = 第 i 列）；0 表示全部，未请求的列置 0 */
+    MemoryContext* arena;  /* 可选；payload 数组和 TEXT/JSONB 拷贝都从此查询级 arena 分配，为 NULL 时逐个 malloc */
 } TamScanCtx;
 
 typedef struct
 {
     ItemPtr heap_ctid;    /* physical ctid of the heap slot */
-    ItemPtr emb_ctid;     /* emb position (for TamEmbTable) */
+    ItemPtr emb_ctid;     /* out: emb position of the new version (for TamEmbTable) */
+    ItemPtr new_heap_ctid; /* out: ctid of the new version */
+    u64 null_bits;        /* payloads 中为 NULL 的列（bit i = 第 i 列）；payloads 为 NULL 时忽略 */
+    TxnId xid;            /* 0 → 自动提交 */
 } TamUpdateCtx;
 
 typedef struct
 {
     ItemPtr heap_ctid;    /* physical ctid of the heap slot */
-    ItemPtr emb_ctid;     /* emb position (for TamEmbTable) */
+    ItemPtr emb_ctid;     /* out: emb position of the deleted version (for TamEmbTable) */
+    TxnId xid;            /* 0 → 自动提交 */
 } TamDeleteCtx;
 
 // clang-format off
@@ -134,8 +142,9 @@ DEFINE_CLASS(TableAmRoutine,
     VMETHOD(TableAmRoutine, append, void, VectorBase* v, TupleVal* payloads, usize n_payloads)
     VMETHOD(TableAmRoutine, append_chunk, void, const DataChunk* chunk, TamInsertCtx* ctx)
     VMETHOD(TableAmRoutine, scan, int,  TamScanCtx* ctx, TableQueryResult* results, usize max_results)
-    VMETHOD(TableAmRoutine, update, int, VectorBase* v, TupleVal* payloads, TamUpdateCtx* ctx)
+    VMETHOD(TableAmRoutine, update, int, VectorBase* v, const Datum* payloads, TamUpdateCtx* ctx)
     VMETHOD(TableAmRoutine, delete, int, TamDeleteCtx* ctx)
+    VMETHOD(TableAmRoutine, vacuum, u64, TxnId horizon)
     VMETHOD(TableAmRoutine,write_blocks, void, BlockManager* bm, MetaBlockWriter* w)
     VMETHOD(TableAmRoutine,load_blocks, void, BlockManager* bm, MetaBlockReader* r)
     VMETHOD(TableAmRoutine,destroy, void)
@@ -184,19 +193,23 @@ typedef struct
     EXTENDS(TableAmRoutine);
     EmbeddingStore embed_store;
     HeapTable heap_table;
-
+    Vector indexes; /* vector<VectorIndex*> — attached, not owned; vacuum removes dead ctids */
+    LWLock index_lock; /* 串行化对挂载索引的修改（索引自身不做并发控制） */
 } EmbeddingHeapTable;
 
 void EmbeddingHeapTable_init(EmbeddingHeapTable* table, i16 dimension, const TableSchema* schema,
                              BlockManager* bm);
 void EmbeddingHeapTable_deinit(EmbeddingHeapTable* table);
+void embeddingHeapTable_attach_index(EmbeddingHeapTable* table, VectorIndex* index);
 
 struct TableQueryResult
 {
     ItemPtr heap_ctid;
     ItemPtr emb_ctid;
     VectorBase vector;
-    Datum* payloads; /* optional, heap user cols (NULL if not requested) */
+    Datum* payloads; /* optional, heap user cols (NULL if not requested); the array and its
+                      * varlena values live in TamScanCtx.arena, or are malloc'd (caller frees)
+                      * when no arena was given */
     f32 distance;
 };
 
@@ -207,19 +220,21 @@ struct DataTable
     char* table_name;    /* owned */
     TableAmRoutine* table;/* owned */
     usize ncols;
+    u64 relid;           /* RegularLock 的表锁标识，创建时分配，进程内唯一 */
 };
 
 DataTable* Datatable_create(StorageManager* manager, char* schema_name, char* table_name,
                             usize column_count, TypeID* column_types);
 
 void DataTable_init(DataTable* datatable);
-void DataTable_deinit(DataTable* datatable);
+int DataTable_deinit(DataTable* datatable);
 
-void dataTable_insert_datachunk(DataTable* datatable, DataChunk* chunk);
+int dataTable_insert_datachunk(DataTable* datatable, DataChunk* chunk);
 void dataTable_insert(DataTable* datatable, VectorBase* v, TupleVal* payloads, usize n_payloads);
-void dataTable_update(DataTable* datatable, ItemPtr old_heap_ctid, VectorBase* v,
-                      TupleVal* payloads, usize n_payloads);
-void dataTable_delete(DataTable* datatable, ItemPtr old_heap_ctid);
+int dataTable_update(DataTable* datatable, ItemPtr old_heap_ctid, VectorBase* v,
+                     const Datum* payloads, u64 null_bits);
+int dataTable_delete(DataTable* datatable, ItemPtr old_heap_ctid);
+i64 dataTable_vacuum(DataTable* datatable, TxnId horizon);
 int dataTable_scan(DataTable* datatable, const VectorCondition* vec_cond, TableQueryResult* results,
                    usize max_results);
 
@@ -0,0 +1,416 @@
+#define _GNU_SOURCE
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "lock.h"
+#include "threadpool.h"
+
+#define TP_DEQUE_CAPACITY 1024 // 2 的幂；满了溢出到注入队列
+#define TP_IDLE_SPINS     16   // 睡眠前再找几轮任务
+#define TP_WAIT_SLICE_NS  1000000 // taskGroup_wait 无事可做时每次睡 1ms 再找
+
+typedef struct Task
+{
+    TaskFn fn;
+    void* arg;
+    TaskGroup* group;
+    struct Task* next; // 注入队列链
+} Task;
+
+/*
+ * Chase-Lev 双端队列（Lê et al., "Correct and Efficient Work-Stealing for
+ * Weak Memory Models"）。bottom 只由所属 worker 修改；top 由偷取者 CAS 推进，
+ * 所属 worker 取最后一个元素时也要与偷取者 CAS 竞争。
+ */
+typedef struct
+{
+    _Alignas(64) _Atomic i64 top;
+    _Alignas(64) _Atomic i64 bottom;
+    _Atomic(Task*) buf[TP_DEQUE_CAPACITY];
+} TaskDeque;
+
+typedef struct
+{
+    ThreadPool* pool;
+    u32 index;
+    pthread_t thread;
+    u32 rng; // 选偷取对象用
+    TaskDeque deque;
+} ThreadPoolWorker;
+
+struct ThreadPool
+{
+    u32 nworkers;
+    u32 flags;
+    ThreadPoolWorker* workers;
+    slock_t inject_lock;
+    _Atomic(Task*) inject_head; // 锁内修改；原子类型只为允许锁外预读
+    Task* inject_tail;
+    _Atomic u64 work_seq;   // 每提交一次加一，空闲 worker 据此判断睡眠期间有无新任务
+    _Atomic u32 nsleeping;
+    // 任一 TaskGroup 计数归零时加一；taskGroup_wait 睡在这个字上而不是 group->pending，
+    // 因为计数归零后等待方随时可能返回、释放栈上的 TaskGroup，完成方不能再碰它
+    _Atomic u32 group_done_seq;
+    atomic_bool shutdown;
+    pthread_mutex_t sleep_mutex;
+    pthread_cond_t sleep_cond;
+};
+
+static __thread ThreadPoolWorker* tp_self = NULL;
+
+static ThreadPool* tp_shared = NULL;
+static pthread_once_t tp_shared_once = PTHREAD_ONCE_INIT;
+
+/* ============================================================
+ * 双端队列
+ * ============================================================ */
+
+static bool deque_push(TaskDeque* dq, Task* task)
+{
+    i64 b = atomic_load_explicit(&dq->bottom, memory_order_relaxed);
+    i64 t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    if (b - t >= TP_DEQUE_CAPACITY) return false;
+    atomic_store_explicit(&dq->buf[b & (TP_DEQUE_CAPACITY - 1)], task, memory_order_relaxed);
+    atomic_store_explicit(&dq->bottom, b + 1, memory_order_release);
+    return true;
+}
+
+static Task* deque_take(TaskDeque* dq)
+{
+    i64 b = atomic_load_explicit(&dq->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&dq->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    i64 t = atomic_load_explicit(&dq->top, memory_order_relaxed);
+    if (t > b)
+    {
+        atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    Task* task = atomic_load_explicit(&dq->buf[b & (TP_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (t == b)
+    {
+        // 只剩一个：与偷取者竞争
+        if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed))
+            task = NULL;
+        atomic_store_explicit(&dq->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static Task* deque_steal(TaskDeque* dq)
+{
+    i64 t = atomic_load_explicit(&dq->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    i64 b = atomic_load_explicit(&dq->bottom, memory_order_acquire);
+    if (t >= b) return NULL;
+    Task* task = atomic_load_explicit(&dq->buf[t & (TP_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&dq->top, &t, t + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed))
+        return NULL;
+    return task;
+}
+
+/* ============================================================
+ * 注入队列与唤醒
+ * ============================================================ */
+
+static void inject_push(ThreadPool* pool, Task* task)
+{
+    task->next = NULL;
+    SpinLockAcquire(&pool->inject_lock);
+    if (pool->inject_tail)
+        pool->inject_tail->next = task;
+    else
+        atomic_store_explicit(&pool->inject_head, task, memory_order_relaxed);
+    pool->inject_tail = task;
+    SpinLockRelease(&pool->inject_lock);
+}
+
+static Task* inject_pop(ThreadPool* pool)
+{
+    // 无锁预读：空闲 worker 反复轮询时不必每次抢自旋锁
+    if (!atomic_load_explicit(&pool->inject_head, memory_order_relaxed)) return NULL;
+    SpinLockAcquire(&pool->inject_lock);
+    Task* task = atomic_load_explicit(&pool->inject_head, memory_order_relaxed);
+    if (task)
+    {
+        atomic_store_explicit(&pool->inject_head, task->next, memory_order_relaxed);
+        if (!task->next) pool->inject_tail = NULL;
+    }
+    SpinLockRelease(&pool->inject_lock);
+    return task;
+}
+
+static void pool_notify(ThreadPool* pool)
+{
+    atomic_fetch_add(&pool->work_seq, 1);
+    if (atomic_load(&pool->nsleeping) == 0) return;
+    pthread_mutex_lock(&pool->sleep_mutex);
+    pthread_cond_signal(&pool->sleep_cond);
+    pthread_mutex_unlock(&pool->sleep_mutex);
+}
+
+/* 依次找：自己的队列 → 注入队列 → 从随机起点轮流偷别的 worker */
+static Task* pool_find_task(ThreadPool* pool, ThreadPoolWorker* self)
+{
+    Task* task;
+    if (self && (task = deque_take(&self->deque))) return task;
+    if ((task = inject_pop(pool))) return task;
+    u32 start = 0;
+    if (self)
+    {
+        self->rng = self->rng * 1103515245u + 12345u;
+        start = self->rng >> 16;
+    }
+    for (u32 i = 0; i < pool->nworkers; i++)
+    {
+        ThreadPoolWorker* victim = &pool->workers[(start + i) % pool->nworkers];
+        if (victim == self) continue;
+        if ((task = deque_steal(&victim->deque))) return task;
+    }
+    return NULL;
+}
+
+static void task_run(Task* task)
+{
+    TaskGroup* group = task->group;
+    // 池比组活得久：减计数之前取出来，之后只碰池
+    ThreadPool* pool = group->pool;
+    task->fn(task->arg);
+    free(task);
+    if (atomic_fetch_sub_explicit(&group->pending, 1, memory_order_acq_rel) == 1)
+    {
+        atomic_fetch_add_explicit(&pool->group_done_seq, 1, memory_order_release);
+#ifdef __linux__
+        syscall(SYS_futex, (u32*)&pool->group_done_seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL,
+                0);
+#endif
+    }
+}
+
+/* ============================================================
+ * worker
+ * ============================================================ */
+
+static void* threadPool_worker_main(void* arg)
+{
+    ThreadPoolWorker* self = arg;
+    ThreadPool* pool = self->pool;
+    tp_self = self;
+#ifdef __linux__
+    if (pool->flags & THREADPOOL_PIN_CPUS)
+    {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(self->index % (ncpu > 0 ? (u32)ncpu : 1u), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+    for (;;)
+    {
+        u64 seq = atomic_load(&pool->work_seq);
+        Task* task = NULL;
+        for (u32 spin = 0; spin < TP_IDLE_SPINS && !task; spin++)
+        {
+            task = pool_find_task(pool, self);
+            if (!task && spin + 1 < TP_IDLE_SPINS) sched_yield();
+        }
+        if (task)
+        {
+            task_run(task);
+            continue;
+        }
+        if (atomic_load(&pool->shutdown)) break;
+        // 找之前记下的 seq 没变才睡：期间的提交要么被看到，要么让 seq 变化
+        pthread_mutex_lock(&pool->sleep_mutex);
+        atomic_fetch_add(&pool->nsleeping, 1);
+        while (atomic_load(&pool->work_seq) == seq && !atomic_load(&pool->shutdown))
+            pthread_cond_wait(&pool->sleep_cond, &pool->sleep_mutex);
+        atomic_fetch_sub(&pool->nsleeping, 1);
+        pthread_mutex_unlock(&pool->sleep_mutex);
+    }
+    tp_self = NULL;
+    return NULL;
+}
+
+ThreadPool* ThreadPool_create(u32 nworkers, u32 flags)
+{
+    if (nworkers == 0)
+    {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        nworkers = ncpu > 1 ? (u32)ncpu - 1 : 1;
+    }
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    pool->flags = flags;
+    pool->workers = calloc(nworkers, sizeof(ThreadPoolWorker));
+    SpinLockInit(&pool->inject_lock);
+    pthread_mutex_init(&pool->sleep_mutex, NULL);
+    pthread_cond_init(&pool->sleep_cond, NULL);
+    for (u32 i = 0; i < nworkers; i++)
+    {
+        ThreadPoolWorker* w = &pool->workers[i];
+        w->pool = pool;
+        w->index = i;
+        w->rng = i * 2654435761u + 1;
+    }
+    // 先把 nworkers 定下来：worker 一启动就会遍历所有队列
+    pool->nworkers = nworkers;
+    u32 started = 0;
+    for (; started < nworkers; started++)
+    {
+        if (pthread_create(&pool->workers[started].thread, NULL, threadPool_worker_main,
+                           &pool->workers[started]) != 0)
+            break;
+    }
+    // 线程创建失败时缩小池；未启动的队列始终为空，偷取时只是白看一眼
+    if (started == 0)
+    {
+        threadPool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void threadPool_destroy(ThreadPool* pool)
+{
+    if (!pool) return;
+    pthread_mutex_lock(&pool->sleep_mutex);
+    atomic_store(&pool->shutdown, true);
+    pthread_cond_broadcast(&pool->sleep_cond);
+    pthread_mutex_unlock(&pool->sleep_mutex);
+    for (u32 i = 0; i < pool->nworkers; i++)
+        if (pool->workers[i].thread) pthread_join(pool->workers[i].thread, NULL);
+    pthread_mutex_destroy(&pool->sleep_mutex);
+    pthread_cond_destroy(&pool->sleep_cond);
+    SpinLockFree(&pool->inject_lock);
+    free(pool->workers);
+    free(pool);
+}
+
+static void threadPool_shared_init(void)
+{
+    tp_shared = ThreadPool_create(0, 0);
+}
+
+ThreadPool* threadPool_shared(void)
+{
+    pthread_once(&tp_shared_once, threadPool_shared_init);
+    return tp_shared;
+}
+
+u32 threadPool_size(ThreadPool* pool)
+{
+    return pool ? pool->nworkers : 0;
+}
+
+/* ============================================================
+ * TaskGroup
+ * ============================================================ */
+
+void TaskGroup_init(TaskGroup* group, ThreadPool* pool)
+{
+    group->pool = pool;
+    atomic_init(&group->pending, 0);
+}
+
+void taskGroup_spawn(TaskGroup* group, TaskFn fn, void* arg)
+{
+    ThreadPool* pool = group->pool;
+    if (!pool)
+    {
+        // 没有池（创建线程失败）：就地执行
+        fn(arg);
+        return;
+    }
+    Task* task = malloc(sizeof(Task));
+    task->fn = fn;
+    task->arg = arg;
+    task->group = group;
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    ThreadPoolWorker* self = tp_self;
+    if (!(self && self->pool == pool && deque_push(&self->deque, task))) inject_push(pool, task);
+    pool_notify(pool);
+}
+
+void taskGroup_wait(TaskGroup* group)
+{
+    ThreadPool* pool = group->pool;
+    ThreadPoolWorker* self = tp_self && tp_self->pool == pool ? tp_self : NULL;
+    for (;;)
+    {
+        // 先读序号再查计数：两者之间完成的组会让序号变化，futex 不会睡过头
+        u32 seq = pool ? atomic_load_explicit(&pool->group_done_seq, memory_order_acquire) : 0;
+        if (atomic_load_explicit(&group->pending, memory_order_acquire) == 0) break;
+        Task* task = pool_find_task(pool, self);
+        if (task)
+        {
+            task_run(task);
+            continue;
+        }
+        // 剩下的任务都在别人手上执行：睡到有组完成，定时醒来看有没有新任务可帮
+#ifdef __linux__
+        struct timespec ts = {0, TP_WAIT_SLICE_NS};
+        syscall(SYS_futex, (u32*)&pool->group_done_seq, FUTEX_WAIT_PRIVATE, seq, &ts, NULL, 0);
+#else
+        sched_yield();
+#endif
+    }
+}
+
+/* ============================================================
+ * parallel_for
+ * ============================================================ */
+
+typedef struct
+{
+    ParallelForFn fn;
+    void* arg;
+    usize lo, hi;
+} ParallelForChunk;
+
+static void parallel_for_task(void* arg)
+{
+    ParallelForChunk* c = arg;
+    c->fn(c->lo, c->hi, c->arg);
+}
+
+void threadPool_parallel_for(ThreadPool* pool, usize begin, usize end, usize grain,
+                             ParallelForFn fn, void* arg)
+{
+    if (end <= begin) return;
+    usize n = end - begin;
+    // 每个线程约 4 块：足够均衡负载，又不至于让调度开销盖过工作量
+    usize nthreads = (usize)threadPool_size(pool) + 1;
+    usize chunk = (n + nthreads * 4 - 1) / (nthreads * 4);
+    if (chunk < grain) chunk = grain;
+    if (chunk == 0) chunk = 1;
+    usize nchunks = (n + chunk - 1) / chunk;
+    if (nchunks <= 1 || !pool)
+    {
+        fn(begin, end, arg);
+        return;
+    }
+
+    ParallelForChunk* chunks = malloc(nchunks * sizeof(ParallelForChunk));
+    TaskGroup group;
+    TaskGroup_init(&group, pool);
+    for (usize i = 0; i < nchunks; i++)
+    {
+        usize lo = begin + i * chunk;
+        chunks[i] = (ParallelForChunk){fn, arg, lo, lo + chunk < end ? lo + chunk : end};
+        // 第一块留给自己
+        if (i > 0) taskGroup_spawn(&group, parallel_for_task, &chunks[i]);
+    }
+    parallel_for_task(&chunks[0]);
+    taskGroup_wait(&group);
+    free(chunks);
+}
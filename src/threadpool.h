@@ -0,0 +1,59 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <stdatomic.h>
+#include "vb_type.h"
+
+/**
+ * threadpool.h — 全库共享的 work-stealing 任务调度器
+ *
+ * 每个 worker 有一个 Chase-Lev 双端队列：自己从底部 LIFO 取（刚产生的任务数据
+ * 还在缓存里），空闲 worker 从别人的顶部 FIFO 偷（偷到的是最早、通常最大的任务）。
+ * 非 worker 线程提交的任务进入全局注入队列。
+ *
+ * TaskGroup 跟踪一组任务。taskGroup_wait 的调用方不空等，而是一起执行队列里的
+ * 任务，所以任务里再开 TaskGroup（嵌套并行）不会把 worker 全部卡死。
+ *
+ * 扫描、索引构建、checkpoint 都应通过 threadPool_shared() 使用同一个池：
+ * worker 数为 CPU 核数 - 1（等待方自己也干活），混合负载下总线程数约等于核数，
+ * 而不是各自起一批线程。
+ */
+
+#define THREADPOOL_PIN_CPUS 0x1u // worker i 绑定到 CPU i % ncpu（仅 Linux）
+
+typedef void (*TaskFn)(void* arg);
+typedef struct ThreadPool ThreadPool;
+
+typedef struct
+{
+    ThreadPool* pool;
+    _Atomic u32 pending; // 尚未完成的任务数；归零后完成方不再访问组，wait 返回即可释放
+} TaskGroup;
+
+// nworkers 为 0 时按 CPU 核数 - 1（至少 1）
+ThreadPool* ThreadPool_create(u32 nworkers, u32 flags);
+
+// 停止并回收 worker；调用前所有 TaskGroup 必须已 wait 完
+void threadPool_destroy(ThreadPool* pool);
+
+// 进程级共享池，首次调用时创建，随进程退出
+ThreadPool* threadPool_shared(void);
+
+u32 threadPool_size(ThreadPool* pool);
+
+void TaskGroup_init(TaskGroup* group, ThreadPool* pool);
+
+// 提交一个任务；在本池 worker 上调用时压入自己的队列，否则进注入队列
+void taskGroup_spawn(TaskGroup* group, TaskFn fn, void* arg);
+
+// 等组内任务全部完成，等待期间帮忙执行池中的任务
+void taskGroup_wait(TaskGroup* group);
+
+// fn(lo, hi, arg) 处理 [lo, hi)
+typedef void (*ParallelForFn)(usize lo, usize hi, void* arg);
+
+// 把 [begin, end) 切成不小于 grain 的区间并行执行 fn，返回时全部完成；
+// 常用于按段下标遍历 SegmentTree（segmentTree_get_node 无锁）
+void threadPool_parallel_for(ThreadPool* pool, usize begin, usize end, usize grain,
+                             ParallelForFn fn, void* arg);
+
+#endif
@@ -0,0 +1,341 @@
+#include <stdlib.h>
+#include <string.h>
+#include "toast.h"
+
+/* ============================================================
+ * overflow pages
+ *
+ * A value is a chain of chunks: [ToastChunkHdr][len bytes], each header
+ * naming the next chunk's page / offset.  Chunks are carved from the tail
+ * page front to back; a page whose live byte count drops to zero goes on
+ * free_pages and is refilled from offset 0 when the tail next moves.
+ * ============================================================ */
+
+#define TOAST_NO_PAGE 0xFFFFFFFFu
+
+typedef struct
+{
+    u32 next_page; /* TOAST_NO_PAGE: last chunk */
+    u16 next_off;
+    u16 len;       /* data bytes following the header */
+} ToastChunkHdr;
+
+#define TOAST_CHUNK_HDR_SIZE ((u16)sizeof(ToastChunkHdr))
+
+static inline u8* toastStore_page(const ToastStore* ts, u32 page_no)
+{
+    return (u8*)segment_get_data(VECTOR_AT(&ts->pages, page_no, BlockSegment*));
+}
+
+static inline u32* toastStore_live(const ToastStore* ts, u32 page_no)
+{
+    return VECTOR_GET(&ts->live, page_no, u32);
+}
+
+static u32 toastStore_new_page(ToastStore* ts)
+{
+    BlockSegment* seg = BlockSegment_create2(0);
+    block_id_t bid = INVALID_BLOCK;
+    if (ts->block_manager)
+    {
+        bid = VCALL(ts->block_manager, get_free_block_id);
+        seg->block_manager = ts->block_manager;
+    }
+    seg->block_id = bid;
+    seg->block = Block_create(bid);
+    vector_push_back(&ts->pages, &seg);
+    u32 zero = 0;
+    vector_push_back(&ts->live, &zero);
+    return (u32)(vector_size(&ts->pages) - 1);
+}
+
+/* Move the tail to a reusable page, or a fresh one. */
+static void toastStore_advance_tail(ToastStore* ts)
+{
+    u32 page_no;
+    if (vector_pop_back(&ts->free_pages, &page_no) != 0) page_no = toastStore_new_page(ts);
+    ts->tail = page_no;
+    ts->tail_off = 0;
+}
+
+void ToastStore_init(ToastStore* ts, BlockManager* bm)
+{
+    Vector_init(&ts->pages, sizeof(BlockSegment*), 0);
+    Vector_init(&ts->live, sizeof(u32), 0);
+    Vector_init(&ts->free_pages, sizeof(u32), 0);
+    ts->block_manager = bm;
+    ts->tail = TOAST_NO_PAGE;
+    ts->tail_off = 0;
+    LWLockInit(&ts->lock, "ToastStore.lock");
+}
+
+void ToastStore_deinit(ToastStore* ts)
+{
+    for (usize i = 0; i < vector_size(&ts->pages); i++)
+    {
+        BlockSegment_destroy((SegmentBase*)VECTOR_AT(&ts->pages, i, BlockSegment*));
+    }
+    vector_deinit(&ts->pages);
+    vector_deinit(&ts->live);
+    vector_deinit(&ts->free_pages);
+    ts->tail = TOAST_NO_PAGE;
+}
+
+ToastPointer toastStore_put(ToastStore* ts, const u8* data, u32 len, u32 rawsize, u16 flags)
+{
+    ToastPointer ptr = {.rawsize = rawsize, .extsize = len, .flags = flags};
+    ToastChunkHdr* prev = NULL;
+    u32 done = 0;
+    LWLockAcquire(&ts->lock, LW_EXCLUSIVE);
+    do
+    {
+        /* a chunk needs its header plus at least one data byte */
+        if (ts->tail == TOAST_NO_PAGE || BLOCK_DATA_SIZE - ts->tail_off <= TOAST_CHUNK_HDR_SIZE)
+            toastStore_advance_tail(ts);
+        u32 room = (u32)BLOCK_DATA_SIZE - ts->tail_off - TOAST_CHUNK_HDR_SIZE;
+        u16 n = (u16)(len - done < room ? len - done : room);
+
+        u8* page = toastStore_page(ts, ts->tail);
+        ToastChunkHdr* hdr = (ToastChunkHdr*)(page + ts->tail_off);
+        hdr->next_page = TOAST_NO_PAGE;
+        hdr->next_off = 0;
+        hdr->len = n;
+        memcpy((u8*)hdr + TOAST_CHUNK_HDR_SIZE, data + done, n);
+        if (prev)
+        {
+            prev->next_page = ts->tail;
+            prev->next_off = ts->tail_off;
+        }
+        else
+        {
+            ptr.page_no = ts->tail;
+            ptr.offset = ts->tail_off;
+        }
+        *toastStore_live(ts, ts->tail) += (u32)TOAST_CHUNK_HDR_SIZE + n;
+        ts->tail_off = (u16)(ts->tail_off + TOAST_CHUNK_HDR_SIZE + n);
+        prev = hdr;
+        done += n;
+    } while (done < len);
+    LWLockRelease(&ts->lock);
+    return ptr;
+}
+
+bool toastStore_fetch(const ToastStore* ts, const ToastPointer* ptr, u8* dst)
+{
+    LWLock* lock = (LWLock*)&ts->lock;
+    u32 page_no = ptr->page_no;
+    u16 off = ptr->offset;
+    u32 done = 0;
+    bool ok = true;
+    LWLockAcquire(lock, LW_SHARED);
+    while (ok && page_no != TOAST_NO_PAGE)
+    {
+        if (page_no >= vector_size(&ts->pages))
+        {
+            ok = false;
+            break;
+        }
+        const ToastChunkHdr* hdr = (const ToastChunkHdr*)(toastStore_page(ts, page_no) + off);
+        ok = done + hdr->len <= ptr->extsize;
+        if (!ok) break;
+        memcpy(dst + done, (const u8*)hdr + TOAST_CHUNK_HDR_SIZE, hdr->len);
+        done += hdr->len;
+        page_no = hdr->next_page;
+        off = hdr->next_off;
+    }
+    LWLockRelease(lock);
+    return ok && done == ptr->extsize;
+}
+
+void toastStore_delete(ToastStore* ts, const ToastPointer* ptr)
+{
+    u32 page_no = ptr->page_no;
+    u16 off = ptr->offset;
+    LWLockAcquire(&ts->lock, LW_EXCLUSIVE);
+    while (page_no != TOAST_NO_PAGE && page_no < vector_size(&ts->pages))
+    {
+        const ToastChunkHdr* hdr = (const ToastChunkHdr*)(toastStore_page(ts, page_no) + off);
+        u32 next_page = hdr->next_page;
+        u16 next_off = hdr->next_off;
+        u32* live = toastStore_live(ts, page_no);
+        *live -= (u32)TOAST_CHUNK_HDR_SIZE + hdr->len;
+        if (*live == 0)
+        {
+            if (page_no == ts->tail)
+                ts->tail_off = 0; /* rewind in place */
+            else
+                vector_push_back(&ts->free_pages, &page_no);
+        }
+        page_no = next_page;
+        off = next_off;
+    }
+    LWLockRelease(&ts->lock);
+}
+
+u32 toastStore_page_count(const ToastStore* ts)
+{
+    LWLock* lock = (LWLock*)&ts->lock;
+    LWLockAcquire(lock, LW_SHARED);
+    u32 n = (u32)vector_size(&ts->pages);
+    LWLockRelease(lock);
+    return n;
+}
+
+/* ============================================================
+ * LZ4 block format
+ *
+ * Sequence: token (hi nibble literal count, lo nibble match length - 4,
+ * 15 = more in following bytes of 255), literals, u16 LE offset, extra
+ * match length bytes.  The last sequence carries literals only; matches
+ * stop LZ_LAST_LITERALS bytes short of the end and start before
+ * LZ_MF_LIMIT, as in the reference format.
+ * ============================================================ */
+
+#define LZ_MIN_MATCH     4u
+#define LZ_LAST_LITERALS 5u
+#define LZ_MF_LIMIT      12u
+#define LZ_MAX_OFFSET    65535u
+#define LZ_HASH_BITS     12u
+#define LZ_HASH_EMPTY    0xFFFFFFFFu
+
+static inline u32 lz_read32(const u8* p)
+{
+    u32 v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline u32 lz_hash(u32 v)
+{
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Write the 255-run continuation of a length whose nibble saturated. */
+static inline u8* lz_write_len(u8* op, usize len)
+{
+    while (len >= 255)
+    {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (u8)len;
+    return op;
+}
+
+static inline usize lz_len_bytes(usize len)
+{
+    return len >= 15 ? (len - 15) / 255 + 1 : 0;
+}
+
+usize toast_compress(const u8* src, usize n, u8* dst, usize cap)
+{
+    u32 table[1u << LZ_HASH_BITS];
+    memset(table, 0xFF, sizeof(table));
+    const u8* ip = src;
+    const u8* anchor = src;
+    const u8* end = src + n;
+    u8* op = dst;
+    u8* oend = dst + cap;
+
+    if (n > LZ_MF_LIMIT)
+    {
+        const u8* mflimit = end - LZ_MF_LIMIT;
+        const u8* matchlimit = end - LZ_LAST_LITERALS;
+        while (ip < mflimit)
+        {
+            u32 seq = lz_read32(ip);
+            u32 h = lz_hash(seq);
+            u32 ref_pos = table[h];
+            table[h] = (u32)(ip - src);
+            if (ref_pos == LZ_HASH_EMPTY || (usize)(ip - src) - ref_pos > LZ_MAX_OFFSET ||
+                lz_read32(src + ref_pos) != seq)
+            {
+                ip++;
+                continue;
+            }
+            const u8* ref = src + ref_pos;
+            const u8* m = ip + LZ_MIN_MATCH;
+            const u8* r = ref + LZ_MIN_MATCH;
+            while (m < matchlimit && *m == *r)
+            {
+                m++;
+                r++;
+            }
+            usize lit = (usize)(ip - anchor);
+            usize mlen = (usize)(m - ip) - LZ_MIN_MATCH;
+            usize need = 1 + lz_len_bytes(lit) + lit + 2 + lz_len_bytes(mlen);
+            if ((usize)(oend - op) < need) return 0;
+
+            u8* token = op++;
+            *token = (u8)((lit >= 15 ? 15 : lit) << 4);
+            if (lit >= 15) op = lz_write_len(op, lit - 15);
+            memcpy(op, anchor, lit);
+            op += lit;
+            u16 off = (u16)(ip - ref);
+            *op++ = (u8)(off & 0xFF);
+            *op++ = (u8)(off >> 8);
+            *token |= (u8)(mlen >= 15 ? 15 : mlen);
+            if (mlen >= 15) op = lz_write_len(op, mlen - 15);
+
+            ip = m;
+            anchor = ip;
+        }
+    }
+
+    usize lit = (usize)(end - anchor);
+    usize need = 1 + lz_len_bytes(lit) + lit;
+    if ((usize)(oend - op) < need) return 0;
+    *op++ = (u8)((lit >= 15 ? 15 : lit) << 4);
+    if (lit >= 15) op = lz_write_len(op, lit - 15);
+    memcpy(op, anchor, lit);
+    op += lit;
+
+    usize out = (usize)(op - dst);
+    return out < n ? out : 0;
+}
+
+/* Read a saturated length's continuation bytes; false when the input runs out. */
+static inline bool lz_read_len(const u8** ip, const u8* iend, usize* len)
+{
+    u8 b;
+    do
+    {
+        if (*ip >= iend) return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+bool toast_decompress(const u8* src, usize n, u8* dst, usize rawsize)
+{
+    const u8* ip = src;
+    const u8* iend = src + n;
+    u8* op = dst;
+    u8* oend = dst + rawsize;
+
+    while (ip < iend)
+    {
+        u8 token = *ip++;
+        usize lit = token >> 4;
+        if (lit == 15 && !lz_read_len(&ip, iend, &lit)) return false;
+        if (lit > (usize)(iend - ip) || lit > (usize)(oend - op)) return false;
+        memcpy(op, ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip >= iend) break; /* last sequence: literals only */
+
+        if (iend - ip < 2) return false;
+        usize off = (usize)ip[0] | ((usize)ip[1] << 8);
+        ip += 2;
+        if (off == 0 || off > (usize)(op - dst)) return false;
+        usize mlen = token & 15u;
+        if (mlen == 15 && !lz_read_len(&ip, iend, &mlen)) return false;
+        mlen += LZ_MIN_MATCH;
+        if (mlen > (usize)(oend - op)) return false;
+        const u8* m = op - off;
+        for (usize i = 0; i < mlen; i++) op[i] = m[i]; /* may overlap */
+        op += mlen;
+    }
+    return op == oend;
+}
@@ -0,0 +1,86 @@
+/**
+ * toast.h — out-of-line storage for oversized varlena values (PG TOAST style)
+ *
+ * When a heap tuple would exceed TOAST_TUPLE_THRESHOLD, heapStore shrinks it
+ * before placement:
+ *   1. compress the largest TEXT / JSONB values inline (LZ4-style block
+ *      format, toast_compress);
+ *   2. if still too large, move the largest values out of line into the
+ *      store's overflow pages and leave a ToastPointer in the tuple.
+ *
+ * On-page varlena words carry the form in their two high bits:
+ *   plain       [u32 len][data]                        (TEXT len = content,
+ *                                                       JSONB len = total)
+ *   compressed  [u32 VARLENA_COMPRESSED | n][u32 rawsize][n - 4 bytes]
+ *   external    [u32 VARLENA_EXTERNAL | 16][ToastPointer]
+ * rawsize is the size of the plain varlena (header included), so
+ * decompressing yields exactly the bytes a plain value would hold.
+ *
+ * Overflow pages hold chains of chunks; a value is one chain and may span
+ * pages.  Per-page live byte counts let vacuum hand fully freed pages back
+ * for reuse, so the heap itself stays dense.  ToastStore.lock serializes
+ * writers against readers; it is a leaf lock, taken under heap page latches.
+ */
+#ifndef TOAST_H
+#define TOAST_H
+
+#include "vb_type.h"
+#include "vector.h"
+#include "segment.h"
+
+#define VARLENA_EXTERNAL   0x80000000u
+#define VARLENA_COMPRESSED 0x40000000u
+#define VARLENA_TAG_MASK   (VARLENA_EXTERNAL | VARLENA_COMPRESSED)
+#define VARLENA_LEN_MASK   0x3FFFFFFFu
+
+#define TOAST_TUPLE_THRESHOLD (BLOCK_SIZE / 4) /* toast tuples larger than this */
+#define TOAST_MIN_COMPRESS    32u              /* values below this are left alone */
+
+#define TOAST_PTR_COMPRESSED 0x0001u
+
+/* Out-of-line value reference stored inside the heap tuple (16 bytes). */
+typedef struct
+{
+    u32 rawsize;  /* plain varlena size once detoasted */
+    u32 extsize;  /* bytes stored in the chunk chain */
+    u32 page_no;  /* first chunk: overflow page ... */
+    u16 offset;   /* ... and byte offset within it */
+    u16 flags;    /* TOAST_PTR_COMPRESSED: chain holds an LZ stream */
+} ToastPointer;
+
+typedef struct
+{
+    Vector pages;      /* vector<BlockSegment*> — overflow pages */
+    Vector live;       /* vector<u32> — bytes of live chunks per page */
+    Vector free_pages; /* vector<u32> — emptied pages ready for reuse */
+    u32 tail;          /* page currently being filled */
+    u16 tail_off;      /* next free byte in tail */
+    BlockManager* block_manager;
+    LWLock lock;       /* EXCLUSIVE: put / delete, SHARED: fetch */
+} ToastStore;
+
+void ToastStore_init(ToastStore* ts, BlockManager* bm);
+void ToastStore_deinit(ToastStore* ts);
+
+/** Store len bytes out of line; flags go into the returned pointer. */
+ToastPointer toastStore_put(ToastStore* ts, const u8* data, u32 len, u32 rawsize, u16 flags);
+
+/** Copy the ptr->extsize stored bytes into dst.  false if the chain is damaged. */
+bool toastStore_fetch(const ToastStore* ts, const ToastPointer* ptr, u8* dst);
+
+/** Release a value's chunks; pages left without live chunks become reusable. */
+void toastStore_delete(ToastStore* ts, const ToastPointer* ptr);
+
+/** Number of overflow pages (allocated, including reusable ones). */
+u32 toastStore_page_count(const ToastStore* ts);
+
+/**
+ * LZ4 block-format compression.  Returns the compressed size, or 0 when the
+ * output would not fit in cap or would not be smaller than n.
+ */
+usize toast_compress(const u8* src, usize n, u8* dst, usize cap);
+
+/** Decompress exactly rawsize bytes into dst; false on a malformed stream. */
+bool toast_decompress(const u8* src, usize n, u8* dst, usize rawsize);
+
+#endif
@@ -0,0 +1,355 @@
+#include <stdlib.h>
+#include <string.h>
+#include "transaction.h"
+#include "epoch.h"
+
+#define CLOG_BITS_PER_XACT 2u
+#define CLOG_XACT_MASK     0x03u
+
+static inline u64 clog_page(TxnId xid)
+{
+    return xid / CLOG_XACTS_PER_PAGE;
+}
+
+static inline _Atomic(_Atomic u8*)* clog_slot(TransactionManager* mgr, u64 pg)
+{
+    return &mgr->clog[pg % CLOG_MAX_PAGES];
+}
+
+static inline usize clog_byte(TxnId xid)
+{
+    return (usize)((xid % CLOG_XACTS_PER_PAGE) / CLOG_XACTS_PER_BYTE);
+}
+
+static inline u32 clog_shift(TxnId xid)
+{
+    return (u32)(xid % CLOG_XACTS_PER_BYTE) * CLOG_BITS_PER_XACT;
+}
+
+void TransactionManager_init(TransactionManager* mgr)
+{
+    atomic_init(&mgr->next_xid, FIRST_NORMAL_TXN_ID);
+    mgr->clog = calloc(CLOG_MAX_PAGES, sizeof(*mgr->clog));
+    atomic_init(&mgr->clog_base, 0);
+    atomic_init(&mgr->clog_aborted, NULL);
+    atomic_flag_clear(&mgr->clog_truncating);
+    SpinLockInit(&mgr->lock);
+    mgr->active_cap = 16;
+    mgr->active = malloc(mgr->active_cap * sizeof(TxnId));
+    mgr->nactive = 0;
+    mgr->snapshots_cap = 16;
+    mgr->snapshots = malloc(mgr->snapshots_cap * sizeof(Snapshot*));
+    mgr->nsnapshots = 0;
+}
+
+void TransactionManager_deinit(TransactionManager* mgr)
+{
+    if (!mgr->clog) return;
+    for (usize i = 0; i < CLOG_MAX_PAGES; i++) free((void*)atomic_load(&mgr->clog[i]));
+    free(mgr->clog);
+    mgr->clog = NULL;
+    free(atomic_load(&mgr->clog_aborted));
+    epoch_reclaim(); /* truncated pages still waiting for readers to leave */
+    for (u32 i = 0; i < mgr->nsnapshots; i++)
+    {
+        free(mgr->snapshots[i]->xip);
+        free(mgr->snapshots[i]);
+    }
+    free(mgr->snapshots);
+    free(mgr->active);
+    SpinLockFree(&mgr->lock);
+}
+
+/*
+ * Make sure page pg is allocated.  Runs without mgr->lock: the page is
+ * calloc'd first and installed with a CAS (a losing racer frees its copy).
+ * Starting a new page is also when the clog is truncated.  False when the
+ * ring is full or out of memory.
+ */
+static bool clog_ensure_page(TransactionManager* mgr, u64 pg)
+{
+    if (pg >= atomic_load(&mgr->clog_base) + CLOG_MAX_PAGES)
+    {
+        transactionManager_truncate_clog(mgr);
+        if (pg >= atomic_load(&mgr->clog_base) + CLOG_MAX_PAGES) return false;
+    }
+    _Atomic(_Atomic u8*)* slot = clog_slot(mgr, pg);
+    if (atomic_load(slot) != NULL) return true;
+
+    _Atomic u8* page = calloc(CLOG_PAGE_SIZE, 1);
+    if (!page) return false;
+    _Atomic u8* expected = NULL;
+    if (!atomic_compare_exchange_strong(slot, &expected, page))
+        free((void*)page);
+    else if (pg > 0)
+        transactionManager_truncate_clog(mgr);
+    return true;
+}
+
+/* Xids are handed out in order under mgr->lock, so active[] stays sorted and
+ * a snapshot can never observe next_xid ahead of the in-progress list.  The
+ * xid's clog page is allocated beforehand, outside the spinlock; if another
+ * backend moves next_xid onto a later page meanwhile, try again. */
+TxnId transactionManager_begin(TransactionManager* mgr)
+{
+    for (;;)
+    {
+        u64 pg = clog_page(atomic_load(&mgr->next_xid));
+        if (!clog_ensure_page(mgr, pg)) return 0; /* INVALID_TXN_ID */
+
+        SpinLockAcquire(&mgr->lock);
+        TxnId xid = atomic_load(&mgr->next_xid);
+        if (clog_page(xid) != pg)
+        {
+            SpinLockRelease(&mgr->lock);
+            continue;
+        }
+        if (mgr->nactive == mgr->active_cap)
+        {
+            TxnId* grown = realloc(mgr->active, mgr->active_cap * 2 * sizeof(TxnId));
+            if (!grown)
+            {
+                SpinLockRelease(&mgr->lock);
+                return 0;
+            }
+            mgr->active = grown;
+            mgr->active_cap *= 2;
+        }
+        atomic_store(&mgr->next_xid, xid + 1);
+        mgr->active[mgr->nactive++] = xid;
+        SpinLockRelease(&mgr->lock);
+        return xid;
+    }
+}
+
+static void transactionManager_finish(TransactionManager* mgr, TxnId xid, TxnStatus status)
+{
+    /* clog first: once xid leaves active[], new snapshots consult the clog.
+     * A running xid is never below the oldest xmin, so its page is not truncated. */
+    _Atomic u8* page = atomic_load(clog_slot(mgr, clog_page(xid)));
+    atomic_fetch_or(&page[clog_byte(xid)], (u8)(status << clog_shift(xid)));
+
+    SpinLockAcquire(&mgr->lock);
+    for (u32 i = 0; i < mgr->nactive; i++)
+    {
+        if (mgr->active[i] != xid) continue;
+        memmove(&mgr->active[i], &mgr->active[i + 1], (mgr->nactive - i - 1) * sizeof(TxnId));
+        mgr->nactive--;
+        break;
+    }
+    SpinLockRelease(&mgr->lock);
+}
+
+void transactionManager_commit(TransactionManager* mgr, TxnId xid)
+{
+    transactionManager_finish(mgr, xid, TXN_STATUS_COMMITTED);
+}
+
+void transactionManager_abort(TransactionManager* mgr, TxnId xid)
+{
+    transactionManager_finish(mgr, xid, TXN_STATUS_ABORTED);
+}
+
+static bool clog_aborted_contains(const ClogAborted* list, TxnId xid)
+{
+    if (!list) return false;
+    u64 lo = 0, hi = list->n;
+    while (lo < hi)
+    {
+        u64 mid = lo + (hi - lo) / 2;
+        if (list->xids[mid] < xid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < list->n && list->xids[lo] == xid;
+}
+
+/* Truncated xids finished before the oldest xmin: committed unless listed as aborted. */
+static TxnStatus clog_truncated_status(TransactionManager* mgr, TxnId xid)
+{
+    return clog_aborted_contains(atomic_load(&mgr->clog_aborted), xid) ? TXN_STATUS_ABORTED
+                                                                        : TXN_STATUS_COMMITTED;
+}
+
+TxnStatus transactionManager_status(const TransactionManager* cmgr, TxnId xid)
+{
+    TransactionManager* mgr = (TransactionManager*)cmgr;
+    u64 pg = clog_page(xid);
+    TxnStatus status = TXN_STATUS_IN_PROGRESS;
+
+    /* Truncation publishes the aborted list, then clog_base, then clears the
+     * slots and retires the pages; the epoch keeps a page we loaded alive.  A
+     * cleared or reused slot is caught by re-reading clog_base afterwards. */
+    epoch_enter();
+    u64 base = atomic_load(&mgr->clog_base);
+    if (pg < base)
+        status = clog_truncated_status(mgr, xid);
+    else if (pg < base + CLOG_MAX_PAGES)
+    {
+        _Atomic u8* page = atomic_load(clog_slot(mgr, pg));
+        if (page)
+            status = (TxnStatus)((atomic_load(&page[clog_byte(xid)]) >> clog_shift(xid)) &
+                                 CLOG_XACT_MASK);
+        if (pg < atomic_load(&mgr->clog_base)) status = clog_truncated_status(mgr, xid);
+    }
+    epoch_exit();
+    return status;
+}
+
+void transactionManager_truncate_clog(TransactionManager* mgr)
+{
+    if (atomic_flag_test_and_set(&mgr->clog_truncating)) return; /* someone else is at it */
+
+    u64 base = atomic_load(&mgr->clog_base);
+    u64 cut = clog_page(transactionManager_oldest_xmin(mgr));
+    if (cut <= base)
+    {
+        atomic_flag_clear(&mgr->clog_truncating);
+        return;
+    }
+
+    /* Collect the aborted xids of pages [base, cut) after the existing list. */
+    ClogAborted* old = atomic_load(&mgr->clog_aborted);
+    u64 n = old ? old->n : 0, cap = n + 64;
+    ClogAborted* list = malloc(sizeof(ClogAborted) + cap * sizeof(TxnId));
+    if (!list)
+    {
+        atomic_flag_clear(&mgr->clog_truncating);
+        return;
+    }
+    if (n > 0) memcpy(list->xids, old->xids, n * sizeof(TxnId));
+    for (u64 pg = base; pg < cut; pg++)
+    {
+        _Atomic u8* page = atomic_load(clog_slot(mgr, pg));
+        if (!page) continue;
+        for (u32 b = 0; b < CLOG_PAGE_SIZE; b++)
+        {
+            u8 bits = atomic_load_explicit(&page[b], memory_order_relaxed);
+            for (u32 k = 0; k < CLOG_XACTS_PER_BYTE; k++)
+            {
+                if (((bits >> (k * CLOG_BITS_PER_XACT)) & CLOG_XACT_MASK) != TXN_STATUS_ABORTED)
+                    continue;
+                if (n == cap)
+                {
+                    cap *= 2;
+                    ClogAborted* grown = realloc(list, sizeof(ClogAborted) + cap * sizeof(TxnId));
+                    if (!grown)
+                    {
+                        free(list);
+                        atomic_flag_clear(&mgr->clog_truncating);
+                        return;
+                    }
+                    list = grown;
+                }
+                list->xids[n++] = pg * CLOG_XACTS_PER_PAGE + b * CLOG_XACTS_PER_BYTE + k;
+            }
+        }
+    }
+    list->n = n;
+
+    atomic_store(&mgr->clog_aborted, list);
+    atomic_store(&mgr->clog_base, cut);
+    for (u64 pg = base; pg < cut; pg++)
+    {
+        _Atomic u8* page = atomic_exchange(clog_slot(mgr, pg), NULL);
+        if (page) epoch_retire((void*)page, free);
+    }
+    if (old) epoch_retire(old, free);
+    atomic_flag_clear(&mgr->clog_truncating);
+    epoch_reclaim();
+}
+
+Snapshot* transactionManager_get_snapshot(TransactionManager* mgr, TxnId xid)
+{
+    Snapshot* snap = malloc(sizeof(Snapshot));
+    if (!snap) return NULL;
+    snap->xid = xid;
+    snap->mgr = mgr;
+
+    SpinLockAcquire(&mgr->lock);
+    snap->xmax = atomic_load(&mgr->next_xid);
+    snap->xmin = mgr->nactive > 0 ? mgr->active[0] : snap->xmax;
+    snap->xcnt = mgr->nactive;
+    snap->xip = NULL;
+    if (mgr->nactive > 0)
+    {
+        snap->xip = malloc(mgr->nactive * sizeof(TxnId));
+        if (!snap->xip) goto fail;
+        memcpy(snap->xip, mgr->active, mgr->nactive * sizeof(TxnId));
+    }
+    if (mgr->nsnapshots == mgr->snapshots_cap)
+    {
+        Snapshot** grown = realloc(mgr->snapshots, mgr->snapshots_cap * 2 * sizeof(Snapshot*));
+        if (!grown) goto fail;
+        mgr->snapshots = grown;
+        mgr->snapshots_cap *= 2;
+    }
+    mgr->snapshots[mgr->nsnapshots++] = snap;
+    SpinLockRelease(&mgr->lock);
+    return snap;
+
+fail:
+    SpinLockRelease(&mgr->lock);
+    free(snap->xip);
+    free(snap);
+    return NULL;
+}
+
+void transactionManager_release_snapshot(TransactionManager* mgr, Snapshot* snapshot)
+{
+    if (!snapshot) return;
+    SpinLockAcquire(&mgr->lock);
+    for (u32 i = 0; i < mgr->nsnapshots; i++)
+    {
+        if (mgr->snapshots[i] != snapshot) continue;
+        mgr->snapshots[i] = mgr->snapshots[--mgr->nsnapshots];
+        break;
+    }
+    SpinLockRelease(&mgr->lock);
+    free(snapshot->xip);
+    free(snapshot);
+}
+
+TxnId transactionManager_oldest_xmin(TransactionManager* mgr)
+{
+    SpinLockAcquire(&mgr->lock);
+    TxnId oldest = atomic_load(&mgr->next_xid);
+    if (mgr->nactive > 0 && mgr->active[0] < oldest) oldest = mgr->active[0];
+    for (u32 i = 0; i < mgr->nsnapshots; i++)
+    {
+        if (mgr->snapshots[i]->xmin < oldest) oldest = mgr->snapshots[i]->xmin;
+    }
+    SpinLockRelease(&mgr->lock);
+    return oldest;
+}
+
+static bool snapshot_xip_contains(const Snapshot* snapshot, TxnId xid)
+{
+    u32 lo = 0, hi = snapshot->xcnt;
+    while (lo < hi)
+    {
+        u32 mid = lo + (hi - lo) / 2;
+        if (snapshot->xip[mid] == xid) return true;
+        if (snapshot->xip[mid] < xid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return false;
+}
+
+bool snapshot_xid_visible(const Snapshot* snapshot, TxnId xid)
+{
+    if (xid == 0) return false;
+    if (xid == snapshot->xid) return true;
+    if (xid >= snapshot->xmax) return false;
+    if (xid >= snapshot->xmin && snapshot_xip_contains(snapshot, xid)) return false;
+    return transactionManager_status(snapshot->mgr, xid) == TXN_STATUS_COMMITTED;
+}
+
+bool snapshot_tuple_visible(const Snapshot* snapshot, TxnId xmin, TxnId xmax)
+{
+    if (!snapshot_xid_visible(snapshot, xmin)) return false;
+    return xmax == 0 || !snapshot_xid_visible(snapshot, xmax);
+}
@@ -1,4 +1,117 @@
+/**
+ * transaction.h — transaction manager, commit log and MVCC snapshots
+ *
+ * A PostgreSQL-style, in-process port:
+ *   - xids come from an atomic counter, starting at FIRST_NORMAL_TXN_ID;
+ *   - the commit log (clog) keeps two status bits per xid in fixed-size
+ *     pages that are allocated on demand and never move, so status reads
+ *     are lock-free;
+ *   - clog pages wholly below the oldest xmin are truncated: their aborted
+ *     xids move to a sorted list and the pages are freed through epoch.h,
+ *     so every older xid reads as committed unless listed.  The page
+ *     directory is a ring of CLOG_MAX_PAGES, which bounds the distance
+ *     between the oldest xmin and the newest xid, not the xid count;
+ *   - a Snapshot records xmin / xmax / the in-progress list at the moment
+ *     it is taken.  A tuple is visible iff its inserter committed before
+ *     the snapshot and its deleter (if any) did not.
+ *
+ * Registered snapshots pin the vacuum horizon: transactionManager_oldest_xmin()
+ * is the oldest xid any running transaction or live snapshot may still see,
+ * and heapStore_vacuum never reclaims a tuple deleted at or after it.
+ */
 #ifndef TRANSACTION_H
 #define TRANSACTION_H
+#include <stdatomic.h>
 #include "vb_type.h"
-#endif
\ No newline at end of file
+#include "lock.h"
+
+#define FIRST_NORMAL_TXN_ID ((TxnId)1)
+
+#define CLOG_XACTS_PER_BYTE 4u
+#define CLOG_PAGE_SIZE      8192u
+#define CLOG_XACTS_PER_PAGE (CLOG_PAGE_SIZE * CLOG_XACTS_PER_BYTE)
+#define CLOG_MAX_PAGES      16384u /* ring size: 512M xids between oldest xmin and next xid */
+
+typedef enum
+{
+    TXN_STATUS_IN_PROGRESS = 0,
+    TXN_STATUS_COMMITTED = 1,
+    TXN_STATUS_ABORTED = 2,
+} TxnStatus;
+
+typedef struct TransactionManager TransactionManager;
+
+typedef struct Snapshot
+{
+    TxnId xmin;  /* every xid < xmin had finished when the snapshot was taken */
+    TxnId xmax;  /* every xid >= xmax had not started yet: invisible */
+    TxnId* xip;  /* in-progress xids in [xmin, xmax), ascending */
+    u32 xcnt;
+    TxnId xid;   /* owning transaction (its own changes are visible), or 0 */
+    TransactionManager* mgr;
+} Snapshot;
+
+/* Aborted xids of truncated clog pages, ascending.  Immutable once published. */
+typedef struct ClogAborted
+{
+    u64 n;
+    TxnId xids[];
+} ClogAborted;
+
+struct TransactionManager
+{
+    _Atomic TxnId next_xid;   /* next xid to hand out */
+    _Atomic(_Atomic u8*)* clog; /* ring [CLOG_MAX_PAGES]: page p at clog[p % CLOG_MAX_PAGES] */
+    _Atomic u64 clog_base;    /* pages below this are truncated */
+    _Atomic(ClogAborted*) clog_aborted; /* aborted xids below clog_base's first xid */
+    atomic_flag clog_truncating; /* one truncation at a time */
+    slock_t lock;             /* protects active[] and snapshots[] */
+    TxnId* active;            /* running xids, ascending */
+    u32 nactive;
+    u32 active_cap;
+    Snapshot** snapshots;     /* registered (live) snapshots */
+    u32 nsnapshots;
+    u32 snapshots_cap;
+};
+
+void TransactionManager_init(TransactionManager* mgr);
+void TransactionManager_deinit(TransactionManager* mgr);
+
+/**
+ * Start a transaction: allocate an xid and mark it in progress.  Returns
+ * INVALID_TXN_ID when the clog ring is full (a transaction or snapshot holds
+ * the oldest xmin CLOG_MAX_PAGES pages back) or a clog page cannot be
+ * allocated.
+ */
+TxnId transactionManager_begin(TransactionManager* mgr);
+void transactionManager_commit(TransactionManager* mgr, TxnId xid);
+void transactionManager_abort(TransactionManager* mgr, TxnId xid);
+
+/** Clog lookup; xids that never began read as TXN_STATUS_IN_PROGRESS. */
+TxnStatus transactionManager_status(const TransactionManager* mgr, TxnId xid);
+
+/**
+ * Take and register a snapshot.  xid is the owning transaction (0 for a
+ * read-only snapshot).  Release with transactionManager_release_snapshot().
+ * Returns NULL on allocation failure.
+ */
+Snapshot* transactionManager_get_snapshot(TransactionManager* mgr, TxnId xid);
+void transactionManager_release_snapshot(TransactionManager* mgr, Snapshot* snapshot);
+
+/** Oldest xid still visible to some running transaction or registered snapshot. */
+TxnId transactionManager_oldest_xmin(TransactionManager* mgr);
+
+/**
+ * Free the clog pages wholly below the oldest xmin, keeping their aborted
+ * xids.  begin() calls this whenever it starts a new page; callers may also
+ * call it after long transactions finish.
+ */
+void transactionManager_truncate_clog(TransactionManager* mgr);
+
+/** True if xid's effects are visible to snapshot (committed before it, or own). */
+bool snapshot_xid_visible(const Snapshot* snapshot, TxnId xid);
+
+/** MVCC visibility of a tuple with the given t_xmin / t_xmax. */
+bool snapshot_tuple_visible(const Snapshot* snapshot, TxnId xmin, TxnId xmax);
+
+#endif
@@ -52,3 +52,42 @@ data_ptr_t VectorBase_get_data(VectorBase* vector)
 {
     return vector->data;
 }
+
+#define VECTOR_MINMAX(ctype)                                   \
+    do                                                         \
+    {                                                          \
+        const ctype* values = (const ctype*)vector->data;      \
+        for (usize i = 0; i < vector->count; i++)              \
+        {                                                      \
+            f64 v = (f64)values[i];                            \
+            if (v < *min) *min = v;                            \
+            if (v > *max) *max = v;                            \
+        }                                                      \
+    } while (0)
+
+void VectorBase_update_minmax(VectorBase* vector, f64* min, f64* max)
+{
+    switch (vector->type)
+    {
+        case TYPE_INT8:
+            VECTOR_MINMAX(int8_t);
+            break;
+        case TYPE_INT16:
+            VECTOR_MINMAX(i16);
+            break;
+        case TYPE_INT32:
+            VECTOR_MINMAX(i32);
+            break;
+        case TYPE_INT64:
+            VECTOR_MINMAX(i64);
+            break;
+        case TYPE_FLOAT32:
+            VECTOR_MINMAX(f32);
+            break;
+        case TYPE_FLOAT64:
+            VECTOR_MINMAX(f64);
+            break;
+        default:
+            break;
+    }
+}
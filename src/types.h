@@ -36,4 +36,7 @@ usize VectorBase_size(VectorBase* vector);
 
 data_ptr_t VectorBase_get_data(VectorBase* vector);
 
+// 用 vector 中的值扩展 [*min, *max]（zone map 统计用，NaN 被忽略）
+void VectorBase_update_minmax(VectorBase* vector, f64* min, f64* max);
+
 #endif
\ No newline at end of file
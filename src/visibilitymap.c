@@ -0,0 +1,66 @@
+#include <stdlib.h>
+#include <string.h>
+#include "visibilitymap.h"
+
+#define VM_INIT_BYTES 16
+
+static inline usize vm_byte(u32 page_no)
+{
+    return page_no / VM_PAGES_PER_BYTE;
+}
+
+static inline u32 vm_shift(u32 page_no)
+{
+    return (page_no % VM_PAGES_PER_BYTE) * VM_BITS_PER_PAGE;
+}
+
+void VisibilityMap_init(VisibilityMap* vm)
+{
+    vm->nbytes = VM_INIT_BYTES;
+    vm->bits = calloc(vm->nbytes, 1);
+}
+
+void VisibilityMap_deinit(VisibilityMap* vm)
+{
+    free(vm->bits);
+    vm->bits = NULL;
+    vm->nbytes = 0;
+}
+
+u8 visibilityMap_get(const VisibilityMap* vm, u32 page_no)
+{
+    usize byte = vm_byte(page_no);
+    if (byte >= vm->nbytes) return 0;
+    return (u8)((vm->bits[byte] >> vm_shift(page_no)) & (VM_ALL_VISIBLE | VM_ALL_FROZEN));
+}
+
+void visibilityMap_set(VisibilityMap* vm, u32 page_no, u8 flags)
+{
+    usize byte = vm_byte(page_no);
+    if (byte >= vm->nbytes)
+    {
+        usize nbytes = vm->nbytes;
+        while (byte >= nbytes) nbytes *= 2;
+        vm->bits = realloc(vm->bits, nbytes);
+        memset(vm->bits + vm->nbytes, 0, nbytes - vm->nbytes);
+        vm->nbytes = nbytes;
+    }
+    vm->bits[byte] |= (u8)((flags & (VM_ALL_VISIBLE | VM_ALL_FROZEN)) << vm_shift(page_no));
+}
+
+void visibilityMap_clear(VisibilityMap* vm, u32 page_no)
+{
+    usize byte = vm_byte(page_no);
+    if (byte >= vm->nbytes) return;
+    vm->bits[byte] &= (u8) ~((VM_ALL_VISIBLE | VM_ALL_FROZEN) << vm_shift(page_no));
+}
+
+u32 visibilityMap_count(const VisibilityMap* vm, u32 npages, u8 flags)
+{
+    u32 n = 0;
+    for (u32 p = 0; p < npages; p++)
+    {
+        if ((visibilityMap_get(vm, p) & flags) == flags) n++;
+    }
+    return n;
+}
@@ -0,0 +1,46 @@
+/**
+ * visibilitymap.h — per-HeapStore visibility map (PostgreSQL VM style)
+ *
+ * Two bits per heap page, indexed by page number (position in tree.nodes):
+ *   VM_ALL_VISIBLE — every tuple on the page is live (t_xmax == 0) and was
+ *                    inserted before the oldest snapshot: scans may skip the
+ *                    per-tuple t_xmin / t_xmax checks, vacuum may skip the page.
+ *   VM_ALL_FROZEN  — all-visible and needs no freezing.  Xids are 64-bit and
+ *                    never wrap, so vacuum sets it together with ALL_VISIBLE;
+ *                    the bit is kept so the on-page format matches PG's.
+ *
+ * Bits are only ever set by vacuum and cleared by any insert / delete /
+ * update touching the page.  Access is protected by HeapStore.map_lock.
+ */
+#ifndef VISIBILITYMAP_H
+#define VISIBILITYMAP_H
+
+#include "vb_type.h"
+
+#define VM_ALL_VISIBLE    0x01u
+#define VM_ALL_FROZEN     0x02u
+#define VM_BITS_PER_PAGE  2u
+#define VM_PAGES_PER_BYTE (8u / VM_BITS_PER_PAGE)
+
+typedef struct
+{
+    u8* bits;      /* VM_BITS_PER_PAGE bits per page */
+    usize nbytes;  /* allocated bytes */
+} VisibilityMap;
+
+void VisibilityMap_init(VisibilityMap* vm);
+void VisibilityMap_deinit(VisibilityMap* vm);
+
+/** Return VM_ALL_VISIBLE / VM_ALL_FROZEN bits of page_no (0 if never set). */
+u8 visibilityMap_get(const VisibilityMap* vm, u32 page_no);
+
+/** OR flags into page_no's bits (grows the map if needed). */
+void visibilityMap_set(VisibilityMap* vm, u32 page_no, u8 flags);
+
+/** Clear both bits of page_no — call on every modification of the page. */
+void visibilityMap_clear(VisibilityMap* vm, u32 page_no);
+
+/** Number of pages among the first npages that have all of `flags` set. */
+u32 visibilityMap_count(const VisibilityMap* vm, u32 npages, u8 flags);
+
+#endif
@@ -0,0 +1,271 @@
+/**
+ * test_catalog_rcu.c
+ *
+ * Tests for the copy-on-write catalog read path (catalog.h):
+ *   catalogSet_get_entry / catalogSet_scan    (lock-free snapshot reads)
+ *   catalog_get_entry_by_oid /
+ *   catalog_get_table_by_oid                  (OID lookups, drop hides them)
+ *   concurrent DDL vs. readers                (snapshot and OID map growth)
+ *   table entry memory                        (per-entry context, freed with the entry)
+ *
+ * Compile & run:
+ *   cd tests && make test_catalog_rcu && ./test_catalog_rcu
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/catalog.h"
+#include "../src/epoch.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+static int create_schema(Catalog* catalog, const char* name)
+{
+    CreateSchemaInfo info;
+    memset(&info, 0, sizeof(info));
+    info.schema_name = (char*)name;
+    return catalog_create_schema(catalog, &info);
+}
+
+static void count_live(CatalogEntry* entry, void* ctx)
+{
+    if (!entry->deleted) (*(int*)ctx)++;
+}
+
+/* ================================================================
+ * Test 1: snapshot lookups follow create / drop
+ * ================================================================ */
+static void test_snapshot_lookup(void)
+{
+    printf("\n=== Test snapshot_lookup ===\n");
+
+    Catalog* catalog = catalog_create();
+    CHECK(create_schema(catalog, "main") == 0, "create main");
+    CHECK(create_schema(catalog, "s1") == 0, "create s1");
+    CHECK(create_schema(catalog, "s1") == -2, "duplicate s1 rejected");
+
+    SchemaCatalogEntry* s1 = catalog_get_schema(catalog, "s1");
+    CHECK(s1 && strcmp(s1->base.name, "s1") == 0, "s1 found by name");
+    CHECK(catalog_get_schema(catalog, "nope") == NULL, "missing name returns NULL");
+
+    int live = 0;
+    catalogSet_scan(&catalog->schemas, count_live, &live);
+    CHECK(live == 2, "scan sees both schemas");
+
+    CHECK(catalog_drop_schema(catalog, "s1") == 0, "drop s1");
+    CHECK(catalog_get_schema(catalog, "s1") == NULL, "dropped schema hidden");
+    CHECK(create_schema(catalog, "s1") == 0, "re-create s1 after drop");
+    SchemaCatalogEntry* again = catalog_get_schema(catalog, "s1");
+    CHECK(again && again != s1, "re-created schema is a new version");
+    catalog_destroy(catalog);
+}
+
+/* ================================================================
+ * Test 2: OIDs are unique and follow drops
+ * ================================================================ */
+static void test_oid_lookup(void)
+{
+    printf("\n=== Test oid_lookup ===\n");
+
+    Catalog* catalog = catalog_create();
+    create_schema(catalog, "main");
+    create_schema(catalog, "other");
+    SchemaCatalogEntry* main_s = catalog_get_schema(catalog, "main");
+    SchemaCatalogEntry* other = catalog_get_schema(catalog, "other");
+    CHECK(main_s->base.oid != INVALID_OID && other->base.oid != INVALID_OID &&
+              main_s->base.oid != other->base.oid,
+          "schemas get distinct OIDs");
+    CHECK(catalog_get_entry_by_oid(catalog, other->base.oid) == &other->base,
+          "OID resolves to the entry");
+    CHECK(catalog_get_table_by_oid(catalog, other->base.oid) == NULL,
+          "table lookup rejects a schema OID");
+    CHECK(catalog_get_entry_by_oid(catalog, 1u << 20) == NULL, "unknown OID returns NULL");
+
+    ColumnDefinition col;
+    memset(&col, 0, sizeof(col));
+    col.type = SQLT_INTEGER;
+    CreateTableInfo tinfo = {"other", "t", false, &col, 1};
+    CHECK(catalog_create_table(catalog, &tinfo) == 0, "create other.t");
+    TableCatalogEntry* t = catalog_get_table(catalog, "other", "t");
+    CHECK(t && catalog_get_table_by_oid(catalog, t->base.oid) == t, "table resolves by name and OID");
+
+    catalog_drop_schema(catalog, "other");
+    CHECK(catalog_get_entry_by_oid(catalog, other->base.oid) == NULL, "dropped OID returns NULL");
+    CHECK(catalog_get_table_by_oid(catalog, t->base.oid) == NULL, "tables of a dropped schema hidden");
+    CHECK(catalog_get_entry_by_oid(catalog, main_s->base.oid) == &main_s->base,
+          "other OIDs unaffected");
+    catalog_destroy(catalog);
+}
+
+/* ================================================================
+ * Test 3: readers race DDL that grows the snapshot and OID map
+ * ================================================================ */
+#define DDL_SCHEMAS 2000
+#define NREADERS    3
+
+typedef struct
+{
+    Catalog* catalog;
+    u64 main_oid;
+    _Atomic int done;
+    _Atomic long bad;
+    _Atomic long reads;
+} DdlShared;
+
+static void* ddl_writer(void* arg)
+{
+    DdlShared* s = arg;
+    char name[32];
+    for (int i = 0; i < DDL_SCHEMAS; i++)
+    {
+        snprintf(name, sizeof(name), "s%d", i);
+        create_schema(s->catalog, name);
+        if (i % 3 == 0)
+        {
+            snprintf(name, sizeof(name), "s%d", i / 2);
+            catalog_drop_schema(s->catalog, name);
+        }
+    }
+    atomic_store(&s->done, 1);
+    return NULL;
+}
+
+static void* ddl_reader(void* arg)
+{
+    DdlShared* s = arg;
+    unsigned seed = (unsigned)(uintptr_t)&seed;
+    char name[32];
+    long bad = 0, reads = 0;
+    do
+    {
+        SchemaCatalogEntry* m = catalog_get_schema(s->catalog, "main");
+        if (!m || strcmp(m->base.name, "main") != 0) bad++;
+        if (catalog_get_entry_by_oid(s->catalog, s->main_oid) != &m->base) bad++;
+
+        int i = rand_r(&seed) % DDL_SCHEMAS;
+        snprintf(name, sizeof(name), "s%d", i);
+        SchemaCatalogEntry* e = catalog_get_schema(s->catalog, name);
+        if (e && (strcmp(e->base.name, name) != 0 || e->base.type != SCHEMA)) bad++;
+        reads++;
+    } while (!atomic_load(&s->done));
+    atomic_fetch_add(&s->bad, bad);
+    atomic_fetch_add(&s->reads, reads);
+    return NULL;
+}
+
+static void test_concurrent_ddl(void)
+{
+    printf("\n=== Test concurrent_ddl ===\n");
+
+    DdlShared s;
+    memset(&s, 0, sizeof(s));
+    s.catalog = catalog_create();
+    create_schema(s.catalog, "main");
+    s.main_oid = catalog_get_schema(s.catalog, "main")->base.oid;
+
+    pthread_t w, r[NREADERS];
+    for (int i = 0; i < NREADERS; i++) pthread_create(&r[i], NULL, ddl_reader, &s);
+    pthread_create(&w, NULL, ddl_writer, &s);
+    pthread_join(w, NULL);
+    for (int i = 0; i < NREADERS; i++) pthread_join(r[i], NULL);
+
+    CHECK(atomic_load(&s.reads) > 0, "readers ran during DDL");
+    CHECK(atomic_load(&s.bad) == 0, "every read saw a consistent catalog");
+
+    int live = 0;
+    catalogSet_scan(&s.catalog->schemas, count_live, &live);
+    int expected = 1;
+    char name[32];
+    for (int i = 0; i < DDL_SCHEMAS; i++)
+    {
+        snprintf(name, sizeof(name), "s%d", i);
+        expected += catalog_get_schema(s.catalog, name) != NULL;
+    }
+    CHECK(live == expected, "scan agrees with name lookups after DDL");
+    CHECK(catalog_get_entry_by_oid(s.catalog, DDL_SCHEMAS) != NULL ||
+              catalog_get_entry_by_oid(s.catalog, DDL_SCHEMAS + 1) != NULL,
+          "OID map grew past its initial size");
+
+    epoch_synchronize();
+    catalog_destroy(s.catalog);
+}
+
+/* ================================================================
+ * Test 4: column definitions live in a per-entry context
+ * ================================================================ */
+static int count_children(MemoryContext* cxt)
+{
+    int n = 0;
+    for (MemoryContext* c = cxt->first_child; c; c = c->next_sibling) n++;
+    return n;
+}
+
+static void test_table_entry_memory(void)
+{
+    printf("\n=== Test table_entry_memory ===\n");
+
+    Catalog* catalog = catalog_create();
+    create_schema(catalog, "main");
+    ColumnDefinition cols[2];
+    memset(cols, 0, sizeof(cols));
+    cols[0].name = strdup("id");
+    cols[0].type = SQLT_INTEGER;
+    cols[1].name = strdup("score");
+    cols[1].type = SQLT_DOUBLE;
+    CreateTableInfo tinfo = {"main", "t", true, cols, 2};
+    CHECK(catalog_create_table(catalog, &tinfo) == 0, "create main.t");
+    free(cols[0].name);
+    free(cols[1].name);
+    cols[0].name = cols[1].name = NULL;
+
+    TableCatalogEntry* t = catalog_get_table(catalog, "main", "t");
+    CHECK(t && t->cxt && t->cxt->parent == &catalog->cxt, "entry context hangs off the catalog");
+    CHECK(t && strcmp(t->columns[1].name, "score") == 0, "column names copied into the entry");
+    usize before = memoryContext_mem_allocated(&catalog->cxt, true);
+
+    // 重名的表项被拒绝后立即销毁，它的上下文不能留在 catalog 下
+    for (int i = 0; i < 8; i++) catalog_create_table(catalog, &tinfo);
+    CHECK(count_children(&catalog->cxt) == 1, "rejected entries leave no context behind");
+    CHECK(memoryContext_mem_allocated(&catalog->cxt, true) == before,
+          "rejected entries return their memory");
+    catalog_destroy(catalog);
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   Catalog RCU Test Suite\n");
+    printf("========================================\n");
+
+    test_snapshot_lookup();
+    test_oid_lookup();
+    test_concurrent_ddl();
+    test_table_entry_memory();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
@@ -64,7 +64,7 @@ static TestEnv create_test_env(void)
 
 static void destroy_test_env(TestEnv* env)
 {
-    if (env->cpm) free(env->cpm);
+    CheckpointManager_destroy(env->cpm);
     if (env->catalog) catalog_destroy(env->catalog);
     if (env->sfbm) destory_single_manager(env->sfbm);
     if (env->sm) free(env->sm);
@@ -165,7 +165,7 @@ void test_loadfromstorage_empty(void)
           "No schemas in empty catalog after load",
           "Should have no schemas loaded from empty database");
 
-    free(load_cpm);
+    CheckpointManager_destroy(load_cpm);
     catalog_destroy(empty_catalog);
     destroy_test_env(&env);
 }
@@ -223,7 +223,7 @@ void test_free_list_management(void)
     Catalog* tmp = catalog_create();
     CheckpointManager* load_cpm = make_load_cpm(&env, tmp);
     checkpointManager_loadfromstorage(load_cpm);
-    free(load_cpm);
+    CheckpointManager_destroy(load_cpm);
     catalog_destroy(tmp);
 
     usize used_after_load = env.sfbm->used_blocks.size;
@@ -300,7 +300,7 @@ void test_roundtrip_single_schema(void)
         FAIL("Roundtrip: 'main' schema NOT found");
     }
 
-    free(load_cpm);
+    CheckpointManager_destroy(load_cpm);
     catalog_destroy(loaded);
     destroy_test_env(&env);
 }
@@ -337,7 +337,7 @@ void test_roundtrip_multi_schema(void)
     CHECK(sa != NULL, "Roundtrip: 'alpha' restored", "Roundtrip: 'alpha' NOT found");
     CHECK(sb != NULL, "Roundtrip: 'beta' restored", "Roundtrip: 'beta' NOT found");
 
-    free(load_cpm);
+    CheckpointManager_destroy(load_cpm);
     catalog_destroy(loaded);
     destroy_test_env(&env);
 }
@@ -382,7 +382,7 @@ void test_roundtrip_many_schemas(void)
     if (all_ok)
         PASS("Roundtrip many: all 10 extra schemas restored");
 
-    free(load_cpm);
+    CheckpointManager_destroy(load_cpm);
     catalog_destroy(loaded);
     destroy_test_env(&env);
 }
@@ -462,7 +462,7 @@ void test_reopen_database(void)
         checkpointManager_createpoint(cpm);
         PASS("Phase 1: checkpoint with [main, persist_me]");
 
-        free(cpm);
+        CheckpointManager_destroy(cpm);
         catalog_destroy(cat);
         destory_single_manager(sfbm);
     }
@@ -502,7 +502,7 @@ void test_reopen_database(void)
         CHECK(sp != NULL, "Phase 2: 'persist_me' schema loaded from disk",
               "Phase 2: 'persist_me' NOT found from disk");
 
-        free(load);
+        CheckpointManager_destroy(load);
         catalog_destroy(cat);
         destory_single_manager(sfbm);
     }
@@ -599,7 +599,7 @@ void test_table_data_roundtrip(void)
 
     TableCatalogEntry* lt = catalog_get_table(loaded, "main", "test_tbl");
     CHECK(lt != NULL, "Loaded table 'test_tbl'", "Table 'test_tbl' NOT loaded");
-    if (!lt) { free(load_cpm); catalog_destroy(loaded); destroy_test_env(&env); return; }
+    if (!lt) { CheckpointManager_destroy(load_cpm); catalog_destroy(loaded); destroy_test_env(&env); return; }
 
     CHECK(lt->column_count == 2,
           "Loaded table has 2 columns",
@@ -652,7 +652,7 @@ void test_table_data_roundtrip(void)
     scanstate_deinit(&state);
     dataChunk_deinit(&output);
     vector_deinit(&types2);
-    free(load_cpm);
+    CheckpointManager_destroy(load_cpm);
     catalog_destroy(loaded);
     destroy_test_env(&env);
     #undef N_ROWS
@@ -725,7 +725,7 @@ void test_table_data_roundtrip_large(void)
 
     TableCatalogEntry* lt = catalog_get_table(loaded, "main", "big_tbl");
     CHECK(lt != NULL, "Loaded big_tbl", "big_tbl NOT loaded");
-    if (!lt) { free(load_cpm); catalog_destroy(loaded); destroy_test_env(&env); return; }
+    if (!lt) { CheckpointManager_destroy(load_cpm); catalog_destroy(loaded); destroy_test_env(&env); return; }
 
     /* Scan and verify */
     DataChunk output = MAKE(DataChunk, types);
@@ -760,7 +760,7 @@ void test_table_data_roundtrip_large(void)
     scanstate_deinit(&state);
     dataChunk_deinit(&output);
     vector_deinit(&types);
-    free(load_cpm);
+    CheckpointManager_destroy(load_cpm);
     catalog_destroy(loaded);
     destroy_test_env(&env);
     #undef TOTAL_ROWS
@@ -894,7 +894,7 @@ void test_multi_table_roundtrip(void)
         vector_deinit(&types);
     }
 
-    free(load_cpm);
+    CheckpointManager_destroy(load_cpm);
     catalog_destroy(loaded);
     destroy_test_env(&env);
 }
@@ -947,7 +947,7 @@ void test_empty_table_roundtrip(void)
         (void)has;
     }
 
-    free(load_cpm);
+    CheckpointManager_destroy(load_cpm);
     catalog_destroy(loaded);
     destroy_test_env(&env);
 }
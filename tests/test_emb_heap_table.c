@@ -4,6 +4,11 @@
  * Tests for EmbeddingHeapTable — specifically:
  *   embeddingHeapTable_append_chunk  (batch insert via vtable .append_chunk)
  *   embeddingHeapTable_scan_chunk    (top-K ANN scan via vtable .scan)
+ *   embeddingHeapTable_vacuum        (dead tuple / emb slot / index cleanup via .vacuum)
+ *   embeddingHeapTable_update        (HOT payload update / new-slot embedding, NULL payloads)
+ *   scan TEXT payloads               (per-query memory context, column subset)
+ *   embeddingHeapTable_delete        (reverse emb→heap map, live bits, emb-first scan)
+ *   embeddingStore_append_batch      (lock-free concurrent bulk ingest)
  *
  * Compile & run:
  *   cd tests && make test_emb_heap_table && ./test_emb_heap_table
@@ -14,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 
 #include "../src/table.h"    /* EmbeddingHeapTable, DataChunk, TableQueryResult */
 #include "../src/operator.h" /* DistanceType: L2, L2_SQUARED, COSINE, ... */
@@ -353,9 +359,430 @@ static void test_two_append_chunks(void)
     EmbeddingHeapTable_deinit(&table);
 }
 
+/* ---- mock vector index: records removed / inserted heap ctids ---- */
+typedef struct
+{
+    VectorIndex base;
+    int removed;
+    u64 removed_ctids[8];
+    int inserted;
+    u64 inserted_ctids[8];
+} MockIndex;
+
+static void mock_index_insert(VectorIndex* index, u64 heap_ctid_packed, ItemPtr emb_ctid,
+                              const f32* vector)
+{
+    MockIndex* m = (MockIndex*)index;
+    (void)emb_ctid;
+    (void)vector;
+    if (m->inserted < 8) m->inserted_ctids[m->inserted] = heap_ctid_packed;
+    m->inserted++;
+}
+
+static bool mock_index_remove(VectorIndex* index, u64 heap_ctid_packed)
+{
+    MockIndex* m = (MockIndex*)index;
+    if (m->removed < 8) m->removed_ctids[m->removed] = heap_ctid_packed;
+    m->removed++;
+    return true;
+}
+
+static VectorIndexVTable mock_index_vtable = {.insert = mock_index_insert,
+                                              .remove = mock_index_remove};
+
+/* ================================================================
+ * Test 7: vacuum reclaims deleted rows, emb slots and index entries
+ * ================================================================ */
+static void test_vacuum_reclaims_deleted(void)
+{
+    printf("\n--- test_vacuum_reclaims_deleted ---\n");
+
+    EmbeddingHeapTable table;
+    EmbeddingHeapTable_init(&table, 2, &empty_schema, NULL);
+    MockIndex index = {.base = {.vtable = &mock_index_vtable}};
+    embeddingHeapTable_attach_index(&table, &index.base);
+
+    f32 d[5][2] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}, {2, 2}};
+    VectorBase vecs[5];
+    for (int i = 0; i < 5; i++) vecs[i] = (VectorBase){TYPE_FLOAT32, 2, (data_ptr_t)d[i]};
+    DataChunk chunk;
+    make_chunk(&chunk, vecs, 5);
+    ItemPtr emb_buf[5], heap_buf[5];
+    TamInsertCtx ctx = {.emb_ctids = emb_buf, .heap_ctids = heap_buf, .count = 5, .xid = 1};
+    VCALL(&table.base, append_chunk, &chunk, &ctx);
+    CHECK(index.inserted == 5 && index.inserted_ctids[4] == item_ptr_pack(heap_buf[4]),
+          "append_chunk registers every row in the attached index");
+
+    CHECK(heapStore_delete_by_ctid(&table.heap_table.store, heap_buf[1]) != INVALID_TXN_ID &&
+              heapStore_delete_by_ctid(&table.heap_table.store, heap_buf[3]) != INVALID_TXN_ID,
+          "delete two rows by heap ctid");
+
+    CHECK(VCALL(&table.base, vacuum, 1) == 0, "horizon before the deletes reclaims nothing");
+    CHECK(VCALL(&table.base, vacuum, VACUUM_HORIZON_ALL) == 2, "vacuum reclaims both rows");
+    CHECK(vector_size(&table.embed_store.free_list) == 2, "emb slots returned to free_list");
+    CHECK(index.removed == 2 && index.removed_ctids[0] == item_ptr_pack(heap_buf[1]) &&
+              index.removed_ctids[1] == item_ptr_pack(heap_buf[3]),
+          "attached index drops the dead heap ctids");
+    CHECK(VCALL(&table.base, vacuum, VACUUM_HORIZON_ALL) == 0, "second vacuum is a no-op");
+
+    f32 q[2] = {1.0f, 0.0f};
+    VectorCondition vc = {.query = {TYPE_FLOAT32, 2, (data_ptr_t)q}, .metric = L2};
+    TamScanCtx scan_ctx = {.vec_cond = &vc, .k = 5};
+    TableQueryResult results[5];
+    int nout = VCALL(&table.base, scan, &scan_ctx, results, 5);
+    CHECK(nout == 3, "scan sees only surviving rows");
+
+    /* re-insert: emb slots and heap slots of the vacuumed rows are reused */
+    f32 n0[2] = {5, 5};
+    VectorBase nv = {TYPE_FLOAT32, 2, (data_ptr_t)n0};
+    make_chunk(&chunk, &nv, 1);
+    ItemPtr emb_new[1], heap_new[1];
+    TamInsertCtx ctx2 = {.emb_ctids = emb_new, .heap_ctids = heap_new, .count = 1, .xid = 2};
+    VCALL(&table.base, append_chunk, &chunk, &ctx2);
+    bool emb_reused = memcmp(&emb_new[0], &emb_buf[1], sizeof(ItemPtr)) == 0 ||
+                      memcmp(&emb_new[0], &emb_buf[3], sizeof(ItemPtr)) == 0;
+    bool heap_reused = memcmp(&heap_new[0], &heap_buf[1], sizeof(ItemPtr)) == 0;
+    CHECK(emb_reused, "new row reuses a vacuumed emb slot");
+    CHECK(heap_reused, "new row reuses the first vacuumed heap slot");
+    nout = VCALL(&table.base, scan, &scan_ctx, results, 5);
+    CHECK(nout == 4, "scan sees surviving rows plus the new one");
+
+    EmbeddingHeapTable_deinit(&table);
+}
+
+/* scan helper: heap ctid and vector of the row nearest to (x, y) */
+static TableQueryResult nearest(EmbeddingHeapTable* table, f32 x, f32 y, Snapshot* snap)
+{
+    f32 q[2] = {x, y};
+    VectorCondition vc = {.query = {TYPE_FLOAT32, 2, (data_ptr_t)q}, .metric = L2};
+    TamScanCtx scan_ctx = {.vec_cond = &vc, .k = 1, .snapshot = snap};
+    TableQueryResult r;
+    memset(&r, 0, sizeof(r));
+    VCALL(&table->base, scan, &scan_ctx, &r, 1);
+    return r;
+}
+
+/* ================================================================
+ * Test 8: update paths — HOT payload update, in-place and MVCC embedding update
+ * ================================================================ */
+static void test_update_paths(void)
+{
+    printf("\n--- test_update_paths ---\n");
+
+    TransactionManager mgr;
+    TransactionManager_init(&mgr);
+    EmbeddingHeapTable table;
+    EmbeddingHeapTable_init(&table, 2, &empty_schema, NULL);
+    heapStore_set_txn_manager(&table.heap_table.store, &mgr);
+    MockIndex index = {.base = {.vtable = &mock_index_vtable}};
+    embeddingHeapTable_attach_index(&table, &index.base);
+
+    f32 d[3][2] = {{1, 0}, {0, 1}, {-1, 0}};
+    VectorBase vecs[3];
+    for (int i = 0; i < 3; i++) vecs[i] = (VectorBase){TYPE_FLOAT32, 2, (data_ptr_t)d[i]};
+    DataChunk chunk;
+    make_chunk(&chunk, vecs, 3);
+    ItemPtr emb_buf[3], heap_buf[3];
+    TamInsertCtx ctx = {.emb_ctids = emb_buf, .heap_ctids = heap_buf, .count = 3};
+    VCALL(&table.base, append_chunk, &chunk, &ctx);
+    CHECK(index.inserted == 3, "appended rows indexed");
+    index.inserted = 0;
+
+    /* payload-only: HOT on the same page, embedding slot shared, index untouched */
+    TamUpdateCtx u1 = {.heap_ctid = heap_buf[1]};
+    CHECK(VCALL(&table.base, update, NULL, NULL, &u1) == 0, "payload-only update succeeds");
+    CHECK(item_ptr_block_id(u1.new_heap_ctid) == item_ptr_block_id(heap_buf[1]) &&
+              !item_ptr_equal(u1.new_heap_ctid, heap_buf[1]),
+          "new version lands on the same page");
+    CHECK(item_ptr_equal(u1.emb_ctid, emb_buf[1]), "new version shares the embedding slot");
+    CHECK(index.inserted == 0 && index.removed == 0, "HOT update leaves indexes alone");
+    CHECK(item_ptr_equal(nearest(&table, 0, 1, NULL).heap_ctid, u1.new_heap_ctid),
+          "scan returns the new version");
+    CHECK(VCALL(&table.base, vacuum, VACUUM_HORIZON_ALL) == 1, "vacuum prunes the old version");
+    CHECK(vector_size(&table.embed_store.free_list) == 0, "shared embedding slot is kept");
+    CHECK(index.removed == 0, "HOT root stays indexed through its redirect");
+    HeapTuple tup;
+    CHECK(heapStore_get_by_ctid(&table.heap_table.store, &empty_schema, heap_buf[1], &tup) == 0 &&
+              item_ptr_equal(tup.hdr.t_ctid, u1.new_heap_ctid),
+          "root ctid resolves to the live version");
+
+    /* embedding-only: new slot and new version; the published slot is never overwritten */
+    f32 moved[2] = {5, 5};
+    VectorBase mv = {TYPE_FLOAT32, 2, (data_ptr_t)moved};
+    TamUpdateCtx u2 = {.heap_ctid = heap_buf[0]};
+    CHECK(VCALL(&table.base, update, &mv, NULL, &u2) == 0, "embedding-only update succeeds");
+    CHECK(!item_ptr_equal(u2.new_heap_ctid, heap_buf[0]) && !item_ptr_equal(u2.emb_ctid, emb_buf[0]),
+          "embedding update writes a new version and a new slot");
+    CHECK(embedding_store_get_ptr_ctid(&table.embed_store, emb_buf[0])[0] == 1.0f,
+          "old slot keeps the old vector");
+    CHECK(index.removed == 0 && index.inserted == 1 &&
+              index.inserted_ctids[0] == item_ptr_pack(u2.new_heap_ctid),
+          "new version gets its own index entry");
+    CHECK(item_ptr_equal(nearest(&table, 5, 5, NULL).heap_ctid, u2.new_heap_ctid),
+          "scan sees the new embedding");
+
+    /* embedding-only with an open snapshot: new version, old one stays visible */
+    Snapshot* snap = transactionManager_get_snapshot(&mgr, 0);
+    f32 again[2] = {-5, -5};
+    VectorBase av = {TYPE_FLOAT32, 2, (data_ptr_t)again};
+    TamUpdateCtx u3 = {.heap_ctid = heap_buf[2]};
+    CHECK(VCALL(&table.base, update, &av, NULL, &u3) == 0, "MVCC embedding update succeeds");
+    CHECK(!item_ptr_equal(u3.emb_ctid, emb_buf[2]), "new embedding written to a new slot");
+    CHECK(index.inserted == 2 && index.inserted_ctids[1] == item_ptr_pack(u3.new_heap_ctid),
+          "non-HOT version gets its own index entry");
+    TableQueryResult old_view = nearest(&table, -1, 0, snap);
+    CHECK(item_ptr_equal(old_view.heap_ctid, heap_buf[2]), "old snapshot still sees the old vector");
+    CHECK(item_ptr_equal(nearest(&table, -5, -5, NULL).heap_ctid, u3.new_heap_ctid),
+          "new snapshot sees the new vector");
+    transactionManager_release_snapshot(&mgr, snap);
+    CHECK(VCALL(&table.base, vacuum, VACUUM_HORIZON_ALL) == 2, "vacuum reclaims both old versions");
+    CHECK(vector_size(&table.embed_store.free_list) == 2, "old embedding slots freed");
+    CHECK(index.removed == 2 && index.removed_ctids[0] == item_ptr_pack(heap_buf[0]) &&
+              index.removed_ctids[1] == item_ptr_pack(heap_buf[2]),
+          "old versions' index entries dropped");
+
+    EmbeddingHeapTable_deinit(&table);
+    TransactionManager_deinit(&mgr);
+}
+
+/* ================================================================
+ * Test 9: TEXT payloads come back from a scan, copied into the query arena
+ * ================================================================ */
+static void test_scan_text_payloads_arena(void)
+{
+    printf("\n--- test_scan_text_payloads_arena ---\n");
+
+    static const TupleColType cols[2] = {TUPLE_COL_I32, TUPLE_COL_TEXT};
+    static const TableSchema schema = {.cols = cols, .ncols = 2};
+    EmbeddingHeapTable table;
+    EmbeddingHeapTable_init(&table, 2, &schema, NULL);
+
+    f32 d[2][2] = {{1, 0}, {0, 1}};
+    VectorBase vecs[2] = {{TYPE_FLOAT32, 2, (data_ptr_t)d[0]}, {TYPE_FLOAT32, 2, (data_ptr_t)d[1]}};
+    u8 t0[4 + 4] = {4, 0, 0, 0, 'c', 'a', 't', 's'};
+    u8 t1[4 + 3] = {3, 0, 0, 0, 'd', 'o', 'g'};
+    Datum r0[2] = {Int32GetDatum(10), PointerGetDatum(t0)};
+    Datum r1[2] = {Int32GetDatum(11), PointerGetDatum(t1)};
+    const Datum* rows[2] = {r0, r1};
+    DataChunk chunk;
+    make_chunk(&chunk, vecs, 2);
+    chunk.payloads = rows;
+    chunk.n_payloads = 2;
+    ItemPtr emb_buf[2], heap_buf[2];
+    TamInsertCtx ctx = {.emb_ctids = emb_buf, .heap_ctids = heap_buf, .count = 2};
+    VCALL(&table.base, append_chunk, &chunk, &ctx);
+
+    MemoryContext arena;
+    MemoryContext_init(&arena, NULL, "scan", 0);
+    f32 q[2] = {0, 1};
+    VectorCondition vc = {.query = {TYPE_FLOAT32, 2, (data_ptr_t)q}, .metric = L2};
+    TamScanCtx scan_ctx = {.vec_cond = &vc, .k = 2, .payload_cols = 1u << 1, .arena = &arena};
+    TableQueryResult res[2];
+    int n = VCALL(&table.base, scan, &scan_ctx, res, 2);
+    CHECK(n == 2, "scan returns both rows");
+    CHECK(memcmp(DatumGetPointer(res[0].payloads[1]), t1, sizeof(t1)) == 0 &&
+              memcmp(DatumGetPointer(res[1].payloads[1]), t0, sizeof(t0)) == 0,
+          "TEXT payloads read back in distance order");
+    CHECK(res[0].payloads[0] == 0, "unrequested column left zero");
+    CHECK(memoryContext_mem_allocated(&arena, false) > 0, "payload arrays carved from the arena");
+    memoryContext_delete(&arena); /* frees payload arrays and TEXT copies together */
+
+    /* payload update writing NULLs: explicit null bit, and a TEXT Datum of 0 */
+    Datum nulls[2] = {0, 0};
+    TamUpdateCtx u = {.heap_ctid = heap_buf[0], .null_bits = 1u << 0};
+    HeapTuple tup;
+    CHECK(VCALL(&table.base, update, NULL, nulls, &u) == 0 &&
+              heapStore_get_by_ctid(&table.heap_table.store, &schema, u.new_heap_ctid, &tup) == 0,
+          "update with NULL payloads succeeds");
+    CHECK(tup.hdr.null_bits == 3 && item_ptr_equal(tup.hdr.t_emb_ctid, emb_buf[0]),
+          "both columns stored as NULL, embedding kept");
+    row_tuple_free(&tup, &schema);
+
+    EmbeddingHeapTable_deinit(&table);
+}
+
 /* ================================================================
  * main
  * ================================================================ */
+/* ================================================================
+ * Test 10: delete clears the slot's live bit; vacuum releases the slot
+ * ================================================================ */
+static void test_delete_reverse_map(void)
+{
+    printf("\n--- test_delete_reverse_map ---\n");
+
+    EmbeddingHeapTable table;
+    EmbeddingHeapTable_init(&table, 2, &empty_schema, NULL);
+    EmbeddingStore* es = &table.embed_store;
+
+    f32 d[4][2] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+    VectorBase vecs[4];
+    for (int i = 0; i < 4; i++) vecs[i] = (VectorBase){TYPE_FLOAT32, 2, (data_ptr_t)d[i]};
+    DataChunk chunk;
+    make_chunk(&chunk, vecs, 4);
+    ItemPtr emb_buf[4], heap_buf[4];
+    TamInsertCtx ctx = {.emb_ctids = emb_buf, .heap_ctids = heap_buf, .count = 4};
+    VCALL(&table.base, append_chunk, &chunk, &ctx);
+
+    bool mapped = true;
+    for (int i = 0; i < 4; i++)
+        mapped = mapped && embeddingStore_is_live(es, emb_buf[i]) &&
+                 item_ptr_equal(embeddingStore_heap_ctid(es, emb_buf[i]), heap_buf[i]);
+    CHECK(mapped, "insert records emb slot -> heap ctid back pointers");
+
+    TamDeleteCtx del = {.heap_ctid = heap_buf[1]};
+    CHECK(VCALL(&table.base, delete, &del) == 0, "delete through the table succeeds");
+    CHECK(item_ptr_equal(del.emb_ctid, emb_buf[1]) && !embeddingStore_is_live(es, emb_buf[1]),
+          "deleted row's emb slot is no longer live");
+    CHECK(item_ptr_equal(embeddingStore_heap_ctid(es, emb_buf[1]), heap_buf[1]),
+          "back pointer kept until vacuum");
+    CHECK(VCALL(&table.base, delete, &del) == -1, "second delete fails");
+    CHECK(vector_size(&es->free_list) == 0, "delete alone frees no slot");
+
+    TableQueryResult r = nearest(&table, 0, 1, NULL);
+    CHECK(!item_ptr_equal(r.heap_ctid, heap_buf[1]), "emb-first scan skips the deleted vector");
+
+    /* bypassing the table leaves the live bit set; the scan falls back to the heap */
+    heapStore_delete_by_ctid(&table.heap_table.store, heap_buf[2]);
+    r = nearest(&table, -1, 0, NULL);
+    CHECK(item_ptr_is_valid(r.heap_ctid) && !item_ptr_equal(r.heap_ctid, heap_buf[2]),
+          "stale live bit does not surface a deleted row");
+
+    /* payload-only update: the shared slot follows the newest version */
+    TamUpdateCtx u = {.heap_ctid = heap_buf[0]};
+    CHECK(VCALL(&table.base, update, NULL, NULL, &u) == 0 &&
+              item_ptr_equal(embeddingStore_heap_ctid(es, emb_buf[0]), u.new_heap_ctid) &&
+              embeddingStore_is_live(es, emb_buf[0]),
+          "update moves the back pointer to the new version");
+
+    CHECK(VCALL(&table.base, vacuum, VACUUM_HORIZON_ALL) == 3, "vacuum reclaims three versions");
+    CHECK(vector_size(&es->free_list) == 2, "both deleted slots returned to free_list");
+    CHECK(!item_ptr_is_valid(embeddingStore_heap_ctid(es, emb_buf[1])) &&
+              !item_ptr_is_valid(embeddingStore_heap_ctid(es, emb_buf[2])),
+          "released slots lose their back pointers");
+    CHECK(embeddingStore_is_live(es, emb_buf[0]), "shared slot survives the old version");
+
+    EmbeddingHeapTable_deinit(&table);
+}
+
+/* ================================================================
+ * Test 11: concurrent bulk ingest reserves disjoint slots lock-free
+ * ================================================================ */
+#define INGEST_THREADS 4
+#define INGEST_CHUNKS  20
+#define INGEST_ROWS    256
+#define INGEST_DIM     8
+
+typedef struct
+{
+    EmbeddingHeapTable* table;
+    int id;
+    ItemPtr emb[INGEST_CHUNKS * INGEST_ROWS];
+    ItemPtr heap[INGEST_CHUNKS * INGEST_ROWS];
+} IngestArg;
+
+/* row r of thread t: every component holds t * 1e6 + r */
+static f32 ingest_value(int t, int r)
+{
+    return (f32)t * 1e6f + (f32)r;
+}
+
+static void* ingest_thread(void* arg)
+{
+    IngestArg* ia = arg;
+    f32 data[INGEST_ROWS][INGEST_DIM];
+    VectorBase vecs[INGEST_ROWS];
+    for (int c = 0; c < INGEST_CHUNKS; c++)
+    {
+        for (int i = 0; i < INGEST_ROWS; i++)
+        {
+            for (int d = 0; d < INGEST_DIM; d++) data[i][d] = ingest_value(ia->id, c * INGEST_ROWS + i);
+            vecs[i] = (VectorBase){TYPE_FLOAT32, INGEST_DIM, (data_ptr_t)data[i]};
+        }
+        DataChunk chunk;
+        make_chunk(&chunk, vecs, INGEST_ROWS);
+        TamInsertCtx ctx = {.emb_ctids = ia->emb + c * INGEST_ROWS,
+                            .heap_ctids = ia->heap + c * INGEST_ROWS,
+                            .count = INGEST_ROWS};
+        VCALL(&ia->table->base, append_chunk, &chunk, &ctx);
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void* a, const void* b)
+{
+    u64 x = *(const u64*)a, y = *(const u64*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void test_concurrent_ingest(void)
+{
+    printf("\n--- test_concurrent_ingest ---\n");
+
+    EmbeddingHeapTable table;
+    EmbeddingHeapTable_init(&table, INGEST_DIM, &empty_schema, NULL);
+    EmbeddingStore* es = &table.embed_store;
+    IngestArg* args = calloc(INGEST_THREADS, sizeof(IngestArg));
+    pthread_t th[INGEST_THREADS];
+    for (int t = 0; t < INGEST_THREADS; t++)
+    {
+        args[t].table = &table;
+        args[t].id = t;
+        pthread_create(&th[t], NULL, ingest_thread, &args[t]);
+    }
+    /* scans interleave with the writers */
+    f32 q[INGEST_DIM] = {0};
+    VectorCondition vc = {.query = {TYPE_FLOAT32, INGEST_DIM, (data_ptr_t)q}, .metric = L2};
+    bool scans_ok = true;
+    for (int i = 0; i < 50; i++)
+    {
+        TamScanCtx sc = {.vec_cond = &vc, .k = 1};
+        TableQueryResult r;
+        int n = VCALL(&table.base, scan, &sc, &r, 1);
+        if (n < 0 || n > 1) scans_ok = false;
+    }
+    for (int t = 0; t < INGEST_THREADS; t++) pthread_join(th[t], NULL);
+
+    usize total = (usize)INGEST_THREADS * INGEST_CHUNKS * INGEST_ROWS;
+    CHECK(scans_ok, "scans run beside the writers");
+    CHECK(embeddingStore_published(es) == total && atomic_load(&es->count) == total,
+          "every reserved slot is published");
+
+    u64* keys = malloc(total * sizeof(u64));
+    bool intact = true, mapped = true;
+    usize k = 0;
+    for (int t = 0; t < INGEST_THREADS; t++)
+        for (int r = 0; r < INGEST_CHUNKS * INGEST_ROWS; r++)
+        {
+            ItemPtr e = args[t].emb[r];
+            keys[k++] = item_ptr_pack(e);
+            const f32* v = embedding_store_get_ptr_ctid(es, e);
+            for (int d = 0; d < INGEST_DIM; d++)
+                if (!v || v[d] != ingest_value(t, r)) intact = false;
+            if (!embeddingStore_is_live(es, e) ||
+                !item_ptr_equal(embeddingStore_heap_ctid(es, e), args[t].heap[r]))
+                mapped = false;
+        }
+    qsort(keys, total, sizeof(u64), cmp_u64);
+    bool distinct = true;
+    for (usize i = 1; i < total; i++)
+        if (keys[i] == keys[i - 1]) distinct = false;
+    CHECK(distinct, "writers reserve disjoint slots");
+    CHECK(intact, "every vector reads back intact");
+    CHECK(mapped, "every slot maps back to its heap row");
+
+    q[0] = ingest_value(2, 77);
+    for (int d = 1; d < INGEST_DIM; d++) q[d] = q[0];
+    TamScanCtx sc = {.vec_cond = &vc, .k = 1};
+    TableQueryResult r;
+    CHECK(VCALL(&table.base, scan, &sc, &r, 1) == 1 && item_ptr_equal(r.emb_ctid, args[2].emb[77]),
+          "scan after ingest finds an exact match");
+
+    free(keys);
+    free(args);
+    EmbeddingHeapTable_deinit(&table);
+}
+
 int main(void)
 {
     printf("=== test_emb_heap_table ===\n");
@@ -366,6 +793,11 @@ int main(void)
     test_scan_respects_k_limit();
     test_scan_cosine_metric();
     test_two_append_chunks();
+    test_vacuum_reclaims_deleted();
+    test_update_paths();
+    test_scan_text_payloads_arena();
+    test_delete_reverse_map();
+    test_concurrent_ingest();
 
     printf("\n=== Results: %d passed, %d failed ===\n", pass_count, fail_count);
     return fail_count > 0 ? 1 : 0;
@@ -0,0 +1,225 @@
+/**
+ * test_epoch.c
+ *
+ * Tests for epoch-based reclamation (epoch.h) and the lock-free SegmentTree
+ * directory built on it:
+ *   epoch_enter / epoch_exit / epoch_retire   (deferred free, nesting)
+ *   epoch_synchronize                         (drains the limbo list)
+ *   segmentTree_get_node / segment_count /
+ *   SegmentTree_get_segment                   (lock-free reads during growth)
+ *
+ * Compile & run:
+ *   cd tests && make test_epoch && ./test_epoch
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/epoch.h"
+#include "../src/segment.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+static _Atomic int freed_count = 0;
+
+static void count_free(void* p)
+{
+    free(p);
+    atomic_fetch_add(&freed_count, 1);
+}
+
+/* ================================================================
+ * Test 1: a retired object outlives the readers that may see it
+ * ================================================================ */
+typedef struct
+{
+    _Atomic int stage; /* 1: reader inside, 2: may exit, 3: exited */
+} Pinned;
+
+static void* pinned_reader(void* arg)
+{
+    Pinned* p = arg;
+    epoch_enter();
+    atomic_store(&p->stage, 1);
+    while (atomic_load(&p->stage) != 2) sched_yield();
+    epoch_exit();
+    atomic_store(&p->stage, 3);
+    return NULL;
+}
+
+static void test_retire_deferred(void)
+{
+    printf("\n=== Test retire_deferred ===\n");
+
+    atomic_store(&freed_count, 0);
+    Pinned p = {0};
+    pthread_t th;
+    pthread_create(&th, NULL, pinned_reader, &p);
+    while (atomic_load(&p.stage) != 1) sched_yield();
+
+    epoch_retire(malloc(16), count_free);
+    for (int i = 0; i < 10; i++) epoch_reclaim();
+    CHECK(atomic_load(&freed_count) == 0, "not freed while a reader is pinned");
+
+    atomic_store(&p.stage, 2);
+    pthread_join(th, NULL);
+    epoch_synchronize();
+    CHECK(atomic_load(&freed_count) == 1, "freed once the reader left");
+}
+
+/* ================================================================
+ * Test 2: nested sections keep the outer pin
+ * ================================================================ */
+static void* nested_reader(void* arg)
+{
+    Pinned* p = arg;
+    epoch_enter();
+    epoch_enter();
+    epoch_exit(); /* inner exit must not unpin */
+    atomic_store(&p->stage, 1);
+    while (atomic_load(&p->stage) != 2) sched_yield();
+    epoch_exit();
+    return NULL;
+}
+
+static void test_nesting(void)
+{
+    printf("\n=== Test nesting ===\n");
+
+    atomic_store(&freed_count, 0);
+    Pinned p = {0};
+    pthread_t th;
+    pthread_create(&th, NULL, nested_reader, &p);
+    while (atomic_load(&p.stage) != 1) sched_yield();
+
+    u64 before = epoch_current();
+    epoch_retire(malloc(16), count_free);
+    for (int i = 0; i < 10; i++) epoch_reclaim();
+    CHECK(epoch_current() <= before + 1, "epoch stalls behind the pinned reader");
+    CHECK(atomic_load(&freed_count) == 0, "inner exit leaves the thread pinned");
+
+    atomic_store(&p.stage, 2);
+    pthread_join(th, NULL);
+    epoch_synchronize();
+    CHECK(atomic_load(&freed_count) == 1, "freed after the outer exit");
+}
+
+/* ================================================================
+ * Test 3: lock-free directory reads while a writer grows the tree
+ * ================================================================ */
+#define SEG_ROWS    10
+#define SEG_TOTAL   20000
+#define NREADERS    4
+
+typedef struct
+{
+    SegmentTree tree;
+    _Atomic int done;
+    _Atomic long bad;
+    _Atomic long reads;
+} TreeShared;
+
+static void seg_free(SegmentBase* seg)
+{
+    free(seg);
+}
+
+static void* tree_writer(void* arg)
+{
+    TreeShared* s = arg;
+    for (usize i = 0; i < SEG_TOTAL; i++)
+    {
+        SegmentBase* seg = calloc(1, sizeof(SegmentBase));
+        seg->start = i * SEG_ROWS;
+        seg->count = SEG_ROWS;
+        segmentTree_append_segment(&s->tree, seg);
+    }
+    atomic_store(&s->done, 1);
+    return NULL;
+}
+
+static void* tree_reader(void* arg)
+{
+    TreeShared* s = arg;
+    unsigned seed = (unsigned)(uintptr_t)&seed;
+    long bad = 0, reads = 0;
+    do
+    {
+        usize n = segmentTree_segment_count(&s->tree);
+        if (n == 0) continue;
+        usize idx = (usize)rand_r(&seed) % n;
+        SegmentBase* seg = segmentTree_get_node(&s->tree, idx);
+        if (!seg || seg->start != idx * SEG_ROWS) bad++;
+        SegmentBase* hit = SegmentTree_get_segment(&s->tree, idx * SEG_ROWS + SEG_ROWS - 1);
+        if (hit != seg) bad++;
+        SegmentBase* last = segmentTree_get_last_segment(&s->tree);
+        if (!last || last->start < (n - 1) * SEG_ROWS) bad++;
+        reads++;
+    } while (!atomic_load(&s->done));
+    atomic_fetch_add(&s->bad, bad);
+    atomic_fetch_add(&s->reads, reads);
+    return NULL;
+}
+
+static void test_tree_concurrent_growth(void)
+{
+    printf("\n=== Test tree_concurrent_growth ===\n");
+
+    TreeShared s;
+    memset(&s, 0, sizeof(s));
+    SegmentTree_init(&s.tree);
+    pthread_t w, r[NREADERS];
+    for (int i = 0; i < NREADERS; i++) pthread_create(&r[i], NULL, tree_reader, &s);
+    pthread_create(&w, NULL, tree_writer, &s);
+    pthread_join(w, NULL);
+    for (int i = 0; i < NREADERS; i++) pthread_join(r[i], NULL);
+
+    CHECK(atomic_load(&s.reads) > 0, "readers ran during growth");
+    CHECK(atomic_load(&s.bad) == 0, "every lookup saw a consistent directory");
+    CHECK(segmentTree_segment_count(&s.tree) == SEG_TOTAL, "all segments published");
+    CHECK(SegmentTree_get_segment(&s.tree, SEG_TOTAL * SEG_ROWS) == NULL, "row past the end");
+    CHECK(segmentTree_get_node(&s.tree, SEG_TOTAL) == NULL, "index past the end");
+
+    usize linked = 0;
+    for (SegmentBase* cur = segmentTree_get_root_segment(&s.tree); cur; cur = cur->next) linked++;
+    CHECK(linked == SEG_TOTAL, "next chain covers every segment");
+    SegmentTree_deinit(&s.tree, seg_free);
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   Epoch Test Suite\n");
+    printf("========================================\n");
+
+    test_retire_deferred();
+    test_nesting();
+    test_tree_concurrent_growth();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
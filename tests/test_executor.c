@@ -0,0 +1,348 @@
+/**
+ * test_executor.c
+ *
+ * Tests for the push-based vectorized executor (executor.h):
+ *   PhysicalTableScan + PhysicalCollect   (batching, heap-only and embedding tables)
+ *   PhysicalFilter                        (selection vectors, typed compares, NULLs)
+ *   PhysicalTopK                          (matches the table's own top-k scan)
+ *   PhysicalProjection                    (column reorder + compaction, null bits)
+ *   PhysicalLimit                         (offset across batches, early scan stop)
+ *
+ * Compile & run:
+ *   cd tests && make test_executor && ./test_executor
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/executor.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+/* ---- fixture: 2-d vectors with (id I32, score F64, tag TEXT) payloads ---- */
+#define N_ROWS 230
+#define DIM    2
+
+static const TupleColType fix_cols[3] = {TUPLE_COL_I32, TUPLE_COL_F64, TUPLE_COL_TEXT};
+static const TableSchema fix_schema = {.cols = fix_cols, .ncols = 3};
+
+typedef struct
+{
+    EmbeddingHeapTable et;
+    DataTable dt;
+    f32 vecs[N_ROWS][DIM];
+    u8 tags[N_ROWS][4 + 2];
+} Fixture;
+
+/* row i: vector (i, 0); id = i; score = i / 2; tag "t<i%10>" */
+static void fixture_init(Fixture* f)
+{
+    EmbeddingHeapTable_init(&f->et, DIM, &fix_schema, NULL);
+    DataTable_init(&f->dt);
+    f->dt.table = &f->et.base;
+
+    VectorBase vb[N_ROWS];
+    Datum vals[N_ROWS][3];
+    const Datum* rows[N_ROWS];
+    for (usize i = 0; i < N_ROWS; i++)
+    {
+        f->vecs[i][0] = (f32)i;
+        f->vecs[i][1] = 0;
+        vb[i] = (VectorBase){TYPE_FLOAT32, DIM, (data_ptr_t)f->vecs[i]};
+        u8* t = f->tags[i];
+        t[0] = 2, t[1] = t[2] = t[3] = 0, t[4] = 't', t[5] = (u8)('0' + i % 10);
+        vals[i][0] = Int32GetDatum((i32)i);
+        vals[i][1] = Float64GetDatum(i / 2.0);
+        vals[i][2] = PointerGetDatum(t);
+        rows[i] = vals[i];
+    }
+    DataChunk chunk;
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.mode = CHUNK_EMBED;
+    chunk.count = N_ROWS;
+    chunk.arrays = vb;
+    chunk.payloads = rows;
+    chunk.n_payloads = 3;
+    ItemPtr emb_buf[N_ROWS], heap_buf[N_ROWS];
+    TamInsertCtx ctx = {.emb_ctids = emb_buf, .heap_ctids = heap_buf, .count = N_ROWS};
+    VCALL(&f->et.base, append_chunk, &chunk, &ctx);
+}
+
+static void fixture_deinit(Fixture* f)
+{
+    DataTable_deinit(&f->dt);
+    EmbeddingHeapTable_deinit(&f->et);
+}
+
+/* ================================================================
+ * Test 1: plain scan batches every row into the collector
+ * ================================================================ */
+static void test_scan_collect(Fixture* f)
+{
+    printf("\n=== Test scan_collect ===\n");
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "query", 0);
+    ExecContext ctx = {.cxt = cxt};
+    TableQueryResult* res = calloc(N_ROWS + 10, sizeof(TableQueryResult));
+    u16 cols[2] = {0, 2};
+    PhysicalCollect* collect = PhysicalCollect_create(&ctx, res, N_ROWS + 10);
+    PhysicalTableScan* scan = PhysicalTableScan_create(&ctx, &f->dt, cols, 2);
+    CHECK(scan && collect, "operators created in the query context");
+    CHECK(physicalTableScan_run(scan, &collect->base) == 0, "pipeline runs");
+    CHECK(collect->count == N_ROWS && scan->rows_scanned == N_ROWS, "every row reaches the sink");
+
+    bool ok = true;
+    for (usize i = 0; i < collect->count; i++)
+    {
+        i32 id = DatumGetInt32(res[i].payloads[0]);
+        const u8* tag = DatumGetPointer(res[i].payloads[1]);
+        if (id < 0 || id >= N_ROWS || tag[5] != '0' + id % 10 || tag == f->tags[id]) ok = false;
+        if (res[i].vector.count != DIM || ((const f32*)res[i].vector.data)[0] != (f32)id) ok = false;
+    }
+    CHECK(ok, "payloads, TEXT copies and vectors line up per row");
+
+    u16 bad = 9;
+    CHECK(PhysicalTableScan_create(&ctx, &f->dt, &bad, 1) == NULL, "out-of-range column rejected");
+    memoryContext_delete(cxt);
+    free(res);
+}
+
+/* ================================================================
+ * Test 2: filter shrinks the selection vector
+ * ================================================================ */
+static void test_filter(Fixture* f)
+{
+    printf("\n=== Test filter ===\n");
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "query", 0);
+    ExecContext ctx = {.cxt = cxt};
+    TableQueryResult* res = calloc(N_ROWS, sizeof(TableQueryResult));
+    u16 cols[2] = {0, 1};
+
+    /* 40 <= id < 120 AND score > 50.0  →  id in [101, 120) */
+    ExecPredicate preds[3] = {
+        {.col = 0, .type = TUPLE_COL_I32, .op = EXEC_CMP_GE, .value = Int32GetDatum(40)},
+        {.col = 0, .type = TUPLE_COL_I32, .op = EXEC_CMP_LT, .value = Int32GetDatum(120)},
+        {.col = 1, .type = TUPLE_COL_F64, .op = EXEC_CMP_GT, .value = Float64GetDatum(50.0)},
+    };
+    PhysicalCollect* collect = PhysicalCollect_create(&ctx, res, N_ROWS);
+    PhysicalFilter* filter = PhysicalFilter_create(&ctx, preds, 3, &collect->base);
+    PhysicalTableScan* scan = PhysicalTableScan_create(&ctx, &f->dt, cols, 2);
+    CHECK(physicalTableScan_run(scan, &filter->base) == 0, "filtered pipeline runs");
+    bool ok = collect->count == 19;
+    for (usize i = 0; i < collect->count; i++)
+    {
+        i32 id = DatumGetInt32(res[i].payloads[0]);
+        if (id < 101 || id >= 120) ok = false;
+    }
+    CHECK(ok, "conjunction keeps exactly the matching rows");
+
+    ExecPredicate text_pred = {.col = 0, .type = TUPLE_COL_TEXT, .op = EXEC_CMP_EQ};
+    CHECK(PhysicalFilter_create(&ctx, &text_pred, 1, &collect->base) == NULL,
+          "varlena comparison rejected");
+
+    /* NULL handling, driven by hand-built chunks */
+    ExecChunk* chunk = ExecChunk_create(cxt, 1);
+    for (usize r = 0; r < 6; r++)
+    {
+        execChunk_col(chunk, 0)[r] = Int64GetDatum((i64)r - 3);
+        chunk->null_bits[r] = r == 4;
+    }
+    chunk->count = 6;
+    collect->count = 0;
+    ExecPredicate neg = {.col = 0, .type = TUPLE_COL_I64, .op = EXEC_CMP_GE, .value = Int64GetDatum(0)};
+    PhysicalFilter* f2 = PhysicalFilter_create(&ctx, &neg, 1, &collect->base);
+    VCALL(&f2->base, push, chunk);
+    CHECK(chunk->has_sel && chunk->sel_count == 2 && chunk->sel[0] == 3 && chunk->sel[1] == 5,
+          "NULL row fails the comparison; survivors selected in order");
+
+    chunk->has_sel = false;
+    ExecPredicate isnull = {.col = 0, .op = EXEC_CMP_IS_NULL};
+    PhysicalFilter* f3 = PhysicalFilter_create(&ctx, &isnull, 1, &collect->base);
+    VCALL(&f3->base, push, chunk);
+    CHECK(chunk->sel_count == 1 && chunk->sel[0] == 4, "IS NULL selects only the NULL row");
+
+    memoryContext_delete(cxt);
+    free(res);
+}
+
+/* ================================================================
+ * Test 3: top-k matches the table's own scan
+ * ================================================================ */
+static void test_topk(Fixture* f)
+{
+    printf("\n=== Test topk ===\n");
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "query", 0);
+    ExecContext ctx = {.cxt = cxt};
+    f32 q[DIM] = {77.3f, 1.0f};
+    VectorCondition vc = {.query = {TYPE_FLOAT32, DIM, (data_ptr_t)q}, .metric = L2};
+    TableQueryResult res[10];
+    u16 cols[1] = {0};
+
+    PhysicalCollect* collect = PhysicalCollect_create(&ctx, res, 10);
+    PhysicalTopK* topk = PhysicalTopK_create(&ctx, &vc, 10, 1, &collect->base);
+    PhysicalTableScan* scan = PhysicalTableScan_create(&ctx, &f->dt, cols, 1);
+    CHECK(physicalTableScan_run(scan, &topk->base) == 0, "top-k pipeline runs");
+
+    TableQueryResult ref[10];
+    int nref = dataTable_scan(&f->dt, &vc, ref, 10);
+    bool same = collect->count == 10 && nref == 10;
+    bool sorted = true;
+    for (usize i = 0; same && i < 10; i++)
+    {
+        same &= DatumGetInt32(res[i].payloads[0]) == DatumGetInt32(ref[i].payloads[0]);
+        same &= fabsf(res[i].distance - ref[i].distance) < 1e-5f;
+        if (i > 0 && res[i].distance < res[i - 1].distance) sorted = false;
+    }
+    for (int i = 0; i < nref; i++)
+    {
+        tupleDesc_free_datums(&f->et.heap_table.store.desc, tupleDesc_cols_mask(3), 0,
+                              ref[i].payloads);
+        free(ref[i].payloads);
+    }
+    CHECK(same, "same rows and distances as dataTable_scan");
+    CHECK(sorted && DatumGetInt32(res[0].payloads[0]) == 77, "output ascending by distance");
+
+    /* hybrid: only ids above 100, nearest 5 */
+    memoryContext_reset(cxt);
+    ExecPredicate gt100[1] = {{.col = 0, .type = TUPLE_COL_I32, .op = EXEC_CMP_GT, .value = Int32GetDatum(100)}};
+    collect = PhysicalCollect_create(&ctx, res, 10);
+    topk = PhysicalTopK_create(&ctx, &vc, 5, 1, &collect->base);
+    PhysicalFilter* filter = PhysicalFilter_create(&ctx, gt100, 1, &topk->base);
+    scan = PhysicalTableScan_create(&ctx, &f->dt, cols, 1);
+    physicalTableScan_run(scan, &filter->base);
+    bool hybrid = collect->count == 5;
+    for (usize i = 0; hybrid && i < 5; i++) hybrid = DatumGetInt32(res[i].payloads[0]) == (i32)(101 + i);
+    CHECK(hybrid, "filter before top-k restricts the candidates");
+
+    memoryContext_delete(cxt);
+}
+
+/* ================================================================
+ * Test 4: projection and limit
+ * ================================================================ */
+static void test_project_limit(Fixture* f)
+{
+    printf("\n=== Test project_limit ===\n");
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "query", 0);
+    ExecContext ctx = {.cxt = cxt};
+    TableQueryResult res[32];
+    u16 scan_cols[3] = {0, 1, 2};
+    u16 proj_cols[2] = {2, 0};
+
+    /* ids >= 10, skip 45, take 20: crosses a batch boundary */
+    ExecPredicate ge10 = {.col = 0, .type = TUPLE_COL_I32, .op = EXEC_CMP_GE, .value = Int32GetDatum(10)};
+    PhysicalCollect* collect = PhysicalCollect_create(&ctx, res, 32);
+    PhysicalLimit* limit = PhysicalLimit_create(&ctx, 20, 45, &collect->base);
+    PhysicalProjection* proj = PhysicalProjection_create(&ctx, proj_cols, 2, &limit->base);
+    PhysicalFilter* filter = PhysicalFilter_create(&ctx, &ge10, 1, &proj->base);
+    PhysicalTableScan* scan = PhysicalTableScan_create(&ctx, &f->dt, scan_cols, 3);
+    CHECK(physicalTableScan_run(scan, &filter->base) == 0, "projection pipeline runs");
+    CHECK(collect->count == 20, "limit returns exactly 20 rows");
+
+    bool ok = true;
+    for (usize i = 0; i < collect->count; i++)
+    {
+        const u8* tag = DatumGetPointer(res[i].payloads[0]);
+        i32 id = DatumGetInt32(res[i].payloads[1]);
+        if (id != (i32)(55 + i) || tag[5] != '0' + id % 10) ok = false;
+    }
+    CHECK(ok, "offset skipped 45 rows; projected columns reordered");
+    CHECK(scan->rows_scanned < N_ROWS, "scan stops once the limit is reached");
+
+    /* projection remaps null bits to the output column positions */
+    ExecChunk* in = ExecChunk_create(cxt, 3);
+    in->count = 2;
+    in->null_bits[0] = 1u << 2;
+    in->null_bits[1] = 1u << 0;
+    collect = PhysicalCollect_create(&ctx, res, 32);
+    PhysicalProjection* p2 = PhysicalProjection_create(&ctx, proj_cols, 2, &collect->base);
+    VCALL(&p2->base, push, in);
+    CHECK(p2->out->null_bits[0] == 1u && p2->out->null_bits[1] == 2u, "null bits follow their columns");
+
+    memoryContext_delete(cxt);
+}
+
+/* ================================================================
+ * Test 5: heap-only table
+ * ================================================================ */
+static void test_heap_table(void)
+{
+    printf("\n=== Test heap_table ===\n");
+
+    static const TupleColType cols[1] = {TUPLE_COL_I64};
+    static const TableSchema schema = {.cols = cols, .ncols = 1};
+    HeapTable ht;
+    HeapTable_init(&ht, &schema, NULL);
+    for (i64 i = 0; i < 120; i++)
+    {
+        Datum d = Int64GetDatum(i * 3);
+        heapStore_insert(&ht.store, 0, INVALID_ITEM_PTR, &d, 0);
+    }
+    DataTable dt;
+    DataTable_init(&dt);
+    dt.table = &ht.base;
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "query", 0);
+    ExecContext ctx = {.cxt = cxt};
+    TableQueryResult res[128];
+    u16 c0 = 0;
+    ExecPredicate le30 = {.col = 0, .type = TUPLE_COL_I64, .op = EXEC_CMP_LE, .value = Int64GetDatum(30)};
+    PhysicalCollect* collect = PhysicalCollect_create(&ctx, res, 128);
+    PhysicalFilter* filter = PhysicalFilter_create(&ctx, &le30, 1, &collect->base);
+    PhysicalTableScan* scan = PhysicalTableScan_create(&ctx, &dt, &c0, 1);
+    CHECK(scan && scan->emb == NULL, "heap table scanned without an embedding store");
+    CHECK(physicalTableScan_run(scan, &filter->base) == 0 && collect->count == 11,
+          "filter over heap rows");
+    CHECK(res[0].vector.data == NULL && res[0].vector.count == 0, "no vector for heap rows");
+
+    memoryContext_delete(cxt);
+    DataTable_deinit(&dt);
+    HeapTable_deinit(&ht);
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   Executor Test Suite\n");
+    printf("========================================\n");
+
+    Fixture* f = calloc(1, sizeof(Fixture));
+    fixture_init(f);
+    test_scan_collect(f);
+    test_filter(f);
+    test_topk(f);
+    test_project_limit(f);
+    fixture_deinit(f);
+    free(f);
+
+    test_heap_table();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
@@ -423,6 +423,37 @@ void test_hmap_collisions(void)
     hmap_destroy(map);
 }
 
+// ========== Test: 64-bit keys (hmap_u64_hash) ==========
+void test_hmap_u64_keys(void)
+{
+    printf("\n=== Test hmap_u64_keys ===\n");
+
+    hmap map;
+    hmap_init(&map, sizeof(u64), sizeof(int), HMAP_DEFAULT_NBUCKETS, hmap_u64_hash, hmap_u64_cmp);
+
+    // 只在高 32 位不同的 key 必须各自独立
+    int n = 1000;
+    bool ok = true;
+    for (int i = 0; i < n; i++)
+    {
+        u64 key = ((u64)i << 32) | 7;
+        if (!hmap_insert(&map, &key, &i)) ok = false;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        u64 key = ((u64)i << 32) | 7;
+        hmap_node* node = hmap_get(&map, &key);
+        if (!node || HMAP_VALUE(node, int) != i) ok = false;
+    }
+    u64 missing = 7 | (1ULL << 63);
+    if (ok && hmap_size(&map) == (usize)n && !hmap_get(&map, &missing))
+        PASS("%d keys differing only in the high 32 bits stay distinct", n);
+    else
+        FAIL("64-bit keys collided or were lost");
+
+    hmap_deinit(&map);
+}
+
 // ========== Test: automatic grow ==========
 void test_hmap_grow(void)
 {
@@ -2142,6 +2173,126 @@ void test_hmap_value_copy_independence(void)
     hmap_destroy(map);
 }
 
+// ========== Test: capacity rounds up to a power of two ==========
+void test_hmap_pow2_capacity(void)
+{
+    printf("\n=== Test hmap_pow2_capacity ===\n");
+
+    hmap* map = hmap_create(sizeof(int), sizeof(int), 10, int_hash, int_compare);
+    if (!map) { FAIL("hmap_create failed"); return; }
+
+    if (map->nbuckets == 16)
+        PASS("nbuckets=10 rounded up to 16");
+    else
+        FAIL("nbuckets=%zu, expected 16", map->nbuckets);
+
+    int keys[100], values[100];
+    for (int i = 0; i < 100; i++)
+    {
+        keys[i] = i;
+        values[i] = i;
+        hmap_insert(map, &keys[i], &values[i]);
+    }
+    if ((map->nbuckets & (map->nbuckets - 1)) == 0 && map->len * 4 <= map->nbuckets * 3)
+        PASS("Grown capacity stays a power of two under 75%% load (%zu)", map->nbuckets);
+    else
+        FAIL("Grown capacity %zu bad for %zu items", map->nbuckets, map->len);
+
+    hmap_destroy(map);
+}
+
+// ========== Test: node pointers survive growth ==========
+void test_hmap_node_stability(void)
+{
+    printf("\n=== Test hmap_node_stability ===\n");
+
+    hmap* map = hmap_create(sizeof(int), sizeof(int), 4, int_hash, int_compare);
+    if (!map) { FAIL("hmap_create failed"); return; }
+
+    int key = -1, value = 7;
+    hmap_node* pinned = hmap_insert(map, &key, &value);
+
+    for (int i = 0; i < 5000; i++) hmap_insert(map, &i, &i);
+    for (int i = 0; i < 5000; i += 2) hmap_delete(map, &i, NULL);
+
+    if (hmap_get(map, &key) == pinned && HMAP_VALUE(pinned, int) == 7)
+        PASS("Node returned by insert is unchanged after growth and deletes");
+    else
+        FAIL("Node pointer moved during rehash");
+
+    HMAP_VALUE(pinned, int) = 8;
+    hmap_node* again = hmap_get(map, &key);
+    if (again && HMAP_VALUE(again, int) == 8)
+        PASS("Write through a held node is visible to hmap_get");
+    else
+        FAIL("Write through a held node was lost");
+
+    hmap_destroy(map);
+}
+
+// ========== Test: tombstones do not break probing ==========
+void test_hmap_tombstone_churn(void)
+{
+    printf("\n=== Test hmap_tombstone_churn ===\n");
+
+    // Weak identity hash + random insert/delete mix, checked against a shadow array
+    hmap* map = hmap_create(sizeof(int), sizeof(int), 8, int_hash, int_compare);
+    if (!map) { FAIL("hmap_create failed"); return; }
+
+    enum { KEYSPACE = 512, OPS = 200000 };
+    int shadow[KEYSPACE];
+    bool present[KEYSPACE] = {false};
+    usize live = 0;
+    unsigned seed = 12345;
+    bool consistent = true;
+    usize max_nbuckets = 0;
+
+    for (int op = 0; op < OPS; op++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        int k = (int)((seed >> 8) % KEYSPACE);
+        if ((seed >> 20) & 1)
+        {
+            int v = op;
+            hmap_insert(map, &k, &v);
+            if (!present[k]) live++;
+            present[k] = true;
+            shadow[k] = v;
+        }
+        else
+        {
+            int out = -1;
+            int rc = hmap_delete(map, &k, &out);
+            if ((rc == 0) != present[k] || (rc == 0 && out != shadow[k])) consistent = false;
+            if (present[k]) live--;
+            present[k] = false;
+        }
+        if (map->nbuckets > max_nbuckets) max_nbuckets = map->nbuckets;
+    }
+
+    for (int k = 0; k < KEYSPACE; k++)
+    {
+        hmap_node* node = hmap_get(map, &k);
+        if ((node != NULL) != present[k] || (node && *(int*)node->value != shadow[k]))
+        {
+            consistent = false;
+            break;
+        }
+    }
+
+    if (consistent && hmap_size(map) == live)
+        PASS("Insert/delete churn matches shadow (%zu live)", live);
+    else
+        FAIL("Churn diverged from shadow (size=%zu, live=%zu)", hmap_size(map), live);
+
+    if (max_nbuckets <= 2048)
+        PASS("Tombstones reclaimed without unbounded growth (max %zu buckets)", max_nbuckets);
+    else
+        FAIL("Table kept growing under churn (%zu buckets)", max_nbuckets);
+
+    hmap_destroy(map);
+}
+
 int main(void)
 {
     printf("========================================\n");
@@ -2166,11 +2317,15 @@ int main(void)
     test_hmap_update();
     test_hmap_string_keys();
     test_hmap_collisions();
+    test_hmap_u64_keys();
     test_hmap_grow();
     test_hmap_stress();
     test_hmap_churn();
     test_hmap_node_access();
     test_hmap_value_copy_independence();
+    test_hmap_pow2_capacity();
+    test_hmap_node_stability();
+    test_hmap_tombstone_churn();
 
     // MAKE / MAP macro tests
     test_hmap_make_macro();
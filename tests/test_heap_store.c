@@ -0,0 +1,817 @@
+/**
+ * test_heap_store.c
+ *
+ * Tests for the slotted-page HeapStore internals:
+ *   FreeSpaceMap            (max-tree search / grow)
+ *   heapStore_insert        (FSM-driven LP_UNUSED slot reuse)
+ *   block_map               (block_id → page lookup for ctids)
+ *   heapStore_vacuum        (dead tuple reclamation, batches, concurrent with readers)
+ *   VisibilityMap           (all-visible bits set by vacuum, cleared by writes)
+ *   heapStore_update_by_ctid (HOT chains, redirect stubs, shared emb slots)
+ *   TupleDesc               (attcacheoff fast path, column-subset deform)
+ *   varlena deform          (TEXT / JSONB: zero-copy, arena and malloc copies)
+ *   page latches            (concurrent inserts, updates and scans without a store lock)
+ *   page compaction         (reused slots whose tuples sit below later slots' tuples)
+ *
+ * Compile & run:
+ *   cd tests && make test_heap_store && ./test_heap_store
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../src/table.h"
+#include "../src/freespace.h"
+#include "../src/visibilitymap.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+/* ---- one int32 payload column ---- */
+static const TupleColType i32_cols[1] = {TUPLE_COL_I32};
+static const TableSchema i32_schema = {.cols = i32_cols, .ncols = 1};
+
+static BlockSegment* page_seg(HeapStore* store, usize page_no)
+{
+    return (BlockSegment*)VECTOR_AT(store->tree.nodes, page_no, SegmentNode).node;
+}
+
+static ItemPtr insert_i32(HeapStore* store, i32 v)
+{
+    Datum d = Int32GetDatum(v);
+    return heapStore_insert(store, 0, INVALID_ITEM_PTR, &d, 0);
+}
+
+/* ================================================================
+ * Test 1: FreeSpaceMap search returns the lowest page with enough room
+ * ================================================================ */
+static void test_fsm_search(void)
+{
+    printf("\n=== Test fsm_search ===\n");
+
+    FreeSpaceMap fsm;
+    FreeSpaceMap_init(&fsm);
+    CHECK(freeSpaceMap_search(&fsm, 1) == FSM_NOT_FOUND, "empty map finds nothing");
+
+    for (u32 p = 0; p < 100; p++) freeSpaceMap_set(&fsm, p, 0);
+    freeSpaceMap_set(&fsm, 37, 200);
+    freeSpaceMap_set(&fsm, 81, 4000);
+    CHECK(fsm.nleaves >= 100, "map grows to cover every page");
+    CHECK(freeSpaceMap_search(&fsm, 100) == 37, "smallest fitting page found first");
+    CHECK(freeSpaceMap_search(&fsm, 1000) == 81, "larger request skips small page");
+    CHECK(freeSpaceMap_search(&fsm, 5000) == FSM_NOT_FOUND, "oversized request not found");
+
+    freeSpaceMap_set(&fsm, 37, 0);
+    CHECK(freeSpaceMap_search(&fsm, 100) == 81, "cleared page drops out of search");
+    CHECK(freeSpaceMap_get(&fsm, 81) == 4000 / FSM_CAT_STEP, "category stored per page");
+
+    freeSpaceMap_reset(&fsm);
+    CHECK(freeSpaceMap_search(&fsm, 1) == FSM_NOT_FOUND, "reset forgets all pages");
+    FreeSpaceMap_deinit(&fsm);
+}
+
+/* ================================================================
+ * Test 2: inserts reuse LP_UNUSED slots found through the FSM
+ * ================================================================ */
+static void test_insert_reuses_free_slots(void)
+{
+    printf("\n=== Test insert_reuses_free_slots ===\n");
+
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &i32_schema, NULL);
+
+    ItemPtr ctids[1000];
+    for (i32 i = 0; i < 1000; i++) ctids[i] = insert_i32(&store, i);
+    usize npages = vector_size(store.tree.nodes);
+    CHECK(npages >= 4, "1000 rows span several pages");
+    CHECK(freeSpaceMap_search(&store.fsm, 1) == FSM_NOT_FOUND, "full pages have no FSM space");
+
+    /* delete the first 10 slots of page 2 and vacuum them */
+    BlockSegment* seg2 = page_seg(&store, 2);
+    for (i32 i = 0; i < 1000; i++)
+        if (item_ptr_block_id(ctids[i]) == seg2->block_id && item_ptr_slot(ctids[i]) < 10)
+            heapStore_delete_by_ctid(&store, ctids[i]);
+    CHECK(heapStore_vacuum(&store, VACUUM_HORIZON_ALL, NULL, NULL) == 10,
+          "vacuum reclaims the deleted slots");
+    CHECK(freeSpaceMap_search(&store.fsm, 48) == 2, "vacuum publishes the page to the FSM");
+
+    bool all_on_page2 = true;
+    for (int i = 0; i < 10; i++)
+    {
+        ItemPtr ctid = insert_i32(&store, 5000 + i);
+        if (item_ptr_block_id(ctid) != seg2->block_id || item_ptr_slot(ctid) != i)
+            all_on_page2 = false;
+    }
+    CHECK(all_on_page2, "inserts fill freed slots in order");
+    CHECK(vector_size(store.tree.nodes) == npages, "slot reuse allocates no new page");
+    CHECK(freeSpaceMap_search(&store.fsm, 1) == FSM_NOT_FOUND, "refilled page leaves the FSM");
+
+    HeapTuple tup;
+    ItemPtr first = make_item_ptr(seg2->block_id, 0);
+    CHECK(heapStore_get_by_ctid(&store, &i32_schema, first, &tup) == 0 &&
+              DatumGetInt32(tup.cols[0]) == 5000,
+          "reused slot holds the new tuple");
+    free(tup.cols);
+
+    ItemPtr next = insert_i32(&store, 9999);
+    BlockSegment* last = (BlockSegment*)segmentTree_get_last_segment(&store.tree);
+    CHECK(item_ptr_block_id(next) == last->block_id, "without FSM space insert appends");
+
+    HeapStore_deinit(&store);
+}
+
+/* ================================================================
+ * Test 3: ctid lookups resolve rows on every page
+ * ================================================================ */
+static void test_get_by_ctid_multi_page(void)
+{
+    printf("\n=== Test get_by_ctid_multi_page ===\n");
+
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &i32_schema, NULL);
+
+    ItemPtr ctids[3000];
+    for (i32 i = 0; i < 3000; i++) ctids[i] = insert_i32(&store, i * 3);
+    CHECK(hmap_size(&store.block_map) == vector_size(store.tree.nodes), "one map entry per page");
+
+    bool all_ok = true;
+    for (i32 i = 2999; i >= 0; i -= 7)
+    {
+        HeapTuple tup;
+        if (heapStore_get_by_ctid(&store, &i32_schema, ctids[i], &tup) != 0 ||
+            DatumGetInt32(tup.cols[0]) != i * 3)
+            all_ok = false;
+        else
+            free(tup.cols);
+    }
+    CHECK(all_ok, "get_by_ctid finds rows on every page");
+
+    HeapTuple tup;
+    ItemPtr bogus = make_item_ptr(123456, 0);
+    CHECK(heapStore_get_by_ctid(&store, &i32_schema, bogus, &tup) == -1,
+          "ctid on an unknown block is rejected");
+    CHECK(heapStore_delete_by_ctid(&store, ctids[1500]) != INVALID_TXN_ID,
+          "delete_by_ctid resolves the page");
+
+    HeapStore_deinit(&store);
+}
+
+static u64 count_live(HeapStore* store)
+{
+    u64 live = 0;
+    HeapStoreIter iter;
+    heapStoreIter_begin(&iter, store);
+    const TupleHdr* hdr;
+    while ((hdr = heapStoreIter_next(&iter)) != NULL)
+        if (hdr->t_xmax == INVALID_TXN_ID) live++;
+    heapStoreIter_end(&iter);
+    return live;
+}
+
+static void count_vacuumed(const TupleHdr* hdr, void* arg)
+{
+    (void)hdr;
+    (*(u64*)arg)++;
+}
+
+/* ================================================================
+ * Test 4: vacuum honours the horizon, compacts pages, keeps live ctids
+ * ================================================================ */
+static void test_vacuum_reclaims_dead_tuples(void)
+{
+    printf("\n=== Test vacuum_reclaims_dead_tuples ===\n");
+
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &i32_schema, NULL);
+
+    ItemPtr ctids[1000];
+    for (i32 i = 0; i < 1000; i++) ctids[i] = insert_i32(&store, i);
+    TxnId first_delete = 0;
+    for (i32 i = 0; i < 1000; i += 2)
+    {
+        TxnId xid = heapStore_delete_by_ctid(&store, ctids[i]);
+        if (i == 0) first_delete = xid;
+    }
+    CHECK(first_delete != INVALID_TXN_ID, "delete assigns a real xid");
+    CHECK(heapStore_vacuum(&store, first_delete, NULL, NULL) == 0,
+          "deletes at or after the horizon are kept");
+
+    u64 seen = 0;
+    u32 next_page = 0;
+    u64 batch = heapStore_vacuum_pages(&store, VACUUM_HORIZON_ALL, &next_page, 1, count_vacuumed,
+                                       &seen);
+    CHECK(next_page == 1 && batch > 0 && batch < 500, "one-page batch stops after page 0");
+    CHECK(batch + heapStore_vacuum(&store, VACUUM_HORIZON_ALL, count_vacuumed, &seen) == 500,
+          "vacuum reclaims every deleted tuple");
+    CHECK(seen == 500, "callback sees each reclaimed tuple");
+    CHECK(count_live(&store) == 500, "live tuples survive vacuum");
+
+    bool intact = true;
+    for (i32 i = 1; i < 1000; i += 2)
+    {
+        HeapTuple tup;
+        if (heapStore_get_by_ctid(&store, &i32_schema, ctids[i], &tup) != 0 ||
+            DatumGetInt32(tup.cols[0]) != i)
+            intact = false;
+        else
+            free(tup.cols);
+    }
+    CHECK(intact, "live ctids resolve to the same rows after compaction");
+    CHECK(freeSpaceMap_search(&store.fsm, 48) == 0, "vacuumed pages published to the FSM");
+
+    usize npages = vector_size(store.tree.nodes);
+    for (i32 i = 0; i < 500; i++) insert_i32(&store, 10000 + i);
+    CHECK(vector_size(store.tree.nodes) == npages, "re-inserts fill vacuumed space");
+
+    HeapStore_deinit(&store);
+}
+
+typedef struct
+{
+    HeapStore* store;
+    u64 reclaimed;
+} VacuumArg;
+
+static void* vacuum_thread(void* arg)
+{
+    VacuumArg* va = arg;
+    va->reclaimed = heapStore_vacuum(va->store, VACUUM_HORIZON_ALL, NULL, NULL);
+    return NULL;
+}
+
+/* ================================================================
+ * Test 5: scans running beside vacuum always see every live tuple
+ * ================================================================ */
+static void test_vacuum_concurrent_with_readers(void)
+{
+    printf("\n=== Test vacuum_concurrent_with_readers ===\n");
+
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &i32_schema, NULL);
+
+    ItemPtr* ctids = malloc(20000 * sizeof(ItemPtr));
+    for (i32 i = 0; i < 20000; i++) ctids[i] = insert_i32(&store, i);
+    for (i32 i = 0; i < 20000; i += 3) heapStore_delete_by_ctid(&store, ctids[i]);
+    u64 live = 20000 - 6667;
+
+    VacuumArg va = {.store = &store};
+    pthread_t th;
+    pthread_create(&th, NULL, vacuum_thread, &va);
+    bool consistent = true;
+    for (int r = 0; r < 20; r++)
+        if (count_live(&store) != live) consistent = false;
+    pthread_join(th, NULL);
+
+    CHECK(consistent, "concurrent scans see a stable live set");
+    CHECK(va.reclaimed == 6667, "concurrent vacuum reclaims every dead tuple");
+    CHECK(count_live(&store) == live, "live count unchanged after vacuum");
+
+    free(ctids);
+    HeapStore_deinit(&store);
+}
+
+/* ================================================================
+ * Test 6: vacuum marks clean pages all-visible; writes clear the bit
+ * ================================================================ */
+static void test_visibility_map(void)
+{
+    printf("\n=== Test visibility_map ===\n");
+
+    VisibilityMap vm;
+    VisibilityMap_init(&vm);
+    visibilityMap_set(&vm, 1000, VM_ALL_VISIBLE);
+    visibilityMap_set(&vm, 1001, VM_ALL_VISIBLE | VM_ALL_FROZEN);
+    CHECK(visibilityMap_get(&vm, 1000) == VM_ALL_VISIBLE, "map grows and keeps bits per page");
+    CHECK(visibilityMap_get(&vm, 999) == 0 && visibilityMap_get(&vm, 1 << 20) == 0,
+          "unset pages read as not visible");
+    visibilityMap_clear(&vm, 1001);
+    CHECK(visibilityMap_get(&vm, 1001) == 0 && visibilityMap_get(&vm, 1000) == VM_ALL_VISIBLE,
+          "clear touches only its own page");
+    VisibilityMap_deinit(&vm);
+
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &i32_schema, NULL);
+    for (i32 i = 0; i < 3000; i++) insert_i32(&store, i);
+    u32 npages = (u32)vector_size(store.tree.nodes);
+    CHECK(visibilityMap_count(&store.vm, npages, VM_ALL_VISIBLE) == 0,
+          "fresh pages are not all-visible");
+
+    heapStore_vacuum(&store, VACUUM_HORIZON_ALL, NULL, NULL);
+    CHECK(visibilityMap_count(&store.vm, npages, VM_ALL_VISIBLE | VM_ALL_FROZEN) == npages,
+          "vacuum marks every clean page all-visible and all-frozen");
+
+    BlockSegment* seg2 = page_seg(&store, 2);
+    ItemPtr victim = make_item_ptr(seg2->block_id, 3);
+    heapStore_delete_by_ctid(&store, victim);
+    CHECK(visibilityMap_get(&store.vm, 2) == 0, "delete clears its page's bits");
+    CHECK(visibilityMap_count(&store.vm, npages, VM_ALL_VISIBLE) == npages - 1,
+          "other pages stay all-visible");
+
+    HeapStoreIter iter;
+    heapStoreIter_begin(&iter, &store);
+    bool flags_ok = true;
+    while (heapStoreIter_next(&iter) != NULL)
+        if (iter.page_all_visible != (iter.page_no != 2)) flags_ok = false;
+    heapStoreIter_end(&iter);
+    CHECK(flags_ok, "iterator reports all-visible per page");
+
+    u64 seen = 0;
+    CHECK(heapStore_vacuum(&store, VACUUM_HORIZON_ALL, count_vacuumed, &seen) == 1 && seen == 1,
+          "second vacuum only reclaims the new dead tuple");
+    CHECK(visibilityMap_get(&store.vm, 2) & VM_ALL_VISIBLE, "pruned page becomes all-visible");
+
+    ItemPtr refill = insert_i32(&store, 99999);
+    CHECK(item_ptr_block_id(refill) == seg2->block_id, "insert reuses the freed slot");
+    CHECK(visibilityMap_get(&store.vm, 2) == 0, "insert clears its page's bits");
+
+    HeapStore_deinit(&store);
+}
+
+/* vacuum callback: remembers the normalized header of every reclaimed tuple */
+typedef struct
+{
+    int n;
+    TupleHdr hdrs[8];
+} VacuumLog;
+
+static void log_vacuumed(const TupleHdr* hdr, void* arg)
+{
+    VacuumLog* log = arg;
+    if (log->n < 8) log->hdrs[log->n] = *hdr;
+    log->n++;
+}
+
+static TxnId update_i32(HeapStore* store, ItemPtr ctid, i32 v, ItemPtr emb_ctid, HeapTuple* nt)
+{
+    Datum d = Int32GetDatum(v);
+    *nt = (HeapTuple){.cols = &d, .ncols = 1};
+    nt->hdr.t_emb_ctid = emb_ctid;
+    TxnId xid = heapStore_update_by_ctid(store, ctid, nt);
+    nt->cols = NULL;
+    return xid;
+}
+
+static i32 get_i32(HeapStore* store, ItemPtr ctid)
+{
+    HeapTuple out;
+    if (heapStore_get_by_ctid(store, &i32_schema, ctid, &out) != 0) return -1;
+    i32 v = DatumGetInt32(out.cols[0]);
+    row_tuple_free(&out, &i32_schema);
+    return v;
+}
+
+/* ================================================================
+ * Test 7: HOT updates chain on the page; vacuum leaves a redirect for the root
+ * ================================================================ */
+static void test_hot_update_chain(void)
+{
+    printf("\n=== Test hot_update_chain ===\n");
+
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &i32_schema, NULL);
+    ItemPtr emb = make_item_ptr(7, 0);
+    Datum d = Int32GetDatum(1);
+    ItemPtr root = heapStore_insert(&store, 0, emb, &d, 0);
+
+    HeapTuple nt;
+    CHECK(update_i32(&store, root, 2, emb, &nt) != INVALID_TXN_ID, "update succeeds");
+    ItemPtr v2 = nt.hdr.t_ctid;
+    CHECK(item_ptr_block_id(v2) == item_ptr_block_id(root) &&
+              (nt.hdr.t_infomask & HEAP_ONLY_TUPLE),
+          "new version is heap-only on the same page");
+    CHECK(get_i32(&store, v2) == 2, "new version readable at its ctid");
+    CHECK(update_i32(&store, root, 3, emb, &nt) == INVALID_TXN_ID,
+          "updating a superseded version fails");
+
+    VacuumLog log = {0};
+    CHECK(heapStore_vacuum(&store, VACUUM_HORIZON_ALL, log_vacuumed, &log) == 1 && log.n == 1,
+          "vacuum prunes the old version");
+    CHECK(!item_ptr_is_valid(log.hdrs[0].t_ctid), "root keeps its index entry (redirect)");
+    CHECK(!item_ptr_is_valid(log.hdrs[0].t_emb_ctid), "shared embedding slot is not freed");
+    CHECK(get_i32(&store, root) == 2, "root ctid redirects to the live version");
+
+    CHECK(update_i32(&store, root, 3, emb, &nt) != INVALID_TXN_ID, "update through the redirect");
+    ItemPtr v3 = nt.hdr.t_ctid;
+    log.n = 0;
+    CHECK(heapStore_vacuum(&store, VACUUM_HORIZON_ALL, log_vacuumed, &log) == 1 &&
+              !item_ptr_is_valid(log.hdrs[0].t_ctid),
+          "heap-only version pruned without an index key");
+    CHECK(get_i32(&store, root) == 3 && get_i32(&store, v3) == 3, "redirect retargeted");
+
+    CHECK(heapStore_delete_by_ctid(&store, root) != INVALID_TXN_ID, "delete through the redirect");
+    log.n = 0;
+    heapStore_vacuum(&store, VACUUM_HORIZON_ALL, log_vacuumed, &log);
+    CHECK(log.n == 2 && item_ptr_equal(log.hdrs[0].t_ctid, root) &&
+              !item_ptr_is_valid(log.hdrs[0].t_emb_ctid),
+          "dead stub reports the root as index key");
+    CHECK(!item_ptr_is_valid(log.hdrs[1].t_ctid) && item_ptr_equal(log.hdrs[1].t_emb_ctid, emb),
+          "last version frees the embedding slot once");
+    CHECK(get_i32(&store, root) == -1, "stub reclaimed with the chain");
+
+    /* a full page forces the new version elsewhere: not HOT */
+    ItemPtr cold = INVALID_ITEM_PTR;
+    while (vector_size(store.tree.nodes) < 2)
+    {
+        ItemPtr c = insert_i32(&store, 0);
+        if (vector_size(store.tree.nodes) < 2) cold = c;
+    }
+    BlockSegment* first = page_seg(&store, 0);
+    CHECK(update_i32(&store, cold, 4, INVALID_ITEM_PTR, &nt) != INVALID_TXN_ID &&
+              !(nt.hdr.t_infomask & HEAP_ONLY_TUPLE) &&
+              item_ptr_block_id(nt.hdr.t_ctid) != first->block_id,
+          "update off a full page is not HOT");
+
+    HeapStore_deinit(&store);
+}
+
+/* ================================================================
+ * Test 8: cached offsets and column-subset deform agree with a full decode
+ * ================================================================ */
+static void test_tuple_desc_deform(void)
+{
+    printf("\n=== Test tuple_desc_deform ===\n");
+
+    static const TupleColType cols[6] = {TUPLE_COL_I32, TUPLE_COL_I64,  TUPLE_COL_BOOL,
+                                         TUPLE_COL_F64, TUPLE_COL_TEXT, TUPLE_COL_I32};
+    static const TableSchema schema = {.cols = cols, .ncols = 6};
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &schema, NULL);
+    CHECK(store.desc.nfixed == 4 && store.desc.attcacheoff[3] == 13 &&
+              store.desc.attcacheoff[4] == 21,
+          "fixed-width prefix offsets cached");
+    TupleDesc fixed_desc;
+    TupleDesc_init(&fixed_desc, &i32_schema);
+    CHECK(fixed_desc.nfixed == 1 && fixed_desc.deform != store.desc.deform,
+          "all-fixed schema gets its own deform routine");
+
+    u8 text[4 + 5] = {5, 0, 0, 0, 'h', 'e', 'l', 'l', 'o'};
+    Datum row[6] = {Int32GetDatum(-7),         Int64GetDatum(1LL << 40), BoolGetDatum(true),
+                    Float64GetDatum(2.5),      PointerGetDatum(text),    Int32GetDatum(42)};
+    heapStore_insert(&store, 0, INVALID_ITEM_PTR, row, 0);
+    heapStore_insert(&store, 0, INVALID_ITEM_PTR, row, 1u << 1); /* col 1 NULL */
+
+    HeapStoreIter iter;
+    heapStoreIter_begin(&iter, &store);
+    int r = 0;
+    bool subset_ok = true, walk_ok = true, full_ok = true;
+    const TupleHdr* hdr;
+    while ((hdr = heapStoreIter_next(&iter)) != NULL)
+    {
+        HeapTupleRef ref = {.hdr = hdr, .col_data = iter.curr_col_data, .schema = &schema,
+                            .store = &store};
+        Datum out[6] = {99, 99, 99, 99, 99, 99};
+        heapStore_deform_cols(&ref, (1u << 3) | (1u << 5), out);
+        if (DatumGetFloat64(out[3]) != 2.5 || DatumGetInt32(out[5]) != 42) walk_ok = false;
+        if (out[0] != 99 || out[1] != 99 || out[2] != 99 || out[4] != 99) subset_ok = false;
+
+        heapStore_deform_tuple(&ref, out, 6);
+        if (DatumGetInt32(out[0]) != -7 || !DatumGetBool(out[2]) ||
+            memcmp(DatumGetPointer(out[4]), text, sizeof(text)) != 0)
+            full_ok = false;
+        if (r == 0 ? DatumGetInt64(out[1]) != (1LL << 40) : out[1] != 0) full_ok = false;
+        free(DatumGetPointer(out[4]));
+        r++;
+    }
+    heapStoreIter_end(&iter);
+    CHECK(r == 2, "both rows scanned");
+    CHECK(subset_ok, "subset deform leaves other columns untouched");
+    CHECK(walk_ok, "columns past a NULL and a varlena decode correctly");
+    CHECK(full_ok, "full deform matches the inserted row");
+
+    HeapStore_deinit(&store);
+}
+
+/* ================================================================
+ * Test 9: TEXT / JSONB deform by reference, into an arena, or malloc'd
+ * ================================================================ */
+static void test_varlena_deform_modes(void)
+{
+    printf("\n=== Test varlena_deform_modes ===\n");
+
+    static const TupleColType cols[3] = {TUPLE_COL_TEXT, TUPLE_COL_JSONB, TUPLE_COL_I32};
+    static const TableSchema schema = {.cols = cols, .ncols = 3};
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &schema, NULL);
+
+    u8 text[4 + 3] = {3, 0, 0, 0, 'a', 'b', 'c'};
+    u8 jsonb_buf[4 + 6] = {10, 0, 0, 0, 'j', 's', 'o', 'n', 'b', '!'};
+    Datum row[3] = {PointerGetDatum(text), JsonbGetDatum(jsonb_buf), Int32GetDatum(5)};
+    ItemPtr ctid = heapStore_insert(&store, 0, INVALID_ITEM_PTR, row, 0);
+    Datum null_text[3] = {0, JsonbGetDatum(jsonb_buf), Int32GetDatum(6)};
+    heapStore_insert(&store, 0, INVALID_ITEM_PTR, null_text, 1u << 0);
+
+    HeapTuple got;
+    CHECK(heapStore_get_by_ctid(&store, &schema, ctid, &got) == 0 &&
+              memcmp(DatumGetPointer(got.cols[0]), text, sizeof(text)) == 0 &&
+              DatumGetJsonb(got.cols[1])->vl_len_ == sizeof(jsonb_buf) &&
+              memcmp(DatumGetJsonb(got.cols[1])->data, "jsonb!", 6) == 0 &&
+              DatumGetInt32(got.cols[2]) == 5,
+          "TEXT and JSONB round-trip through get_by_ctid");
+    row_tuple_free(&got, &schema);
+
+    MemoryContext arena;
+    MemoryContext_init(&arena, NULL, "deform", 64);
+    HeapStoreIter iter;
+    heapStoreIter_begin(&iter, &store);
+    const TupleHdr* hdr;
+    int r = 0;
+    bool byref_in_page = true, arena_ok = true, null_ok = true;
+    while ((hdr = heapStoreIter_next(&iter)) != NULL)
+    {
+        HeapTupleRef ref = {.hdr = hdr, .col_data = iter.curr_col_data, .schema = &schema,
+                            .store = &store};
+        Datum byref[3], copy[3];
+        heapStore_deform_cols_byref(&ref, tupleDesc_cols_mask(3), byref);
+        const u8* jb = DatumGetPointer(byref[1]);
+        if (jb < iter.curr_col_data || jb >= (const u8*)hdr + iter.curr_tup_len)
+            byref_in_page = false;
+        heapStore_deform_cols_arena(&ref, tupleDesc_cols_mask(3), copy, &arena);
+        if (DatumGetPointer(copy[1]) == jb || memcmp(DatumGetPointer(copy[1]), jb, 10) != 0)
+            arena_ok = false;
+        if (r == 1 && (copy[0] != 0 || DatumGetInt32(copy[2]) != 6)) null_ok = false;
+        r++;
+    }
+    heapStoreIter_end(&iter);
+    CHECK(byref_in_page, "zero-copy Datums point into the page");
+    CHECK(arena_ok, "arena copies match the page bytes");
+    CHECK(null_ok, "NULL TEXT column skipped on write and read");
+
+    for (int i = 0; i < 10; i++) memoryContext_alloc(&arena, 40);
+    void* big = memoryContext_alloc(&arena, 1000);
+    CHECK(big != NULL, "oversized request gets its own block");
+    memoryContext_reset(&arena);
+    void* first = memoryContext_alloc(&arena, 8);
+    memoryContext_reset(&arena);
+    CHECK(first != NULL && memoryContext_alloc(&arena, 8) == first, "reset rewinds the kept block");
+    memoryContext_delete(&arena);
+
+    HeapStore_deinit(&store);
+}
+
+/* ================================================================
+ * Test 10: inserts, updates and scans run concurrently on page latches
+ * ================================================================ */
+#define LATCH_ROWS      4000
+#define LATCH_INSERTERS 4
+#define LATCH_INSERTS   5000
+#define LATCH_UPDATERS  2
+#define LATCH_ROUNDS    5
+
+typedef struct
+{
+    HeapStore* store;
+    ItemPtr* ctids; /* inserters: out; updaters: current version of each row */
+    int id;
+    bool ok;
+    _Atomic int* stop;
+    long bad;
+} LatchArg;
+
+static void* latch_inserter(void* arg)
+{
+    LatchArg* la = arg;
+    for (int i = 0; i < LATCH_INSERTS; i++)
+        la->ctids[la->id * LATCH_INSERTS + i] = insert_i32(la->store, -1 - la->id);
+    return NULL;
+}
+
+/* updater id owns rows r with r % LATCH_UPDATERS == id: no write conflicts */
+static void* latch_updater(void* arg)
+{
+    LatchArg* la = arg;
+    la->ok = true;
+    for (int round = 0; round < LATCH_ROUNDS; round++)
+        for (i32 r = la->id; r < LATCH_ROWS; r += LATCH_UPDATERS)
+        {
+            Datum d = Int32GetDatum(r);
+            HeapTuple nt = {.cols = &d, .ncols = 1};
+            nt.hdr.t_emb_ctid = INVALID_ITEM_PTR;
+            if (heapStore_update_by_ctid(la->store, la->ctids[r], &nt) == INVALID_TXN_ID)
+                la->ok = false;
+            la->ctids[r] = nt.hdr.t_ctid;
+        }
+    return NULL;
+}
+
+static void* latch_scanner(void* arg)
+{
+    LatchArg* la = arg;
+    while (!atomic_load(la->stop))
+    {
+        HeapStoreIter iter;
+        heapStoreIter_begin(&iter, la->store);
+        const TupleHdr* hdr;
+        while ((hdr = heapStoreIter_next(&iter)) != NULL)
+        {
+            i32 v;
+            memcpy(&v, iter.curr_col_data, sizeof(v));
+            if (v >= LATCH_ROWS || v < -LATCH_INSERTERS) la->bad++;
+        }
+        heapStoreIter_end(&iter);
+    }
+    return NULL;
+}
+
+static int cmp_u64(const void* a, const void* b)
+{
+    u64 x = *(const u64*)a, y = *(const u64*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void test_page_latches_concurrent(void)
+{
+    printf("\n=== Test page_latches_concurrent ===\n");
+
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &i32_schema, NULL);
+    ItemPtr* rows = malloc(LATCH_ROWS * sizeof(ItemPtr));
+    for (i32 r = 0; r < LATCH_ROWS; r++) rows[r] = insert_i32(&store, r);
+
+    ItemPtr* inserted = malloc(LATCH_INSERTERS * LATCH_INSERTS * sizeof(ItemPtr));
+    _Atomic int stop = 0;
+    LatchArg ins[LATCH_INSERTERS], upd[LATCH_UPDATERS], scan = {.store = &store, .stop = &stop};
+    pthread_t ins_th[LATCH_INSERTERS], upd_th[LATCH_UPDATERS], scan_th;
+    pthread_create(&scan_th, NULL, latch_scanner, &scan);
+    for (int t = 0; t < LATCH_INSERTERS; t++)
+    {
+        ins[t] = (LatchArg){.store = &store, .ctids = inserted, .id = t};
+        pthread_create(&ins_th[t], NULL, latch_inserter, &ins[t]);
+    }
+    for (int t = 0; t < LATCH_UPDATERS; t++)
+    {
+        upd[t] = (LatchArg){.store = &store, .ctids = rows, .id = t};
+        pthread_create(&upd_th[t], NULL, latch_updater, &upd[t]);
+    }
+    for (int t = 0; t < LATCH_INSERTERS; t++) pthread_join(ins_th[t], NULL);
+    bool upd_ok = true;
+    for (int t = 0; t < LATCH_UPDATERS; t++)
+    {
+        pthread_join(upd_th[t], NULL);
+        upd_ok = upd_ok && upd[t].ok;
+    }
+    atomic_store(&stop, 1);
+    pthread_join(scan_th, NULL);
+
+    CHECK(upd_ok, "every update of an owned row succeeds");
+    CHECK(scan.bad == 0, "scanners never see a torn tuple");
+
+    usize n = LATCH_INSERTERS * LATCH_INSERTS;
+    u64* keys = malloc(n * sizeof(u64));
+    for (usize i = 0; i < n; i++) keys[i] = item_ptr_pack(inserted[i]);
+    qsort(keys, n, sizeof(u64), cmp_u64);
+    bool distinct = true;
+    for (usize i = 1; i < n; i++)
+        if (keys[i] == keys[i - 1]) distinct = false;
+    CHECK(distinct, "concurrent inserts get distinct ctids");
+
+    bool readable = true;
+    for (int t = 0; t < LATCH_INSERTERS; t++)
+        for (int i = 0; i < LATCH_INSERTS; i++)
+        {
+            HeapTuple got;
+            if (heapStore_get_by_ctid(&store, &i32_schema, inserted[t * LATCH_INSERTS + i], &got) != 0)
+            {
+                readable = false;
+                continue;
+            }
+            if (DatumGetInt32(got.cols[0]) != -1 - t) readable = false;
+            row_tuple_free(&got, &i32_schema);
+        }
+    CHECK(readable, "inserted tuples read back intact");
+
+    int* seen = calloc(LATCH_ROWS, sizeof(int));
+    u64 live = 0;
+    HeapStoreIter iter;
+    heapStoreIter_begin(&iter, &store);
+    const TupleHdr* hdr;
+    while ((hdr = heapStoreIter_next(&iter)) != NULL)
+    {
+        if (hdr->t_xmax != INVALID_TXN_ID) continue;
+        i32 v;
+        memcpy(&v, iter.curr_col_data, sizeof(v));
+        if (v >= 0) seen[v]++;
+        live++;
+    }
+    heapStoreIter_end(&iter);
+    bool one_each = true;
+    for (i32 r = 0; r < LATCH_ROWS; r++)
+        if (seen[r] != 1) one_each = false;
+    CHECK(one_each, "every updated row has exactly one live version");
+    CHECK(live == LATCH_ROWS + n, "no insert lost");
+
+    free(seen);
+    free(keys);
+    free(inserted);
+    free(rows);
+    HeapStore_deinit(&store);
+}
+
+/* ================================================================
+ * Test 11: compaction after slot reuse keeps every tuple intact
+ *
+ * A reused slot's tuple is carved at pd_upper, below the tuples of
+ * later slots, so slot order no longer matches address order.
+ * ================================================================ */
+static ItemPtr insert_text(HeapStore* store, u8* buf, u32 len, char fill)
+{
+    buf[0] = (u8)len;
+    buf[1] = buf[2] = buf[3] = 0;
+    memset(buf + 4, fill, len);
+    Datum d = PointerGetDatum(buf);
+    return heapStore_insert(store, 0, INVALID_ITEM_PTR, &d, 0);
+}
+
+static bool text_is(HeapStore* store, const TableSchema* schema, ItemPtr ctid, u32 len, char fill)
+{
+    HeapTuple tup;
+    if (heapStore_get_by_ctid(store, schema, ctid, &tup) != 0) return false;
+    const u8* p = DatumGetPointer(tup.cols[0]);
+    bool ok = p != NULL && p[0] == len;
+    for (u32 i = 0; ok && i < len; i++) ok = p[4 + i] == (u8)fill;
+    row_tuple_free(&tup, schema);
+    return ok;
+}
+
+static void test_compact_after_slot_reuse(void)
+{
+    printf("\n=== Test compact_after_slot_reuse ===\n");
+
+    static const TupleColType cols[1] = {TUPLE_COL_TEXT};
+    static const TableSchema schema = {.cols = cols, .ncols = 1};
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &schema, NULL);
+
+    u8 a[4 + 40], b[4 + 40], c[4 + 40], d[4 + 120];
+    ItemPtr ca = insert_text(&store, a, 40, 'a');
+    ItemPtr cb = insert_text(&store, b, 40, 'b');
+    ItemPtr cc = insert_text(&store, c, 40, 'c');
+
+    heapStore_delete_by_ctid(&store, cb);
+    CHECK(heapStore_vacuum(&store, VACUUM_HORIZON_ALL, NULL, NULL) == 1, "B reclaimed");
+
+    ItemPtr cd = insert_text(&store, d, 120, 'd');
+    CHECK(item_ptr_equal(cd, cb), "larger D reuses B's slot");
+    CHECK(text_is(&store, &schema, cc, 40, 'c') && text_is(&store, &schema, cd, 120, 'd'),
+          "C and D readable before the second vacuum");
+
+    heapStore_delete_by_ctid(&store, ca);
+    CHECK(heapStore_vacuum(&store, VACUUM_HORIZON_ALL, NULL, NULL) == 1, "A reclaimed");
+    CHECK(text_is(&store, &schema, cc, 40, 'c'), "C intact after compaction");
+    CHECK(text_is(&store, &schema, cd, 120, 'd'), "D intact after compaction");
+
+    HeapStore_deinit(&store);
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   HeapStore Test Suite\n");
+    printf("========================================\n");
+
+    test_fsm_search();
+    test_insert_reuses_free_slots();
+    test_get_by_ctid_multi_page();
+    test_vacuum_reclaims_dead_tuples();
+    test_vacuum_concurrent_with_readers();
+    test_visibility_map();
+    test_hot_update_chain();
+    test_tuple_desc_deform();
+    test_varlena_deform_modes();
+    test_page_latches_concurrent();
+    test_compact_after_slot_reuse();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
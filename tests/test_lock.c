@@ -0,0 +1,419 @@
+/**
+ * test_lock.c
+ *
+ * Tests for the lock primitives in lock.h:
+ *   LWLockConditionalAcquire    (shared / exclusive compatibility)
+ *   LWLockAcquire / Release     (mutual exclusion under contention, parking)
+ *   SpinLockAcquire / Release   (TAS mutual exclusion)
+ *   LockAcquire / LockRelease   (RegularLock modes, re-entrancy, fast path,
+ *                                blocking, deadlock detection)
+ *
+ * Compile & run:
+ *   cd tests && make test_lock && ./test_lock
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/lock.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+#define NTHREADS 8
+#define NITERS   100000
+
+/* ================================================================
+ * Test 1: shared / exclusive compatibility
+ * ================================================================ */
+static void test_lwlock_modes(void)
+{
+    printf("\n=== Test lwlock_modes ===\n");
+
+    LWLock lock;
+    LWLockInit(&lock, "test");
+    CHECK(LWLockConditionalAcquire(&lock, LW_SHARED), "shared on a free lock");
+    CHECK(LWLockConditionalAcquire(&lock, LW_SHARED), "second shared holder admitted");
+    CHECK(!LWLockConditionalAcquire(&lock, LW_EXCLUSIVE), "exclusive refused while shared");
+    LWLockRelease(&lock);
+    LWLockRelease(&lock);
+    CHECK(LWLockConditionalAcquire(&lock, LW_EXCLUSIVE), "exclusive once readers left");
+    CHECK(!LWLockConditionalAcquire(&lock, LW_SHARED), "shared refused while exclusive");
+    CHECK(!LWLockConditionalAcquire(&lock, LW_EXCLUSIVE), "exclusive refused while exclusive");
+    LWLockRelease(&lock);
+    CHECK(atomic_load(&lock.state) == 0, "state word back to zero");
+    LWLockDestroy(&lock);
+}
+
+/* ================================================================
+ * Test 2: readers never observe a half-written pair
+ * ================================================================ */
+typedef struct
+{
+    LWLock lock;
+    long a, b;
+    long torn;
+    long increments;
+} RwShared;
+
+static void* rw_writer(void* arg)
+{
+    RwShared* s = arg;
+    for (int i = 0; i < NITERS; i++)
+    {
+        LWLockAcquire(&s->lock, LW_EXCLUSIVE);
+        s->a++;
+        s->b++;
+        s->increments++;
+        LWLockRelease(&s->lock);
+    }
+    return NULL;
+}
+
+static void* rw_reader(void* arg)
+{
+    RwShared* s = arg;
+    for (int i = 0; i < NITERS; i++)
+    {
+        LWLockAcquire(&s->lock, LW_SHARED);
+        long a = s->a, b = s->b;
+        LWLockRelease(&s->lock);
+        if (a != b) __atomic_fetch_add(&s->torn, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+static void test_lwlock_contention(void)
+{
+    printf("\n=== Test lwlock_contention ===\n");
+
+    RwShared s;
+    memset(&s, 0, sizeof(s));
+    LWLockInit(&s.lock, "rw");
+    pthread_t th[NTHREADS];
+    for (int i = 0; i < NTHREADS; i++)
+        pthread_create(&th[i], NULL, (i % 2) ? rw_reader : rw_writer, &s);
+    for (int i = 0; i < NTHREADS; i++) pthread_join(th[i], NULL);
+
+    CHECK(s.increments == (long)(NTHREADS / 2) * NITERS, "no exclusive increment lost");
+    CHECK(s.a == s.increments && s.b == s.increments, "protected pair consistent");
+    CHECK(s.torn == 0, "readers never saw a torn update");
+    CHECK(atomic_load(&s.lock.state) == 0, "state word back to zero");
+}
+
+/* ================================================================
+ * Test 3: a blocked acquirer parks and is woken by the release
+ * ================================================================ */
+typedef struct
+{
+    LWLock* lock;
+    LWLockMode mode;
+    _Atomic int acquired;
+} Waiter;
+
+static void* park_waiter(void* arg)
+{
+    Waiter* w = arg;
+    LWLockAcquire(w->lock, w->mode);
+    atomic_store(&w->acquired, 1);
+    LWLockRelease(w->lock);
+    return NULL;
+}
+
+static void test_lwlock_park_wake(void)
+{
+    printf("\n=== Test lwlock_park_wake ===\n");
+
+    LWLock lock;
+    LWLockInit(&lock, "park");
+    LWLockAcquire(&lock, LW_EXCLUSIVE);
+    Waiter w[3] = {{&lock, LW_SHARED, 0}, {&lock, LW_SHARED, 0}, {&lock, LW_EXCLUSIVE, 0}};
+    pthread_t th[3];
+    for (int i = 0; i < 3; i++) pthread_create(&th[i], NULL, park_waiter, &w[i]);
+    usleep(50000);
+    CHECK(!atomic_load(&w[0].acquired) && !atomic_load(&w[2].acquired), "waiters blocked");
+    CHECK(atomic_load(&lock.state) & LW_FLAG_HAS_WAITERS, "waiters parked on the state word");
+    LWLockRelease(&lock);
+    for (int i = 0; i < 3; i++) pthread_join(th[i], NULL);
+    CHECK(atomic_load(&w[0].acquired) && atomic_load(&w[1].acquired) &&
+              atomic_load(&w[2].acquired),
+          "release wakes every waiter");
+    CHECK(atomic_load(&lock.state) == 0, "state word back to zero");
+}
+
+/* ================================================================
+ * Test 4: spinlock mutual exclusion
+ * ================================================================ */
+typedef struct
+{
+    slock_t lock;
+    long counter;
+} SpinShared;
+
+static void* spin_worker(void* arg)
+{
+    SpinShared* s = arg;
+    for (int i = 0; i < NITERS; i++)
+    {
+        SpinLockAcquire(&s->lock);
+        s->counter++;
+        SpinLockRelease(&s->lock);
+    }
+    return NULL;
+}
+
+static void test_spinlock(void)
+{
+    printf("\n=== Test spinlock ===\n");
+
+    SpinShared s;
+    SpinLockInit(&s.lock);
+    s.counter = 0;
+    pthread_t th[NTHREADS];
+    for (int i = 0; i < NTHREADS; i++) pthread_create(&th[i], NULL, spin_worker, &s);
+    for (int i = 0; i < NTHREADS; i++) pthread_join(th[i], NULL);
+    CHECK(s.counter == (long)NTHREADS * NITERS, "no spinlock-protected increment lost");
+    SpinLockFree(&s.lock);
+}
+
+/* ================================================================
+ * Test 5: RegularLock conflict matrix and re-entrancy
+ * ================================================================ */
+typedef struct
+{
+    uint64_t relid;
+    LOCKMODE mode;
+    bool got;
+} TryLock;
+
+/* 在另一个线程上做一次不等待的尝试，看本线程持有的锁是否挡住它 */
+static void* try_lock_thread(void* arg)
+{
+    TryLock* t = arg;
+    t->got = ConditionalLockRelation(t->relid, t->mode);
+    if (t->got) UnlockRelation(t->relid, t->mode);
+    return NULL;
+}
+
+static bool other_thread_can_lock(uint64_t relid, LOCKMODE mode)
+{
+    TryLock t = {relid, mode, false};
+    pthread_t th;
+    pthread_create(&th, NULL, try_lock_thread, &t);
+    pthread_join(th, NULL);
+    return t.got;
+}
+
+static void test_regular_lock_modes(void)
+{
+    printf("\n=== Test regular_lock_modes ===\n");
+
+    const uint64_t rel = 1001;
+    CHECK(LockRelation(rel, AccessShareLock) == LOCKACQUIRE_OK, "AccessShare granted");
+    CHECK(other_thread_can_lock(rel, RowExclusiveLock), "reads do not block writes");
+    CHECK(other_thread_can_lock(rel, ShareUpdateExclusiveLock), "reads do not block vacuum");
+    CHECK(!other_thread_can_lock(rel, AccessExclusiveLock), "reads block DDL");
+    UnlockRelation(rel, AccessShareLock);
+    CHECK(other_thread_can_lock(rel, AccessExclusiveLock), "DDL admitted once reads left");
+
+    CHECK(LockRelation(rel, ShareUpdateExclusiveLock) == LOCKACQUIRE_OK, "vacuum lock granted");
+    CHECK(!other_thread_can_lock(rel, ShareUpdateExclusiveLock), "vacuum is self-exclusive");
+    CHECK(other_thread_can_lock(rel, AccessShareLock) && other_thread_can_lock(rel, RowExclusiveLock),
+          "vacuum coexists with reads and writes");
+    UnlockRelation(rel, ShareUpdateExclusiveLock);
+
+    CHECK(LockRelation(rel, ExclusiveLock) == LOCKACQUIRE_OK, "Exclusive granted");
+    CHECK(other_thread_can_lock(rel, AccessShareLock), "Exclusive admits AccessShare");
+    CHECK(!other_thread_can_lock(rel, RowExclusiveLock), "Exclusive blocks writes");
+    UnlockRelation(rel, ExclusiveLock);
+
+    LOCKTAG tag;
+    SET_LOCKTAG_RELATION(tag, rel);
+    CHECK(LockRelation(rel, RowExclusiveLock) == LOCKACQUIRE_OK, "first RowExclusive");
+    CHECK(LockRelation(rel, RowExclusiveLock) == LOCKACQUIRE_ALREADY_HELD, "re-entrant acquire");
+    UnlockRelation(rel, RowExclusiveLock);
+    CHECK(LockHeldByMe(&tag, RowExclusiveLock), "still held after one release");
+    UnlockRelation(rel, RowExclusiveLock);
+    CHECK(!LockHeldByMe(&tag, RowExclusiveLock), "released after matching releases");
+    CHECK(!LockRelease(&tag, RowExclusiveLock), "release of an unheld lock reports false");
+
+    CHECK(LockTuple(rel, 3, 7, ExclusiveLock) == LOCKACQUIRE_OK, "tuple lock granted");
+    CHECK(other_thread_can_lock(rel, AccessExclusiveLock), "tuple lock is not a table lock");
+    LockRelation(rel, AccessShareLock);
+    LockRelation(rel, RowExclusiveLock);
+    LockReleaseAll();
+    SET_LOCKTAG_TUPLE(tag, rel, 3, 7);
+    CHECK(!LockHeldByMe(&tag, ExclusiveLock), "LockReleaseAll drops every lock");
+    CHECK(other_thread_can_lock(rel, AccessExclusiveLock), "nothing left on the relation");
+}
+
+/* ================================================================
+ * Test 6: fast-path weak locks are seen by a strong locker
+ * ================================================================ */
+#define FP_READERS 4
+
+typedef struct
+{
+    uint64_t relid;
+    _Atomic int holding;
+    _Atomic int release;
+} FastPathShared;
+
+static void* fastpath_holder(void* arg)
+{
+    FastPathShared* s = arg;
+    LockRelation(s->relid, AccessShareLock);
+    atomic_fetch_add(&s->holding, 1);
+    while (!atomic_load(&s->release)) sched_yield();
+    UnlockRelation(s->relid, AccessShareLock);
+    return NULL;
+}
+
+static void test_fastpath_transfer(void)
+{
+    printf("\n=== Test fastpath_transfer ===\n");
+
+    FastPathShared s = {2002, 0, 0};
+    pthread_t th[FP_READERS];
+    for (int i = 0; i < FP_READERS; i++) pthread_create(&th[i], NULL, fastpath_holder, &s);
+    while (atomic_load(&s.holding) < FP_READERS) sched_yield();
+
+    CHECK(!ConditionalLockRelation(s.relid, AccessExclusiveLock),
+          "strong lock sees fast-path AccessShare holders");
+    CHECK(other_thread_can_lock(s.relid, AccessShareLock), "weak locks still granted");
+    atomic_store(&s.release, 1);
+    for (int i = 0; i < FP_READERS; i++) pthread_join(th[i], NULL);
+    CHECK(ConditionalLockRelation(s.relid, AccessExclusiveLock),
+          "strong lock granted after transferred locks released");
+    UnlockRelation(s.relid, AccessExclusiveLock);
+    CHECK(LockRelation(s.relid, AccessShareLock) == LOCKACQUIRE_OK, "fast path usable again");
+    UnlockRelation(s.relid, AccessShareLock);
+}
+
+/* ================================================================
+ * Test 7: DDL waits for readers; readers queue behind waiting DDL
+ * ================================================================ */
+typedef struct
+{
+    uint64_t relid;
+    LOCKMODE mode;
+    _Atomic int state; /* 1: acquired, 2: released */
+    LockAcquireResult result;
+} Blocker;
+
+static void* blocking_locker(void* arg)
+{
+    Blocker* b = arg;
+    b->result = LockRelation(b->relid, b->mode);
+    atomic_store(&b->state, 1);
+    UnlockRelation(b->relid, b->mode);
+    atomic_store(&b->state, 2);
+    return NULL;
+}
+
+static void test_regular_lock_wait(void)
+{
+    printf("\n=== Test regular_lock_wait ===\n");
+
+    const uint64_t rel = 3003;
+    LockRelation(rel, AccessShareLock);
+    Blocker ddl = {rel, AccessExclusiveLock, 0, LOCKACQUIRE_NOT_AVAIL};
+    pthread_t t1;
+    pthread_create(&t1, NULL, blocking_locker, &ddl);
+    usleep(100000); /* 超过死锁检测超时：无环，继续等 */
+    CHECK(atomic_load(&ddl.state) == 0, "DDL waits for the reader");
+    CHECK(!other_thread_can_lock(rel, AccessShareLock), "new reader queues behind waiting DDL");
+
+    UnlockRelation(rel, AccessShareLock);
+    pthread_join(t1, NULL);
+    CHECK(ddl.result == LOCKACQUIRE_OK && atomic_load(&ddl.state) == 2,
+          "release wakes the DDL waiter");
+}
+
+/* ================================================================
+ * Test 8: a lock-order inversion is reported as a deadlock
+ * ================================================================ */
+typedef struct
+{
+    uint64_t first, second;
+    pthread_barrier_t* barrier;
+    LockAcquireResult result;
+} Crossed;
+
+static void* crossed_locker(void* arg)
+{
+    Crossed* c = arg;
+    LockRelation(c->first, AccessExclusiveLock);
+    pthread_barrier_wait(c->barrier);
+    c->result = LockRelation(c->second, AccessExclusiveLock);
+    /* 受害者不持有 second；非受害者在对方放弃后拿到 */
+    LockReleaseAll();
+    return NULL;
+}
+
+static void test_deadlock_detection(void)
+{
+    printf("\n=== Test deadlock_detection ===\n");
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, 2);
+    Crossed a = {4004, 4005, &barrier, LOCKACQUIRE_NOT_AVAIL};
+    Crossed b = {4005, 4004, &barrier, LOCKACQUIRE_NOT_AVAIL};
+    pthread_t ta, tb;
+    pthread_create(&ta, NULL, crossed_locker, &a);
+    pthread_create(&tb, NULL, crossed_locker, &b);
+    pthread_join(ta, NULL);
+    pthread_join(tb, NULL);
+    pthread_barrier_destroy(&barrier);
+
+    int victims = (a.result == LOCKACQUIRE_DEADLOCK) + (b.result == LOCKACQUIRE_DEADLOCK);
+    int winners = (a.result == LOCKACQUIRE_OK) + (b.result == LOCKACQUIRE_OK);
+    CHECK(victims >= 1, "deadlock detected");
+    CHECK(victims + winners == 2, "every waiter either won or was chosen as victim");
+    CHECK(other_thread_can_lock(4004, AccessExclusiveLock) &&
+              other_thread_can_lock(4005, AccessExclusiveLock),
+          "no lock left behind");
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   Lock Test Suite\n");
+    printf("========================================\n");
+
+    test_lwlock_modes();
+    test_lwlock_contention();
+    test_lwlock_park_wake();
+    test_spinlock();
+    test_regular_lock_modes();
+    test_fastpath_transfer();
+    test_regular_lock_wait();
+    test_deadlock_detection();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
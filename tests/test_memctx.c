@@ -0,0 +1,156 @@
+/**
+ * test_memctx.c
+ *
+ * Tests for memory contexts (memctx.h):
+ *   memoryContext_alloc / alloc_zero / strdup   (alignment, oversized blocks)
+ *   memoryContext_reset                         (rewind kept block, drop children)
+ *   memoryContext_delete                        (whole subtree, unlink from parent)
+ *   memoryContext_mem_allocated                 (accounting)
+ *
+ * Compile & run:
+ *   cd tests && make test_memctx && ./test_memctx
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/memctx.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+/* ================================================================
+ * Test 1: bump allocation
+ * ================================================================ */
+static void test_alloc(void)
+{
+    printf("\n=== Test alloc ===\n");
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "test", 256);
+    CHECK(cxt && memoryContext_mem_allocated(cxt, false) == 0, "no block until first alloc");
+
+    bool aligned = true;
+    u8* prev = NULL;
+    bool contiguous = true;
+    for (int i = 0; i < 8; i++)
+    {
+        u8* p = memoryContext_alloc(cxt, 13);
+        aligned &= ((uintptr_t)p & 7) == 0;
+        if (prev && p != prev + 16) contiguous = false;
+        prev = p;
+    }
+    CHECK(aligned, "allocations are 8-byte aligned");
+    CHECK(contiguous, "small allocations bump within one block");
+    CHECK(memoryContext_mem_allocated(cxt, false) == 256, "one block allocated");
+
+    u8* big = memoryContext_alloc(cxt, 4096);
+    u8* after = memoryContext_alloc(cxt, 8);
+    CHECK(big && after == prev + 16, "oversized request leaves the current block in use");
+
+    u8* zero = memoryContext_alloc_zero(cxt, 100);
+    bool all_zero = true;
+    for (int i = 0; i < 100; i++) all_zero &= zero[i] == 0;
+    CHECK(all_zero, "alloc_zero clears memory");
+
+    char* s = memoryContext_strdup(cxt, "vectorbase");
+    CHECK(s && strcmp(s, "vectorbase") == 0, "strdup copies the string");
+    memoryContext_delete(cxt);
+}
+
+/* ================================================================
+ * Test 2: reset keeps one block and drops children
+ * ================================================================ */
+static void test_reset(void)
+{
+    printf("\n=== Test reset ===\n");
+
+    MemoryContext parent;
+    MemoryContext_init(&parent, NULL, "parent", 128);
+    void* first = memoryContext_alloc(&parent, 8);
+    for (int i = 0; i < 100; i++) memoryContext_alloc(&parent, 64);
+    memoryContext_alloc(&parent, 10000);
+
+    MemoryContext* child = MemoryContext_create(&parent, "child", 128);
+    MemoryContext_create(child, "grandchild", 128);
+    memoryContext_alloc(child, 64);
+    CHECK(memoryContext_mem_allocated(&parent, true) > memoryContext_mem_allocated(&parent, false),
+          "recursive accounting includes children");
+
+    memoryContext_reset(&parent);
+    CHECK(parent.first_child == NULL, "reset deletes child contexts");
+    CHECK(memoryContext_mem_allocated(&parent, true) == 128, "reset keeps a single block");
+    void* again = memoryContext_alloc(&parent, 8);
+    memoryContext_reset(&parent);
+    CHECK(again != NULL && memoryContext_alloc(&parent, 8) == again, "reset rewinds the kept block");
+    (void)first;
+    memoryContext_delete(&parent);
+    CHECK(parent.blocks == NULL && memoryContext_mem_allocated(&parent, true) == 0,
+          "delete on an embedded context frees its blocks");
+}
+
+/* ================================================================
+ * Test 3: delete unlinks from the parent
+ * ================================================================ */
+static void test_delete_tree(void)
+{
+    printf("\n=== Test delete_tree ===\n");
+
+    MemoryContext* root = MemoryContext_create(NULL, "root", 0);
+    MemoryContext* a = MemoryContext_create(root, "a", 0);
+    MemoryContext* b = MemoryContext_create(root, "b", 0);
+    MemoryContext* c = MemoryContext_create(root, "c", 0);
+    MemoryContext_create(b, "b1", 0);
+    memoryContext_alloc(a, 1);
+    memoryContext_alloc(c, 1);
+
+    memoryContext_delete(b);
+    int nchildren = 0;
+    bool linked = true;
+    for (MemoryContext* x = root->first_child; x; x = x->next_sibling)
+    {
+        nchildren++;
+        if (x->next_sibling && x->next_sibling->prev_sibling != x) linked = false;
+    }
+    CHECK(nchildren == 2 && linked, "middle child unlinked, siblings stay linked");
+    CHECK(memoryContext_mem_allocated(root, true) == 2 * MEMCTX_DEFAULT_BLOCK_SIZE,
+          "remaining children still accounted");
+
+    memoryContext_delete(root);
+    CHECK(1, "deleting the root frees the whole tree");
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   MemoryContext Test Suite\n");
+    printf("========================================\n");
+
+    test_alloc();
+    test_reset();
+    test_delete_tree();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
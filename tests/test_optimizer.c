@@ -0,0 +1,537 @@
+/**
+ * test_optimizer.c
+ *
+ * Tests for the cost-based vector query optimizer (optimizer.h) and the
+ * index scan source it drives (executor.h):
+ *   tableStats_analyze                 (row count, min/max, ndistinct, histogram)
+ *   optimizer_selectivity              (EQ / range / NULL clauses, defaults, conjunctions)
+ *   optimizer_plan                     (brute force vs index post-filter vs filtered traversal)
+ *   optimizer_execute                  (every strategy returns the exact top-k, fallback)
+ *   PhysicalIndexScan                  (MVCC: rows deleted behind the index are skipped,
+ *                                       HOT successors found through the root's entry)
+ *
+ * Compile & run:
+ *   cd tests && make test_optimizer && ./test_optimizer
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/optimizer.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+#define NEAR(a, b, eps) (fabs((f64)(a) - (f64)(b)) <= (eps))
+
+/* ---- mock index: exact search, visits candidates in distance order ---- */
+typedef struct
+{
+    EXTENDS(VectorIndex);
+    u64* ctids;
+    const f32** vecs;
+    usize n;
+    usize cap;
+    usize searches;
+    usize filtered_searches;
+    usize filter_calls;
+} MockIndex;
+
+typedef struct
+{
+    f32 dist;
+    usize idx;
+} MockCand;
+
+static int mock_cand_cmp(const void* a, const void* b)
+{
+    f32 x = ((const MockCand*)a)->dist, y = ((const MockCand*)b)->dist;
+    return (x > y) - (x < y);
+}
+
+static void mock_insert(VectorIndex* index, u64 heap_ctid_packed, ItemPtr emb_ctid,
+                        const f32* vector)
+{
+    MockIndex* m = (MockIndex*)index;
+    (void)emb_ctid;
+    if (m->n == m->cap)
+    {
+        m->cap = m->cap ? m->cap * 2 : 64;
+        m->ctids = realloc(m->ctids, m->cap * sizeof(u64));
+        m->vecs = realloc(m->vecs, m->cap * sizeof(const f32*));
+    }
+    m->ctids[m->n] = heap_ctid_packed;
+    m->vecs[m->n++] = vector;
+    index->vector_count = m->n;
+}
+
+static MockCand* mock_sorted(MockIndex* m, const f32* query)
+{
+    MockCand* c = malloc((m->n ? m->n : 1) * sizeof(MockCand));
+    for (usize i = 0; i < m->n; i++)
+    {
+        f32 s = 0;
+        for (i16 d = 0; d < m->base.dimension; d++)
+        {
+            f32 diff = m->vecs[i][d] - query[d];
+            s += diff * diff;
+        }
+        c[i] = (MockCand){sqrtf(s), i};
+    }
+    qsort(c, m->n, sizeof(MockCand), mock_cand_cmp);
+    return c;
+}
+
+static usize mock_search(VectorIndex* index, const f32* query, usize k, SearchResult* results)
+{
+    MockIndex* m = (MockIndex*)index;
+    m->searches++;
+    MockCand* c = mock_sorted(m, query);
+    usize n = k < m->n ? k : m->n;
+    for (usize i = 0; i < n; i++)
+        results[i] = (SearchResult){m->ctids[c[i].idx], 0, c[i].dist};
+    free(c);
+    return n;
+}
+
+static usize mock_search_filtered(VectorIndex* index, const f32* query, usize k,
+                                  IndexFilterFn filter, void* arg, SearchResult* results)
+{
+    MockIndex* m = (MockIndex*)index;
+    m->filtered_searches++;
+    MockCand* c = mock_sorted(m, query);
+    usize n = 0;
+    for (usize i = 0; i < m->n && n < k; i++)
+    {
+        m->filter_calls++;
+        u64 ctid = m->ctids[c[i].idx];
+        if (filter(ctid, arg)) results[n++] = (SearchResult){ctid, 0, c[i].dist};
+    }
+    free(c);
+    return n;
+}
+
+static VectorIndexVTable mock_vtable = {.insert = mock_insert,
+                                        .search = mock_search,
+                                        .search_filtered = mock_search_filtered};
+static VectorIndexVTable mock_plain_vtable = {.insert = mock_insert, .search = mock_search};
+
+static void mock_init(MockIndex* m, VectorIndexVTable* vt, i16 dim)
+{
+    memset(m, 0, sizeof(*m));
+    m->base.vtable = vt;
+    m->base.type = INDEX_HNSW;
+    m->base.metric = L2;
+    m->base.dimension = dim;
+}
+
+static void mock_deinit(MockIndex* m)
+{
+    free(m->ctids);
+    free(m->vecs);
+}
+
+/* ---- fixture: row i has vector (i, 0, 0, 0), cat = i % 100, val = i / N, name TEXT ---- */
+#define N_ROWS 3000
+#define DIM    4
+#define K      10
+
+static const TupleColType fix_cols[3] = {TUPLE_COL_I32, TUPLE_COL_F64, TUPLE_COL_TEXT};
+static const TableSchema fix_schema = {.cols = fix_cols, .ncols = 3};
+
+typedef struct
+{
+    EmbeddingHeapTable et;
+    DataTable dt;
+    MockIndex index;
+    ItemPtr heap_ctid[N_ROWS];
+    f32 vecs[N_ROWS][DIM];
+    u8 names[N_ROWS][4 + 2];
+} Fixture;
+
+static void fixture_init(Fixture* f)
+{
+    EmbeddingHeapTable_init(&f->et, DIM, &fix_schema, NULL);
+    DataTable_init(&f->dt);
+    f->dt.table = &f->et.base;
+
+    VectorBase* vb = malloc(N_ROWS * sizeof(VectorBase));
+    Datum(*vals)[3] = malloc(N_ROWS * sizeof(*vals));
+    const Datum** rows = malloc(N_ROWS * sizeof(Datum*));
+    for (usize i = 0; i < N_ROWS; i++)
+    {
+        memset(f->vecs[i], 0, sizeof(f->vecs[i]));
+        f->vecs[i][0] = (f32)i;
+        vb[i] = (VectorBase){TYPE_FLOAT32, DIM, (data_ptr_t)f->vecs[i]};
+        u8* t = f->names[i];
+        t[0] = 2, t[1] = t[2] = t[3] = 0, t[4] = 'n', t[5] = (u8)('0' + i % 10);
+        vals[i][0] = Int32GetDatum((i32)(i % 100));
+        vals[i][1] = Float64GetDatum((f64)i / N_ROWS);
+        vals[i][2] = PointerGetDatum(t);
+        rows[i] = vals[i];
+    }
+    DataChunk chunk;
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.mode = CHUNK_EMBED;
+    chunk.count = N_ROWS;
+    chunk.arrays = vb;
+    chunk.payloads = rows;
+    chunk.n_payloads = 3;
+    ItemPtr* emb_buf = malloc(N_ROWS * sizeof(ItemPtr));
+    TamInsertCtx ctx = {.emb_ctids = emb_buf, .heap_ctids = f->heap_ctid, .count = N_ROWS};
+    VCALL(&f->et.base, append_chunk, &chunk, &ctx);
+
+    mock_init(&f->index, &mock_vtable, DIM);
+    for (usize i = 0; i < N_ROWS; i++)
+        VCALL(&f->index.base, insert, item_ptr_pack(f->heap_ctid[i]), emb_buf[i], f->vecs[i]);
+    embeddingHeapTable_attach_index(&f->et, &f->index.base);
+    free(emb_buf);
+    free(rows);
+    free(vals);
+    free(vb);
+}
+
+static void fixture_deinit(Fixture* f)
+{
+    DataTable_deinit(&f->dt);
+    EmbeddingHeapTable_deinit(&f->et);
+    mock_deinit(&f->index);
+}
+
+/* ================================================================
+ * Test 1: ANALYZE builds per-column statistics
+ * ================================================================ */
+static void test_analyze(Fixture* f, TableStats* stats)
+{
+    printf("\n=== Test analyze ===\n");
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "query", 0);
+    ExecContext ctx = {.cxt = cxt};
+    CHECK(tableStats_analyze(stats, &ctx, &f->dt) == 0, "analyze succeeds");
+    CHECK(stats->nrows == N_ROWS && stats->sample_rows == N_ROWS && stats->ncols == 3,
+          "small table is sampled in full");
+
+    const ColumnStats* cat = &stats->cols[0];
+    CHECK(cat->valid && cat->min == 0 && cat->max == 99 && cat->ndistinct == 100 &&
+              cat->null_frac == 0,
+          "I32 column: min / max / ndistinct exact");
+    const ColumnStats* val = &stats->cols[1];
+    CHECK(val->valid && val->nbounds == STATS_HIST_BOUNDS && val->bounds[0] == 0 &&
+              NEAR(val->bounds[STATS_HIST_BOUNDS - 1], (f64)(N_ROWS - 1) / N_ROWS, 1e-12),
+          "F64 column: histogram spans min..max");
+    CHECK(!stats->cols[2].valid, "TEXT column has no statistics");
+    CHECK(memoryContext_mem_allocated(cxt, true) == memoryContext_mem_allocated(cxt, false),
+          "analyze context deleted afterwards");
+    memoryContext_delete(cxt);
+}
+
+/* ================================================================
+ * Test 2: selectivity estimates
+ * ================================================================ */
+static void test_selectivity(const TableStats* stats)
+{
+    printf("\n=== Test selectivity ===\n");
+
+    ExecPredicate cat_eq = {.col = 0, .type = TUPLE_COL_I32, .op = EXEC_CMP_EQ,
+                            .value = Int32GetDatum(7)};
+    ExecPredicate cat_out = {.col = 0, .type = TUPLE_COL_I32, .op = EXEC_CMP_EQ,
+                             .value = Int32GetDatum(500)};
+    ExecPredicate val_lt = {.col = 1, .type = TUPLE_COL_F64, .op = EXEC_CMP_LT,
+                            .value = Float64GetDatum(0.25)};
+    ExecPredicate val_ge = {.col = 1, .type = TUPLE_COL_F64, .op = EXEC_CMP_GE,
+                            .value = Float64GetDatum(0.9)};
+    ExecPredicate name_eq = {.col = 2, .type = TUPLE_COL_TEXT, .op = EXEC_CMP_EQ};
+
+    CHECK(NEAR(optimizer_clause_selectivity(stats, &cat_eq), 0.01, 1e-9), "EQ: 1 / ndistinct");
+    CHECK(optimizer_clause_selectivity(stats, &cat_out) == 0, "EQ outside [min, max]: 0");
+    CHECK(NEAR(optimizer_clause_selectivity(stats, &val_lt), 0.25, 0.01), "LT from the histogram");
+    CHECK(NEAR(optimizer_clause_selectivity(stats, &val_ge), 0.10, 0.01), "GE from the histogram");
+    CHECK(optimizer_clause_selectivity(stats, &name_eq) == DEFAULT_EQ_SEL,
+          "column without statistics uses the default");
+    ExecPredicate conj[2] = {cat_eq, val_lt};
+    CHECK(NEAR(optimizer_selectivity(stats, conj, 2), 0.0025, 1e-4),
+          "conjunction multiplies (independence)");
+    CHECK(optimizer_selectivity(NULL, &val_lt, 1) == DEFAULT_INEQ_SEL &&
+              optimizer_selectivity(NULL, NULL, 0) == 1,
+          "no statistics: default range selectivity; no predicates: 1");
+
+    /* NULL-heavy column, built by hand */
+    ColumnStats cs = {.valid = true, .type = TUPLE_COL_I64, .null_frac = 0.3, .ndistinct = 10,
+                      .min = 0, .max = 9, .nbounds = 2, .bounds = {0, 9}};
+    TableStats hand = {.nrows = 1000, .ncols = 1, .cols = &cs};
+    ExecPredicate isnull = {.col = 0, .op = EXEC_CMP_IS_NULL};
+    ExecPredicate ne = {.col = 0, .type = TUPLE_COL_I64, .op = EXEC_CMP_NE,
+                        .value = Int64GetDatum(3)};
+    CHECK(NEAR(optimizer_clause_selectivity(&hand, &isnull), 0.3, 1e-12), "IS NULL: null_frac");
+    CHECK(NEAR(optimizer_clause_selectivity(&hand, &ne), 0.7 * 0.9, 1e-12), "NE excludes NULLs");
+}
+
+/* ================================================================
+ * Test 3: strategy choice follows selectivity
+ * ================================================================ */
+static void test_plan_choice(void)
+{
+    printf("\n=== Test plan_choice ===\n");
+
+    /* 1M rows, val uniform over [0, 1]; only the statistics and the index size matter */
+    EmbeddingHeapTable et;
+    EmbeddingHeapTable_init(&et, DIM, &fix_schema, NULL);
+    DataTable dt;
+    DataTable_init(&dt);
+    dt.table = &et.base;
+    ColumnStats cols[3] = {{0}};
+    cols[1] = (ColumnStats){.valid = true, .type = TUPLE_COL_F64, .ndistinct = 1e6, .min = 0,
+                            .max = 1, .nbounds = STATS_HIST_BOUNDS};
+    for (int b = 0; b < STATS_HIST_BOUNDS; b++)
+        cols[1].bounds[b] = (f64)b / (STATS_HIST_BOUNDS - 1);
+    TableStats stats = {.nrows = 1000000, .ncols = 3, .cols = cols};
+
+    f32 q[DIM] = {0};
+    VectorCondition vc = {.query = {TYPE_FLOAT32, DIM, (data_ptr_t)q}, .metric = L2};
+    ExecPredicate pred = {.col = 1, .type = TUPLE_COL_F64, .op = EXEC_CMP_LT};
+    VectorQuery query = {.cond = &vc, .k = K, .preds = &pred, .npreds = 1};
+    QueryPlan plan;
+
+    pred.value = Float64GetDatum(0.5);
+    CHECK(optimizer_plan(&stats, &dt, &query, &plan) == 0 && plan.strategy == PLAN_BRUTE_FORCE,
+          "no index attached: brute force");
+
+    MockIndex index;
+    mock_init(&index, &mock_vtable, DIM);
+    index.base.vector_count = 1000000;
+    embeddingHeapTable_attach_index(&et, &index.base);
+
+    optimizer_plan(&stats, &dt, &query, &plan);
+    CHECK(plan.strategy == PLAN_INDEX_POSTFILTER && plan.index == &index.base &&
+              plan.probe_k == (usize)ceil(K * OPT_POSTFILTER_OVERFETCH / 0.5),
+          "broad filter (50%): index search with post-filter, over-fetching k / sel");
+    CHECK(NEAR(plan.selectivity, 0.5, 1e-9) && NEAR(plan.est_rows, 500000, 1), "row estimate");
+
+    pred.value = Float64GetDatum(0.01);
+    optimizer_plan(&stats, &dt, &query, &plan);
+    CHECK(plan.strategy == PLAN_INDEX_FILTERED && plan.probe_k == K &&
+              isinf(plan.costs[PLAN_INDEX_POSTFILTER]),
+          "1% filter: post-filter ruled out, filtered traversal wins");
+
+    pred.value = Float64GetDatum(0.0001);
+    optimizer_plan(&stats, &dt, &query, &plan);
+    CHECK(plan.strategy == PLAN_BRUTE_FORCE && plan.cost < plan.costs[PLAN_INDEX_FILTERED],
+          "0.01% filter: brute force over the survivors");
+
+    index.base.vtable = &mock_plain_vtable;
+    pred.value = Float64GetDatum(0.01);
+    optimizer_plan(&stats, &dt, &query, &plan);
+    CHECK(plan.strategy == PLAN_BRUTE_FORCE && isinf(plan.costs[PLAN_INDEX_FILTERED]),
+          "index without search_filtered: no filtered traversal");
+
+    query.npreds = 0;
+    optimizer_plan(&stats, &dt, &query, &plan);
+    CHECK(plan.strategy == PLAN_INDEX_POSTFILTER && plan.probe_k == K,
+          "no filter: plain top-k probe");
+
+    index.base.metric = COSINE;
+    optimizer_plan(&stats, &dt, &query, &plan);
+    CHECK(plan.strategy == PLAN_BRUTE_FORCE, "index with another metric is ignored");
+
+    f32 q3[3] = {0};
+    VectorCondition vc3 = {.query = {TYPE_FLOAT32, 3, (data_ptr_t)q3}, .metric = L2};
+    query.cond = &vc3;
+    CHECK(optimizer_plan(&stats, &dt, &query, &plan) == -1, "dimension mismatch rejected");
+
+    DataTable_deinit(&dt);
+    EmbeddingHeapTable_deinit(&et);
+}
+
+/* ================================================================
+ * Test 4: every strategy returns the exact filtered top-k
+ * ================================================================ */
+static bool same_results(const TableQueryResult* a, int na, const TableQueryResult* b, int nb)
+{
+    if (na != nb) return false;
+    for (int i = 0; i < na; i++)
+    {
+        if (!item_ptr_equal(a[i].heap_ctid, b[i].heap_ctid) || a[i].distance != b[i].distance)
+            return false;
+        if (DatumGetInt32(a[i].payloads[0]) != DatumGetInt32(b[i].payloads[0])) return false;
+    }
+    return true;
+}
+
+static void test_execute(Fixture* f, const TableStats* stats)
+{
+    printf("\n=== Test execute ===\n");
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "query", 0);
+    ExecContext ctx = {.cxt = cxt};
+    f32 q[DIM] = {1500.3f, 0, 0, 0};
+    VectorCondition vc = {.query = {TYPE_FLOAT32, DIM, (data_ptr_t)q}, .metric = L2};
+    u16 cols[2] = {0, 2};
+    TableQueryResult res[K], ref[K];
+    QueryPlan plan, brute = {.strategy = PLAN_BRUTE_FORCE};
+
+    /* broad: val < 0.8 */
+    ExecPredicate broad = {.col = 1, .type = TUPLE_COL_F64, .op = EXEC_CMP_LT,
+                           .value = Float64GetDatum(0.8)};
+    VectorQuery query = {.cond = &vc, .k = K, .preds = &broad, .npreds = 1, .cols = cols,
+                         .ncols = 2};
+    optimizer_plan(stats, &f->dt, &query, &plan);
+    CHECK(plan.strategy == PLAN_INDEX_POSTFILTER, "broad filter planned as index + post-filter");
+    usize searches = f->index.searches;
+    int n = optimizer_execute(&ctx, &f->dt, &query, &plan, res);
+    int nref = optimizer_execute(&ctx, &f->dt, &query, &brute, ref);
+    CHECK(n == K && f->index.searches == searches + 1 && !plan.fell_back,
+          "one index probe fills k rows");
+    CHECK(same_results(res, n, ref, nref), "post-filter result equals brute force");
+    bool ok = true;
+    for (int i = 0; i < n; i++)
+    {
+        const u8* name = DatumGetPointer(res[i].payloads[1]);
+        ok &= name[5] == '0' + DatumGetInt32(res[i].payloads[0]) % 10;
+        ok &= i == 0 || res[i - 1].distance <= res[i].distance;
+    }
+    CHECK(ok, "payloads follow query->cols; sorted by distance");
+
+    /* selective: cat = 7 */
+    ExecPredicate sel = {.col = 0, .type = TUPLE_COL_I32, .op = EXEC_CMP_EQ,
+                         .value = Int32GetDatum(7)};
+    query.preds = &sel;
+    optimizer_plan(stats, &f->dt, &query, &plan);
+    CHECK(plan.strategy == PLAN_BRUTE_FORCE, "1% filter on a small table: brute force");
+    n = optimizer_execute(&ctx, &f->dt, &query, &plan, res);
+    ok = n == K;
+    for (int i = 0; i < n; i++) ok &= DatumGetInt32(res[i].payloads[0]) == 7;
+    CHECK(ok, "brute force returns k matching rows");
+
+    /* the same query forced through filtered traversal */
+    memcpy(ref, res, sizeof(ref));
+    nref = n;
+    QueryPlan filtered = {.strategy = PLAN_INDEX_FILTERED, .index = &f->index.base, .probe_k = K};
+    usize calls = f->index.filter_calls;
+    n = optimizer_execute(&ctx, &f->dt, &query, &filtered, res);
+    CHECK(same_results(res, n, ref, nref), "filtered traversal result equals brute force");
+    CHECK(f->index.filter_calls - calls > K, "predicate evaluated on rejected candidates too");
+
+    /* forced post-filter with too small a probe: falls back to brute force */
+    QueryPlan post = {.strategy = PLAN_INDEX_POSTFILTER, .index = &f->index.base, .probe_k = 2 * K};
+    n = optimizer_execute(&ctx, &f->dt, &query, &post, res);
+    CHECK(post.fell_back && same_results(res, n, ref, nref), "short post-filter result falls back");
+
+    memoryContext_delete(cxt);
+}
+
+/* ================================================================
+ * Test 5: index scan skips rows deleted behind the index
+ * ================================================================ */
+static void test_index_scan_visibility(Fixture* f)
+{
+    printf("\n=== Test index_scan_visibility ===\n");
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "query", 0);
+    ExecContext ctx = {.cxt = cxt};
+    f32 q[DIM] = {42.1f, 0, 0, 0};
+    TableQueryResult res[4];
+    u16 cols[1] = {0};
+
+    CHECK(heapStore_delete_by_ctid(&f->et.heap_table.store, f->heap_ctid[42]) != INVALID_TXN_ID,
+          "delete row 42 (index not told)");
+    PhysicalCollect* collect = PhysicalCollect_create(&ctx, res, 4);
+    PhysicalIndexScan* scan =
+        PhysicalIndexScan_create(&ctx, &f->dt, &f->index.base, q, 4, cols, 1, NULL, 0);
+    CHECK(scan && physicalIndexScan_run(scan, &collect->base) == 0, "index scan runs");
+    CHECK(scan->rows_fetched == 4 && collect->count == 3,
+          "deleted candidate dropped after the heap fetch");
+    bool ok = true;
+    for (usize i = 0; i < collect->count; i++) ok &= DatumGetInt32(res[i].payloads[0]) != 42;
+    CHECK(ok, "row 42 not returned");
+
+    ExecPredicate text = {.col = 0, .type = TUPLE_COL_TEXT, .op = EXEC_CMP_EQ};
+    CHECK(PhysicalIndexScan_create(&ctx, &f->dt, &f->index.base, q, 4, cols, 1, &text, 1) == NULL,
+          "varlena predicate rejected for filtered traversal");
+    memoryContext_delete(cxt);
+}
+
+/* ================================================================
+ * Test 6: index scan follows HOT chains from the root's index entry
+ * ================================================================ */
+static void test_index_scan_hot(Fixture* f)
+{
+    printf("\n=== Test index_scan_hot ===\n");
+
+    MemoryContext* cxt = MemoryContext_create(NULL, "query", 0);
+    ExecContext ctx = {.cxt = cxt};
+    f32 q[DIM] = {2999.1f, 0, 0, 0};
+    TableQueryResult res[4];
+    u16 cols[1] = {0};
+
+    ItemPtr root = f->heap_ctid[2999];
+    Datum vals[3] = {Int32GetDatum(77), Float64GetDatum(0.5), PointerGetDatum(f->names[2999])};
+    CHECK(dataTable_update(&f->dt, root, NULL, vals, 0) == 0, "payload-only update of row 2999");
+    HeapTupleRef ref;
+    bool hot = heapStore_fetch_ref(&f->et.heap_table.store, root, &ref) == 0;
+    hot = hot && (ref.hdr->t_infomask & HEAP_HOT_UPDATED);
+    heapStore_release_ref(&ref);
+    CHECK(hot, "update took the HOT path (index still keyed by the root)");
+
+    PhysicalCollect* collect = PhysicalCollect_create(&ctx, res, 4);
+    PhysicalIndexScan* scan =
+        PhysicalIndexScan_create(&ctx, &f->dt, &f->index.base, q, 4, cols, 1, NULL, 0);
+    CHECK(scan && physicalIndexScan_run(scan, &collect->base) == 0, "index scan runs");
+    CHECK(collect->count == 4 && DatumGetInt32(res[0].payloads[0]) == 77 &&
+              !item_ptr_equal(res[0].heap_ctid, root),
+          "HOT successor returned with its own ctid");
+
+    ExecPredicate cat = {.col = 0, .type = TUPLE_COL_I32, .op = EXEC_CMP_EQ,
+                         .value = Int32GetDatum(77)};
+    collect = PhysicalCollect_create(&ctx, res, 1);
+    scan = PhysicalIndexScan_create(&ctx, &f->dt, &f->index.base, q, 1, cols, 1, &cat, 1);
+    CHECK(scan && physicalIndexScan_run(scan, &collect->base) == 0, "filtered index scan runs");
+    CHECK(collect->count == 1 && res[0].distance < 1.0f,
+          "filter callback sees the HOT successor's new payload");
+    memoryContext_delete(cxt);
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   Optimizer Test Suite\n");
+    printf("========================================\n");
+
+    Fixture* f = calloc(1, sizeof(Fixture));
+    fixture_init(f);
+    TableStats stats;
+    TableStats_init(&stats);
+    test_analyze(f, &stats);
+    test_selectivity(&stats);
+    test_plan_choice();
+    test_execute(f, &stats);
+    test_index_scan_visibility(f);
+    test_index_scan_hot(f);
+    TableStats_deinit(&stats);
+    fixture_deinit(f);
+    free(f);
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
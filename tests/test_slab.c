@@ -0,0 +1,211 @@
+/**
+ * test_slab.c
+ *
+ * Tests for the slab pool (slab.h) and pooled block buffers (storage.h):
+ *   slabPool_alloc / slabPool_free       (alignment, reuse, slab growth)
+ *   concurrent alloc / free              (spinlock-protected free list)
+ *   Block_create / block_destroy         (embedded FileBuffer, pooled buffer)
+ *   FileBuffer_create / fileBuffer_destroy (BLOCK_SIZE pooled, other sizes malloc)
+ *
+ * Compile & run:
+ *   cd tests && make test_slab && ./test_slab
+ */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/slab.h"
+#include "../src/storage.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+/* ================================================================
+ * Test 1: alignment and reuse
+ * ================================================================ */
+static void test_alloc_free(void)
+{
+    printf("\n=== Test alloc_free ===\n");
+
+    SlabPool pool;
+    SlabPool_init(&pool, 8192);
+    CHECK(slabPool_mapped_bytes(&pool) == 0, "no slab mapped before first alloc");
+
+    u8* a = slabPool_alloc(&pool);
+    u8* b = slabPool_alloc(&pool);
+    CHECK(a && b && a != b, "two distinct objects");
+    CHECK(((uintptr_t)a & 8191) == 0 && ((uintptr_t)b & 8191) == 0, "objects aligned to obj_size");
+    CHECK(b == a + 8192, "consecutive allocations are adjacent");
+    CHECK(slabPool_mapped_bytes(&pool) == SLAB_SIZE, "one slab mapped");
+    CHECK(slabPool_free_count(&pool) == SLAB_SIZE / 8192 - 2, "rest of the slab is on the free list");
+
+    memset(a, 0xAB, 8192);
+    slabPool_free(&pool, a);
+    CHECK(slabPool_alloc(&pool) == a, "freed object is reused first");
+
+    SlabPool_deinit(&pool);
+
+    SlabPool odd;
+    SlabPool_init(&odd, 3000);
+    CHECK(odd.obj_size == 4096, "object size rounded up to a power of two");
+    SlabPool_deinit(&odd);
+}
+
+/* ================================================================
+ * Test 2: growing past one slab
+ * ================================================================ */
+static void test_multi_slab(void)
+{
+    printf("\n=== Test multi_slab ===\n");
+
+    SlabPool pool;
+    SlabPool_init(&pool, 8192);
+    usize per_slab = SLAB_SIZE / 8192;
+    usize n = per_slab * 2 + 3;
+    u8** objs = malloc(n * sizeof(u8*));
+    bool ok = true;
+    for (usize i = 0; i < n; i++)
+    {
+        objs[i] = slabPool_alloc(&pool);
+        if (!objs[i]) ok = false;
+        else objs[i][0] = (u8)i;
+    }
+    CHECK(ok, "all allocations succeeded");
+    CHECK(slabPool_mapped_bytes(&pool) == 3 * SLAB_SIZE, "three slabs mapped");
+
+    bool intact = true;
+    for (usize i = 0; i < n; i++) intact &= objs[i][0] == (u8)i;
+    CHECK(intact, "objects do not overlap");
+
+    for (usize i = 0; i < n; i++) slabPool_free(&pool, objs[i]);
+    CHECK(slabPool_free_count(&pool) == 3 * per_slab, "every object back on the free list");
+    CHECK(slabPool_mapped_bytes(&pool) == 3 * SLAB_SIZE, "slabs are kept for reuse");
+    free(objs);
+    SlabPool_deinit(&pool);
+}
+
+/* ================================================================
+ * Test 3: concurrent alloc / free
+ * ================================================================ */
+#define N_THREADS 4
+#define N_ROUNDS  2000
+#define N_HELD    16
+
+static SlabPool shared_pool;
+static _Atomic int corrupt = 0;
+
+static void* worker(void* arg)
+{
+    u8 tag = (u8)(uintptr_t)arg;
+    u8* held[N_HELD];
+    for (int r = 0; r < N_ROUNDS; r++)
+    {
+        for (int i = 0; i < N_HELD; i++)
+        {
+            held[i] = slabPool_alloc(&shared_pool);
+            memset(held[i], tag, 64);
+        }
+        for (int i = 0; i < N_HELD; i++)
+        {
+            for (int j = 0; j < 64; j++)
+                if (held[i][j] != tag) corrupt = 1;
+            slabPool_free(&shared_pool, held[i]);
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    printf("\n=== Test concurrent ===\n");
+
+    SlabPool_init(&shared_pool, 4096);
+    pthread_t th[N_THREADS];
+    for (int i = 0; i < N_THREADS; i++) pthread_create(&th[i], NULL, worker, (void*)(uintptr_t)(i + 1));
+    for (int i = 0; i < N_THREADS; i++) pthread_join(th[i], NULL);
+    CHECK(!corrupt, "no object handed to two threads at once");
+    CHECK(slabPool_free_count(&shared_pool) * shared_pool.obj_size == slabPool_mapped_bytes(&shared_pool),
+          "every object returned after the threads finish");
+    SlabPool_deinit(&shared_pool);
+}
+
+/* ================================================================
+ * Test 4: Block / FileBuffer on the block buffer pool
+ * ================================================================ */
+static void test_block_buffers(void)
+{
+    printf("\n=== Test block_buffers ===\n");
+
+    SlabPool* pool = blockBuffer_pool();
+    Block* b = Block_create(7);
+    CHECK(b && b->id == 7, "Block_create sets the id");
+    CHECK(b->fb == (FileBuffer*)(b + 1), "FileBuffer header embedded in the Block allocation");
+    CHECK(((uintptr_t)b->fb->internal_buf & (BLOCK_SIZE - 1)) == 0, "block buffer aligned to BLOCK_SIZE");
+    CHECK(b->fb->size == BLOCK_SIZE - sizeof(u64) && b->fb->buffer == b->fb->internal_buf + sizeof(u64),
+          "buffer layout matches the checksum header");
+
+    bool zero = true;
+    for (usize i = 0; i < b->fb->size; i++) zero &= b->fb->buffer[i] == 0;
+    CHECK(zero, "block buffer starts zeroed");
+
+    usize free_before = slabPool_free_count(pool);
+    data_ptr_t buf = b->fb->internal_buf;
+    memset(b->fb->buffer, 0x5A, b->fb->size);
+    block_destroy(b);
+    CHECK(slabPool_free_count(pool) == free_before + 1, "block_destroy returns the buffer to the pool");
+
+    Block* again = Block_create(8);
+    CHECK(again->fb->internal_buf == buf && again->fb->buffer[0] == 0, "recycled buffer is zeroed");
+    // legacy teardown used by older callers
+    fileBuffer_destroy(again->fb);
+    free(again);
+    CHECK(slabPool_free_count(pool) == free_before + 1, "fileBuffer_destroy + free also releases it");
+
+    FileBuffer* fb = FileBuffer_create(BLOCK_SIZE);
+    CHECK(fb && (fb->flags & FILEBUFFER_POOLED), "FileBuffer_create(BLOCK_SIZE) uses the pool");
+    fileBuffer_destroy(fb);
+
+    FileBuffer* hdr = FileBuffer_create(HEADER_SIZE);
+    CHECK(hdr && !(hdr->flags & FILEBUFFER_POOLED) && hdr->internal_size == HEADER_SIZE,
+          "other sizes keep the malloc path");
+    CHECK(((uintptr_t)hdr->internal_buf % FILE_BUFFER_BLOCK_SIZE) == 0, "malloc path stays aligned");
+    fileBuffer_destroy(hdr);
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   Slab Test Suite\n");
+    printf("========================================\n");
+
+    test_alloc_free();
+    test_multi_slab();
+    test_concurrent();
+    test_block_buffers();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
@@ -4,6 +4,9 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include "storage.h"
+#include "table.h"
+#include "db.h"
+#include <math.h>
 
 /* ============================================================
  * Test Framework
@@ -655,6 +658,349 @@ static int run_in_fork(void (*test_fn)(void), const char* name) {
     return 0;
 }
 
+/* ============================================================
+ * Section: Checkpoint Tests
+ * ============================================================ */
+
+#define CKPT_TABLES 6
+
+static void ckpt_create_tables(Catalog* cat) {
+    CreateSchemaInfo sinfo = {.schema_name = DEFAULT_SCHEMA, .if_not_exists = true};
+    catalog_create_schema(cat, &sinfo);
+    for (int t = 0; t < CKPT_TABLES; t++) {
+        char tname[32];
+        snprintf(tname, sizeof(tname), "t%d", t);
+        usize ncols = (usize)(t % 3) + 1;
+        ColumnDefinition* cols = calloc(ncols, sizeof(ColumnDefinition));
+        for (usize c = 0; c < ncols; c++) {
+            char cname[32];
+            snprintf(cname, sizeof(cname), "c%zu", c);
+            cols[c].name = strdup(cname);
+            cols[c].oid = c;
+            cols[c].type = SQLT_INTEGER;
+        }
+        CreateTableInfo info = {.schema_name = DEFAULT_SCHEMA, .table_name = tname,
+                                .if_not_exists = false, .columns = cols, .col_count = ncols};
+        catalog_create_table(cat, &info);
+        free(cols);
+    }
+}
+
+static bool ckpt_write_db(u32 nworkers) {
+    cleanup_db();
+    SingleFileBlockManager* mgr = create_new_database(TEST_DB, true);
+    if (!mgr) { printf("  [SKIP]\n"); return false; }
+    Catalog* cat = catalog_create();
+    ckpt_create_tables(cat);
+
+    CheckpointManager* cpm = CheckpointManager_create((BlockManager*)mgr, cat);
+    checkpointManager_set_workers(cpm, nworkers);
+    ASSERT_EQ_U64(cpm->nworkers, nworkers, "checkpoint worker count set");
+    checkpointManager_createpoint(cpm);
+    ASSERT_TRUE(mgr->meta_block != INVALID_BLOCK, "checkpoint produced a meta block");
+    CheckpointManager_destroy(cpm);
+    destory_single_manager(mgr);
+    return true;
+}
+
+static void ckpt_roundtrip(u32 nworkers) {
+    if (!ckpt_write_db(nworkers)) return;
+
+    SingleFileBlockManager* reopened = create_new_database(TEST_DB, false);
+    ASSERT_NOT_NULL(reopened, "reopen database after checkpoint");
+    if (!reopened) return;
+    Catalog* loaded = catalog_create();
+    CheckpointManager* loader = CheckpointManager_create((BlockManager*)reopened, loaded);
+    checkpointManager_loadfromstorage(loader);
+
+    int found = 0, cols_ok = 0;
+    for (int t = 0; t < CKPT_TABLES; t++) {
+        char tname[32];
+        snprintf(tname, sizeof(tname), "t%d", t);
+        TableCatalogEntry* e = catalog_get_table(loaded, DEFAULT_SCHEMA, tname);
+        if (!e) continue;
+        found++;
+        if (e->column_count == (usize)(t % 3) + 1) cols_ok++;
+    }
+    ASSERT_EQ_U64(found, CKPT_TABLES, "all tables restored from checkpoint");
+    ASSERT_EQ_U64(cols_ok, CKPT_TABLES, "restored tables keep their column counts");
+
+    CheckpointManager_destroy(loader);
+    destory_single_manager(reopened);
+    cleanup_db();
+}
+
+void test_checkpoint_serial_roundtrip(void) {
+    printf("\n--- test_checkpoint_serial_roundtrip ---\n");
+    ckpt_roundtrip(1);
+}
+
+void test_checkpoint_parallel_roundtrip(void) {
+    printf("\n--- test_checkpoint_parallel_roundtrip ---\n");
+    ckpt_roundtrip(4);
+}
+
+static void ckpt_lazy_load(u32 prefetch_workers) {
+    if (!ckpt_write_db(1)) return;
+
+    SingleFileBlockManager* reopened = create_new_database(TEST_DB, false);
+    ASSERT_NOT_NULL(reopened, "reopen database after checkpoint");
+    if (!reopened) return;
+    Catalog* loaded = catalog_create();
+    CheckpointManager* loader = CheckpointManager_create((BlockManager*)reopened, loaded);
+    checkpointManager_set_load_mode(loader, CHECKPOINT_LOAD_LAZY, prefetch_workers);
+    checkpointManager_loadfromstorage(loader);
+    ASSERT_EQ_U64(loader->pending_tables.size, CKPT_TABLES, "lazy load defers every table");
+
+    if (prefetch_workers == 0) {
+        // catalog 已可见但数据未读：直接查 CatalogSet 不会触发加载
+        SchemaCatalogEntry* schema = catalog_get_schema(loaded, DEFAULT_SCHEMA);
+        TableCatalogEntry* raw = (TableCatalogEntry*)catalogSet_get_entry(&schema->tables, "t0");
+        ASSERT_NOT_NULL(raw, "table definition visible before data load");
+        if (raw)
+            ASSERT_EQ_U64(atomic_load(&raw->data_state), TABLE_DATA_PENDING,
+                          "table data still pending before first access");
+    } else {
+        checkpointManager_wait_prefetch(loader);
+    }
+
+    int loaded_ok = 0;
+    for (int t = 0; t < CKPT_TABLES; t++) {
+        char tname[32];
+        snprintf(tname, sizeof(tname), "t%d", t);
+        TableCatalogEntry* e = catalog_get_table(loaded, DEFAULT_SCHEMA, tname);
+        if (e && atomic_load(&e->data_state) == TABLE_DATA_LOADED &&
+            e->column_count == (usize)(t % 3) + 1)
+            loaded_ok++;
+    }
+    ASSERT_EQ_U64(loaded_ok, CKPT_TABLES, "every table loaded after access/prefetch");
+
+    // 重新 checkpoint 懒加载的库，再 eager 打开仍能看到所有表
+    checkpointManager_createpoint(loader);
+    CheckpointManager_destroy(loader);
+    destory_single_manager(reopened);
+
+    SingleFileBlockManager* again = create_new_database(TEST_DB, false);
+    ASSERT_NOT_NULL(again, "reopen database after lazy re-checkpoint");
+    if (!again) return;
+    Catalog* cat2 = catalog_create();
+    CheckpointManager* loader2 = CheckpointManager_create((BlockManager*)again, cat2);
+    checkpointManager_loadfromstorage(loader2);
+    int found = 0;
+    for (int t = 0; t < CKPT_TABLES; t++) {
+        char tname[32];
+        snprintf(tname, sizeof(tname), "t%d", t);
+        if (catalog_get_table(cat2, DEFAULT_SCHEMA, tname)) found++;
+    }
+    ASSERT_EQ_U64(found, CKPT_TABLES, "tables survive a checkpoint taken in lazy mode");
+    CheckpointManager_destroy(loader2);
+    destory_single_manager(again);
+    cleanup_db();
+}
+
+void test_checkpoint_lazy_load_on_access(void) {
+    printf("\n--- test_checkpoint_lazy_load_on_access ---\n");
+    ckpt_lazy_load(0);
+}
+
+void test_checkpoint_lazy_load_prefetch(void) {
+    printf("\n--- test_checkpoint_lazy_load_prefetch ---\n");
+    ckpt_lazy_load(3);
+}
+
+/* 预取还在跑时关闭数据库：db_close 先等预取结束再释放 catalog */
+void test_checkpoint_close_during_prefetch(void) {
+    printf("\n--- test_checkpoint_close_during_prefetch ---\n");
+    if (!ckpt_write_db(1)) return;
+
+    SingleFileBlockManager* reopened = create_new_database(TEST_DB, false);
+    ASSERT_NOT_NULL(reopened, "reopen database after checkpoint");
+    if (!reopened) return;
+    StorageManager sm = {.block_manager = (BlockManager*)reopened};
+    DBConfig config = {.load_mode = CHECKPOINT_LOAD_LAZY, .prefetch_workers = 3};
+    DB db;
+    ASSERT_TRUE(db_open(&db, &sm, &config) == 0, "db_open with lazy prefetch config");
+    db_close(&db);
+    ASSERT_TRUE(db.checkpoint_manager == NULL && db.catalog == NULL,
+                "db_close releases checkpoint manager and catalog");
+    destory_single_manager(reopened);
+    cleanup_db();
+}
+
+/* 默认配置打开数据库走懒加载：catalog 立即可见，表数据在访问时或由预取加载 */
+void test_db_open_default_lazy(void) {
+    printf("\n--- test_db_open_default_lazy ---\n");
+    if (!ckpt_write_db(1)) return;
+
+    SingleFileBlockManager* reopened = create_new_database(TEST_DB, false);
+    ASSERT_NOT_NULL(reopened, "reopen database after checkpoint");
+    if (!reopened) return;
+    StorageManager sm = {.block_manager = (BlockManager*)reopened};
+    DB db;
+    ASSERT_TRUE(db_open(&db, &sm, NULL) == 0, "db_open with default config");
+    ASSERT_TRUE(db.checkpoint_manager->load_mode == CHECKPOINT_LOAD_LAZY &&
+                    db.checkpoint_manager->prefetch_workers == DB_DEFAULT_PREFETCH_WORKERS,
+                "default open uses lazy load with background prefetch");
+    ASSERT_EQ_U64(db.checkpoint_manager->pending_tables.size, CKPT_TABLES,
+                  "table data deferred at open");
+
+    int loaded_ok = 0;
+    for (int t = 0; t < CKPT_TABLES; t++) {
+        char tname[32];
+        snprintf(tname, sizeof(tname), "t%d", t);
+        TableCatalogEntry* e = catalog_get_table(db.catalog, DEFAULT_SCHEMA, tname);
+        if (e && atomic_load(&e->data_state) == TABLE_DATA_LOADED) loaded_ok++;
+    }
+    ASSERT_EQ_U64(loaded_ok, CKPT_TABLES, "every table loaded on access");
+    db_close(&db);
+    destory_single_manager(reopened);
+    cleanup_db();
+}
+
+/* 手工写一列的数据块：每块 rows_per_block 行，值为 row * scale。返回 DataPointer 列表。 */
+static Vector zm_write_column(BlockManager* bm, usize total_rows, usize rows_per_block,
+                              i64 scale, bool wide) {
+    Vector dps = VEC(DataPointer, 0);
+    for (usize start = 0; start < total_rows; start += rows_per_block) {
+        usize n = MIN(rows_per_block, total_rows - start);
+        Block* blk = Block_create(VCALL(bm, get_free_block_id));
+        DataPointer dp = {.min = INFINITY, .max = -INFINITY, .row_start = start,
+                          .tuple_count = n, .block_id = blk->id, .offset = 0,
+                          .has_stats = true};
+        for (usize r = 0; r < n; r++) {
+            i64 v = (i64)(start + r) * scale;
+            if (wide) ((i64*)blk->fb->buffer)[r] = v;
+            else ((i32*)blk->fb->buffer)[r] = (i32)v;
+            dp.min = MIN(dp.min, (f64)v);
+            dp.max = MAX(dp.max, (f64)v);
+        }
+        VCALL(bm, write, blk);
+        block_destroy(blk);
+        vector_push_back(&dps, &dp);
+    }
+    return dps;
+}
+
+/* 把两列的 DataPointer 写成一段 tabledata，记到 entry 上。legacy 模拟 zone map 之前的格式 */
+static void zm_write_table_data(BlockManager* bm, TableCatalogEntry* entry, Vector* dps,
+                                bool legacy) {
+    MetaBlockWriter* td = MetaBlockWriter_create(bm);
+    entry->td_block_id = td->block->id;
+    entry->td_offset = td->offset;
+    for (int c = 0; c < 2; c++) {
+        SERIALIZER_WRITE_U64(td, vector_size(&dps[c]));
+        VECTOR_FOREACH(&dps[c], raw) {
+            DataPointer* dp = raw;
+            SERIALIZER_WRITE_F64(td, legacy ? 0 : dp->min);
+            SERIALIZER_WRITE_F64(td, legacy ? 0 : dp->max);
+            SERIALIZER_WRITE_U64(td, dp->row_start);
+            SERIALIZER_WRITE_U64(td, dp->tuple_count);
+            SERIALIZER_WRITE_U64(td, dp->block_id);
+            SERIALIZER_WRITE_U32(td, dp->offset);
+            if (!legacy) SERIALIZER_WRITE_U8(td, (u8)dp->has_stats);
+        }
+        vector_deinit(&dps[c]);
+    }
+    metaBlockWriter_flush(td);
+    metaBlockWriter_destroy(td);
+}
+
+typedef struct {
+    u64 first_row;
+    u64 rows;
+    bool values_ok;
+} ZmScanResult;
+
+static void zm_collect(DataChunk* chunk, u64 row_start, void* arg) {
+    ZmScanResult* res = arg;
+    if (res->rows == 0) res->first_row = row_start;
+    if (row_start != res->first_row + res->rows) res->values_ok = false;
+    i64* c0 = (i64*)chunk->arrays[0].data;
+    i32* c1 = (i32*)chunk->arrays[1].data;
+    for (usize i = 0; i < chunk->arrays[0].count; i++) {
+        if (c0[i] != (i64)(row_start + i) || c1[i] != (i32)((row_start + i) * 2))
+            res->values_ok = false;
+    }
+    res->rows += chunk->arrays[0].count;
+}
+
+void test_checkpoint_zone_map_scan(void) {
+    printf("\n--- test_checkpoint_zone_map_scan ---\n");
+    cleanup_db();
+    SingleFileBlockManager* mgr = create_new_database(TEST_DB, true);
+    if (!mgr) { printf("  [SKIP]\n"); return; }
+    BlockManager* bm = (BlockManager*)mgr;
+    Catalog* cat = catalog_create();
+    CreateSchemaInfo sinfo = {.schema_name = DEFAULT_SCHEMA, .if_not_exists = true};
+    catalog_create_schema(cat, &sinfo);
+    ColumnDefinition cols[2] = {{.name = strdup("ts"), .oid = 0, .type = SQLT_BIGINT},
+                                {.name = strdup("v"), .oid = 1, .type = SQLT_INTEGER}};
+    CreateTableInfo info = {.schema_name = DEFAULT_SCHEMA, .table_name = "zm",
+                            .if_not_exists = false, .columns = cols, .col_count = 2};
+    catalog_create_table(cat, &info);
+    TableCatalogEntry* entry = catalog_get_table(cat, DEFAULT_SCHEMA, "zm");
+
+    // ts: 3 块 x 100 行；v: 2 块 x 150 行，两列块边界不同
+    Vector dps[2] = {zm_write_column(bm, 300, 100, 1, true),
+                     zm_write_column(bm, 300, 150, 2, false)};
+    zm_write_table_data(bm, entry, dps, false);
+
+    DataPointer dp = {.min = 10, .max = 20, .has_stats = true};
+    ZoneMapPredicate pmatch = {.column = 0, .min = 15, .max = INFINITY};
+    ASSERT_TRUE(dataPointer_may_match(&dp, &pmatch), "overlapping zone may match");
+    pmatch.min = 21;
+    ASSERT_TRUE(!dataPointer_may_match(&dp, &pmatch), "disjoint zone cannot match");
+    dp.has_stats = false;
+    ASSERT_TRUE(dataPointer_may_match(&dp, &pmatch), "zone without stats may match");
+
+    CheckpointManager* cpm = CheckpointManager_create(bm, cat);
+    ZmScanResult all = {.values_ok = true};
+    usize skipped = checkpointManager_scan_table(cpm, entry, NULL, 0, zm_collect, &all);
+    ASSERT_EQ_U64(all.rows, 300, "unfiltered scan returns every row");
+    ASSERT_EQ_U64(skipped, 0, "unfiltered scan skips nothing");
+    ASSERT_TRUE(all.values_ok, "unfiltered scan values line up across columns");
+
+    // ts >= 250：只剩 ts 的第 3 块和 v 的第 2 块
+    ZoneMapPredicate gt = {.column = 0, .min = 250, .max = INFINITY};
+    ZmScanResult tail = {.values_ok = true};
+    skipped = checkpointManager_scan_table(cpm, entry, &gt, 1, zm_collect, &tail);
+    ASSERT_EQ_U64(tail.first_row, 200, "range scan starts at first matching block");
+    ASSERT_EQ_U64(tail.rows, 100, "range scan reads only the matching block's rows");
+    ASSERT_EQ_U64(skipped, 3, "range scan skips non-matching blocks of every column");
+    ASSERT_TRUE(tail.values_ok, "range scan values line up across columns");
+
+    // 120 <= ts <= 130 AND v >= 400：行区间 [100,200) ∩ [150,300) = [150,200)
+    ZoneMapPredicate both[2] = {{.column = 0, .min = 120, .max = 130},
+                                {.column = 1, .min = 400, .max = INFINITY}};
+    ZmScanResult mid = {.values_ok = true};
+    checkpointManager_scan_table(cpm, entry, both, 2, zm_collect, &mid);
+    ASSERT_EQ_U64(mid.first_row, 150, "conjunctive predicates intersect row ranges");
+    ASSERT_EQ_U64(mid.rows, 50, "conjunctive scan row count");
+    ASSERT_TRUE(mid.values_ok, "conjunctive scan values line up across columns");
+
+    ZoneMapPredicate none = {.column = 0, .min = 1000, .max = INFINITY};
+    ZmScanResult empty = {.values_ok = true};
+    skipped = checkpointManager_scan_table(cpm, entry, &none, 1, zm_collect, &empty);
+    ASSERT_EQ_U64(empty.rows, 0, "predicate outside every zone returns nothing");
+    ASSERT_EQ_U64(skipped, 5, "predicate outside every zone skips all blocks");
+
+    // 旧格式 checkpoint：min/max 都是 0 且没有标志位，范围谓词不能跳过任何块
+    dps[0] = zm_write_column(bm, 300, 100, 1, true);
+    dps[1] = zm_write_column(bm, 300, 150, 2, false);
+    zm_write_table_data(bm, entry, dps, true);
+    bm->checkpoint_format = 0;
+    ZmScanResult legacy = {.values_ok = true};
+    skipped = checkpointManager_scan_table(cpm, entry, &gt, 1, zm_collect, &legacy);
+    ASSERT_EQ_U64(legacy.rows, 300, "legacy checkpoint range scan returns every row");
+    ASSERT_EQ_U64(skipped, 0, "legacy checkpoint range scan skips nothing");
+    ASSERT_TRUE(legacy.values_ok, "legacy checkpoint values line up across columns");
+    bm->checkpoint_format = CHECKPOINT_FORMAT;
+
+    CheckpointManager_destroy(cpm);
+    destory_single_manager(mgr);
+    cleanup_db();
+}
+
 /* ============================================================
  * Main
  * ============================================================ */
@@ -695,6 +1041,15 @@ int main(void) {
     run_in_fork(test_write_header_destroy_safe, "test_write_header_destroy_safe");
     run_in_fork(test_write_header_twice, "test_write_header_twice");
 
+    printf("\n====== Checkpoint Tests ======\n");
+    run_in_fork(test_checkpoint_serial_roundtrip, "test_checkpoint_serial_roundtrip");
+    run_in_fork(test_checkpoint_parallel_roundtrip, "test_checkpoint_parallel_roundtrip");
+    run_in_fork(test_checkpoint_lazy_load_on_access, "test_checkpoint_lazy_load_on_access");
+    run_in_fork(test_checkpoint_lazy_load_prefetch, "test_checkpoint_lazy_load_prefetch");
+    run_in_fork(test_checkpoint_close_during_prefetch, "test_checkpoint_close_during_prefetch");
+    run_in_fork(test_db_open_default_lazy, "test_db_open_default_lazy");
+    run_in_fork(test_checkpoint_zone_map_scan, "test_checkpoint_zone_map_scan");
+
     printf("\n====== Vector Correctness Tests ======\n");
     test_vector_deinit_nulls_data();
     test_vector_init_no_free_on_error();
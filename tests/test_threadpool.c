@@ -0,0 +1,272 @@
+/**
+ * test_threadpool.c
+ *
+ * Tests for the work-stealing scheduler in threadpool.h:
+ *   taskGroup_spawn / taskGroup_wait   (every task runs once, from any thread)
+ *   nested TaskGroups                  (waiters help, no pool starvation)
+ *   work stealing                      (tasks spawned on one worker spread out)
+ *   threadPool_parallel_for            (each index covered exactly once)
+ *   short-lived TaskGroups             (group freed as soon as wait returns)
+ *   THREADPOOL_PIN_CPUS / shared pool  (smoke)
+ *
+ * Compile & run:
+ *   cd tests && make test_threadpool && ./test_threadpool
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/threadpool.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+/* ================================================================
+ * Test 1: every spawned task runs exactly once
+ * ================================================================ */
+#define NTASKS 10000
+
+static _Atomic int hits[NTASKS];
+
+static void mark_task(void* arg)
+{
+    atomic_fetch_add(&hits[(usize)arg], 1);
+}
+
+static void test_spawn_wait(void)
+{
+    printf("\n=== Test spawn_wait ===\n");
+
+    ThreadPool* pool = ThreadPool_create(4, 0);
+    CHECK(pool && threadPool_size(pool) == 4, "pool started four workers");
+    memset(hits, 0, sizeof(hits));
+    TaskGroup group;
+    TaskGroup_init(&group, pool);
+    for (usize i = 0; i < NTASKS; i++) taskGroup_spawn(&group, mark_task, (void*)i);
+    taskGroup_wait(&group);
+
+    int once = 0;
+    for (usize i = 0; i < NTASKS; i++) once += atomic_load(&hits[i]) == 1;
+    CHECK(once == NTASKS, "each task ran exactly once");
+    CHECK(atomic_load(&group.pending) == 0, "group drained");
+    threadPool_destroy(pool);
+}
+
+/* ================================================================
+ * Test 2: nested groups deeper than the pool do not starve
+ * ================================================================ */
+typedef struct
+{
+    ThreadPool* pool;
+    int depth;
+    _Atomic long* leaves;
+} NestArg;
+
+static void nest_task(void* arg)
+{
+    NestArg* a = arg;
+    if (a->depth == 0)
+    {
+        atomic_fetch_add(a->leaves, 1);
+        return;
+    }
+    NestArg kids[4];
+    TaskGroup group;
+    TaskGroup_init(&group, a->pool);
+    for (int i = 0; i < 4; i++)
+    {
+        kids[i] = (NestArg){a->pool, a->depth - 1, a->leaves};
+        taskGroup_spawn(&group, nest_task, &kids[i]);
+    }
+    taskGroup_wait(&group);
+}
+
+static void test_nested_groups(void)
+{
+    printf("\n=== Test nested_groups ===\n");
+
+    ThreadPool* pool = ThreadPool_create(2, 0);
+    _Atomic long leaves = 0;
+    NestArg root = {pool, 5, &leaves};
+    nest_task(&root);
+    CHECK(atomic_load(&leaves) == 1024, "4^5 leaves ran with two workers");
+    threadPool_destroy(pool);
+}
+
+/* ================================================================
+ * Test 3: tasks spawned by one worker are stolen by others
+ * ================================================================ */
+#define STEAL_TASKS 64
+
+typedef struct
+{
+    ThreadPool* pool;
+    pthread_t ran_on[STEAL_TASKS];
+} StealShared;
+
+typedef struct
+{
+    StealShared* s;
+    int i;
+} StealArg;
+
+static void steal_leaf(void* arg)
+{
+    StealArg* a = arg;
+    a->s->ran_on[a->i] = pthread_self();
+    usleep(1000); /* 让出 CPU，单核机器上其他 worker 也能偷到 */
+}
+
+static void steal_root(void* arg)
+{
+    StealShared* s = arg;
+    StealArg args[STEAL_TASKS];
+    TaskGroup group;
+    TaskGroup_init(&group, s->pool);
+    for (int i = 0; i < STEAL_TASKS; i++)
+    {
+        args[i] = (StealArg){s, i};
+        taskGroup_spawn(&group, steal_leaf, &args[i]);
+    }
+    taskGroup_wait(&group);
+}
+
+static void test_work_stealing(void)
+{
+    printf("\n=== Test work_stealing ===\n");
+
+    StealShared s;
+    memset(&s, 0, sizeof(s));
+    s.pool = ThreadPool_create(4, 0);
+    TaskGroup group;
+    TaskGroup_init(&group, s.pool);
+    taskGroup_spawn(&group, steal_root, &s);
+    taskGroup_wait(&group);
+
+    int distinct = 0;
+    for (int i = 0; i < STEAL_TASKS; i++)
+    {
+        int seen = 0;
+        for (int j = 0; j < i && !seen; j++) seen = pthread_equal(s.ran_on[i], s.ran_on[j]);
+        distinct += !seen;
+    }
+    CHECK(distinct > 1, "local deque tasks ran on more than one thread");
+    threadPool_destroy(s.pool);
+}
+
+/* ================================================================
+ * Test 4: parallel_for covers the range exactly once
+ * ================================================================ */
+#define PF_N 100003
+
+static _Atomic unsigned char covered[PF_N];
+
+static void cover_range(usize lo, usize hi, void* arg)
+{
+    _Atomic long* calls = arg;
+    atomic_fetch_add(calls, 1);
+    for (usize i = lo; i < hi; i++) atomic_fetch_add(&covered[i], 1);
+}
+
+static void test_parallel_for(void)
+{
+    printf("\n=== Test parallel_for ===\n");
+
+    ThreadPool* pool = ThreadPool_create(3, THREADPOOL_PIN_CPUS);
+    memset(covered, 0, sizeof(covered));
+    _Atomic long calls = 0;
+    threadPool_parallel_for(pool, 0, PF_N, 100, cover_range, &calls);
+    int once = 0;
+    for (usize i = 0; i < PF_N; i++) once += atomic_load(&covered[i]) == 1;
+    CHECK(once == PF_N, "each index covered exactly once");
+    CHECK(atomic_load(&calls) > 1, "range split into several chunks");
+
+    atomic_store(&calls, 0);
+    threadPool_parallel_for(pool, 10, 20, 100, cover_range, &calls);
+    CHECK(atomic_load(&calls) == 1, "range below grain runs as one chunk");
+    atomic_store(&calls, 0);
+    threadPool_parallel_for(pool, 5, 5, 1, cover_range, &calls);
+    CHECK(atomic_load(&calls) == 0, "empty range runs nothing");
+    threadPool_destroy(pool);
+
+    ThreadPool* shared = threadPool_shared();
+    CHECK(shared && shared == threadPool_shared(), "shared pool is a singleton");
+    memset(covered, 0, sizeof(covered));
+    threadPool_parallel_for(shared, 0, PF_N, 1, cover_range, &calls);
+    once = 0;
+    for (usize i = 0; i < PF_N; i++) once += atomic_load(&covered[i]) == 1;
+    CHECK(once == PF_N, "shared pool covers the range");
+}
+
+/* ================================================================
+ * Test 5: a group may be freed as soon as taskGroup_wait returns
+ * ================================================================ */
+#define SHORT_GROUP_ROUNDS 2000
+#define SHORT_GROUP_TASKS  4
+
+static void bump(void* arg)
+{
+    atomic_fetch_add((_Atomic long*)arg, 1);
+}
+
+static void test_short_lived_groups(void)
+{
+    printf("\n=== Test short_lived_groups ===\n");
+
+    ThreadPool* pool = ThreadPool_create(3, 0);
+    _Atomic long ran = 0;
+    int complete = 0;
+    for (int r = 0; r < SHORT_GROUP_ROUNDS; r++)
+    {
+        TaskGroup* group = malloc(sizeof(TaskGroup));
+        TaskGroup_init(group, pool);
+        long before = atomic_load(&ran);
+        for (int t = 0; t < SHORT_GROUP_TASKS; t++) taskGroup_spawn(group, bump, &ran);
+        taskGroup_wait(group);
+        complete += atomic_load(&ran) - before == SHORT_GROUP_TASKS;
+        // 完成方在计数归零后不能再碰组：立刻覆写并释放
+        memset(group, 0xff, sizeof(TaskGroup));
+        free(group);
+    }
+    CHECK(complete == SHORT_GROUP_ROUNDS, "every wait returns after all of its tasks");
+    threadPool_destroy(pool);
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   ThreadPool Test Suite\n");
+    printf("========================================\n");
+
+    test_spawn_wait();
+    test_nested_groups();
+    test_work_stealing();
+    test_parallel_for();
+    test_short_lived_groups();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
@@ -0,0 +1,229 @@
+/**
+ * test_toast.c
+ *
+ * Tests for out-of-line storage of oversized tuples:
+ *   toast_compress / toast_decompress  (LZ4 block format round trips)
+ *   ToastStore                         (chunk chains across pages, page reuse)
+ *   HeapStore + TOAST                  (inline compression, external values,
+ *                                       detoast on read, vacuum release)
+ *
+ * Compile & run:
+ *   cd tests && make test_toast && ./test_toast
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/table.h"
+#include "../src/toast.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+static const TupleColType text_cols[2] = {TUPLE_COL_I32, TUPLE_COL_TEXT};
+static const TableSchema text_schema = {.cols = text_cols, .ncols = 2};
+
+/* xorshift noise: incompressible bytes */
+static void fill_noise(u8* p, usize n, u32 seed)
+{
+    for (usize i = 0; i < n; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        p[i] = (u8)seed;
+    }
+}
+
+/* malloc'd TEXT datum: [u32 len][data] */
+static u8* make_text(usize len, bool noisy)
+{
+    u8* t = malloc(4 + len);
+    u32 l = (u32)len;
+    memcpy(t, &l, 4);
+    if (noisy)
+        fill_noise(t + 4, len, 12345u + (u32)len);
+    else
+        for (usize i = 0; i < len; i++) t[4 + i] = (u8)("vector metadata "[i % 16]);
+    return t;
+}
+
+static bool text_equal(Datum got, const u8* want)
+{
+    u32 len;
+    memcpy(&len, want, 4);
+    return got && memcmp(DatumGetPointer(got), want, 4 + len) == 0;
+}
+
+/* ================================================================
+ * Test 1: compression round trips
+ * ================================================================ */
+static void test_lz_round_trip(void)
+{
+    printf("\n=== Test lz_round_trip ===\n");
+
+    usize n = 10000;
+    u8* src = make_text(n, false);
+    u8* dst = malloc(n);
+    u8* back = malloc(n + 4);
+    usize clen = toast_compress(src, n + 4, dst, n);
+    CHECK(clen > 0 && clen < n / 10, "repetitive text compresses well");
+    CHECK(toast_decompress(dst, clen, back, n + 4) && memcmp(back, src, n + 4) == 0,
+          "decompress restores the input");
+    CHECK(!toast_decompress(dst, clen, back, n + 3), "wrong raw size is rejected");
+
+    u8 run[300];
+    memset(run, 'x', sizeof(run));
+    clen = toast_compress(run, sizeof(run), dst, n);
+    CHECK(clen > 0 && toast_decompress(dst, clen, back, sizeof(run)) &&
+              memcmp(back, run, sizeof(run)) == 0,
+          "overlapping match (offset 1) round-trips");
+
+    fill_noise(src, n, 7);
+    CHECK(toast_compress(src, n, dst, n) == 0, "incompressible input is refused");
+    u8 tiny[5] = {1, 2, 3, 4, 5};
+    CHECK(toast_compress(tiny, 5, dst, n) == 0, "tiny input is refused");
+
+    free(src);
+    free(dst);
+    free(back);
+}
+
+/* ================================================================
+ * Test 2: chunk chains span pages; emptied pages are reused
+ * ================================================================ */
+static void test_toast_store_pages(void)
+{
+    printf("\n=== Test toast_store_pages ===\n");
+
+    ToastStore ts;
+    ToastStore_init(&ts, NULL);
+    usize n = 3 * BLOCK_SIZE;
+    u8* big = malloc(n);
+    u8* back = malloc(n);
+    fill_noise(big, n, 99);
+
+    ToastPointer a = toastStore_put(&ts, big, (u32)n, (u32)n, 0);
+    CHECK(toastStore_page_count(&ts) == 4, "value spans four pages");
+    CHECK(toastStore_fetch(&ts, &a, back) && memcmp(back, big, n) == 0, "fetch reassembles chunks");
+
+    ToastPointer b = toastStore_put(&ts, big, 100, 100, 0);
+    toastStore_delete(&ts, &a);
+    ToastPointer c = toastStore_put(&ts, big, (u32)(2 * BLOCK_SIZE), (u32)(2 * BLOCK_SIZE), 0);
+    CHECK(toastStore_page_count(&ts) == 4, "freed pages are reused");
+    CHECK(toastStore_fetch(&ts, &b, back) && memcmp(back, big, 100) == 0,
+          "neighbouring value survives the delete");
+    CHECK(toastStore_fetch(&ts, &c, back) && memcmp(back, big, 2 * BLOCK_SIZE) == 0,
+          "value written into reused pages reads back");
+
+    ToastStore_deinit(&ts);
+    free(big);
+    free(back);
+}
+
+/* ================================================================
+ * Test 3: heap tuples over the threshold are compressed or moved out of line
+ * ================================================================ */
+static void test_heap_toast(void)
+{
+    printf("\n=== Test heap_toast ===\n");
+
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &text_schema, NULL);
+
+    u8* doc = make_text(20000, false);
+    Datum row[2] = {Int32GetDatum(1), PointerGetDatum(doc)};
+    ItemPtr c1 = heapStore_insert(&store, 0, INVALID_ITEM_PTR, row, 0);
+    CHECK(toastStore_page_count(&store.toast) == 0, "compressible document stays inline");
+
+    u8* blob = make_text(30000, true);
+    row[0] = Int32GetDatum(2);
+    row[1] = PointerGetDatum(blob);
+    ItemPtr c2 = heapStore_insert(&store, 0, INVALID_ITEM_PTR, row, 0);
+    u32 toast_pages = toastStore_page_count(&store.toast);
+    CHECK(toast_pages >= 4, "incompressible document moved out of line");
+    CHECK(vector_size(store.tree.nodes) == 1, "heap keeps a single dense page");
+
+    HeapTuple got;
+    CHECK(heapStore_get_by_ctid(&store, &text_schema, c1, &got) == 0 && text_equal(got.cols[1], doc),
+          "compressed value detoasts on read");
+    row_tuple_free(&got, &text_schema);
+    CHECK(heapStore_get_by_ctid(&store, &text_schema, c2, &got) == 0 && text_equal(got.cols[1], blob),
+          "external value detoasts on read");
+    row_tuple_free(&got, &text_schema);
+
+    HeapStoreIter iter;
+    heapStoreIter_begin(&iter, &store);
+    const TupleHdr* hdr;
+    bool byref_ok = true;
+    while ((hdr = heapStoreIter_next(&iter)) != NULL)
+    {
+        HeapTupleRef ref = {.hdr = hdr, .col_data = iter.curr_col_data, .schema = &text_schema,
+                            .store = &store};
+        Datum out[2];
+        heapStore_deform_cols_byref(&ref, 0x3, out);
+        if (!datum_is_toasted(out[1])) byref_ok = false;
+        Datum plain = heapStore_detoast(&store, out[1], NULL);
+        if (!text_equal(plain, DatumGetInt32(out[0]) == 1 ? doc : blob)) byref_ok = false;
+        free(DatumGetPointer(plain));
+    }
+    heapStoreIter_end(&iter);
+    CHECK(byref_ok, "zero-copy deform leaves values toasted until heapStore_detoast");
+
+    heapStore_delete_by_ctid(&store, c2);
+    heapStore_vacuum(&store, VACUUM_HORIZON_ALL, NULL, NULL);
+    row[0] = Int32GetDatum(3);
+    ItemPtr c3 = heapStore_insert(&store, 0, INVALID_ITEM_PTR, row, 0);
+    CHECK(toastStore_page_count(&store.toast) == toast_pages, "vacuum frees overflow pages for reuse");
+    CHECK(heapStore_get_by_ctid(&store, &text_schema, c3, &got) == 0 && text_equal(got.cols[1], blob),
+          "value stored in reused pages reads back");
+    row_tuple_free(&got, &text_schema);
+
+    store.toast_compression = false;
+    row[1] = PointerGetDatum(doc);
+    ItemPtr c4 = heapStore_insert(&store, 0, INVALID_ITEM_PTR, row, 0);
+    CHECK(toastStore_page_count(&store.toast) > toast_pages, "compression off: stored out of line");
+    CHECK(heapStore_get_by_ctid(&store, &text_schema, c4, &got) == 0 && text_equal(got.cols[1], doc),
+          "uncompressed external value reads back");
+    row_tuple_free(&got, &text_schema);
+
+    HeapStore_deinit(&store);
+    free(doc);
+    free(blob);
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   TOAST Test Suite\n");
+    printf("========================================\n");
+
+    test_lz_round_trip();
+    test_toast_store_pages();
+    test_heap_toast();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}
@@ -0,0 +1,282 @@
+/**
+ * test_transaction.c
+ *
+ * Tests for the transaction manager and MVCC snapshots:
+ *   TransactionManager      (xid allocation, commit log, oldest xmin)
+ *   clog truncation         (aborted xids kept, full ring refuses new xids)
+ *   Snapshot visibility     (in-progress / committed-later / own changes)
+ *   HeapStore + txn_mgr     (snapshot scans, delete conflicts, vacuum horizon)
+ *
+ * Compile & run:
+ *   cd tests && make test_transaction && ./test_transaction
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../src/table.h"
+#include "../src/transaction.h"
+
+/* ============================================================
+ * Test Framework
+ * ============================================================ */
+
+static int pass_count = 0;
+static int fail_count = 0;
+
+#define PASS(msg, ...)                             \
+    do {                                           \
+        pass_count++;                              \
+        printf("[PASS] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define FAIL(msg, ...)                             \
+    do {                                           \
+        fail_count++;                              \
+        printf("[FAIL] " msg "\n", ##__VA_ARGS__); \
+    } while (0)
+
+#define CHECK(cond, msg) \
+    do { if (cond) { PASS("%s", msg); } else { FAIL("%s  (line %d)", msg, __LINE__); } } while (0)
+
+static const TupleColType i32_cols[1] = {TUPLE_COL_I32};
+static const TableSchema i32_schema = {.cols = i32_cols, .ncols = 1};
+
+static ItemPtr insert_i32(HeapStore* store, TxnId xid, i32 v)
+{
+    Datum d = Int32GetDatum(v);
+    return heapStore_insert(store, xid, INVALID_ITEM_PTR, &d, 0);
+}
+
+static u64 count_visible(HeapStore* store, const Snapshot* snap)
+{
+    u64 n = 0;
+    HeapStoreIter iter;
+    heapStoreIter_begin_snapshot(&iter, store, snap);
+    while (heapStoreIter_next(&iter) != NULL) n++;
+    heapStoreIter_end(&iter);
+    return n;
+}
+
+/* ================================================================
+ * Test 1: commit log and snapshot visibility rules
+ * ================================================================ */
+static void test_snapshot_visibility(void)
+{
+    printf("\n=== Test snapshot_visibility ===\n");
+
+    TransactionManager mgr;
+    TransactionManager_init(&mgr);
+
+    TxnId a = transactionManager_begin(&mgr);
+    TxnId b = transactionManager_begin(&mgr);
+    CHECK(a == FIRST_NORMAL_TXN_ID && b == a + 1, "xids are handed out in order");
+    CHECK(transactionManager_status(&mgr, a) == TXN_STATUS_IN_PROGRESS, "new xid is in progress");
+
+    transactionManager_commit(&mgr, a);
+    Snapshot* s1 = transactionManager_get_snapshot(&mgr, 0);
+    CHECK(s1->xmin == b && s1->xmax == b + 1 && s1->xcnt == 1, "snapshot records xmin/xmax/xip");
+    CHECK(snapshot_xid_visible(s1, a), "committed xid is visible");
+    CHECK(!snapshot_xid_visible(s1, b), "in-progress xid is invisible");
+
+    transactionManager_commit(&mgr, b);
+    CHECK(!snapshot_xid_visible(s1, b), "commit after the snapshot stays invisible");
+    TxnId c = transactionManager_begin(&mgr);
+    transactionManager_abort(&mgr, c);
+    Snapshot* s2 = transactionManager_get_snapshot(&mgr, 0);
+    CHECK(snapshot_xid_visible(s2, b), "later snapshot sees the commit");
+    CHECK(!snapshot_xid_visible(s2, c), "aborted xid is never visible");
+    CHECK(snapshot_tuple_visible(s2, a, c), "tuple with aborted deleter is visible");
+    CHECK(!snapshot_tuple_visible(s2, a, b), "tuple with committed deleter is invisible");
+
+    TxnId d = transactionManager_begin(&mgr);
+    Snapshot* own = transactionManager_get_snapshot(&mgr, d);
+    CHECK(snapshot_tuple_visible(own, d, 0), "own insert is visible");
+    CHECK(!snapshot_tuple_visible(own, a, d), "own delete hides the tuple");
+
+    CHECK(transactionManager_oldest_xmin(&mgr) == s1->xmin, "oldest snapshot pins the horizon");
+    transactionManager_release_snapshot(&mgr, s1);
+    transactionManager_release_snapshot(&mgr, s2);
+    CHECK(transactionManager_oldest_xmin(&mgr) == d, "running xid pins the horizon");
+    transactionManager_commit(&mgr, d);
+    transactionManager_release_snapshot(&mgr, own);
+    CHECK(transactionManager_oldest_xmin(&mgr) == d + 1, "idle manager horizon is next xid");
+
+    TransactionManager_deinit(&mgr);
+}
+
+/* ================================================================
+ * Test 2: heap scans, deletes and vacuum honour snapshots
+ * ================================================================ */
+static void test_heap_store_snapshots(void)
+{
+    printf("\n=== Test heap_store_snapshots ===\n");
+
+    TransactionManager mgr;
+    TransactionManager_init(&mgr);
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &i32_schema, NULL);
+    heapStore_set_txn_manager(&store, &mgr);
+
+    ItemPtr ctids[100];
+    for (i32 i = 0; i < 100; i++) ctids[i] = insert_i32(&store, 0, i);
+
+    TxnId writer = transactionManager_begin(&mgr);
+    for (i32 i = 0; i < 50; i++) insert_i32(&store, writer, 1000 + i);
+    Snapshot* before = transactionManager_get_snapshot(&mgr, 0);
+    CHECK(count_visible(&store, before) == 100, "uncommitted inserts are invisible");
+    transactionManager_commit(&mgr, writer);
+    CHECK(count_visible(&store, before) == 100, "snapshot ignores a later commit");
+    Snapshot* after = transactionManager_get_snapshot(&mgr, 0);
+    CHECK(count_visible(&store, after) == 150, "new snapshot sees committed inserts");
+    transactionManager_release_snapshot(&mgr, after);
+
+    TxnId deleter = transactionManager_begin(&mgr);
+    CHECK(heapStore_delete_xid(&store, deleter, ctids[0]) == deleter, "delete inside a txn");
+    CHECK(heapStore_delete_by_ctid(&store, ctids[0]) == INVALID_TXN_ID,
+          "concurrent delete of the same row conflicts");
+    transactionManager_abort(&mgr, deleter);
+    CHECK(count_visible(&store, before) == 100, "aborted delete leaves the row visible");
+    CHECK(heapStore_delete_by_ctid(&store, ctids[0]) != INVALID_TXN_ID,
+          "row deleted by an aborted txn can be deleted again");
+    for (i32 i = 1; i < 10; i++) heapStore_delete_by_ctid(&store, ctids[i]);
+
+    CHECK(heapStore_vacuum(&store, VACUUM_HORIZON_ALL, NULL, NULL) == 0,
+          "vacuum keeps rows an open snapshot can see");
+    CHECK(count_visible(&store, before) == 100, "old snapshot still sees deleted rows");
+    transactionManager_release_snapshot(&mgr, before);
+    CHECK(heapStore_vacuum(&store, VACUUM_HORIZON_ALL, NULL, NULL) == 10,
+          "released snapshot lets vacuum reclaim");
+
+    TxnId rolled_back = transactionManager_begin(&mgr);
+    for (i32 i = 0; i < 5; i++) insert_i32(&store, rolled_back, -i);
+    transactionManager_abort(&mgr, rolled_back);
+    CHECK(heapStore_vacuum(&store, VACUUM_HORIZON_ALL, NULL, NULL) == 5,
+          "vacuum reclaims tuples of aborted inserters");
+
+    HeapStore_deinit(&store);
+    TransactionManager_deinit(&mgr);
+}
+
+/* ================================================================
+ * Test 3: a scan never sees half of a concurrent transaction
+ * ================================================================ */
+typedef struct
+{
+    HeapStore* store;
+    TransactionManager* mgr;
+    int batches;
+} WriterArg;
+
+static void* writer_thread(void* arg)
+{
+    WriterArg* wa = arg;
+    for (int b = 0; b < wa->batches; b++)
+    {
+        TxnId xid = transactionManager_begin(wa->mgr);
+        for (i32 i = 0; i < 10; i++) insert_i32(wa->store, xid, i); /* latches pages itself */
+        transactionManager_commit(wa->mgr, xid);
+    }
+    return NULL;
+}
+
+static void test_concurrent_snapshot_scans(void)
+{
+    printf("\n=== Test concurrent_snapshot_scans ===\n");
+
+    TransactionManager mgr;
+    TransactionManager_init(&mgr);
+    HeapStore store;
+    memset(&store, 0, sizeof(store));
+    HeapStore_init(&store, &i32_schema, NULL);
+    heapStore_set_txn_manager(&store, &mgr);
+
+    WriterArg wa = {.store = &store, .mgr = &mgr, .batches = 500};
+    pthread_t th;
+    pthread_create(&th, NULL, writer_thread, &wa);
+    bool whole_batches = true;
+    u64 last = 0;
+    bool monotonic = true;
+    for (int r = 0; r < 200; r++)
+    {
+        Snapshot* snap = transactionManager_get_snapshot(&mgr, 0);
+        u64 n = count_visible(&store, snap);
+        transactionManager_release_snapshot(&mgr, snap);
+        if (n % 10 != 0) whole_batches = false;
+        if (n < last) monotonic = false;
+        last = n;
+    }
+    pthread_join(th, NULL);
+
+    CHECK(whole_batches, "scans see only whole committed transactions");
+    CHECK(monotonic, "later snapshots never see fewer rows");
+    Snapshot* snap = transactionManager_get_snapshot(&mgr, 0);
+    CHECK(count_visible(&store, snap) == 5000, "all batches visible after the writer");
+    transactionManager_release_snapshot(&mgr, snap);
+
+    HeapStore_deinit(&store);
+    TransactionManager_deinit(&mgr);
+}
+
+/* ================================================================
+ * Test 4: clog pages below the oldest xmin are truncated
+ * ================================================================ */
+static void test_clog_truncation(void)
+{
+    printf("\n=== Test clog_truncation ===\n");
+
+    TransactionManager mgr;
+    TransactionManager_init(&mgr);
+
+    TxnId aborted = 0, committed = 0;
+    for (u32 i = 0; i < 3 * CLOG_XACTS_PER_PAGE; i++)
+    {
+        TxnId xid = transactionManager_begin(&mgr);
+        if (i == 100)
+        {
+            transactionManager_abort(&mgr, xid);
+            aborted = xid;
+            continue;
+        }
+        if (i == 101) committed = xid;
+        transactionManager_commit(&mgr, xid);
+    }
+    CHECK(atomic_load(&mgr.clog_base) >= 2, "pages below the oldest xmin are truncated");
+    CHECK(atomic_load(&mgr.clog[0]) == NULL, "truncated page freed from the ring");
+    CHECK(transactionManager_status(&mgr, aborted) == TXN_STATUS_ABORTED,
+          "aborted xid still reads as aborted");
+    CHECK(transactionManager_status(&mgr, committed) == TXN_STATUS_COMMITTED,
+          "committed xid still reads as committed");
+
+    /* a running transaction pins the oldest xmin: the ring fills up */
+    TxnId pin = transactionManager_begin(&mgr);
+    u64 base = atomic_load(&mgr.clog_base);
+    atomic_store(&mgr.next_xid, (base + CLOG_MAX_PAGES) * CLOG_XACTS_PER_PAGE);
+    CHECK(transactionManager_begin(&mgr) == INVALID_TXN_ID, "full clog ring refuses new xids");
+    transactionManager_commit(&mgr, pin);
+    TxnId next = transactionManager_begin(&mgr);
+    CHECK(next != INVALID_TXN_ID && transactionManager_status(&mgr, pin) == TXN_STATUS_COMMITTED,
+          "finishing the pinning transaction frees the ring");
+    transactionManager_commit(&mgr, next);
+
+    TransactionManager_deinit(&mgr);
+}
+
+int main(void)
+{
+    printf("========================================\n");
+    printf("   Transaction Test Suite\n");
+    printf("========================================\n");
+
+    test_snapshot_visibility();
+    test_heap_store_snapshots();
+    test_concurrent_snapshot_scans();
+    test_clog_truncation();
+
+    printf("\n========================================\n");
+    printf("   Results: %d passed, %d failed\n", pass_count, fail_count);
+    printf("========================================\n\n");
+    return fail_count > 0 ? 1 : 0;
+}